@@ -53,6 +53,7 @@ public class OmniCapture : ModuleRules
         bool bHasOpenEXR = false;
         HashSet<string> OpenExrModules = new HashSet<string>();
         HashSet<string> ImathModules = new HashSet<string>();
+        HashSet<string> JpegTurboModules = new HashSet<string>();
 
         string thirdPartyDirectory = Target.UEThirdPartySourceDirectory;
         if (!string.IsNullOrEmpty(thirdPartyDirectory) && Directory.Exists(thirdPartyDirectory))
@@ -60,6 +61,7 @@ public class OmniCapture : ModuleRules
             CollectThirdPartyModules(thirdPartyDirectory, "OpenEXR", OpenExrModules);
             CollectThirdPartyModules(thirdPartyDirectory, "OpenExr", OpenExrModules);
             CollectThirdPartyModules(thirdPartyDirectory, "Imath", ImathModules);
+            CollectThirdPartyModules(thirdPartyDirectory, "LibJpegTurbo", JpegTurboModules);
         }
 
         if (OpenExrModules.Count > 0)
@@ -75,6 +77,14 @@ public class OmniCapture : ModuleRules
 
         PrivateDefinitions.Add($"WITH_OMNICAPTURE_OPENEXR={(bHasOpenEXR ? 1 : 0)}");
 
+        bool bHasLibJpegTurbo = JpegTurboModules.Count > 0;
+        if (bHasLibJpegTurbo)
+        {
+            AddEngineThirdPartyPrivateStaticDependencies(Target, JpegTurboModules.ToArray());
+        }
+
+        PrivateDefinitions.Add($"WITH_OMNICAPTURE_LIBJPEGTURBO={(bHasLibJpegTurbo ? 1 : 0)}");
+
         if (Target.Platform == UnrealTargetPlatform.Win64)
         {
             PrivateDependencyModuleNames.AddRange(new string[]
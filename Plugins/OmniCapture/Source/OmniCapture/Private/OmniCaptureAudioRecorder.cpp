@@ -7,7 +7,6 @@
 #include "HAL/FileManager.h"
 #include "Sound/SoundWave.h"
 #include "Sound/SoundSubmix.h"
-#include "Misc/ScopeLock.h"
 
 #if WITH_AUDIOMIXER
 #include "AudioMixerDevice.h"
@@ -17,8 +16,6 @@ DEFINE_LOG_CATEGORY_STATIC(LogOmniCaptureAudio, Log, All);
 
 namespace
 {
-    constexpr int32 GMaxPendingAudioPackets = 256;
-
 #if WITH_AUDIOMIXER
     class FOmniCaptureSubmixListener final : public Audio::ISubmixBufferListener
     {
@@ -55,9 +52,9 @@ bool FOmniCaptureAudioRecorder::Initialize(UWorld* InWorld, const FOmniCaptureSe
             TargetSubmix = LoadedSubmix;
         }
     }
-    PendingPacketCount = 0;
-    DroppedPacketCount = 0;
-    bLoggedOverflowWarning = false;
+    // Allocated once here so the audio thread never allocates.
+    Ring.Initialize();
+    ResetRing();
     AudioClockOrigin = -1.0;
     AudioStartTime = 0.0;
     bPaused.Store(false);
@@ -79,15 +76,17 @@ bool FOmniCaptureAudioRecorder::Initialize(UWorld* InWorld, const FOmniCaptureSe
     return WorldPtr.IsValid();
 }
 
-void FOmniCaptureAudioRecorder::Start()
+void FOmniCaptureAudioRecorder::Start(double TimelineOriginSeconds)
 {
     if (!WorldPtr.IsValid() || bIsRecording)
     {
         return;
     }
 
-    DroppedPacketCount = 0;
-    bLoggedOverflowWarning = false;
+    ResetRing();
+    RecordedBytes = 0;
+    TimelineOrigin = TimelineOriginSeconds;
+    TimelineOffset = 0.0;
 
     RegisterListener();
     AudioStartTime = FPlatformTime::Seconds();
@@ -118,57 +117,48 @@ void FOmniCaptureAudioRecorder::Stop(const FString& OutputDirectory, const FStri
 
     bIsRecording = false;
 
-    {
-        FScopeLock Lock(&PacketCS);
-        FOmniAudioPacket Packet;
-        while (PendingPackets.Dequeue(Packet))
-        {
-        }
-        PendingPacketCount = 0;
-    }
+    // The listener is gone, so nothing produces into the ring any more.
+    ResetRing();
 
     AudioClockOrigin = -1.0;
     AudioStartTime = 0.0;
-    DroppedPacketCount = 0;
-    bLoggedOverflowWarning = false;
     bPaused.Store(false);
 }
 
-void FOmniCaptureAudioRecorder::GatherAudio(double FrameTimestamp, TArray<FOmniAudioPacket>& OutPackets)
+void FOmniCaptureAudioRecorder::GatherAudio(double FrameTimestamp, FOmniCaptureFrame& Frame)
 {
-    FScopeLock Lock(&PacketCS);
+    Ring.Gather(FrameTimestamp, Frame, bIsRecording && !bPaused.Load());
+}
 
-    const double Threshold = FrameTimestamp + (1.0 / 120.0);
-    for (;;)
+bool FOmniCaptureAudioRecorder::GetAudioFormat(int32& OutSampleRate, int32& OutNumChannels) const
+{
+#if WITH_AUDIOMIXER
+    if (MixerDevice)
     {
-        FOmniAudioPacket Packet;
-        if (!PendingPackets.Peek(Packet))
-        {
-            break;
-        }
-
-        if (Packet.Timestamp > Threshold)
-        {
-            break;
-        }
-
-        PendingPackets.Dequeue(Packet);
-        PendingPacketCount.DecrementExchange();
-        OutPackets.Add(MoveTemp(Packet));
+        OutSampleRate = FMath::RoundToInt(MixerDevice->GetSampleRate());
+        OutNumChannels = MixerDevice->GetNumDeviceChannels();
+        return OutSampleRate > 0 && OutNumChannels > 0;
     }
+#endif
+    return false;
 }
 
 FString FOmniCaptureAudioRecorder::GetDebugStatus() const
 {
-    const int32 Pending = PendingPacketCount.Load();
-    const int32 Dropped = DroppedPacketCount.Load();
+    const int32 Pending = GetPendingPacketCount();
     const FString SubmixName = TargetSubmix.IsValid() ? TargetSubmix->GetName() : TEXT("Master");
-    return FString::Printf(TEXT("AudioPackets:%d Dropped:%d SR:%d Submix:%s"), Pending, Dropped, CachedSampleRate, *SubmixName);
+    return FString::Printf(TEXT("AudioPackets:%d Overflow:%d Underflow:%d SR:%d Submix:%s"), Pending, Ring.GetOverflowCount(), Ring.GetUnderflowCount(), CachedSampleRate, *SubmixName);
 }
 
 int32 FOmniCaptureAudioRecorder::GetPendingPacketCount() const
 {
-    return PendingPacketCount.Load();
+    return Ring.GetPendingChunkCount();
+}
+
+void FOmniCaptureAudioRecorder::ResetRing()
+{
+    Ring.Reset();
+    bLoggedOverflowWarning = false;
 }
 
 void FOmniCaptureAudioRecorder::SetPaused(bool bInPaused)
@@ -217,6 +207,9 @@ void FOmniCaptureAudioRecorder::HandleSubmixBuffer(const float* AudioData, int32
         return;
     }
 
+    // The engine records the submix whether or not capture is paused, as 16-bit PCM.
+    RecordedBytes.AddExchange(static_cast<int64>(NumSamples) * sizeof(int16));
+
     if (bPaused.Load())
     {
         return;
@@ -225,49 +218,18 @@ void FOmniCaptureAudioRecorder::HandleSubmixBuffer(const float* AudioData, int32
 #if WITH_AUDIOMIXER
     CachedSampleRate = SampleRate;
 
+    // A recorder started for a later segment still lands on the capture timeline rather than restarting at zero.
     if (AudioClockOrigin < 0.0)
     {
         AudioClockOrigin = AudioClock;
+        TimelineOffset = FMath::Max(0.0, FPlatformTime::Seconds() - TimelineOrigin);
     }
 
-    const double RelativeTimestamp = FMath::Max(0.0, AudioClock - AudioClockOrigin);
-    FOmniAudioPacket Packet;
-    Packet.Timestamp = RelativeTimestamp;
-    Packet.SampleRate = SampleRate;
-    Packet.NumChannels = NumChannels;
-    Packet.PCM16.SetNumUninitialized(NumSamples);
+    const double RelativeTimestamp = TimelineOffset + FMath::Max(0.0, AudioClock - AudioClockOrigin);
 
-    for (int32 Index = 0; Index < NumSamples; ++Index)
+    if (!Ring.Push(AudioData, NumSamples, NumChannels, SampleRate, Gain, RelativeTimestamp) && NumSamples > 0 && !bLoggedOverflowWarning.Exchange(true))
     {
-        const float SampleValue = AudioData[Index] * Gain;
-        const int32 IntValue = FMath::RoundToInt(SampleValue * 32767.0f);
-        Packet.PCM16[Index] = static_cast<int16>(FMath::Clamp(IntValue, -32768, 32767));
-    }
-
-    {
-        FScopeLock Lock(&PacketCS);
-        bool bDropped = false;
-        while (PendingPacketCount.Load() >= GMaxPendingAudioPackets)
-        {
-            FOmniAudioPacket DiscardedPacket;
-            if (!PendingPackets.Dequeue(DiscardedPacket))
-            {
-                PendingPacketCount = 0;
-                break;
-            }
-
-            PendingPacketCount.DecrementExchange();
-            DroppedPacketCount.IncrementExchange();
-            bDropped = true;
-        }
-
-        PendingPackets.Enqueue(MoveTemp(Packet));
-        PendingPacketCount.IncrementExchange();
-
-        if (bDropped && !bLoggedOverflowWarning.Exchange(true))
-        {
-            UE_LOG(LogOmniCaptureAudio, Warning, TEXT("OmniCapture audio queue overflowed. Dropping oldest packets to keep audio in sync."));
-        }
+        UE_LOG(LogOmniCaptureAudio, Warning, TEXT("OmniCapture audio ring is full. Dropping new submix buffers until capture catches up."));
     }
 #else
     (void)AudioData;
@@ -0,0 +1,136 @@
+#include "OmniCaptureAudioRing.h"
+
+#include "OmniCaptureCPUKernels.h"
+
+namespace
+{
+    /** Buffers stamped up to this far past a frame still belong to it. */
+    constexpr double GAudioLookaheadSeconds = 1.0 / 120.0;
+    /** Buffers closer than this to the end of the previous one are treated as continuing it. */
+    constexpr double GAudioContiguousSeconds = 0.002;
+    /** A frame this far past the last gathered audio with none waiting counts as an underflow. */
+    constexpr double GAudioUnderflowSeconds = 0.05;
+}
+
+void FOmniCaptureAudioRing::Initialize(int32 SampleCapacity, int32 ChunkCapacity)
+{
+    Samples.SetNumZeroed(static_cast<int32>(FMath::RoundUpToPowerOfTwo(static_cast<uint32>(FMath::Max(1, SampleCapacity)))));
+    Chunks.SetNum(static_cast<int32>(FMath::RoundUpToPowerOfTwo(static_cast<uint32>(FMath::Max(1, ChunkCapacity)))));
+    Reset();
+}
+
+void FOmniCaptureAudioRing::Reset()
+{
+    SampleWriteIndex = 0;
+    SampleReadIndex = 0;
+    ChunkWriteIndex = 0;
+    ChunkReadIndex = 0;
+    LastGatheredEndTime = -1.0;
+    OverflowCount = 0;
+    UnderflowCount = 0;
+}
+
+bool FOmniCaptureAudioRing::Push(const float* InSamples, int32 NumSamples, int32 NumChannels, int32 SampleRate, float Gain, double Timestamp)
+{
+    if (NumSamples <= 0 || Chunks.Num() == 0)
+    {
+        return false;
+    }
+
+    // Only this side moves the write counters; the read counters say how much Gather has copied out.
+    const uint64 ChunkWrite = ChunkWriteIndex.Load();
+    const uint64 SampleCapacity = Samples.Num();
+    if (ChunkWrite - ChunkReadIndex.Load() >= static_cast<uint64>(Chunks.Num())
+        || SampleWriteIndex + NumSamples - SampleReadIndex.Load() > SampleCapacity)
+    {
+        OverflowCount.IncrementExchange();
+        return false;
+    }
+
+    const int32 StartSlot = static_cast<int32>(SampleWriteIndex & (SampleCapacity - 1));
+    const int32 FirstSpan = FMath::Min(NumSamples, static_cast<int32>(SampleCapacity) - StartSlot);
+    FOmniCaptureCPUKernels::PackPCM16(InSamples, Gain, Samples.GetData() + StartSlot, FirstSpan);
+    if (FirstSpan < NumSamples)
+    {
+        FOmniCaptureCPUKernels::PackPCM16(InSamples + FirstSpan, Gain, Samples.GetData(), NumSamples - FirstSpan);
+    }
+
+    FAudioChunk& Chunk = Chunks[ChunkWrite & (Chunks.Num() - 1)];
+    Chunk.Timestamp = Timestamp;
+    Chunk.SampleRate = SampleRate;
+    Chunk.NumChannels = NumChannels;
+    Chunk.NumSamples = NumSamples;
+    Chunk.Start = SampleWriteIndex;
+    SampleWriteIndex += NumSamples;
+
+    // Publishing the chunk last makes its samples visible to Gather together with it.
+    ChunkWriteIndex.Store(ChunkWrite + 1);
+    return true;
+}
+
+void FOmniCaptureAudioRing::Gather(double FrameTimestamp, FOmniCaptureFrame& Frame, bool bExpectAudio)
+{
+    if (Chunks.Num() == 0)
+    {
+        return;
+    }
+
+    const uint64 ChunkMask = Chunks.Num() - 1;
+    const uint64 SampleMask = Samples.Num() - 1;
+    const double Threshold = FrameTimestamp + GAudioLookaheadSeconds;
+    const uint64 ChunkWrite = ChunkWriteIndex.Load();
+    uint64 ChunkRead = ChunkReadIndex.Load();
+
+    FOmniAudioPacket* Packet = nullptr;
+    double PacketEnd = 0.0;
+    for (; ChunkRead != ChunkWrite; ++ChunkRead)
+    {
+        const FAudioChunk& Chunk = Chunks[ChunkRead & ChunkMask];
+        if (Chunk.Timestamp > Threshold)
+        {
+            break;
+        }
+
+        // Back-to-back buffers of one format become one packet, so a frame normally carries a single PCM buffer.
+        const bool bContinuesPacket = Packet
+            && Packet->SampleRate == Chunk.SampleRate
+            && Packet->NumChannels == Chunk.NumChannels
+            && FMath::Abs(Chunk.Timestamp - PacketEnd) <= GAudioContiguousSeconds;
+        if (!bContinuesPacket)
+        {
+            Packet = &Frame.AudioPackets.AddDefaulted_GetRef();
+            if (Frame.SpareAudioPCM.Num() > 0)
+            {
+                Packet->PCM16 = Frame.SpareAudioPCM.Pop(EAllowShrinking::No);
+                Packet->PCM16.Reset();
+            }
+            Packet->Timestamp = Chunk.Timestamp;
+            Packet->SampleRate = Chunk.SampleRate;
+            Packet->NumChannels = Chunk.NumChannels;
+        }
+
+        const int32 Offset = Packet->PCM16.Num();
+        Packet->PCM16.SetNumUninitialized(Offset + Chunk.NumSamples);
+        const int32 StartSlot = static_cast<int32>(Chunk.Start & SampleMask);
+        const int32 FirstSpan = FMath::Min(Chunk.NumSamples, Samples.Num() - StartSlot);
+        FMemory::Memcpy(Packet->PCM16.GetData() + Offset, Samples.GetData() + StartSlot, FirstSpan * sizeof(int16));
+        if (FirstSpan < Chunk.NumSamples)
+        {
+            FMemory::Memcpy(Packet->PCM16.GetData() + Offset + FirstSpan, Samples.GetData(), (Chunk.NumSamples - FirstSpan) * sizeof(int16));
+        }
+        PacketEnd = Packet->Timestamp + static_cast<double>(Packet->PCM16.Num()) / (static_cast<double>(Packet->SampleRate) * FMath::Max(Packet->NumChannels, 1));
+
+        // The samples are copied out, so the producer may reuse them.
+        SampleReadIndex.Store(Chunk.Start + Chunk.NumSamples);
+        ChunkReadIndex.Store(ChunkRead + 1);
+    }
+
+    if (Packet)
+    {
+        LastGatheredEndTime = PacketEnd;
+    }
+    else if (bExpectAudio && LastGatheredEndTime >= 0.0 && FrameTimestamp > LastGatheredEndTime + GAudioUnderflowSeconds)
+    {
+        UnderflowCount.IncrementExchange();
+    }
+}
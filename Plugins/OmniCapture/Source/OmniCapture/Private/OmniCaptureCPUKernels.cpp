@@ -0,0 +1,390 @@
+#include "OmniCaptureCPUKernels.h"
+
+#include "Math/VectorRegister.h"
+
+namespace
+{
+    constexpr int32 GKernelLanes = 4;
+    constexpr float GWeightScale = 1.0f / MAX_uint16;
+
+    // Linear [0,1] is quantised to this many steps before the sRGB lookup; fine enough that the step never moves a channel
+    // by more than one code value, small enough to stay in L1.
+    constexpr int32 GSRGBTableSteps = 4095;
+
+    struct FSRGBEncodeTable
+    {
+        uint8 Color[GSRGBTableSteps + 1];
+        uint8 Alpha[GSRGBTableSteps + 1];
+
+        FSRGBEncodeTable()
+        {
+            for (int32 Step = 0; Step <= GSRGBTableSteps; ++Step)
+            {
+                const float Value = static_cast<float>(Step) / GSRGBTableSteps;
+                const FColor Encoded = FLinearColor(Value, Value, Value, Value).ToFColor(true);
+                Color[Step] = Encoded.R;
+                Alpha[Step] = Encoded.A;
+            }
+        }
+    };
+
+    const FSRGBEncodeTable& GetSRGBEncodeTable()
+    {
+        static const FSRGBEncodeTable Table;
+        return Table;
+    }
+
+    FORCEINLINE VectorRegister4Float LoadTexel(const FLinearColor& Texel)
+    {
+        return VectorLoad(&Texel.R);
+    }
+
+    FORCEINLINE VectorRegister4Float LoadTexel(const FFloat16Color& Texel)
+    {
+        alignas(16) float Widened[4];
+        FPlatformMath::VectorLoadHalf(Widened, reinterpret_cast<const uint16*>(&Texel));
+        return VectorLoadAligned(Widened);
+    }
+
+    template <typename TexelType>
+    FORCEINLINE const TexelType* GetTexel(const TexelType* const (&Faces)[6], uint32 Texel)
+    {
+        return Faces[Texel >> FOmniCaptureCubemapSample::FaceShift] + (Texel & FOmniCaptureCubemapSample::TexelMask);
+    }
+
+    template <typename TexelType>
+    FORCEINLINE void GatherNearestPixel(const TexelType* const (&Faces)[6], const FOmniCaptureCubemapSample& Sample, FLinearColor& Out)
+    {
+        VectorStore(Sample.Texel == FOmniCaptureCubemapSample::Transparent ? VectorZeroFloat() : LoadTexel(*GetTexel(Faces, Sample.Texel)), &Out.R);
+    }
+
+    template <typename TexelType>
+    FORCEINLINE void GatherBilinearPixel(const TexelType* const (&Faces)[6], int32 Resolution, const FOmniCaptureCubemapSample& Sample, FLinearColor& Out)
+    {
+        if (Sample.Texel == FOmniCaptureCubemapSample::Transparent)
+        {
+            VectorStore(VectorZeroFloat(), &Out.R);
+            return;
+        }
+
+        // A zero fraction means the neighbour is never weighted, so the step is skipped rather than reading past the face edge.
+        const TexelType* Texel00 = GetTexel(Faces, Sample.Texel);
+        const int32 StepX = Sample.WeightX ? 1 : 0;
+        const int32 StepY = Sample.WeightY ? Resolution : 0;
+
+        const VectorRegister4Float P00 = LoadTexel(Texel00[0]);
+        const VectorRegister4Float P10 = LoadTexel(Texel00[StepX]);
+        const VectorRegister4Float P01 = LoadTexel(Texel00[StepY]);
+        const VectorRegister4Float P11 = LoadTexel(Texel00[StepY + StepX]);
+        const VectorRegister4Float WeightX = VectorSetFloat1(Sample.WeightX * GWeightScale);
+        const VectorRegister4Float WeightY = VectorSetFloat1(Sample.WeightY * GWeightScale);
+
+        const VectorRegister4Float Top = VectorMultiplyAdd(VectorSubtract(P10, P00), WeightX, P00);
+        const VectorRegister4Float Bottom = VectorMultiplyAdd(VectorSubtract(P11, P01), WeightX, P01);
+        VectorStore(VectorMultiplyAdd(VectorSubtract(Bottom, Top), WeightY, Top), &Out.R);
+    }
+
+    template <typename TexelType>
+    void GatherNearestSpan(const TexelType* const (&Faces)[6], const FOmniCaptureCubemapSample* Samples, int32 Count, FLinearColor* Out)
+    {
+        for (int32 Index = 0; Index < Count; ++Index)
+        {
+            GatherNearestPixel(Faces, Samples[Index], Out[Index]);
+        }
+    }
+
+    template <typename TexelType>
+    void GatherBilinearSpan(const TexelType* const (&Faces)[6], int32 Resolution, const FOmniCaptureCubemapSample* Samples, int32 Count, FLinearColor* Out)
+    {
+        // Four independent pixels per iteration keep the loads of one in flight while the blends of another retire.
+        int32 Index = 0;
+        for (; Index + GKernelLanes <= Count; Index += GKernelLanes)
+        {
+            GatherBilinearPixel(Faces, Resolution, Samples[Index + 0], Out[Index + 0]);
+            GatherBilinearPixel(Faces, Resolution, Samples[Index + 1], Out[Index + 1]);
+            GatherBilinearPixel(Faces, Resolution, Samples[Index + 2], Out[Index + 2]);
+            GatherBilinearPixel(Faces, Resolution, Samples[Index + 3], Out[Index + 3]);
+        }
+        for (; Index < Count; ++Index)
+        {
+            GatherBilinearPixel(Faces, Resolution, Samples[Index], Out[Index]);
+        }
+    }
+
+    FLinearColor ReadTexelReference(const FOmniCaptureCubemapView& Cubemap, uint32 Face, int32 Index)
+    {
+        return Cubemap.bHalf ? FLinearColor(Cubemap.HalfFaces[Face][Index]) : Cubemap.Faces[Face][Index];
+    }
+
+    FORCEINLINE void PackSRGBPixel(const FSRGBEncodeTable& Table, const VectorRegister4Float& Source, FColor& Out)
+    {
+        const VectorRegister4Float Clamped = VectorMin(VectorMax(Source, VectorZeroFloat()), VectorOneFloat());
+        const VectorRegister4Float Scaled = VectorMultiplyAdd(Clamped, VectorSetFloat1(static_cast<float>(GSRGBTableSteps)), VectorSetFloat1(0.5f));
+
+        alignas(16) int32 Steps[4];
+        VectorIntStoreAligned(VectorFloatToInt(Scaled), Steps);
+        Out = FColor(Table.Color[Steps[0]], Table.Color[Steps[1]], Table.Color[Steps[2]], Table.Alpha[Steps[3]]);
+    }
+
+    template <typename PixelType>
+    void PackSRGBSpan(const PixelType* Source, FColor* Out, int32 Count)
+    {
+        const FSRGBEncodeTable& Table = GetSRGBEncodeTable();
+
+        int32 Index = 0;
+        for (; Index + GKernelLanes <= Count; Index += GKernelLanes)
+        {
+            PackSRGBPixel(Table, LoadTexel(Source[Index + 0]), Out[Index + 0]);
+            PackSRGBPixel(Table, LoadTexel(Source[Index + 1]), Out[Index + 1]);
+            PackSRGBPixel(Table, LoadTexel(Source[Index + 2]), Out[Index + 2]);
+            PackSRGBPixel(Table, LoadTexel(Source[Index + 3]), Out[Index + 3]);
+        }
+        for (; Index < Count; ++Index)
+        {
+            PackSRGBPixel(Table, LoadTexel(Source[Index]), Out[Index]);
+        }
+    }
+
+    FORCEINLINE void PackUNorm16Pixel(const VectorRegister4Float& Source, uint16* Out)
+    {
+        // Multiply and add stay separate so the rounding matches FMath::RoundToInt(Value * 65535) exactly.
+        const VectorRegister4Float Clamped = VectorMin(VectorMax(Source, VectorZeroFloat()), VectorOneFloat());
+        const VectorRegister4Float Scaled = VectorAdd(VectorMultiply(Clamped, VectorSetFloat1(65535.0f)), VectorSetFloat1(0.5f));
+
+        alignas(16) int32 Values[4];
+        VectorIntStoreAligned(VectorFloatToInt(Scaled), Values);
+        Out[0] = static_cast<uint16>(Values[2]);
+        Out[1] = static_cast<uint16>(Values[1]);
+        Out[2] = static_cast<uint16>(Values[0]);
+        Out[3] = static_cast<uint16>(Values[3]);
+    }
+
+    template <typename PixelType>
+    void PackUNorm16Span(const PixelType* Source, uint16* Out, int32 Count)
+    {
+        int32 Index = 0;
+        for (; Index + GKernelLanes <= Count; Index += GKernelLanes)
+        {
+            PackUNorm16Pixel(LoadTexel(Source[Index + 0]), Out + (Index + 0) * 4);
+            PackUNorm16Pixel(LoadTexel(Source[Index + 1]), Out + (Index + 1) * 4);
+            PackUNorm16Pixel(LoadTexel(Source[Index + 2]), Out + (Index + 2) * 4);
+            PackUNorm16Pixel(LoadTexel(Source[Index + 3]), Out + (Index + 3) * 4);
+        }
+        for (; Index < Count; ++Index)
+        {
+            PackUNorm16Pixel(LoadTexel(Source[Index]), Out + Index * 4);
+        }
+    }
+
+    FORCEINLINE VectorRegister4Float UnpackColorPixel(const FColor& Source)
+    {
+        // FColor sits in memory as B, G, R, A. A true divide keeps the result bit-identical to ReinterpretAsLinear.
+        const VectorRegister4Float BGRA = VectorLoadByte4(&Source);
+        return VectorDivide(VectorSwizzle(BGRA, 2, 1, 0, 3), VectorSetFloat1(255.0f));
+    }
+
+    FORCEINLINE void PackPCM16Lanes(const float* Source, const VectorRegister4Float& Gain, int16* Out)
+    {
+        // Same operation order as the reference: gain, full scale, then floor(x + 0.5), clamped before the integer conversion.
+        const VectorRegister4Float Scaled = VectorAdd(VectorMultiply(VectorMultiply(VectorLoad(Source), Gain), VectorSetFloat1(32767.0f)), VectorSetFloat1(0.5f));
+        const VectorRegister4Float Clamped = VectorMin(VectorMax(VectorFloor(Scaled), VectorSetFloat1(-32768.0f)), VectorSetFloat1(32767.0f));
+
+        alignas(16) int32 Values[4];
+        VectorIntStoreAligned(VectorFloatToInt(Clamped), Values);
+        Out[0] = static_cast<int16>(Values[0]);
+        Out[1] = static_cast<int16>(Values[1]);
+        Out[2] = static_cast<int16>(Values[2]);
+        Out[3] = static_cast<int16>(Values[3]);
+    }
+}
+
+void FOmniCaptureCPUKernels::GatherNearest(const FOmniCaptureCubemapView& Cubemap, const FOmniCaptureCubemapSample* Samples, int32 Count, FLinearColor* Out)
+{
+    if (Cubemap.bHalf)
+    {
+        GatherNearestSpan(Cubemap.HalfFaces, Samples, Count, Out);
+    }
+    else
+    {
+        GatherNearestSpan(Cubemap.Faces, Samples, Count, Out);
+    }
+}
+
+void FOmniCaptureCPUKernels::GatherBilinear(const FOmniCaptureCubemapView& Cubemap, const FOmniCaptureCubemapSample* Samples, int32 Count, FLinearColor* Out)
+{
+    if (Cubemap.bHalf)
+    {
+        GatherBilinearSpan(Cubemap.HalfFaces, Cubemap.Resolution, Samples, Count, Out);
+    }
+    else
+    {
+        GatherBilinearSpan(Cubemap.Faces, Cubemap.Resolution, Samples, Count, Out);
+    }
+}
+
+void FOmniCaptureCPUKernels::GatherBilinearReference(const FOmniCaptureCubemapView& Cubemap, const FOmniCaptureCubemapSample* Samples, int32 Count, FLinearColor* Out)
+{
+    for (int32 Index = 0; Index < Count; ++Index)
+    {
+        const FOmniCaptureCubemapSample& Sample = Samples[Index];
+        if (Sample.Texel == FOmniCaptureCubemapSample::Transparent)
+        {
+            Out[Index] = FLinearColor::Transparent;
+            continue;
+        }
+
+        const uint32 Face = Sample.Texel >> FOmniCaptureCubemapSample::FaceShift;
+        const int32 TexelIndex = static_cast<int32>(Sample.Texel & FOmniCaptureCubemapSample::TexelMask);
+        const int32 X0 = TexelIndex % Cubemap.Resolution;
+        const int32 Y0 = TexelIndex / Cubemap.Resolution;
+        const int32 X1 = FMath::Min(X0 + 1, Cubemap.Resolution - 1);
+        const int32 Y1 = FMath::Min(Y0 + 1, Cubemap.Resolution - 1);
+
+        const float WeightX = Sample.WeightX * GWeightScale;
+        const float WeightY = Sample.WeightY * GWeightScale;
+        const FLinearColor Top = FMath::Lerp(ReadTexelReference(Cubemap, Face, Y0 * Cubemap.Resolution + X0), ReadTexelReference(Cubemap, Face, Y0 * Cubemap.Resolution + X1), WeightX);
+        const FLinearColor Bottom = FMath::Lerp(ReadTexelReference(Cubemap, Face, Y1 * Cubemap.Resolution + X0), ReadTexelReference(Cubemap, Face, Y1 * Cubemap.Resolution + X1), WeightX);
+        Out[Index] = FMath::Lerp(Top, Bottom, WeightY);
+    }
+}
+
+void FOmniCaptureCPUKernels::PackFloat16(const FLinearColor* Source, FFloat16Color* Out, int32 Count)
+{
+    static_assert(sizeof(FFloat16Color) == 4 * sizeof(uint16), "FFloat16Color is expected to be four packed halves.");
+
+    // One FLinearColor is exactly one four-lane register, so each pixel converts in a single F16C/NEON instruction where available.
+    for (int32 Index = 0; Index < Count; ++Index)
+    {
+        FPlatformMath::VectorStoreHalf(reinterpret_cast<uint16*>(&Out[Index]), &Source[Index].R);
+    }
+}
+
+void FOmniCaptureCPUKernels::PackFloat16Reference(const FLinearColor* Source, FFloat16Color* Out, int32 Count)
+{
+    for (int32 Index = 0; Index < Count; ++Index)
+    {
+        Out[Index] = FFloat16Color(Source[Index]);
+    }
+}
+
+void FOmniCaptureCPUKernels::PackSRGB(const FLinearColor* Source, FColor* Out, int32 Count)
+{
+    PackSRGBSpan(Source, Out, Count);
+}
+
+void FOmniCaptureCPUKernels::PackSRGBReference(const FLinearColor* Source, FColor* Out, int32 Count)
+{
+    for (int32 Index = 0; Index < Count; ++Index)
+    {
+        Out[Index] = Source[Index].ToFColor(true);
+    }
+}
+
+void FOmniCaptureCPUKernels::PackSRGB(const FFloat16Color* Source, FColor* Out, int32 Count)
+{
+    PackSRGBSpan(Source, Out, Count);
+}
+
+void FOmniCaptureCPUKernels::WidenFloat16(const FFloat16Color* Source, FLinearColor* Out, int32 Count)
+{
+    for (int32 Index = 0; Index < Count; ++Index)
+    {
+        FPlatformMath::VectorLoadHalf(&Out[Index].R, reinterpret_cast<const uint16*>(&Source[Index]));
+    }
+}
+
+void FOmniCaptureCPUKernels::WidenFloat16Reference(const FFloat16Color* Source, FLinearColor* Out, int32 Count)
+{
+    for (int32 Index = 0; Index < Count; ++Index)
+    {
+        const FFloat16Color& Pixel = Source[Index];
+        Out[Index] = FLinearColor(Pixel.R.GetFloat(), Pixel.G.GetFloat(), Pixel.B.GetFloat(), Pixel.A.GetFloat());
+    }
+}
+
+void FOmniCaptureCPUKernels::PackUNorm16BGRA(const FLinearColor* Source, uint16* Out, int32 Count)
+{
+    PackUNorm16Span(Source, Out, Count);
+}
+
+void FOmniCaptureCPUKernels::PackUNorm16BGRA(const FFloat16Color* Source, uint16* Out, int32 Count)
+{
+    PackUNorm16Span(Source, Out, Count);
+}
+
+void FOmniCaptureCPUKernels::PackUNorm16BGRAReference(const FLinearColor* Source, uint16* Out, int32 Count)
+{
+    const auto ToUInt16 = [](float Value) -> uint16
+    {
+        return static_cast<uint16>(FMath::RoundToInt(FMath::Clamp(Value, 0.0f, 1.0f) * 65535.0f));
+    };
+
+    for (int32 Index = 0; Index < Count; ++Index)
+    {
+        const FLinearColor& Pixel = Source[Index];
+        *Out++ = ToUInt16(Pixel.B);
+        *Out++ = ToUInt16(Pixel.G);
+        *Out++ = ToUInt16(Pixel.R);
+        *Out++ = ToUInt16(Pixel.A);
+    }
+}
+
+void FOmniCaptureCPUKernels::ExpandUNorm16BGRA(const FColor* Source, uint16* Out, int32 Count)
+{
+    // Plain byte loop with no cross-lane work; compilers vectorise it on their own.
+    const uint8* Bytes = reinterpret_cast<const uint8*>(Source);
+    const int64 ValueCount = static_cast<int64>(Count) * 4;
+    for (int64 Index = 0; Index < ValueCount; ++Index)
+    {
+        Out[Index] = static_cast<uint16>(Bytes[Index] * 257u);
+    }
+}
+
+void FOmniCaptureCPUKernels::UnpackColor(const FColor* Source, FLinearColor* Out, int32 Count)
+{
+    for (int32 Index = 0; Index < Count; ++Index)
+    {
+        VectorStore(UnpackColorPixel(Source[Index]), &Out[Index].R);
+    }
+}
+
+void FOmniCaptureCPUKernels::UnpackColorReference(const FColor* Source, FLinearColor* Out, int32 Count)
+{
+    for (int32 Index = 0; Index < Count; ++Index)
+    {
+        Out[Index] = Source[Index].ReinterpretAsLinear();
+    }
+}
+
+void FOmniCaptureCPUKernels::UnpackColor(const FColor* Source, FFloat16Color* Out, int32 Count)
+{
+    alignas(16) float Linear[4];
+    for (int32 Index = 0; Index < Count; ++Index)
+    {
+        VectorStoreAligned(UnpackColorPixel(Source[Index]), Linear);
+        FPlatformMath::VectorStoreHalf(reinterpret_cast<uint16*>(&Out[Index]), Linear);
+    }
+}
+
+void FOmniCaptureCPUKernels::PackPCM16(const float* Source, float Gain, int16* Out, int32 Count)
+{
+    const VectorRegister4Float GainVector = VectorSetFloat1(Gain);
+    int32 Index = 0;
+    for (; Index + GKernelLanes <= Count; Index += GKernelLanes)
+    {
+        PackPCM16Lanes(Source + Index, GainVector, Out + Index);
+    }
+    if (Index < Count)
+    {
+        PackPCM16Reference(Source + Index, Gain, Out + Index, Count - Index);
+    }
+}
+
+void FOmniCaptureCPUKernels::PackPCM16Reference(const float* Source, float Gain, int16* Out, int32 Count)
+{
+    for (int32 Index = 0; Index < Count; ++Index)
+    {
+        const int32 Value = FMath::RoundToInt(Source[Index] * Gain * 32767.0f);
+        Out[Index] = static_cast<int16>(FMath::Clamp(Value, -32768, 32767));
+    }
+}
@@ -0,0 +1,887 @@
+#include "OmniCaptureCPUReprojection.h"
+
+#include "OmniCaptureCPUKernels.h"
+#include "OmniCaptureFramePool.h"
+
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "HAL/FileManager.h"
+#include "Misc/Guid.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/Archive.h"
+
+namespace
+{
+    // Rows per tile. Small enough to balance uneven rows (VR180 and fisheye skip whole spans), large enough
+    // that tile hand-off costs nothing next to the sampling work.
+    constexpr int32 GCPURowsPerTile = 8;
+
+    constexpr uint32 GReprojectionLUTMagic = 0x54554C4F; // "OLUT"
+    constexpr uint32 GReprojectionLUTVersion = 1;
+    constexpr int32 GMaxCachedReprojectionLUTs = 4;
+
+    FVector DirectionFromEquirectPixelCPU(const FIntPoint& Pixel, const FIntPoint& EyeResolution, double LongitudeSpan, double LatitudeSpan, float& OutLatitude)
+    {
+        const FVector2D UV((static_cast<double>(Pixel.X) + 0.5) / EyeResolution.X, (static_cast<double>(Pixel.Y) + 0.5) / EyeResolution.Y);
+        const double Longitude = (UV.X * 2.0 - 1.0) * LongitudeSpan;
+        const double Latitude = (0.5 - UV.Y) * LatitudeSpan * 2.0;
+        OutLatitude = static_cast<float>(Latitude);
+
+        const double CosLat = FMath::Cos(Latitude);
+        const double SinLat = FMath::Sin(Latitude);
+        const double CosLon = FMath::Cos(Longitude);
+        const double SinLon = FMath::Sin(Longitude);
+
+        FVector Direction;
+        Direction.X = CosLat * CosLon;
+        Direction.Y = SinLat;
+        Direction.Z = CosLat * SinLon;
+        return Direction.GetSafeNormal();
+    }
+
+    FVector DirectionFromFisheyePixelCPU(const FIntPoint& Pixel, const FIntPoint& EyeResolution, double FovRadians, bool& bOutValid)
+    {
+        if (EyeResolution.X <= 0 || EyeResolution.Y <= 0)
+        {
+            bOutValid = false;
+            return FVector::ZeroVector;
+        }
+
+        const FVector2D UV((static_cast<double>(Pixel.X) + 0.5) / EyeResolution.X, (static_cast<double>(Pixel.Y) + 0.5) / EyeResolution.Y);
+        FVector2D Normalized = FVector2D(UV.X * 2.0 - 1.0, 1.0 - UV.Y * 2.0);
+
+        const double Radius = Normalized.Size();
+        if (Radius > 1.0)
+        {
+            bOutValid = false;
+            return FVector::ZeroVector;
+        }
+
+        const double HalfFov = FMath::Clamp(FovRadians * 0.5, 0.0, PI);
+        const double Theta = Radius * HalfFov;
+        const double Phi = FMath::Atan2(Normalized.Y, Normalized.X);
+        const double SinTheta = FMath::Sin(Theta);
+
+        FVector Direction;
+        Direction.X = FMath::Cos(Theta);
+        Direction.Y = SinTheta * FMath::Sin(Phi);
+        Direction.Z = SinTheta * FMath::Cos(Phi);
+
+        bOutValid = true;
+        return Direction.GetSafeNormal();
+    }
+
+    void DirectionToFaceUVCPU(const FVector& Direction, uint32& OutFaceIndex, FVector2D& OutUV, int32 FaceResolution, float SeamStrength)
+    {
+        const FVector AbsDir = Direction.GetAbs();
+
+        if (AbsDir.X >= AbsDir.Y && AbsDir.X >= AbsDir.Z)
+        {
+            if (Direction.X > 0.0f)
+            {
+                OutFaceIndex = 0;
+                OutUV = FVector2D(-Direction.Z, Direction.Y) / AbsDir.X;
+            }
+            else
+            {
+                OutFaceIndex = 1;
+                OutUV = FVector2D(Direction.Z, Direction.Y) / AbsDir.X;
+            }
+        }
+        else if (AbsDir.Y >= AbsDir.X && AbsDir.Y >= AbsDir.Z)
+        {
+            if (Direction.Y > 0.0f)
+            {
+                OutFaceIndex = 2;
+                OutUV = FVector2D(Direction.X, -Direction.Z) / AbsDir.Y;
+            }
+            else
+            {
+                OutFaceIndex = 3;
+                OutUV = FVector2D(Direction.X, Direction.Z) / AbsDir.Y;
+            }
+        }
+        else
+        {
+            if (Direction.Z > 0.0f)
+            {
+                OutFaceIndex = 4;
+                OutUV = FVector2D(Direction.X, Direction.Y) / AbsDir.Z;
+            }
+            else
+            {
+                OutFaceIndex = 5;
+                OutUV = FVector2D(-Direction.X, Direction.Y) / AbsDir.Z;
+            }
+        }
+
+        OutUV = (OutUV + FVector2D(1.0, 1.0)) * 0.5f;
+
+        const double Resolution = static_cast<double>(FMath::Max(1, FaceResolution));
+        const double Scale = FMath::Lerp(1.0, (Resolution - 1.0) / Resolution, SeamStrength);
+        const double Bias = (0.5 / Resolution) * SeamStrength;
+        OutUV = FVector2D(OutUV.X * Scale + Bias, OutUV.Y * Scale + Bias);
+        OutUV.X = FMath::Clamp(OutUV.X, 0.0f, 1.0f);
+        OutUV.Y = FMath::Clamp(OutUV.Y, 0.0f, 1.0f);
+    }
+
+    FLinearColor SampleCubemapCPU(const FOmniCaptureCPUCubemap& Cubemap, const FVector& Direction, int32 FaceResolution, float SeamStrength)
+    {
+        uint32 FaceIndex = 0;
+        FVector2D FaceUV = FVector2D::ZeroVector;
+        DirectionToFaceUVCPU(Direction, FaceIndex, FaceUV, FaceResolution, SeamStrength);
+
+        const FOmniCaptureCPUFace& Face = Cubemap.Faces[FaceIndex];
+        const int32 SampleX = FMath::Clamp(static_cast<int32>(FaceUV.X * (Face.Resolution - 1)), 0, Face.Resolution - 1);
+        const int32 SampleY = FMath::Clamp(static_cast<int32>(FaceUV.Y * (Face.Resolution - 1)), 0, Face.Resolution - 1);
+        const int32 SampleIndex = SampleY * Face.Resolution + SampleX;
+
+        return Face.IsValid() && SampleIndex >= 0 && SampleIndex < Face.Resolution * Face.Resolution
+            ? Face.GetTexel(SampleIndex)
+            : FLinearColor::Black;
+    }
+
+    void ApplyPolarMitigation(float PolarStrength, float Latitude, FVector& Direction)
+    {
+        if (PolarStrength <= 0.0f)
+        {
+            return;
+        }
+
+        double PoleFactor = FMath::Clamp(FMath::Abs(Latitude) / (PI * 0.5), 0.0, 1.0);
+        PoleFactor = FMath::Pow(PoleFactor, 4.0);
+        const double Blend = PoleFactor * PolarStrength;
+        if (Blend <= 0.0)
+        {
+            return;
+        }
+
+        const FVector PoleVector(0.0f, Latitude >= 0.0f ? 1.0f : -1.0f, 0.0f);
+        Direction = FVector(FMath::Lerp(Direction.X, PoleVector.X, Blend),
+            FMath::Lerp(Direction.Y, PoleVector.Y, Blend),
+            FMath::Lerp(Direction.Z, PoleVector.Z, Blend));
+        Direction.Normalize();
+    }
+
+    template <typename RowFunction>
+    void ForEachRowTile(int32 RowCount, int32 MaxWorkers, const RowFunction& ProcessRow)
+    {
+        const int32 TileCount = FMath::DivideAndRoundUp(FMath::Max(0, RowCount), GCPURowsPerTile);
+        const int32 WorkerCount = FMath::Min(MaxWorkers > 0 ? MaxWorkers : FOmniCaptureCPUReprojection::GetMaxWorkerCount(), TileCount);
+        if (WorkerCount <= 1)
+        {
+            for (int32 Row = 0; Row < RowCount; ++Row)
+            {
+                ProcessRow(Row);
+            }
+            return;
+        }
+
+        // Tiles are claimed in ascending order, so the threads in flight sample neighbouring latitudes and share cube faces in cache.
+        TAtomic<int32> NextTile { 0 };
+        ParallelFor(WorkerCount, [&](int32)
+        {
+            for (;;)
+            {
+                const int32 Tile = NextTile.IncrementExchange();
+                if (Tile >= TileCount)
+                {
+                    break;
+                }
+
+                const int32 RowEnd = FMath::Min(RowCount, (Tile + 1) * GCPURowsPerTile);
+                for (int32 Row = Tile * GCPURowsPerTile; Row < RowEnd; ++Row)
+                {
+                    ProcessRow(Row);
+                }
+            }
+        });
+    }
+
+    /** How output pixels map to per-eye pixels for the active stereo layout. */
+    struct FEyeMapping
+    {
+        FIntPoint OutputSize = FIntPoint::ZeroValue;
+        FIntPoint EyeResolution = FIntPoint::ZeroValue;
+        bool bStereo = false;
+        bool bSideBySide = false;
+        int32 EyeSplit = 1;
+
+        /** Range of eye pixels the mapping can produce, i.e. the extent of a sampling map shared by both eyes. */
+        FIntPoint GetDomain() const
+        {
+            if (!bStereo)
+            {
+                return OutputSize;
+            }
+
+            return bSideBySide
+                ? FIntPoint(FMath::Min(EyeSplit, OutputSize.X), OutputSize.Y)
+                : FIntPoint(OutputSize.X, FMath::Min(EyeSplit, OutputSize.Y));
+        }
+
+        void Map(int32 X, int32 Y, FIntPoint& OutEyePixel, bool& bOutRightEye) const
+        {
+            OutEyePixel = FIntPoint(X, Y);
+            bOutRightEye = false;
+
+            if (bStereo)
+            {
+                if (bSideBySide)
+                {
+                    bOutRightEye = X >= EyeSplit;
+                    OutEyePixel.X = X % EyeSplit;
+                }
+                else
+                {
+                    bOutRightEye = Y >= EyeSplit;
+                    OutEyePixel.Y = Y % EyeSplit;
+                }
+            }
+        }
+    };
+
+    struct FReprojectionLUTKey
+    {
+        uint8 Projection = 0;
+        FIntPoint Domain = FIntPoint::ZeroValue;
+        FIntPoint EyeResolution = FIntPoint::ZeroValue;
+        int32 FaceResolution = 0;
+        double LongitudeSpan = 0.0;
+        double LatitudeSpan = 0.0;
+        double FovRadians = 0.0;
+        float SeamBlend = 0.0f;
+        float PolarDampening = 0.0f;
+        bool bHalfSphere = false;
+
+        bool operator==(const FReprojectionLUTKey& Other) const
+        {
+            return Projection == Other.Projection
+                && Domain == Other.Domain
+                && EyeResolution == Other.EyeResolution
+                && FaceResolution == Other.FaceResolution
+                && LongitudeSpan == Other.LongitudeSpan
+                && LatitudeSpan == Other.LatitudeSpan
+                && FovRadians == Other.FovRadians
+                && SeamBlend == Other.SeamBlend
+                && PolarDampening == Other.PolarDampening
+                && bHalfSphere == Other.bHalfSphere;
+        }
+
+        friend uint32 GetTypeHash(const FReprojectionLUTKey& Key)
+        {
+            uint32 Hash = GetTypeHash(Key.Projection);
+            Hash = HashCombine(Hash, GetTypeHash(Key.Domain));
+            Hash = HashCombine(Hash, GetTypeHash(Key.EyeResolution));
+            Hash = HashCombine(Hash, GetTypeHash(Key.FaceResolution));
+            Hash = HashCombine(Hash, GetTypeHash(Key.LongitudeSpan));
+            Hash = HashCombine(Hash, GetTypeHash(Key.LatitudeSpan));
+            Hash = HashCombine(Hash, GetTypeHash(Key.FovRadians));
+            Hash = HashCombine(Hash, GetTypeHash(Key.SeamBlend));
+            Hash = HashCombine(Hash, GetTypeHash(Key.PolarDampening));
+            return HashCombine(Hash, GetTypeHash(Key.bHalfSphere));
+        }
+
+        friend FArchive& operator<<(FArchive& Ar, FReprojectionLUTKey& Key)
+        {
+            Ar << Key.Projection << Key.Domain << Key.EyeResolution << Key.FaceResolution;
+            Ar << Key.LongitudeSpan << Key.LatitudeSpan << Key.FovRadians;
+            Ar << Key.SeamBlend << Key.PolarDampening << Key.bHalfSphere;
+            return Ar;
+        }
+    };
+
+    struct FReprojectionLUT
+    {
+        FReprojectionLUTKey Key;
+        TArray64<FOmniCaptureCubemapSample> Samples;
+    };
+
+    using FReprojectionLUTRef = TSharedPtr<const FReprojectionLUT, ESPMode::ThreadSafe>;
+
+    FCriticalSection GReprojectionLUTCS;
+    TArray<FReprojectionLUTRef> GReprojectionLUTCache;
+
+    FString GetLUTFilePath(const FReprojectionLUTKey& Key)
+    {
+        return FOmniCaptureCPUReprojection::GetLUTCacheDirectory() / FString::Printf(TEXT("%08x_%dx%d_f%d.omnilut"), GetTypeHash(Key), Key.Domain.X, Key.Domain.Y, Key.FaceResolution);
+    }
+
+    FReprojectionLUTRef LoadLUT(const FReprojectionLUTKey& Key)
+    {
+        const FString FilePath = GetLUTFilePath(Key);
+        TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*FilePath, FILEREAD_Silent));
+        if (!Reader)
+        {
+            return nullptr;
+        }
+
+        uint32 Magic = 0;
+        uint32 Version = 0;
+        FReprojectionLUTKey StoredKey;
+        int64 SampleCount = 0;
+        *Reader << Magic << Version;
+        if (Magic != GReprojectionLUTMagic || Version != GReprojectionLUTVersion)
+        {
+            return nullptr;
+        }
+
+        *Reader << StoredKey << SampleCount;
+        const int64 ExpectedCount = static_cast<int64>(Key.Domain.X) * Key.Domain.Y;
+        if (Reader->IsError() || !(StoredKey == Key) || SampleCount != ExpectedCount)
+        {
+            return nullptr;
+        }
+
+        TSharedPtr<FReprojectionLUT, ESPMode::ThreadSafe> LUT = MakeShared<FReprojectionLUT, ESPMode::ThreadSafe>();
+        LUT->Key = Key;
+        LUT->Samples.SetNumUninitialized(SampleCount);
+        Reader->Serialize(LUT->Samples.GetData(), SampleCount * sizeof(FOmniCaptureCubemapSample));
+        if (Reader->IsError() || !Reader->Close())
+        {
+            return nullptr;
+        }
+
+        return LUT;
+    }
+
+    void SaveLUT(const FReprojectionLUT& LUT)
+    {
+        const FString FilePath = GetLUTFilePath(LUT.Key);
+        // Unique per writer, since two conversions with the same settings may save the same map at once.
+        const FString TempPath = FilePath + TEXT(".") + FGuid::NewGuid().ToString() + TEXT(".tmp");
+        IFileManager::Get().MakeDirectory(*FPaths::GetPath(FilePath), true);
+
+        {
+            TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*TempPath));
+            if (!Writer)
+            {
+                return;
+            }
+
+            uint32 Magic = GReprojectionLUTMagic;
+            uint32 Version = GReprojectionLUTVersion;
+            FReprojectionLUTKey Key = LUT.Key;
+            int64 SampleCount = LUT.Samples.Num();
+            *Writer << Magic << Version << Key << SampleCount;
+            Writer->Serialize(const_cast<FOmniCaptureCubemapSample*>(LUT.Samples.GetData()), SampleCount * sizeof(FOmniCaptureCubemapSample));
+            if (!Writer->Close())
+            {
+                IFileManager::Get().Delete(*TempPath, false, true, true);
+                return;
+            }
+        }
+
+        // Write-then-rename so a render node that dies mid-write never leaves a truncated map behind.
+        IFileManager::Get().Move(*FilePath, *TempPath, true, true, false, true);
+    }
+
+    /** Resolves the cubemap sample for each eye pixel of one row; shared by the map builder and uncached conversion. */
+    template <typename ResolveDirectionType>
+    void ResolveSamples(const FIntPoint& EyeResolution, int32 FaceResolution, float SeamBlend, const ResolveDirectionType& ResolveDirection, int32 EyeY, int32 Count, FOmniCaptureCubemapSample* OutSamples)
+    {
+        for (int32 X = 0; X < Count; ++X)
+        {
+            FOmniCaptureCubemapSample& Sample = OutSamples[X];
+            Sample = FOmniCaptureCubemapSample();
+
+            FVector Direction;
+            if (!ResolveDirection(FIntPoint(X, EyeY), EyeResolution, Direction))
+            {
+                continue;
+            }
+
+            uint32 FaceIndex = 0;
+            FVector2D FaceUV = FVector2D::ZeroVector;
+            DirectionToFaceUVCPU(Direction, FaceIndex, FaceUV, FaceResolution, SeamBlend);
+
+            // Same truncation SampleCubemapCPU applies, so the nearest texel matches the per-pixel path exactly.
+            const double TexelX = FaceUV.X * (FaceResolution - 1);
+            const double TexelY = FaceUV.Y * (FaceResolution - 1);
+            const int32 SampleX = FMath::Clamp(static_cast<int32>(TexelX), 0, FaceResolution - 1);
+            const int32 SampleY = FMath::Clamp(static_cast<int32>(TexelY), 0, FaceResolution - 1);
+
+            Sample.Texel = (FaceIndex << FOmniCaptureCubemapSample::FaceShift) | static_cast<uint32>(SampleY * FaceResolution + SampleX);
+            Sample.WeightX = static_cast<uint16>(FMath::RoundToInt(FMath::Clamp(TexelX - SampleX, 0.0, 1.0) * MAX_uint16));
+            Sample.WeightY = static_cast<uint16>(FMath::RoundToInt(FMath::Clamp(TexelY - SampleY, 0.0, 1.0) * MAX_uint16));
+        }
+    }
+
+    template <typename ResolveDirectionType>
+    FReprojectionLUTRef BuildLUT(const FReprojectionLUTKey& Key, const FEyeMapping& Mapping, float SeamBlend, const ResolveDirectionType& ResolveDirection, int32 MaxWorkers)
+    {
+        TSharedPtr<FReprojectionLUT, ESPMode::ThreadSafe> LUT = MakeShared<FReprojectionLUT, ESPMode::ThreadSafe>();
+        LUT->Key = Key;
+        LUT->Samples.SetNumUninitialized(static_cast<int64>(Key.Domain.X) * Key.Domain.Y);
+
+        ForEachRowTile(Key.Domain.Y, MaxWorkers, [&](int32 Y)
+        {
+            ResolveSamples(Mapping.EyeResolution, Key.FaceResolution, SeamBlend, ResolveDirection, Y, Key.Domain.X, &LUT->Samples[static_cast<int64>(Y) * Key.Domain.X]);
+        });
+
+        return LUT;
+    }
+
+    /** Returns the cached map for Key and marks it most recently used. Call with GReprojectionLUTCS held. */
+    FReprojectionLUTRef FindCachedLUT(const FReprojectionLUTKey& Key)
+    {
+        for (int32 Index = 0; Index < GReprojectionLUTCache.Num(); ++Index)
+        {
+            if (GReprojectionLUTCache[Index]->Key == Key)
+            {
+                FReprojectionLUTRef Found = GReprojectionLUTCache[Index];
+                GReprojectionLUTCache.RemoveAt(Index, 1, EAllowShrinking::No);
+                GReprojectionLUTCache.Add(Found);
+                return Found;
+            }
+        }
+        return nullptr;
+    }
+
+    template <typename ResolveDirectionType>
+    FReprojectionLUTRef FindOrBuildLUT(const FReprojectionLUTKey& Key, const FEyeMapping& Mapping, float SeamBlend, bool bPersist, const ResolveDirectionType& ResolveDirection, int32 MaxWorkers)
+    {
+        {
+            FScopeLock Lock(&GReprojectionLUTCS);
+            if (FReprojectionLUTRef Found = FindCachedLUT(Key))
+            {
+                return Found;
+            }
+        }
+
+        // Loading and building run unlocked so conversions with other settings, and cache hits, never wait on disk
+        // I/O or a full-resolution build.
+        FReprojectionLUTRef LUT = bPersist ? LoadLUT(Key) : nullptr;
+        if (!LUT.IsValid())
+        {
+            LUT = BuildLUT(Key, Mapping, SeamBlend, ResolveDirection, MaxWorkers);
+            if (bPersist)
+            {
+                SaveLUT(*LUT);
+            }
+        }
+
+        FScopeLock Lock(&GReprojectionLUTCS);
+        // Another conversion with the same settings may have published its map first; share that one.
+        if (FReprojectionLUTRef Found = FindCachedLUT(Key))
+        {
+            return Found;
+        }
+
+        if (GReprojectionLUTCache.Num() >= GMaxCachedReprojectionLUTs)
+        {
+            GReprojectionLUTCache.RemoveAt(0, 1, EAllowShrinking::No);
+        }
+        GReprojectionLUTCache.Add(LUT);
+        return LUT;
+    }
+
+    bool HasUniformFaces(const FOmniCaptureCPUCubemap& Cubemap, int32 FaceResolution)
+    {
+        const bool bHalf = Cubemap.Faces[0].HasHalfStorage();
+        for (int32 FaceIndex = 0; FaceIndex < 6; ++FaceIndex)
+        {
+            const FOmniCaptureCPUFace& Face = Cubemap.Faces[FaceIndex];
+            if (Face.Resolution != FaceResolution || Face.HasHalfStorage() != bHalf || !Face.IsValid())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    FOmniCaptureCubemapView MakeCubemapView(const FOmniCaptureCPUCubemap& Cubemap)
+    {
+        FOmniCaptureCubemapView View;
+        View.Resolution = Cubemap.Faces[0].Resolution;
+        View.bHalf = Cubemap.Faces[0].HasHalfStorage();
+        for (int32 FaceIndex = 0; FaceIndex < 6; ++FaceIndex)
+        {
+            View.Faces[FaceIndex] = Cubemap.Faces[FaceIndex].Pixels.GetData();
+            View.HalfFaces[FaceIndex] = Cubemap.Faces[FaceIndex].HalfPixels.GetData();
+        }
+        return View;
+    }
+
+    using FGatherRowFunction = TFunction<void(int32 Y, FLinearColor* OutRow)>;
+
+    EOmniCapturePixelDataType GetOutputPixelDataType(bool bIsLinear, EOmniCapturePixelPrecision Precision)
+    {
+        if (!bIsLinear)
+        {
+            return EOmniCapturePixelDataType::Color8;
+        }
+
+        return Precision == EOmniCapturePixelPrecision::FullFloat
+            ? EOmniCapturePixelDataType::LinearColorFloat32
+            : EOmniCapturePixelDataType::LinearColorFloat16;
+    }
+
+    /** Gathers rows [RowStart, RowStart + RowCount) and packs them tightly into OutRows as PixelDataType. */
+    void PackRows(const FGatherRowFunction& GatherRow, EOmniCapturePixelDataType PixelDataType, int32 Width, int32 RowStart, int32 RowCount, void* OutRows, int32 MaxWorkers)
+    {
+        ForEachRowTile(RowCount, MaxWorkers, [&](int32 Row)
+        {
+            const int32 Y = RowStart + Row;
+            const int64 RowOffset = static_cast<int64>(Row) * Width;
+            if (PixelDataType == EOmniCapturePixelDataType::LinearColorFloat32)
+            {
+                GatherRow(Y, static_cast<FLinearColor*>(OutRows) + RowOffset);
+                return;
+            }
+
+            TArray<FLinearColor> LinearRow;
+            LinearRow.SetNumUninitialized(Width);
+            GatherRow(Y, LinearRow.GetData());
+            if (PixelDataType == EOmniCapturePixelDataType::LinearColorFloat16)
+            {
+                FOmniCaptureCPUKernels::PackFloat16(LinearRow.GetData(), static_cast<FFloat16Color*>(OutRows) + RowOffset, Width);
+            }
+            else
+            {
+                FOmniCaptureCPUKernels::PackSRGB(LinearRow.GetData(), static_cast<FColor*>(OutRows) + RowOffset, Width);
+            }
+        });
+    }
+
+    /** Runs GatherRow over every output row into a pooled frame of the pixel type the result asks for. */
+    void WriteOutput(const FIntPoint& OutputSize, const FGatherRowFunction& GatherRow, FOmniCaptureEquirectResult& OutResult, int32 MaxWorkers)
+    {
+        OutResult.PixelDataType = GetOutputPixelDataType(OutResult.bIsLinear, OutResult.PixelPrecision);
+
+        void* Pixels = nullptr;
+        switch (OutResult.PixelDataType)
+        {
+        case EOmniCapturePixelDataType::LinearColorFloat32:
+        {
+            TUniquePtr<TImagePixelData<FLinearColor>> PixelData = FOmniCaptureFramePool::Get().AcquirePixels<FLinearColor>(OutputSize);
+            Pixels = PixelData->Pixels.GetData();
+            OutResult.PixelData = MoveTemp(PixelData);
+            break;
+        }
+        case EOmniCapturePixelDataType::LinearColorFloat16:
+        {
+            TUniquePtr<TImagePixelData<FFloat16Color>> PixelData = FOmniCaptureFramePool::Get().AcquirePixels<FFloat16Color>(OutputSize);
+            Pixels = PixelData->Pixels.GetData();
+            OutResult.PixelData = MoveTemp(PixelData);
+            OutResult.PixelPrecision = EOmniCapturePixelPrecision::HalfFloat;
+            break;
+        }
+        default:
+        {
+            TUniquePtr<TImagePixelData<FColor>> PixelData = FOmniCaptureFramePool::Get().AcquirePixels<FColor>(OutputSize);
+            Pixels = PixelData->Pixels.GetData();
+            OutResult.PixelData = MoveTemp(PixelData);
+            break;
+        }
+        }
+
+        PackRows(GatherRow, OutResult.PixelDataType, OutputSize.X, 0, OutputSize.Y, Pixels, MaxWorkers);
+    }
+
+    void PrepareResult(const FOmniCaptureSettings& Settings, const FOmniCaptureCPUCubemap& LeftCubemap, const FIntPoint& OutputSize, FOmniCaptureEquirectResult& OutResult)
+    {
+        OutResult.Size = OutputSize;
+        OutResult.bIsLinear = Settings.Gamma == EOmniCaptureGamma::Linear;
+        OutResult.bUsedCPUFallback = true;
+        OutResult.OutputTarget.SafeRelease();
+        OutResult.Texture.SafeRelease();
+        OutResult.ReadyFence.SafeRelease();
+        OutResult.EncoderPlanes.Reset();
+        OutResult.RowSource.Reset();
+
+        OutResult.PixelPrecision = LeftCubemap.Precision;
+    }
+
+    /** Builds the per-row gatherer over the given faces; the faces must outlive the returned function. */
+    template <typename ResolveDirectionType>
+    FGatherRowFunction MakeGatherRow(const FOmniCaptureSettings& Settings, const FEyeMapping& Mapping, FReprojectionLUTKey Key, const ResolveDirectionType& ResolveDirection, const FOmniCaptureCPUCubemap& LeftCubemap, const FOmniCaptureCPUCubemap& RightCubemap, int32 MaxWorkers)
+    {
+        const FIntPoint OutputSize = Mapping.OutputSize;
+        const int32 FaceResolution = LeftCubemap.Faces[0].Resolution;
+        const float SeamBlend = Settings.SeamBlend;
+
+        // The span kernels address texels through one face size per cubemap; anything else takes the per-pixel path.
+        const bool bUniformFaces = FaceResolution > 0
+            && static_cast<int64>(FaceResolution) * FaceResolution <= FOmniCaptureCubemapSample::TexelMask
+            && HasUniformFaces(LeftCubemap, FaceResolution)
+            && (!Mapping.bStereo || HasUniformFaces(RightCubemap, FaceResolution));
+
+        if (!bUniformFaces)
+        {
+            return [Mapping, ResolveDirection, Left = &LeftCubemap, Right = &RightCubemap, FaceResolution, SeamBlend](int32 Y, FLinearColor* OutRow)
+            {
+                for (int32 X = 0; X < Mapping.OutputSize.X; ++X)
+                {
+                    FIntPoint EyePixel;
+                    bool bRightEye = false;
+                    Mapping.Map(X, Y, EyePixel, bRightEye);
+
+                    FVector Direction;
+                    OutRow[X] = ResolveDirection(EyePixel, Mapping.EyeResolution, Direction)
+                        ? SampleCubemapCPU((Mapping.bStereo && bRightEye) ? *Right : *Left, Direction, FaceResolution, SeamBlend)
+                        : FLinearColor::Transparent;
+                }
+            };
+        }
+
+        const FIntPoint Domain = Mapping.GetDomain();
+        FReprojectionLUTRef LUT;
+        if (Settings.bCacheCPUReprojectionLUT)
+        {
+            Key.Domain = Domain;
+            Key.EyeResolution = Mapping.EyeResolution;
+            Key.FaceResolution = FaceResolution;
+            Key.SeamBlend = SeamBlend;
+            LUT = FindOrBuildLUT(Key, Mapping, SeamBlend, Settings.bPersistCPUReprojectionLUT, ResolveDirection, MaxWorkers);
+        }
+
+        const FOmniCaptureCubemapView LeftView = MakeCubemapView(LeftCubemap);
+        const FOmniCaptureCubemapView RightView = Mapping.bStereo ? MakeCubemapView(RightCubemap) : LeftView;
+        const bool bBilinear = Settings.bBilinearCPUSampling;
+
+        // Every layout maps an output row onto runs of consecutive eye pixels starting at eye column zero, so each run
+        // reads one contiguous stretch of the sampling map.
+        return [Mapping, ResolveDirection, LUT, Domain, LeftView, RightView, FaceResolution, SeamBlend, bBilinear](int32 Y, FLinearColor* OutRow)
+        {
+            TArray<FOmniCaptureCubemapSample> RowSamples;
+            auto GatherRun = [&](int32 OutX, int32 EyeY, int32 Count, const FOmniCaptureCubemapView& View)
+            {
+                const FOmniCaptureCubemapSample* Samples = nullptr;
+                if (LUT.IsValid())
+                {
+                    Samples = &LUT->Samples[static_cast<int64>(EyeY) * Domain.X];
+                }
+                else
+                {
+                    RowSamples.SetNumUninitialized(Count, EAllowShrinking::No);
+                    ResolveSamples(Mapping.EyeResolution, FaceResolution, SeamBlend, ResolveDirection, EyeY, Count, RowSamples.GetData());
+                    Samples = RowSamples.GetData();
+                }
+
+                if (bBilinear)
+                {
+                    FOmniCaptureCPUKernels::GatherBilinear(View, Samples, Count, OutRow + OutX);
+                }
+                else
+                {
+                    FOmniCaptureCPUKernels::GatherNearest(View, Samples, Count, OutRow + OutX);
+                }
+            };
+
+            const int32 OutputWidth = Mapping.OutputSize.X;
+            if (Mapping.bStereo && Mapping.bSideBySide)
+            {
+                for (int32 X = 0; X < OutputWidth; X += Mapping.EyeSplit)
+                {
+                    GatherRun(X, Y, FMath::Min(Mapping.EyeSplit, OutputWidth - X), X >= Mapping.EyeSplit ? RightView : LeftView);
+                }
+            }
+            else if (Mapping.bStereo)
+            {
+                GatherRun(0, Y % Mapping.EyeSplit, OutputWidth, Y >= Mapping.EyeSplit ? RightView : LeftView);
+            }
+            else
+            {
+                GatherRun(0, Y, OutputWidth, LeftView);
+            }
+        };
+    }
+
+    FGatherRowFunction MakeEquirectangularGatherRow(const FOmniCaptureSettings& Settings, const FOmniCaptureCPUCubemap& LeftCubemap, const FOmniCaptureCPUCubemap& RightCubemap, int32 MaxWorkers, FIntPoint& OutOutputSize)
+    {
+        FEyeMapping Mapping;
+        Mapping.OutputSize = Settings.GetEquirectResolution();
+        Mapping.EyeResolution = Mapping.OutputSize;
+        Mapping.bStereo = Settings.Mode == EOmniCaptureMode::Stereo;
+        Mapping.bSideBySide = Mapping.bStereo && Settings.StereoLayout == EOmniCaptureStereoLayout::SideBySide;
+        if (Mapping.bStereo)
+        {
+            if (Mapping.bSideBySide)
+            {
+                Mapping.EyeSplit = Mapping.OutputSize.X / 2;
+                Mapping.EyeResolution = FIntPoint(Mapping.EyeSplit, Mapping.OutputSize.Y);
+            }
+            else
+            {
+                Mapping.EyeSplit = Mapping.OutputSize.Y / 2;
+                Mapping.EyeResolution = FIntPoint(Mapping.OutputSize.X, Mapping.EyeSplit);
+            }
+        }
+
+        const double LongitudeSpan = Settings.GetLongitudeSpanRadians();
+        const double LatitudeSpan = Settings.GetLatitudeSpanRadians();
+        const bool bHalfSphere = Settings.IsVR180();
+        const float PolarDampening = Settings.PolarDampening;
+
+        FReprojectionLUTKey Key;
+        Key.Projection = static_cast<uint8>(EOmniCaptureProjection::Equirectangular);
+        Key.LongitudeSpan = LongitudeSpan;
+        Key.LatitudeSpan = LatitudeSpan;
+        Key.PolarDampening = PolarDampening;
+        Key.bHalfSphere = bHalfSphere;
+
+        auto ResolveDirection = [LongitudeSpan, LatitudeSpan, bHalfSphere, PolarDampening](const FIntPoint& EyePixel, const FIntPoint& EyeResolution, FVector& OutDirection)
+        {
+            float Latitude = 0.0f;
+            OutDirection = DirectionFromEquirectPixelCPU(EyePixel, EyeResolution, LongitudeSpan, LatitudeSpan, Latitude);
+            ApplyPolarMitigation(PolarDampening, Latitude, OutDirection);
+            return !(bHalfSphere && OutDirection.X < 0.0f);
+        };
+
+        OutOutputSize = Mapping.OutputSize;
+        return MakeGatherRow(Settings, Mapping, Key, ResolveDirection, LeftCubemap, RightCubemap, MaxWorkers);
+    }
+
+    FGatherRowFunction MakeFisheyeGatherRow(const FOmniCaptureSettings& Settings, const FOmniCaptureCPUCubemap& LeftCubemap, const FOmniCaptureCPUCubemap& RightCubemap, int32 MaxWorkers, FIntPoint& OutOutputSize)
+    {
+        const FIntPoint EyeSize = Settings.GetFisheyeResolution();
+
+        FEyeMapping Mapping;
+        Mapping.OutputSize = Settings.GetOutputResolution();
+        Mapping.EyeResolution = EyeSize;
+        Mapping.bStereo = Settings.Mode == EOmniCaptureMode::Stereo;
+        Mapping.bSideBySide = Mapping.bStereo && Settings.StereoLayout == EOmniCaptureStereoLayout::SideBySide;
+        if (Mapping.bStereo)
+        {
+            if (Mapping.bSideBySide)
+            {
+                Mapping.EyeSplit = FMath::Max(1, EyeSize.X);
+                Mapping.EyeResolution = FIntPoint(Mapping.EyeSplit, EyeSize.Y);
+            }
+            else
+            {
+                Mapping.EyeSplit = FMath::Max(1, EyeSize.Y);
+                Mapping.EyeResolution = FIntPoint(EyeSize.X, Mapping.EyeSplit);
+            }
+        }
+
+        const bool bHalfSphere = Settings.IsVR180();
+        const double FovRadians = FMath::DegreesToRadians(FMath::Clamp(Settings.FisheyeFOV, 0.0f, 360.0f));
+
+        FReprojectionLUTKey Key;
+        Key.Projection = static_cast<uint8>(EOmniCaptureProjection::Fisheye);
+        Key.FovRadians = FovRadians;
+        Key.bHalfSphere = bHalfSphere;
+
+        auto ResolveDirection = [FovRadians, bHalfSphere](const FIntPoint& EyePixel, const FIntPoint& EyeResolution, FVector& OutDirection)
+        {
+            bool bValid = false;
+            OutDirection = DirectionFromFisheyePixelCPU(EyePixel, EyeResolution, FovRadians, bValid);
+            return bValid && !(bHalfSphere && OutDirection.X < 0.0f);
+        };
+
+        OutOutputSize = Mapping.OutputSize;
+        return MakeGatherRow(Settings, Mapping, Key, ResolveDirection, LeftCubemap, RightCubemap, MaxWorkers);
+    }
+
+    /** Hands the faces to a row source and builds its gatherer over the moved faces, which then live as long as it does. */
+    template <typename MakeGatherRowType>
+    void StreamConversion(const FOmniCaptureSettings& Settings, FOmniCaptureCPUCubemap&& LeftCubemap, FOmniCaptureCPUCubemap&& RightCubemap, FOmniCaptureEquirectResult& OutResult, int32 MaxWorkers, const MakeGatherRowType& MakeGatherRowFor)
+    {
+        TSharedRef<FOmniCaptureCPURowSource, ESPMode::ThreadSafe> Source = MakeShared<FOmniCaptureCPURowSource, ESPMode::ThreadSafe>();
+        Source->LeftCubemap = MoveTemp(LeftCubemap);
+        Source->RightCubemap = MoveTemp(RightCubemap);
+        Source->MaxWorkers = MaxWorkers;
+        Source->GatherRow = MakeGatherRowFor(Settings, Source->LeftCubemap, Source->RightCubemap, MaxWorkers, Source->Size);
+
+        PrepareResult(Settings, Source->LeftCubemap, Source->Size, OutResult);
+        OutResult.PixelDataType = GetOutputPixelDataType(OutResult.bIsLinear, OutResult.PixelPrecision);
+        if (OutResult.PixelDataType == EOmniCapturePixelDataType::LinearColorFloat16)
+        {
+            OutResult.PixelPrecision = EOmniCapturePixelPrecision::HalfFloat;
+        }
+
+        Source->bIsLinear = OutResult.bIsLinear;
+        Source->PixelPrecision = OutResult.PixelPrecision;
+        Source->PixelDataType = OutResult.PixelDataType;
+        OutResult.RowSource = Source;
+    }
+}
+
+int64 FOmniCaptureCPURowSource::GetBytesPerRow() const
+{
+    switch (PixelDataType)
+    {
+    case EOmniCapturePixelDataType::LinearColorFloat32:
+        return static_cast<int64>(Size.X) * sizeof(FLinearColor);
+    case EOmniCapturePixelDataType::LinearColorFloat16:
+        return static_cast<int64>(Size.X) * sizeof(FFloat16Color);
+    default:
+        return static_cast<int64>(Size.X) * sizeof(FColor);
+    }
+}
+
+int64 FOmniCaptureCPURowSource::GetResidentBytes() const
+{
+    int64 Bytes = 0;
+    const FOmniCaptureCPUCubemap* Cubemaps[] = { &LeftCubemap, &RightCubemap };
+    for (const FOmniCaptureCPUCubemap* Cubemap : Cubemaps)
+    {
+        for (const FOmniCaptureCPUFace& Face : Cubemap->Faces)
+        {
+            Bytes += Face.Pixels.Num() * static_cast<int64>(sizeof(FLinearColor));
+            Bytes += Face.HalfPixels.Num() * static_cast<int64>(sizeof(FFloat16Color));
+        }
+    }
+    return Bytes;
+}
+
+void FOmniCaptureCPURowSource::ProduceRows(int32 RowStart, int32 RowCount, void* OutRows) const
+{
+    if (!IsValid() || !OutRows || RowStart < 0 || RowCount <= 0 || RowStart + RowCount > Size.Y)
+    {
+        return;
+    }
+
+    PackRows(GatherRow, PixelDataType, Size.X, RowStart, RowCount, OutRows, MaxWorkers);
+}
+
+int32 FOmniCaptureCPUReprojection::GetMaxWorkerCount()
+{
+    return FTaskGraphInterface::IsRunning() ? FTaskGraphInterface::Get().GetNumWorkerThreads() + 1 : 1;
+}
+
+FString FOmniCaptureCPUReprojection::GetLUTCacheDirectory()
+{
+    return FPaths::ProjectSavedDir() / TEXT("OmniCapture") / TEXT("ReprojectionCache");
+}
+
+void FOmniCaptureCPUReprojection::ResetLUTCache()
+{
+    FScopeLock Lock(&GReprojectionLUTCS);
+    GReprojectionLUTCache.Reset();
+}
+
+int32 FOmniCaptureCPUReprojection::GetCachedLUTCount()
+{
+    FScopeLock Lock(&GReprojectionLUTCS);
+    return GReprojectionLUTCache.Num();
+}
+
+void FOmniCaptureCPUReprojection::ConvertToEquirectangular(const FOmniCaptureSettings& Settings, const FOmniCaptureCPUCubemap& LeftCubemap, const FOmniCaptureCPUCubemap& RightCubemap, FOmniCaptureEquirectResult& OutResult, int32 MaxWorkers)
+{
+    FIntPoint OutputSize;
+    const FGatherRowFunction GatherRow = MakeEquirectangularGatherRow(Settings, LeftCubemap, RightCubemap, MaxWorkers, OutputSize);
+    PrepareResult(Settings, LeftCubemap, OutputSize, OutResult);
+    WriteOutput(OutputSize, GatherRow, OutResult, MaxWorkers);
+}
+
+void FOmniCaptureCPUReprojection::ConvertToFisheye(const FOmniCaptureSettings& Settings, const FOmniCaptureCPUCubemap& LeftCubemap, const FOmniCaptureCPUCubemap& RightCubemap, FOmniCaptureEquirectResult& OutResult, int32 MaxWorkers)
+{
+    FIntPoint OutputSize;
+    const FGatherRowFunction GatherRow = MakeFisheyeGatherRow(Settings, LeftCubemap, RightCubemap, MaxWorkers, OutputSize);
+    PrepareResult(Settings, LeftCubemap, OutputSize, OutResult);
+    WriteOutput(OutputSize, GatherRow, OutResult, MaxWorkers);
+}
+
+void FOmniCaptureCPUReprojection::StreamToEquirectangular(const FOmniCaptureSettings& Settings, FOmniCaptureCPUCubemap&& LeftCubemap, FOmniCaptureCPUCubemap&& RightCubemap, FOmniCaptureEquirectResult& OutResult, int32 MaxWorkers)
+{
+    StreamConversion(Settings, MoveTemp(LeftCubemap), MoveTemp(RightCubemap), OutResult, MaxWorkers, MakeEquirectangularGatherRow);
+}
+
+void FOmniCaptureCPUReprojection::StreamToFisheye(const FOmniCaptureSettings& Settings, FOmniCaptureCPUCubemap&& LeftCubemap, FOmniCaptureCPUCubemap&& RightCubemap, FOmniCaptureEquirectResult& OutResult, int32 MaxWorkers)
+{
+    StreamConversion(Settings, MoveTemp(LeftCubemap), MoveTemp(RightCubemap), OutResult, MaxWorkers, MakeFisheyeGatherRow);
+}
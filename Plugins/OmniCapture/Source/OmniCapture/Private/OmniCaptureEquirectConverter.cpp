@@ -1,7 +1,9 @@
 #include "OmniCaptureEquirectConverter.h"
+#include "OmniCaptureCPUReprojection.h"
 
 #include "OmniCaptureIncludeFixes.h" // 统一兼容：TRT2D + TRTResource
 #include "OmniCaptureTypes.h"
+#include "OmniCaptureFramePool.h"
 
 #include "GlobalShader.h"
 #include "PixelShaderUtils.h"
@@ -23,37 +25,6 @@
 
 namespace
 {
-    struct FCPUFaceData
-    {
-        int32 Resolution = 0;
-        EOmniCapturePixelPrecision Precision = EOmniCapturePixelPrecision::Unknown;
-        TArray<FLinearColor> Pixels;
-
-        bool IsValid() const
-        {
-            return Resolution > 0 && Pixels.Num() == Resolution * Resolution;
-        }
-    };
-
-    struct FCPUCubemap
-    {
-        FCPUFaceData Faces[6];
-        EOmniCapturePixelPrecision Precision = EOmniCapturePixelPrecision::Unknown;
-
-        bool IsValid() const
-        {
-            for (int32 Index = 0; Index < 6; ++Index)
-            {
-                if (!Faces[Index].IsValid())
-                {
-                    return false;
-                }
-            }
-
-            return Precision != EOmniCapturePixelPrecision::Unknown;
-        }
-    };
-
     EOmniCapturePixelPrecision PixelPrecisionFromFormat(EPixelFormat Format)
     {
         switch (Format)
@@ -236,7 +207,7 @@ namespace
 
     IMPLEMENT_GLOBAL_SHADER(FOmniConvertToBGRACS, "/Plugin/OmniCapture/Private/OmniColorConvertCS.usf", "ConvertBGRA", SF_Compute);
 
-    bool ReadFaceData(UTextureRenderTarget2D* RenderTarget, FCPUFaceData& OutFace)
+    bool ReadFaceData(UTextureRenderTarget2D* RenderTarget, FOmniCaptureCPUFace& OutFace)
     {
         if (!RenderTarget)
         {
@@ -257,6 +228,7 @@ namespace
         }
 
         OutFace.Pixels.Reset();
+        OutFace.HalfPixels.Reset();
         OutFace.Precision = PixelPrecisionFromFormat(RenderTarget->GetFormat());
 
         // Use the standard UNorm readback mode instead of the Min/Max resolve
@@ -277,25 +249,20 @@ namespace
         }
         else
         {
-            TArray<FFloat16Color> HalfPixels;
-            if (!Resource->ReadFloat16Pixels(HalfPixels, Flags, FIntRect()))
+            // Kept as read; the sampler widens texels as it touches them, so faces cost half the memory and no up-front pass.
+            if (!Resource->ReadFloat16Pixels(OutFace.HalfPixels, Flags, FIntRect()))
             {
                 return false;
             }
 
             OutFace.Precision = EOmniCapturePixelPrecision::HalfFloat;
-            OutFace.Pixels.SetNum(HalfPixels.Num());
-            for (int32 Index = 0; Index < HalfPixels.Num(); ++Index)
-            {
-                OutFace.Pixels[Index] = FLinearColor(HalfPixels[Index]);
-            }
         }
 
         OutFace.Resolution = SizeX;
         return OutFace.IsValid();
     }
 
-    bool BuildCPUCubemap(const FOmniEyeCapture& Eye, FCPUCubemap& OutCubemap)
+    bool BuildCPUCubemap(const FOmniEyeCapture& Eye, FOmniCaptureCPUCubemap& OutCubemap)
     {
         OutCubemap.Precision = EOmniCapturePixelPrecision::Unknown;
 
@@ -320,149 +287,6 @@ namespace
         return OutCubemap.IsValid();
     }
 
-    FVector DirectionFromEquirectPixelCPU(const FIntPoint& Pixel, const FIntPoint& EyeResolution, double LongitudeSpan, double LatitudeSpan, float& OutLatitude)
-    {
-        const FVector2D UV((static_cast<double>(Pixel.X) + 0.5) / EyeResolution.X, (static_cast<double>(Pixel.Y) + 0.5) / EyeResolution.Y);
-        const double Longitude = (UV.X * 2.0 - 1.0) * LongitudeSpan;
-        const double Latitude = (0.5 - UV.Y) * LatitudeSpan * 2.0;
-        OutLatitude = static_cast<float>(Latitude);
-
-        const double CosLat = FMath::Cos(Latitude);
-        const double SinLat = FMath::Sin(Latitude);
-        const double CosLon = FMath::Cos(Longitude);
-        const double SinLon = FMath::Sin(Longitude);
-
-        FVector Direction;
-        Direction.X = CosLat * CosLon;
-        Direction.Y = SinLat;
-        Direction.Z = CosLat * SinLon;
-        return Direction.GetSafeNormal();
-    }
-
-    FVector DirectionFromFisheyePixelCPU(const FIntPoint& Pixel, const FIntPoint& EyeResolution, double FovRadians, bool& bOutValid)
-    {
-        if (EyeResolution.X <= 0 || EyeResolution.Y <= 0)
-        {
-            bOutValid = false;
-            return FVector::ZeroVector;
-        }
-
-        const FVector2D UV((static_cast<double>(Pixel.X) + 0.5) / EyeResolution.X, (static_cast<double>(Pixel.Y) + 0.5) / EyeResolution.Y);
-        FVector2D Normalized = FVector2D(UV.X * 2.0 - 1.0, 1.0 - UV.Y * 2.0);
-
-        const double Radius = Normalized.Size();
-        if (Radius > 1.0)
-        {
-            bOutValid = false;
-            return FVector::ZeroVector;
-        }
-
-        const double HalfFov = FMath::Clamp(FovRadians * 0.5, 0.0, PI);
-        const double Theta = Radius * HalfFov;
-        const double Phi = FMath::Atan2(Normalized.Y, Normalized.X);
-        const double SinTheta = FMath::Sin(Theta);
-
-        FVector Direction;
-        Direction.X = FMath::Cos(Theta);
-        Direction.Y = SinTheta * FMath::Sin(Phi);
-        Direction.Z = SinTheta * FMath::Cos(Phi);
-
-        bOutValid = true;
-        return Direction.GetSafeNormal();
-    }
-
-    void DirectionToFaceUVCPU(const FVector& Direction, uint32& OutFaceIndex, FVector2D& OutUV, int32 FaceResolution, float SeamStrength)
-    {
-        const FVector AbsDir = Direction.GetAbs();
-
-        if (AbsDir.X >= AbsDir.Y && AbsDir.X >= AbsDir.Z)
-        {
-            if (Direction.X > 0.0f)
-            {
-                OutFaceIndex = 0;
-                OutUV = FVector2D(-Direction.Z, Direction.Y) / AbsDir.X;
-            }
-            else
-            {
-                OutFaceIndex = 1;
-                OutUV = FVector2D(Direction.Z, Direction.Y) / AbsDir.X;
-            }
-        }
-        else if (AbsDir.Y >= AbsDir.X && AbsDir.Y >= AbsDir.Z)
-        {
-            if (Direction.Y > 0.0f)
-            {
-                OutFaceIndex = 2;
-                OutUV = FVector2D(Direction.X, -Direction.Z) / AbsDir.Y;
-            }
-            else
-            {
-                OutFaceIndex = 3;
-                OutUV = FVector2D(Direction.X, Direction.Z) / AbsDir.Y;
-            }
-        }
-        else
-        {
-            if (Direction.Z > 0.0f)
-            {
-                OutFaceIndex = 4;
-                OutUV = FVector2D(Direction.X, Direction.Y) / AbsDir.Z;
-            }
-            else
-            {
-                OutFaceIndex = 5;
-                OutUV = FVector2D(-Direction.X, Direction.Y) / AbsDir.Z;
-            }
-        }
-
-        OutUV = (OutUV + FVector2D(1.0, 1.0)) * 0.5f;
-
-        const double Resolution = static_cast<double>(FMath::Max(1, FaceResolution));
-        const double Scale = FMath::Lerp(1.0, (Resolution - 1.0) / Resolution, SeamStrength);
-        const double Bias = (0.5 / Resolution) * SeamStrength;
-        OutUV = FVector2D(OutUV.X * Scale + Bias, OutUV.Y * Scale + Bias);
-        OutUV.X = FMath::Clamp(OutUV.X, 0.0f, 1.0f);
-        OutUV.Y = FMath::Clamp(OutUV.Y, 0.0f, 1.0f);
-    }
-
-    FLinearColor SampleCubemapCPU(const FCPUCubemap& Cubemap, const FVector& Direction, int32 FaceResolution, float SeamStrength)
-    {
-        uint32 FaceIndex = 0;
-        FVector2D FaceUV = FVector2D::ZeroVector;
-        DirectionToFaceUVCPU(Direction, FaceIndex, FaceUV, FaceResolution, SeamStrength);
-
-        const FCPUFaceData& Face = Cubemap.Faces[FaceIndex];
-        const int32 SampleX = FMath::Clamp(static_cast<int32>(FaceUV.X * (Face.Resolution - 1)), 0, Face.Resolution - 1);
-        const int32 SampleY = FMath::Clamp(static_cast<int32>(FaceUV.Y * (Face.Resolution - 1)), 0, Face.Resolution - 1);
-        const int32 SampleIndex = SampleY * Face.Resolution + SampleX;
-
-        return Face.Pixels.IsValidIndex(SampleIndex)
-            ? FLinearColor(Face.Pixels[SampleIndex])
-            : FLinearColor::Black;
-    }
-
-    void ApplyPolarMitigation(float PolarStrength, float Latitude, FVector& Direction)
-    {
-        if (PolarStrength <= 0.0f)
-        {
-            return;
-        }
-
-        double PoleFactor = FMath::Clamp(FMath::Abs(Latitude) / (PI * 0.5), 0.0, 1.0);
-        PoleFactor = FMath::Pow(PoleFactor, 4.0);
-        const double Blend = PoleFactor * PolarStrength;
-        if (Blend <= 0.0)
-        {
-            return;
-        }
-
-        const FVector PoleVector(0.0f, Latitude >= 0.0f ? 1.0f : -1.0f, 0.0f);
-        Direction = FVector(FMath::Lerp(Direction.X, PoleVector.X, Blend),
-            FMath::Lerp(Direction.Y, PoleVector.Y, Blend),
-            FMath::Lerp(Direction.Z, PoleVector.Z, Blend));
-        Direction.Normalize();
-    }
-
     void AddYUVConversionPasses(
         FRDGBuilder& GraphBuilder,
         const FOmniCaptureSettings& Settings,
@@ -750,7 +574,6 @@ namespace
             FPlatformProcess::SleepNoStats(0.001f);
         }
 
-        const uint32 PixelCount = OutputWidth * OutputHeight;
         const uint32 BytesPerPixel = Precision == EOmniCapturePixelPrecision::FullFloat ? sizeof(FLinearColor) : sizeof(FFloat16Color);
         int32 RowPitchInPixels = 0;
         const uint8* RawData = static_cast<const uint8*>(Readback.Lock(RowPitchInPixels));
@@ -762,8 +585,7 @@ namespace
             {
                 if (Precision == EOmniCapturePixelPrecision::FullFloat)
                 {
-                    TUniquePtr<TImagePixelData<FLinearColor>> PixelData = MakeUnique<TImagePixelData<FLinearColor>>(FIntPoint(OutputWidth, OutputHeight));
-                    PixelData->Pixels.SetNum(PixelCount);
+                    TUniquePtr<TImagePixelData<FLinearColor>> PixelData = FOmniCaptureFramePool::Get().AcquirePixels<FLinearColor>(FIntPoint(OutputWidth, OutputHeight));
 
                     FLinearColor* DestData = PixelData->Pixels.GetData();
                     const FLinearColor* SourcePixels = reinterpret_cast<const FLinearColor*>(RawData);
@@ -775,21 +597,10 @@ namespace
 
                     OutResult.PixelData = MoveTemp(PixelData);
                     OutResult.PixelDataType = EOmniCapturePixelDataType::LinearColorFloat32;
-
-                    OutResult.PreviewPixels.SetNum(PixelCount);
-                    const TImagePixelData<FLinearColor>* FloatData = static_cast<const TImagePixelData<FLinearColor>*>(OutResult.PixelData.Get());
-                    if (FloatData)
-                    {
-                        for (uint32 Index = 0; Index < PixelCount; ++Index)
-                        {
-                            OutResult.PreviewPixels[Index] = FloatData->Pixels[Index].ToFColor(true);
-                        }
-                    }
                 }
                 else
                 {
-                    TUniquePtr<TImagePixelData<FFloat16Color>> PixelData = MakeUnique<TImagePixelData<FFloat16Color>>(FIntPoint(OutputWidth, OutputHeight));
-                    PixelData->Pixels.SetNum(PixelCount);
+                    TUniquePtr<TImagePixelData<FFloat16Color>> PixelData = FOmniCaptureFramePool::Get().AcquirePixels<FFloat16Color>(FIntPoint(OutputWidth, OutputHeight));
 
                     FFloat16Color* DestData = PixelData->Pixels.GetData();
                     const FFloat16Color* SourcePixels = reinterpret_cast<const FFloat16Color*>(RawData);
@@ -801,25 +612,11 @@ namespace
 
                     OutResult.PixelData = MoveTemp(PixelData);
                     OutResult.PixelDataType = EOmniCapturePixelDataType::LinearColorFloat16;
-
-                    OutResult.PreviewPixels.SetNum(PixelCount);
-                    const TImagePixelData<FFloat16Color>* FloatData = static_cast<const TImagePixelData<FFloat16Color>*>(OutResult.PixelData.Get());
-                    if (FloatData)
-                    {
-                        for (uint32 Index = 0; Index < PixelCount; ++Index)
-                        {
-                            const FFloat16Color& Source = FloatData->Pixels[Index];
-                            const FLinearColor Linear(Source.R.GetFloat(), Source.G.GetFloat(), Source.B.GetFloat(), Source.A.GetFloat());
-                            OutResult.PreviewPixels[Index] = Linear.ToFColor(true);
-                        }
-                    }
                 }
             }
             else
             {
-                TUniquePtr<TImagePixelData<FColor>> PixelData = MakeUnique<TImagePixelData<FColor>>(FIntPoint(OutputWidth, OutputHeight));
-                PixelData->Pixels.SetNum(PixelCount);
-                OutResult.PreviewPixels.SetNum(PixelCount);
+                TUniquePtr<TImagePixelData<FColor>> PixelData = FOmniCaptureFramePool::Get().AcquirePixels<FColor>(FIntPoint(OutputWidth, OutputHeight));
 
                 const uint8* SourcePixels = RawData;
                 for (int32 Row = 0; Row < OutputHeight; ++Row)
@@ -839,9 +636,7 @@ namespace
                             const FFloat16Color* Pixel = reinterpret_cast<const FFloat16Color*>(SourceRow) + Column;
                             Linear = FLinearColor(Pixel->R.GetFloat(), Pixel->G.GetFloat(), Pixel->B.GetFloat(), Pixel->A.GetFloat());
                         }
-                        const FColor SRGB = Linear.ToFColor(true);
-                        DestRow[Column] = SRGB;
-                        OutResult.PreviewPixels[Row * OutputWidth + Column] = SRGB;
+                        DestRow[Column] = Linear.ToFColor(true);
                     }
                 }
 
@@ -1020,7 +815,6 @@ namespace
             FPlatformProcess::SleepNoStats(0.001f);
         }
 
-        const uint32 PixelCount = OutputSize.X * OutputSize.Y;
         const uint32 BytesPerPixel = Precision == EOmniCapturePixelPrecision::FullFloat ? sizeof(FLinearColor) : sizeof(FFloat16Color);
         int32 RowPitchInPixels = 0;
         const uint8* RawData = static_cast<const uint8*>(Readback.Lock(RowPitchInPixels));
@@ -1032,8 +826,7 @@ namespace
             {
                 if (Precision == EOmniCapturePixelPrecision::FullFloat)
                 {
-                    TUniquePtr<TImagePixelData<FLinearColor>> PixelData = MakeUnique<TImagePixelData<FLinearColor>>(OutputSize);
-                    PixelData->Pixels.SetNum(PixelCount);
+                    TUniquePtr<TImagePixelData<FLinearColor>> PixelData = FOmniCaptureFramePool::Get().AcquirePixels<FLinearColor>(OutputSize);
 
                     FLinearColor* DestData = PixelData->Pixels.GetData();
                     const FLinearColor* SourcePixels = reinterpret_cast<const FLinearColor*>(RawData);
@@ -1045,21 +838,10 @@ namespace
 
                     OutResult.PixelData = MoveTemp(PixelData);
                     OutResult.PixelDataType = EOmniCapturePixelDataType::LinearColorFloat32;
-
-                    OutResult.PreviewPixels.SetNum(PixelCount);
-                    const TImagePixelData<FLinearColor>* FloatData = static_cast<const TImagePixelData<FLinearColor>*>(OutResult.PixelData.Get());
-                    if (FloatData)
-                    {
-                        for (uint32 Index = 0; Index < PixelCount; ++Index)
-                        {
-                            OutResult.PreviewPixels[Index] = FloatData->Pixels[Index].ToFColor(true);
-                        }
-                    }
                 }
                 else
                 {
-                    TUniquePtr<TImagePixelData<FFloat16Color>> PixelData = MakeUnique<TImagePixelData<FFloat16Color>>(OutputSize);
-                    PixelData->Pixels.SetNum(PixelCount);
+                    TUniquePtr<TImagePixelData<FFloat16Color>> PixelData = FOmniCaptureFramePool::Get().AcquirePixels<FFloat16Color>(OutputSize);
 
                     FFloat16Color* DestData = PixelData->Pixels.GetData();
                     const FFloat16Color* SourcePixels = reinterpret_cast<const FFloat16Color*>(RawData);
@@ -1071,25 +853,11 @@ namespace
 
                     OutResult.PixelData = MoveTemp(PixelData);
                     OutResult.PixelDataType = EOmniCapturePixelDataType::LinearColorFloat16;
-
-                    OutResult.PreviewPixels.SetNum(PixelCount);
-                    const TImagePixelData<FFloat16Color>* FloatData = static_cast<const TImagePixelData<FFloat16Color>*>(OutResult.PixelData.Get());
-                    if (FloatData)
-                    {
-                        for (uint32 Index = 0; Index < PixelCount; ++Index)
-                        {
-                            const FFloat16Color& Source = FloatData->Pixels[Index];
-                            const FLinearColor Linear(Source.R.GetFloat(), Source.G.GetFloat(), Source.B.GetFloat(), Source.A.GetFloat());
-                            OutResult.PreviewPixels[Index] = Linear.ToFColor(true);
-                        }
-                    }
                 }
             }
             else
             {
-                TUniquePtr<TImagePixelData<FColor>> PixelData = MakeUnique<TImagePixelData<FColor>>(OutputSize);
-                PixelData->Pixels.SetNum(PixelCount);
-                OutResult.PreviewPixels.SetNum(PixelCount);
+                TUniquePtr<TImagePixelData<FColor>> PixelData = FOmniCaptureFramePool::Get().AcquirePixels<FColor>(OutputSize);
 
                 const uint8* SourcePixels = RawData;
                 for (int32 Row = 0; Row < OutputSize.Y; ++Row)
@@ -1109,9 +877,7 @@ namespace
                             const FFloat16Color* Pixel = reinterpret_cast<const FFloat16Color*>(SourceRow) + Column;
                             Linear = FLinearColor(Pixel->R.GetFloat(), Pixel->G.GetFloat(), Pixel->B.GetFloat(), Pixel->A.GetFloat());
                         }
-                        const FColor SRGB = Linear.ToFColor(true);
-                        DestRow[Column] = SRGB;
-                        OutResult.PreviewPixels[Row * OutputSize.X + Column] = SRGB;
+                        DestRow[Column] = Linear.ToFColor(true);
                     }
                 }
 
@@ -1234,15 +1000,23 @@ namespace
 
 namespace
 {
+    /** PNG and EXR sequences can take rows straight from the CPU projection; everything else needs the full frame. */
+    bool ShouldStreamCPUConversion(const FOmniCaptureSettings& Settings)
+    {
+        return Settings.bStreamCPUConversionToWriter
+            && Settings.OutputFormat == EOmniOutputFormat::ImageSequence
+            && (Settings.ImageFormat == EOmniCaptureImageFormat::PNG || Settings.ImageFormat == EOmniCaptureImageFormat::EXR);
+    }
+
     void ConvertOnCPU(const FOmniCaptureSettings& Settings, const FOmniEyeCapture& LeftEye, const FOmniEyeCapture& RightEye, FOmniCaptureEquirectResult& OutResult)
     {
-        FCPUCubemap LeftCubemap;
+        FOmniCaptureCPUCubemap LeftCubemap;
         if (!BuildCPUCubemap(LeftEye, LeftCubemap))
         {
             return;
         }
 
-        FCPUCubemap RightCubemap;
+        FOmniCaptureCPUCubemap RightCubemap;
         if (Settings.Mode == EOmniCaptureMode::Stereo)
         {
             if (!BuildCPUCubemap(RightEye, RightCubemap))
@@ -1251,120 +1025,24 @@ namespace
             }
         }
 
-        const bool bStereo = Settings.Mode == EOmniCaptureMode::Stereo;
-        const bool bSideBySide = bStereo && Settings.StereoLayout == EOmniCaptureStereoLayout::SideBySide;
-        const int32 FaceResolution = LeftCubemap.Faces[0].Resolution;
-        const FIntPoint OutputSize = Settings.GetEquirectResolution();
-        const int32 OutputWidth = OutputSize.X;
-        const int32 OutputHeight = OutputSize.Y;
-        const double LongitudeSpan = Settings.GetLongitudeSpanRadians();
-        const double LatitudeSpan = Settings.GetLatitudeSpanRadians();
-        const bool bHalfSphere = Settings.IsVR180();
-
-        OutResult.Size = FIntPoint(OutputWidth, OutputHeight);
-        OutResult.bIsLinear = Settings.Gamma == EOmniCaptureGamma::Linear;
-        OutResult.bUsedCPUFallback = true;
-        OutResult.OutputTarget.SafeRelease();
-        OutResult.Texture.SafeRelease();
-        OutResult.ReadyFence.SafeRelease();
-        OutResult.EncoderPlanes.Reset();
-
-        const int32 PixelCount = OutputWidth * OutputHeight;
-        OutResult.PreviewPixels.SetNum(PixelCount);
-        OutResult.PixelPrecision = LeftCubemap.Precision;
-
-        auto ProcessPixel = [&](auto& PixelArray, auto ConvertColor)
-        {
-            for (int32 Y = 0; Y < OutputHeight; ++Y)
-            {
-                for (int32 X = 0; X < OutputWidth; ++X)
-                {
-                    const int32 Index = Y * OutputWidth + X;
-
-                    FIntPoint EyePixel(X, Y);
-                    FIntPoint EyeResolution(OutputWidth, OutputHeight);
-                    bool bRightEye = false;
-
-                    if (bStereo)
-                    {
-                        if (bSideBySide)
-                        {
-                            const int32 EyeWidth = OutputWidth / 2;
-                            bRightEye = X >= EyeWidth;
-                            EyePixel.X = X % EyeWidth;
-                            EyeResolution = FIntPoint(EyeWidth, OutputHeight);
-                        }
-                        else
-                        {
-                            const int32 EyeHeight = OutputHeight / 2;
-                            bRightEye = Y >= EyeHeight;
-                            EyePixel.Y = Y % EyeHeight;
-                            EyeResolution = FIntPoint(OutputWidth, EyeHeight);
-                        }
-                    }
-
-                    float Latitude = 0.0f;
-                    FVector Direction = DirectionFromEquirectPixelCPU(EyePixel, EyeResolution, LongitudeSpan, LatitudeSpan, Latitude);
-                    ApplyPolarMitigation(Settings.PolarDampening, Latitude, Direction);
-
-                    if (bHalfSphere && Direction.X < 0.0f)
-                    {
-                        PixelArray[Index] = ConvertColor(FLinearColor::Transparent);
-                        OutResult.PreviewPixels[Index] = FColor::Transparent;
-                        continue;
-                    }
-
-                    const FLinearColor LinearColor = SampleCubemapCPU(
-                        (bStereo && bRightEye) ? RightCubemap : LeftCubemap,
-                        Direction,
-                        FaceResolution,
-                        Settings.SeamBlend);
-
-                    PixelArray[Index] = ConvertColor(LinearColor);
-                    OutResult.PreviewPixels[Index] = LinearColor.ToFColor(true);
-                }
-            }
-        };
-
-        if (OutResult.bIsLinear)
+        if (ShouldStreamCPUConversion(Settings))
         {
-            if (OutResult.PixelPrecision == EOmniCapturePixelPrecision::FullFloat)
-            {
-                TUniquePtr<TImagePixelData<FLinearColor>> PixelData = MakeUnique<TImagePixelData<FLinearColor>>(OutResult.Size);
-                PixelData->Pixels.SetNum(PixelCount);
-                ProcessPixel(PixelData->Pixels, [](const FLinearColor& Linear) { return Linear; });
-                OutResult.PixelData = MoveTemp(PixelData);
-                OutResult.PixelDataType = EOmniCapturePixelDataType::LinearColorFloat32;
-            }
-            else
-            {
-                OutResult.PixelPrecision = EOmniCapturePixelPrecision::HalfFloat;
-                TUniquePtr<TImagePixelData<FFloat16Color>> PixelData = MakeUnique<TImagePixelData<FFloat16Color>>(OutResult.Size);
-                PixelData->Pixels.SetNum(PixelCount);
-                ProcessPixel(PixelData->Pixels, [](const FLinearColor& Linear) { return FFloat16Color(Linear); });
-                OutResult.PixelData = MoveTemp(PixelData);
-                OutResult.PixelDataType = EOmniCapturePixelDataType::LinearColorFloat16;
-            }
-        }
-        else
-        {
-            TUniquePtr<TImagePixelData<FColor>> PixelData = MakeUnique<TImagePixelData<FColor>>(OutResult.Size);
-            PixelData->Pixels.SetNum(PixelCount);
-            ProcessPixel(PixelData->Pixels, [](const FLinearColor& Linear) { return Linear.ToFColor(true); });
-            OutResult.PixelData = MoveTemp(PixelData);
-            OutResult.PixelDataType = EOmniCapturePixelDataType::Color8;
+            FOmniCaptureCPUReprojection::StreamToEquirectangular(Settings, MoveTemp(LeftCubemap), MoveTemp(RightCubemap), OutResult);
+            return;
         }
+
+        FOmniCaptureCPUReprojection::ConvertToEquirectangular(Settings, LeftCubemap, RightCubemap, OutResult);
     }
 
     void ConvertFisheyeOnCPU(const FOmniCaptureSettings& Settings, const FOmniEyeCapture& LeftEye, const FOmniEyeCapture& RightEye, FOmniCaptureEquirectResult& OutResult)
     {
-        FCPUCubemap LeftCubemap;
+        FOmniCaptureCPUCubemap LeftCubemap;
         if (!BuildCPUCubemap(LeftEye, LeftCubemap))
         {
             return;
         }
 
-        FCPUCubemap RightCubemap;
+        FOmniCaptureCPUCubemap RightCubemap;
         if (Settings.Mode == EOmniCaptureMode::Stereo)
         {
             if (!BuildCPUCubemap(RightEye, RightCubemap))
@@ -1373,112 +1051,13 @@ namespace
             }
         }
 
-        const bool bStereo = Settings.Mode == EOmniCaptureMode::Stereo;
-        const bool bSideBySide = bStereo && Settings.StereoLayout == EOmniCaptureStereoLayout::SideBySide;
-        const int32 FaceResolution = LeftCubemap.Faces[0].Resolution;
-        const FIntPoint OutputSize = Settings.GetOutputResolution();
-        const FIntPoint EyeSize = Settings.GetFisheyeResolution();
-        const bool bHalfSphere = Settings.IsVR180();
-        const double FovRadians = FMath::DegreesToRadians(FMath::Clamp(Settings.FisheyeFOV, 0.0f, 360.0f));
-
-        OutResult.Size = OutputSize;
-        OutResult.bIsLinear = Settings.Gamma == EOmniCaptureGamma::Linear;
-        OutResult.bUsedCPUFallback = true;
-        OutResult.OutputTarget.SafeRelease();
-        OutResult.Texture.SafeRelease();
-        OutResult.ReadyFence.SafeRelease();
-        OutResult.EncoderPlanes.Reset();
-
-        const int32 PixelCount = OutputSize.X * OutputSize.Y;
-        OutResult.PreviewPixels.SetNum(PixelCount);
-        OutResult.PixelPrecision = LeftCubemap.Precision;
-
-        auto ProcessPixel = [&](auto& PixelArray, auto ConvertColor)
+        if (ShouldStreamCPUConversion(Settings))
         {
-            for (int32 Y = 0; Y < OutputSize.Y; ++Y)
-            {
-                for (int32 X = 0; X < OutputSize.X; ++X)
-                {
-                    const int32 Index = Y * OutputSize.X + X;
-
-                    FIntPoint EyePixel(X, Y);
-                    FIntPoint EyeResolution = EyeSize;
-                    bool bRightEye = false;
-
-                    if (bStereo)
-                    {
-                        if (bSideBySide)
-                        {
-                            const int32 EyeWidth = FMath::Max(1, EyeSize.X);
-                            bRightEye = X >= EyeWidth;
-                            EyePixel.X = X % EyeWidth;
-                            EyeResolution = FIntPoint(EyeWidth, EyeSize.Y);
-                        }
-                        else
-                        {
-                            const int32 EyeHeight = FMath::Max(1, EyeSize.Y);
-                            bRightEye = Y >= EyeHeight;
-                            EyePixel.Y = Y % EyeHeight;
-                            EyeResolution = FIntPoint(EyeSize.X, EyeHeight);
-                        }
-                    }
-
-                    bool bValid = false;
-                    FVector Direction = DirectionFromFisheyePixelCPU(EyePixel, EyeResolution, FovRadians, bValid);
-                    if (!bValid)
-                    {
-                        PixelArray[Index] = ConvertColor(FLinearColor::Transparent);
-                        OutResult.PreviewPixels[Index] = FColor::Transparent;
-                        continue;
-                    }
-
-                    if (bHalfSphere && Direction.X < 0.0f)
-                    {
-                        PixelArray[Index] = ConvertColor(FLinearColor::Transparent);
-                        OutResult.PreviewPixels[Index] = FColor::Transparent;
-                        continue;
-                    }
-
-                    const FLinearColor LinearColor = SampleCubemapCPU(
-                        (bStereo && bRightEye) ? RightCubemap : LeftCubemap,
-                        Direction,
-                        FaceResolution,
-                        Settings.SeamBlend);
-
-                    PixelArray[Index] = ConvertColor(LinearColor);
-                    OutResult.PreviewPixels[Index] = LinearColor.ToFColor(true);
-                }
-            }
-        };
-
-        if (OutResult.bIsLinear)
-        {
-            if (OutResult.PixelPrecision == EOmniCapturePixelPrecision::FullFloat)
-            {
-                TUniquePtr<TImagePixelData<FLinearColor>> PixelData = MakeUnique<TImagePixelData<FLinearColor>>(OutputSize);
-                PixelData->Pixels.SetNum(PixelCount);
-                ProcessPixel(PixelData->Pixels, [](const FLinearColor& Linear) { return Linear; });
-                OutResult.PixelData = MoveTemp(PixelData);
-                OutResult.PixelDataType = EOmniCapturePixelDataType::LinearColorFloat32;
-            }
-            else
-            {
-                OutResult.PixelPrecision = EOmniCapturePixelPrecision::HalfFloat;
-                TUniquePtr<TImagePixelData<FFloat16Color>> PixelData = MakeUnique<TImagePixelData<FFloat16Color>>(OutputSize);
-                PixelData->Pixels.SetNum(PixelCount);
-                ProcessPixel(PixelData->Pixels, [](const FLinearColor& Linear) { return FFloat16Color(Linear); });
-                OutResult.PixelData = MoveTemp(PixelData);
-                OutResult.PixelDataType = EOmniCapturePixelDataType::LinearColorFloat16;
-            }
-        }
-        else
-        {
-            TUniquePtr<TImagePixelData<FColor>> PixelData = MakeUnique<TImagePixelData<FColor>>(OutputSize);
-            PixelData->Pixels.SetNum(PixelCount);
-            ProcessPixel(PixelData->Pixels, [](const FLinearColor& Linear) { return Linear.ToFColor(true); });
-            OutResult.PixelData = MoveTemp(PixelData);
-            OutResult.PixelDataType = EOmniCapturePixelDataType::Color8;
+            FOmniCaptureCPUReprojection::StreamToFisheye(Settings, MoveTemp(LeftCubemap), MoveTemp(RightCubemap), OutResult);
+            return;
         }
+
+        FOmniCaptureCPUReprojection::ConvertToFisheye(Settings, LeftCubemap, RightCubemap, OutResult);
     }
 }
 
@@ -1679,8 +1258,6 @@ FOmniCaptureEquirectResult FOmniCaptureEquirectConverter::ConvertToPlanar(const
     Result.OutputTarget.SafeRelease();
     Result.GPUSource.SafeRelease();
 
-    const int32 PixelCount = OutputSize.X * OutputSize.Y;
-
     if (Result.bIsLinear)
     {
         TUniquePtr<TImagePixelData<FFloat16Color>> PixelData = MakeUnique<TImagePixelData<FFloat16Color>>(OutputSize);
@@ -1716,36 +1293,9 @@ FOmniCaptureEquirectResult FOmniCaptureEquirectConverter::ConvertToPlanar(const
 
     if (!Result.PixelData.IsValid())
     {
-        Result.PreviewPixels.Reset();
         return Result;
     }
 
-    Result.PreviewPixels.SetNum(PixelCount);
-    if (Result.bIsLinear)
-    {
-        const TImagePixelData<FFloat16Color>* FloatData = static_cast<const TImagePixelData<FFloat16Color>*>(Result.PixelData.Get());
-        if (FloatData)
-        {
-            for (int32 Index = 0; Index < PixelCount; ++Index)
-            {
-                Result.PreviewPixels[Index] = FLinearColor(FloatData->Pixels[Index]).ToFColor(true);
-            }
-        }
-    }
-    else
-    {
-        const TImagePixelData<FColor>* ColorData = static_cast<const TImagePixelData<FColor>*>(Result.PixelData.Get());
-        if (ColorData)
-        {
-            Result.PreviewPixels = ColorData->Pixels;
-        }
-    }
-
-    if (Result.PreviewPixels.Num() != PixelCount)
-    {
-        Result.PreviewPixels.Init(FColor::Black, PixelCount);
-    }
-
     Result.Texture = Resource->GetRenderTargetTexture();
 
     if (Result.Texture.IsValid() && Settings.OutputFormat == EOmniOutputFormat::NVENCHardware)
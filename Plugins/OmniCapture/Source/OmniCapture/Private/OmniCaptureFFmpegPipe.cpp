@@ -0,0 +1,375 @@
+#include "OmniCaptureFFmpegPipe.h"
+
+#include "HAL/Event.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Guid.h"
+#include "OmniCaptureWorkerPool.h"
+
+#if PLATFORM_WINDOWS
+#include "Windows/AllowWindowsPlatformTypes.h"
+#include "Windows/WindowsHWrapper.h"
+#include "Windows/HideWindowsPlatformTypes.h"
+#endif
+
+namespace
+{
+    constexpr int64 GPipeChunkBytes = 1024 * 1024;
+    constexpr uint32 GAudioPipeBufferBytes = 256 * 1024;
+    constexpr uint32 GSpaceWaitMilliseconds = 50;
+
+#if PLATFORM_WINDOWS
+    /** An outbound named pipe for a single reader; ffmpeg opens it like any other input file. */
+    void* CreateAudioPipe(const FString& Path)
+    {
+        HANDLE Pipe = ::CreateNamedPipeW(*Path, PIPE_ACCESS_OUTBOUND, PIPE_TYPE_BYTE | PIPE_WAIT, 1, GAudioPipeBufferBytes, 0, 0, nullptr);
+        return Pipe != INVALID_HANDLE_VALUE ? Pipe : nullptr;
+    }
+
+    bool ConnectAudioPipe(void* Pipe)
+    {
+        return ::ConnectNamedPipe(Pipe, nullptr) || ::GetLastError() == ERROR_PIPE_CONNECTED;
+    }
+
+    /** Releases a ConnectAudioPipe still waiting for a reader that is never coming. */
+    void UnblockAudioPipe(const FString& Path)
+    {
+        HANDLE Client = ::CreateFileW(*Path, GENERIC_READ, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+        if (Client != INVALID_HANDLE_VALUE)
+        {
+            ::CloseHandle(Client);
+        }
+    }
+
+    bool WriteAudioPipe(void* Pipe, const uint8* Data, int64 Size)
+    {
+        while (Size > 0)
+        {
+            DWORD Written = 0;
+            if (!::WriteFile(Pipe, Data, static_cast<DWORD>(FMath::Min(Size, GPipeChunkBytes)), &Written, nullptr) || Written == 0)
+            {
+                return false;
+            }
+            Data += Written;
+            Size -= Written;
+        }
+        return true;
+    }
+
+    void CloseAudioPipe(void* Pipe)
+    {
+        // Closing rather than disconnecting lets the reader drain what is still buffered before it sees end of file.
+        ::FlushFileBuffers(Pipe);
+        ::CloseHandle(Pipe);
+    }
+#else
+    void* CreateAudioPipe(const FString& Path)
+    {
+        return nullptr;
+    }
+
+    bool ConnectAudioPipe(void* Pipe)
+    {
+        return false;
+    }
+
+    void UnblockAudioPipe(const FString& Path)
+    {
+    }
+
+    bool WriteAudioPipe(void* Pipe, const uint8* Data, int64 Size)
+    {
+        return false;
+    }
+
+    void CloseAudioPipe(void* Pipe)
+    {
+    }
+#endif
+}
+
+/** One of ffmpeg's inputs: a single writer thread working through queued buffers in push order. */
+struct FOmniCaptureFFmpegPipeInput
+{
+    FOmniCaptureFFmpegPipeInput()
+    {
+        SpaceEvent = FPlatformProcess::GetSynchEventFromPool();
+    }
+
+    ~FOmniCaptureFFmpegPipeInput()
+    {
+        Writer.Stop();
+        FPlatformProcess::ReturnSynchEventToPool(SpaceEvent);
+    }
+
+    FOmniCaptureWorkerPool Writer;
+    TFunction<bool(const uint8* Data, int64 Size)> Write;
+    TAtomic<int64> QueuedBytes { 0 };
+    TAtomic<bool> bBroken { false };
+    FEvent* SpaceEvent = nullptr;
+
+    /** Named audio pipe only. */
+    FString PipePath;
+    void* PipeHandle = nullptr;
+    TAtomic<bool> bConnected { false };
+};
+
+FOmniCaptureFFmpegPipe::FOmniCaptureFFmpegPipe()
+{
+}
+
+FOmniCaptureFFmpegPipe::~FOmniCaptureFFmpegPipe()
+{
+    Finish();
+}
+
+bool FOmniCaptureFFmpegPipe::Start(const FString& Binary, const FString& Arguments, const FString& WorkingDirectory, bool bWithAudio, int64 InMaxQueuedBytes)
+{
+    Finish();
+
+    MaxQueuedBytes = FMath::Max<int64>(GPipeChunkBytes, InMaxQueuedBytes);
+    {
+        FScopeLock Lock(&StatsCS);
+        Stats = FOmniCaptureFFmpegPipeStats();
+    }
+
+    FString CommandLine = Arguments;
+    if (bWithAudio)
+    {
+        AudioInput = MakeUnique<FOmniCaptureFFmpegPipeInput>();
+        AudioInput->PipePath = FString::Printf(TEXT("\\\\.\\pipe\\OmniCapture_%s"), *FGuid::NewGuid().ToString(EGuidFormats::Digits));
+        AudioInput->PipeHandle = CreateAudioPipe(AudioInput->PipePath);
+        if (!AudioInput->PipeHandle)
+        {
+            UE_LOG(LogTemp, Warning, TEXT("OmniCapture could not create the FFmpeg audio pipe %s."), *AudioInput->PipePath);
+            AudioInput.Reset();
+            return false;
+        }
+        CommandLine.ReplaceInline(GetAudioPipeToken(), *AudioInput->PipePath);
+    }
+
+    if (!FPlatformProcess::CreatePipe(StdInRead, StdInWrite, true))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Failed to create the FFmpeg input pipe."));
+        if (AudioInput.IsValid())
+        {
+            CloseAudioPipe(AudioInput->PipeHandle);
+            AudioInput.Reset();
+        }
+        return false;
+    }
+
+    UE_LOG(LogTemp, Log, TEXT("Starting live FFmpeg encode: %s %s"), *Binary, *CommandLine);
+    ProcHandle = FPlatformProcess::CreateProc(*Binary, *CommandLine, true, true, true, nullptr, 0, WorkingDirectory.IsEmpty() ? nullptr : *WorkingDirectory, nullptr, StdInRead);
+    if (!ProcHandle.IsValid())
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Failed to launch FFmpeg process."));
+        FPlatformProcess::ClosePipe(StdInRead, StdInWrite);
+        StdInRead = StdInWrite = nullptr;
+        if (AudioInput.IsValid())
+        {
+            CloseAudioPipe(AudioInput->PipeHandle);
+            AudioInput.Reset();
+        }
+        return false;
+    }
+
+    VideoInput = MakeUnique<FOmniCaptureFFmpegPipeInput>();
+    VideoInput->Write = [this](const uint8* Data, int64 Size)
+    {
+        while (Size > 0)
+        {
+            int32 Written = 0;
+            FPlatformProcess::WritePipe(StdInWrite, Data, static_cast<int32>(FMath::Min(Size, GPipeChunkBytes)), &Written);
+            if (Written <= 0)
+            {
+                if (!IsProcessRunning())
+                {
+                    return false;
+                }
+                FPlatformProcess::Sleep(0.001f);
+                continue;
+            }
+            Data += Written;
+            Size -= Written;
+        }
+        return true;
+    };
+    VideoInput->Writer.Start(TEXT("OmniCaptureFFmpegVideo"), 1);
+
+    if (AudioInput.IsValid())
+    {
+        FOmniCaptureFFmpegPipeInput& Audio = *AudioInput;
+        Audio.Write = [&Audio](const uint8* Data, int64 Size)
+        {
+            return WriteAudioPipe(Audio.PipeHandle, Data, Size);
+        };
+        Audio.Writer.Start(TEXT("OmniCaptureFFmpegAudio"), 1);
+        // ffmpeg opens its inputs one after another, so the audio pipe connects once it has probed the video on stdin.
+        Audio.Writer.Enqueue([&Audio]()
+        {
+            Audio.bConnected = ConnectAudioPipe(Audio.PipeHandle);
+            if (!Audio.bConnected.Load())
+            {
+                Audio.bBroken = true;
+            }
+        });
+    }
+
+    bStarted = true;
+    return true;
+}
+
+bool FOmniCaptureFFmpegPipe::PushVideo(TArray64<uint8>&& Bytes)
+{
+    if (!VideoInput.IsValid())
+    {
+        return false;
+    }
+
+    const int64 Size = Bytes.Num();
+    const bool bPushed = Push(*VideoInput, MoveTemp(Bytes));
+    if (bPushed)
+    {
+        FScopeLock Lock(&StatsCS);
+        ++Stats.VideoPushes;
+        Stats.VideoBytes += Size;
+    }
+    return bPushed;
+}
+
+bool FOmniCaptureFFmpegPipe::PushAudio(TArray64<uint8>&& Bytes)
+{
+    if (!AudioInput.IsValid())
+    {
+        return false;
+    }
+
+    const int64 Size = Bytes.Num();
+    const bool bPushed = Push(*AudioInput, MoveTemp(Bytes));
+    if (bPushed)
+    {
+        FScopeLock Lock(&StatsCS);
+        Stats.AudioBytes += Size;
+    }
+    return bPushed;
+}
+
+bool FOmniCaptureFFmpegPipe::Push(FOmniCaptureFFmpegPipeInput& Input, TArray64<uint8>&& Bytes)
+{
+    const int64 Size = Bytes.Num();
+    if (!bStarted || Input.bBroken.Load() || Size == 0)
+    {
+        if (Size > 0)
+        {
+            FScopeLock Lock(&StatsCS);
+            ++Stats.DroppedPushes;
+        }
+        return Size == 0;
+    }
+
+    // One buffer is always let through, so a single frame larger than the limit still moves.
+    if (Input.QueuedBytes.Load() > 0 && Input.QueuedBytes.Load() + Size > MaxQueuedBytes)
+    {
+        const double WaitStart = FPlatformTime::Seconds();
+        while (Input.QueuedBytes.Load() > 0 && Input.QueuedBytes.Load() + Size > MaxQueuedBytes && !Input.bBroken.Load())
+        {
+            if (!IsProcessRunning())
+            {
+                Input.bBroken = true;
+                break;
+            }
+            Input.SpaceEvent->Wait(GSpaceWaitMilliseconds);
+        }
+
+        FScopeLock Lock(&StatsCS);
+        ++Stats.BlockedPushes;
+        Stats.BlockedSeconds += FPlatformTime::Seconds() - WaitStart;
+    }
+
+    if (Input.bBroken.Load())
+    {
+        FScopeLock Lock(&StatsCS);
+        ++Stats.DroppedPushes;
+        return false;
+    }
+
+    Input.QueuedBytes.AddExchange(Size);
+    Input.Writer.Enqueue([&Input, Bytes = MoveTemp(Bytes)]()
+    {
+        if (!Input.bBroken.Load() && !Input.Write(Bytes.GetData(), Bytes.Num()))
+        {
+            UE_LOG(LogTemp, Warning, TEXT("FFmpeg stopped reading one of its inputs; further frames are dropped."));
+            Input.bBroken = true;
+        }
+        Input.QueuedBytes.SubExchange(Bytes.Num());
+        Input.SpaceEvent->Trigger();
+    });
+    return true;
+}
+
+int32 FOmniCaptureFFmpegPipe::Finish()
+{
+    if (!bStarted)
+    {
+        return INDEX_NONE;
+    }
+    bStarted = false;
+
+    // Each input is closed as soon as its own queue is empty: ffmpeg may be blocked reading one until the other ends,
+    // so neither can wait for both. An exited ffmpeg reads nothing more, and whatever is still queued is dropped.
+    while (VideoInput.IsValid() || AudioInput.IsValid())
+    {
+        const bool bRunning = IsProcessRunning();
+        if (VideoInput.IsValid() && (VideoInput->QueuedBytes.Load() == 0 || VideoInput->bBroken.Load() || !bRunning))
+        {
+            VideoInput->bBroken = VideoInput->bBroken.Load() || !bRunning;
+            VideoInput->Writer.Stop();
+            VideoInput.Reset();
+            // Closing stdin is ffmpeg's end of video.
+            FPlatformProcess::ClosePipe(StdInRead, StdInWrite);
+            StdInRead = StdInWrite = nullptr;
+        }
+
+        // The audio pipe has to be opened by ffmpeg before it is closed here, or ffmpeg would fail to find it.
+        if (AudioInput.IsValid() && ((AudioInput->bConnected.Load() && AudioInput->QueuedBytes.Load() == 0) || AudioInput->bBroken.Load() || !bRunning))
+        {
+            FOmniCaptureFFmpegPipeInput& Audio = *AudioInput;
+            if (!Audio.bConnected.Load())
+            {
+                Audio.bBroken = true;
+                UnblockAudioPipe(Audio.PipePath);
+            }
+            Audio.bBroken = Audio.bBroken.Load() || !bRunning;
+            Audio.Writer.Stop();
+            CloseAudioPipe(Audio.PipeHandle);
+            AudioInput.Reset();
+        }
+
+        if (VideoInput.IsValid())
+        {
+            VideoInput->SpaceEvent->Wait(GSpaceWaitMilliseconds);
+        }
+        else if (AudioInput.IsValid())
+        {
+            AudioInput->SpaceEvent->Wait(GSpaceWaitMilliseconds);
+        }
+    }
+
+    FPlatformProcess::WaitForProc(ProcHandle);
+    int32 ReturnCode = 0;
+    FPlatformProcess::GetProcReturnCode(ProcHandle, &ReturnCode);
+    FPlatformProcess::CloseProc(ProcHandle);
+    return ReturnCode;
+}
+
+FOmniCaptureFFmpegPipeStats FOmniCaptureFFmpegPipe::GetStats() const
+{
+    FScopeLock Lock(&StatsCS);
+    return Stats;
+}
+
+bool FOmniCaptureFFmpegPipe::IsProcessRunning() const
+{
+    FProcHandle Handle = ProcHandle;
+    return Handle.IsValid() && FPlatformProcess::IsProcRunning(Handle);
+}
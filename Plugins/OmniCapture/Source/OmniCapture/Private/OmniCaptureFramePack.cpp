@@ -0,0 +1,502 @@
+#include "OmniCaptureFramePack.h"
+
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace
+{
+    constexpr uint32 GPackMagic = 0x4B504D4F; // "OMPK"
+    constexpr uint32 GChunkMagic = 0x43504D4F; // "OMPC"
+    constexpr uint32 GIndexMagic = 0x49504D4F; // "OMPI"
+    /** Version 2 added reference chunks; a version 1 pack is a version 2 pack without any. */
+    constexpr uint16 GPackVersion = 2;
+    constexpr uint16 GMinPackVersion = 1;
+    constexpr int64 GHeaderBytes = 32;
+    constexpr int64 GChunkHeaderBytes = 20;
+    constexpr uint8 GPrimaryFlag = 1;
+    /** The payload is the offset and size of an earlier chunk's payload rather than file bytes. */
+    constexpr uint8 GReferenceFlag = 2;
+    constexpr int64 GReferencePayloadBytes = 16;
+
+    struct FPackHeader
+    {
+        uint32 Magic = GPackMagic;
+        uint16 Version = GPackVersion;
+        uint16 HeaderBytes = static_cast<uint16>(GHeaderBytes);
+        /** 0 until the pack is closed. */
+        int64 IndexOffset = 0;
+        int64 IndexBytes = 0;
+        int64 Reserved = 0;
+
+        friend FArchive& operator<<(FArchive& Ar, FPackHeader& Header)
+        {
+            Ar << Header.Magic << Header.Version << Header.HeaderBytes << Header.IndexOffset << Header.IndexBytes << Header.Reserved;
+            return Ar;
+        }
+    };
+
+    struct FChunkHeader
+    {
+        uint32 Magic = GChunkMagic;
+        int32 FrameIndex = INDEX_NONE;
+        uint8 Flags = 0;
+        uint8 Padding = 0;
+        uint16 NameBytes = 0;
+        int64 PayloadBytes = 0;
+
+        friend FArchive& operator<<(FArchive& Ar, FChunkHeader& Header)
+        {
+            Ar << Header.Magic << Header.FrameIndex << Header.Flags << Header.Padding << Header.NameBytes << Header.PayloadBytes;
+            return Ar;
+        }
+    };
+
+    FString DecodeName(const uint8* Bytes, int32 Length)
+    {
+        const FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(Bytes), Length);
+        return FString(Converted.Length(), Converted.Get());
+    }
+
+    bool ReadBytes(IFileHandle& Handle, int64 Offset, int64 Length, TArray<uint8>& Out)
+    {
+        Out.SetNumUninitialized(static_cast<int32>(Length));
+        return Handle.Seek(Offset) && Handle.Read(Out.GetData(), Length);
+    }
+}
+
+FOmniCaptureFramePackWriter::~FOmniCaptureFramePackWriter()
+{
+    Close();
+}
+
+bool FOmniCaptureFramePackWriter::Open(const FString& InFilePath, int64 PreallocateBytes)
+{
+    Close();
+
+    FScopeLock Lock(&WriteCS);
+    FilePath = InFilePath;
+    IFileManager::Get().MakeDirectory(*FPaths::GetPath(FilePath), true);
+    Handle.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*FilePath, false, true));
+    if (!Handle.IsValid())
+    {
+        UE_LOG(LogTemp, Warning, TEXT("OmniCapture could not create frame pack '%s'"), *FilePath);
+        return false;
+    }
+
+    Entries.Reset();
+    EntryByName.Reset();
+    bFailed = false;
+    GrowBytes = FMath::Max<int64>(0, PreallocateBytes);
+    AllocatedBytes = 0;
+
+    TArray<uint8> HeaderBytes;
+    FMemoryWriter Writer(HeaderBytes);
+    FPackHeader Header;
+    Writer << Header;
+    if (!EnsureCapacity(GHeaderBytes) || !Handle->Seek(0) || !Handle->Write(HeaderBytes.GetData(), HeaderBytes.Num()))
+    {
+        Handle.Reset();
+        return false;
+    }
+
+    WriteOffset = GHeaderBytes;
+    BytesWritten = WriteOffset;
+    return true;
+}
+
+bool FOmniCaptureFramePackWriter::Append(int32 FrameIndex, const FString& Name, bool bPrimary, const uint8* Data, int64 Size)
+{
+    FScopeLock Lock(&WriteCS);
+    int64 PayloadOffset = 0;
+    if (!WriteChunk(FrameIndex, Name, bPrimary ? GPrimaryFlag : 0, Data, Size, PayloadOffset))
+    {
+        return false;
+    }
+
+    AddEntry(FrameIndex, Name, bPrimary, PayloadOffset, Size);
+    return true;
+}
+
+bool FOmniCaptureFramePackWriter::AppendReference(int32 FrameIndex, const FString& Name, bool bPrimary, const FString& SourceName)
+{
+    FScopeLock Lock(&WriteCS);
+    const int32* SourceIndex = EntryByName.Find(SourceName);
+    if (!SourceIndex)
+    {
+        return false;
+    }
+
+    int64 TargetOffset = Entries[*SourceIndex].Offset;
+    int64 TargetSize = Entries[*SourceIndex].Size;
+    TArray<uint8> Payload;
+    FMemoryWriter Writer(Payload);
+    Writer << TargetOffset << TargetSize;
+
+    int64 PayloadOffset = 0;
+    if (!WriteChunk(FrameIndex, Name, (bPrimary ? GPrimaryFlag : 0) | GReferenceFlag, Payload.GetData(), Payload.Num(), PayloadOffset))
+    {
+        return false;
+    }
+
+    // The index has no notion of references: the entry simply points at the source's bytes.
+    AddEntry(FrameIndex, Name, bPrimary, TargetOffset, TargetSize);
+    return true;
+}
+
+bool FOmniCaptureFramePackWriter::Close()
+{
+    FScopeLock Lock(&WriteCS);
+    if (!Handle.IsValid())
+    {
+        return false;
+    }
+
+    TArray<uint8> IndexBytes;
+    FMemoryWriter Writer(IndexBytes);
+    uint32 IndexMagic = GIndexMagic;
+    int32 EntryCount = Entries.Num();
+    Writer << IndexMagic << EntryCount;
+    for (FOmniCaptureFramePackEntry& Entry : Entries)
+    {
+        const FTCHARToUTF8 NameUtf8(*Entry.Name);
+        uint8 Flags = Entry.bPrimary ? GPrimaryFlag : 0;
+        uint16 NameBytes = static_cast<uint16>(FMath::Min(NameUtf8.Length(), static_cast<int32>(MAX_uint16)));
+        Writer << Entry.FrameIndex << Flags << NameBytes;
+        Writer.Serialize(const_cast<ANSICHAR*>(NameUtf8.Get()), NameBytes);
+        Writer << Entry.Offset << Entry.Size;
+    }
+
+    FPackHeader Header;
+    Header.IndexOffset = WriteOffset;
+    Header.IndexBytes = IndexBytes.Num();
+    TArray<uint8> HeaderBytes;
+    FMemoryWriter HeaderWriter(HeaderBytes);
+    HeaderWriter << Header;
+
+    // Without an index the chunks are still readable, so a failed append leaves the pack to recovery rather than pointing at a torn tail.
+    bool bWritten = !bFailed
+        && Handle->Seek(WriteOffset)
+        && Handle->Write(IndexBytes.GetData(), IndexBytes.Num())
+        && Handle->Seek(0)
+        && Handle->Write(HeaderBytes.GetData(), HeaderBytes.Num());
+    const int64 FinalSize = bWritten ? WriteOffset + IndexBytes.Num() : WriteOffset;
+    if (AllocatedBytes > FinalSize)
+    {
+        bWritten &= Handle->Truncate(FinalSize);
+    }
+    bWritten &= Handle->Flush();
+    Handle.Reset();
+
+    BytesWritten = FinalSize;
+    return bWritten;
+}
+
+int32 FOmniCaptureFramePackWriter::GetEntryCount() const
+{
+    FScopeLock Lock(&WriteCS);
+    return Entries.Num();
+}
+
+bool FOmniCaptureFramePackWriter::WriteChunk(int32 FrameIndex, const FString& Name, uint8 Flags, const uint8* Data, int64 Size, int64& OutPayloadOffset)
+{
+    if (!Handle.IsValid() || bFailed)
+    {
+        return false;
+    }
+
+    const FTCHARToUTF8 NameUtf8(*Name);
+    FChunkHeader Chunk;
+    Chunk.FrameIndex = FrameIndex;
+    Chunk.Flags = Flags;
+    Chunk.NameBytes = static_cast<uint16>(FMath::Min(NameUtf8.Length(), static_cast<int32>(MAX_uint16)));
+    Chunk.PayloadBytes = Size;
+
+    TArray<uint8> ChunkBytes;
+    ChunkBytes.Reserve(GChunkHeaderBytes + Chunk.NameBytes);
+    FMemoryWriter Writer(ChunkBytes);
+    Writer << Chunk;
+    Writer.Serialize(const_cast<ANSICHAR*>(NameUtf8.Get()), Chunk.NameBytes);
+
+    const int64 PayloadOffset = WriteOffset + ChunkBytes.Num();
+    if (!EnsureCapacity(PayloadOffset + Size)
+        || !Handle->Seek(WriteOffset)
+        || !Handle->Write(ChunkBytes.GetData(), ChunkBytes.Num())
+        || (Size > 0 && !Handle->Write(Data, Size)))
+    {
+        // Later chunks would land after a torn one and could never be recovered, so the pack stops here.
+        UE_LOG(LogTemp, Warning, TEXT("OmniCapture could not append '%s' to frame pack '%s'"), *Name, *FilePath);
+        bFailed = true;
+        return false;
+    }
+
+    WriteOffset = PayloadOffset + Size;
+    BytesWritten = WriteOffset;
+    OutPayloadOffset = PayloadOffset;
+    return true;
+}
+
+void FOmniCaptureFramePackWriter::AddEntry(int32 FrameIndex, const FString& Name, bool bPrimary, int64 Offset, int64 Size)
+{
+    EntryByName.Add(Name, Entries.Num());
+    FOmniCaptureFramePackEntry& Entry = Entries.AddDefaulted_GetRef();
+    Entry.FrameIndex = FrameIndex;
+    Entry.Name = Name;
+    Entry.bPrimary = bPrimary;
+    Entry.Offset = Offset;
+    Entry.Size = Size;
+}
+
+bool FOmniCaptureFramePackWriter::EnsureCapacity(int64 RequiredEnd)
+{
+    if (GrowBytes <= 0 || RequiredEnd <= AllocatedBytes)
+    {
+        return true;
+    }
+
+    const int64 NewSize = FMath::Max(RequiredEnd, AllocatedBytes + GrowBytes);
+    if (!Handle->Truncate(NewSize))
+    {
+        // Some file systems refuse to extend this way; appends still grow the file, only without the head start.
+        UE_LOG(LogTemp, Verbose, TEXT("OmniCapture could not preallocate frame pack '%s'; growing per append"), *FilePath);
+        GrowBytes = 0;
+        return true;
+    }
+
+    AllocatedBytes = NewSize;
+    return true;
+}
+
+FOmniCaptureFramePackReader::~FOmniCaptureFramePackReader()
+{
+    Close();
+}
+
+bool FOmniCaptureFramePackReader::Open(const FString& InFilePath)
+{
+    Close();
+
+    FScopeLock Lock(&ReadCS);
+    FilePath = InFilePath;
+    // Shared for writing so a pack that is still being captured can be read.
+    Handle.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*FilePath, true));
+    if (!Handle.IsValid())
+    {
+        return false;
+    }
+
+    const int64 FileSize = Handle->Size();
+    TArray<uint8> HeaderBytes;
+    if (FileSize < GHeaderBytes || !ReadBytes(*Handle, 0, GHeaderBytes, HeaderBytes))
+    {
+        Handle.Reset();
+        return false;
+    }
+
+    FMemoryReader Reader(HeaderBytes);
+    FPackHeader Header;
+    Reader << Header;
+    if (Header.Magic != GPackMagic || Header.Version < GMinPackVersion || Header.Version > GPackVersion || Header.HeaderBytes != GHeaderBytes)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("'%s' is not an OmniCapture frame pack"), *FilePath);
+        Handle.Reset();
+        return false;
+    }
+
+    if (Header.IndexOffset < GHeaderBytes || Header.IndexOffset + Header.IndexBytes > FileSize || !ReadIndex(Header.IndexOffset, Header.IndexBytes))
+    {
+        RecoverEntries(FileSize);
+    }
+
+    for (int32 EntryIndex = 0; EntryIndex < Entries.Num(); ++EntryIndex)
+    {
+        EntryByName.Add(Entries[EntryIndex].Name, EntryIndex);
+    }
+    return true;
+}
+
+void FOmniCaptureFramePackReader::Close()
+{
+    FScopeLock Lock(&ReadCS);
+    Handle.Reset();
+    Entries.Reset();
+    EntryByName.Reset();
+    bRecovered = false;
+}
+
+bool FOmniCaptureFramePackReader::ReadIndex(int64 IndexOffset, int64 IndexBytes)
+{
+    TArray<uint8> Bytes;
+    if (IndexBytes < 8 || IndexBytes > MAX_int32 || !ReadBytes(*Handle, IndexOffset, IndexBytes, Bytes))
+    {
+        return false;
+    }
+
+    FMemoryReader Reader(Bytes);
+    uint32 IndexMagic = 0;
+    int32 EntryCount = 0;
+    Reader << IndexMagic << EntryCount;
+    if (IndexMagic != GIndexMagic || EntryCount < 0)
+    {
+        return false;
+    }
+
+    TArray<FOmniCaptureFramePackEntry> Parsed;
+    Parsed.Reserve(EntryCount);
+    TArray<uint8> NameBytes;
+    for (int32 EntryIndex = 0; EntryIndex < EntryCount && !Reader.IsError(); ++EntryIndex)
+    {
+        FOmniCaptureFramePackEntry& Entry = Parsed.AddDefaulted_GetRef();
+        uint8 Flags = 0;
+        uint16 NameLength = 0;
+        Reader << Entry.FrameIndex << Flags << NameLength;
+        if (Reader.Tell() + NameLength > Reader.TotalSize())
+        {
+            return false;
+        }
+        NameBytes.SetNumUninitialized(NameLength);
+        Reader.Serialize(NameBytes.GetData(), NameLength);
+        Reader << Entry.Offset << Entry.Size;
+        Entry.Name = DecodeName(NameBytes.GetData(), NameLength);
+        Entry.bPrimary = (Flags & GPrimaryFlag) != 0;
+        if (Entry.Offset < GHeaderBytes || Entry.Size < 0 || Entry.Offset + Entry.Size > IndexOffset)
+        {
+            return false;
+        }
+    }
+
+    if (Reader.IsError())
+    {
+        return false;
+    }
+
+    Entries = MoveTemp(Parsed);
+    bRecovered = false;
+    return true;
+}
+
+void FOmniCaptureFramePackReader::RecoverEntries(int64 FileSize)
+{
+    Entries.Reset();
+    bRecovered = true;
+
+    TArray<uint8> ChunkBytes;
+    int64 Offset = GHeaderBytes;
+    while (Offset + GChunkHeaderBytes <= FileSize && ReadBytes(*Handle, Offset, GChunkHeaderBytes, ChunkBytes))
+    {
+        FMemoryReader Reader(ChunkBytes);
+        FChunkHeader Chunk;
+        Reader << Chunk;
+
+        // The preallocated tail reads back as zeros, which ends the walk like any other torn chunk.
+        const int64 PayloadOffset = Offset + GChunkHeaderBytes + Chunk.NameBytes;
+        if (Chunk.Magic != GChunkMagic || Chunk.PayloadBytes < 0 || PayloadOffset + Chunk.PayloadBytes > FileSize)
+        {
+            break;
+        }
+
+        TArray<uint8> NameBytes;
+        if (!ReadBytes(*Handle, Offset + GChunkHeaderBytes, Chunk.NameBytes, NameBytes))
+        {
+            break;
+        }
+
+        int64 EntryOffset = PayloadOffset;
+        int64 EntrySize = Chunk.PayloadBytes;
+        if ((Chunk.Flags & GReferenceFlag) != 0)
+        {
+            // References only ever point backwards, at a chunk this walk has already accepted.
+            TArray<uint8> ReferenceBytes;
+            if (Chunk.PayloadBytes != GReferencePayloadBytes || !ReadBytes(*Handle, PayloadOffset, GReferencePayloadBytes, ReferenceBytes))
+            {
+                break;
+            }
+            FMemoryReader ReferenceReader(ReferenceBytes);
+            ReferenceReader << EntryOffset << EntrySize;
+            if (EntryOffset < GHeaderBytes || EntrySize < 0 || EntryOffset + EntrySize > Offset)
+            {
+                break;
+            }
+        }
+
+        FOmniCaptureFramePackEntry& Entry = Entries.AddDefaulted_GetRef();
+        Entry.FrameIndex = Chunk.FrameIndex;
+        Entry.Name = DecodeName(NameBytes.GetData(), NameBytes.Num());
+        Entry.bPrimary = (Chunk.Flags & GPrimaryFlag) != 0;
+        Entry.Offset = EntryOffset;
+        Entry.Size = EntrySize;
+        Offset = PayloadOffset + Chunk.PayloadBytes;
+    }
+
+    UE_LOG(LogTemp, Warning, TEXT("OmniCapture frame pack '%s' has no index; recovered %d entries from its chunks"), *FilePath, Entries.Num());
+}
+
+const FOmniCaptureFramePackEntry* FOmniCaptureFramePackReader::FindEntry(const FString& Name) const
+{
+    const int32* EntryIndex = EntryByName.Find(Name);
+    return EntryIndex ? &Entries[*EntryIndex] : nullptr;
+}
+
+TArray<int32> FOmniCaptureFramePackReader::GetPrimaryEntriesInFrameOrder() const
+{
+    TArray<int32> Primary;
+    for (int32 EntryIndex = 0; EntryIndex < Entries.Num(); ++EntryIndex)
+    {
+        if (Entries[EntryIndex].bPrimary)
+        {
+            Primary.Add(EntryIndex);
+        }
+    }
+
+    // Encode threads finish out of order, so the pack itself is only roughly sorted.
+    Primary.StableSort([this](int32 A, int32 B)
+    {
+        return Entries[A].FrameIndex < Entries[B].FrameIndex;
+    });
+    return Primary;
+}
+
+bool FOmniCaptureFramePackReader::ReadEntry(const FOmniCaptureFramePackEntry& Entry, TArray64<uint8>& OutData) const
+{
+    FScopeLock Lock(&ReadCS);
+    if (!Handle.IsValid())
+    {
+        return false;
+    }
+
+    OutData.SetNumUninitialized(Entry.Size);
+    return Handle->Seek(Entry.Offset) && (Entry.Size == 0 || Handle->Read(OutData.GetData(), Entry.Size));
+}
+
+bool FOmniCaptureFramePackReader::ExtractToDirectory(const FString& Directory, int32* OutFilesWritten) const
+{
+    IFileManager::Get().MakeDirectory(*Directory, true);
+
+    int32 FilesWritten = 0;
+    bool bAllWritten = true;
+    TArray64<uint8> Data;
+    for (const FOmniCaptureFramePackEntry& Entry : Entries)
+    {
+        // Names come from the file, so anything that would climb out of Directory is cut back to its file name.
+        const FString TargetPath = Directory / FPaths::GetCleanFilename(Entry.Name);
+        if (ReadEntry(Entry, Data) && FFileHelper::SaveArrayToFile(Data, *TargetPath))
+        {
+            ++FilesWritten;
+        }
+        else
+        {
+            UE_LOG(LogTemp, Warning, TEXT("OmniCapture could not extract '%s' from '%s'"), *Entry.Name, *FilePath);
+            bAllWritten = false;
+        }
+    }
+
+    if (OutFilesWritten)
+    {
+        *OutFilesWritten = FilesWritten;
+    }
+    return bAllWritten;
+}
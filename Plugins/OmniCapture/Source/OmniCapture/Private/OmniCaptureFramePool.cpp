@@ -0,0 +1,240 @@
+#include "OmniCaptureFramePool.h"
+
+#include "Misc/ScopeLock.h"
+
+namespace
+{
+    constexpr int64 GMinSizeClassBytes = 64 * 1024;
+    constexpr int32 GMaxIdleFrames = 32;
+}
+
+FOmniCaptureFramePool& FOmniCaptureFramePool::Get()
+{
+    static FOmniCaptureFramePool Pool;
+    return Pool;
+}
+
+FOmniCaptureFramePool::FOmniCaptureFramePool()
+{
+    BufferHits = 0;
+    BufferMisses = 0;
+    BuffersDiscarded = 0;
+    FrameHits = 0;
+    FrameMisses = 0;
+}
+
+void FOmniCaptureFramePool::Configure(int64 InBudgetBytes)
+{
+    BudgetBytes = FMath::Max<int64>(0, InBudgetBytes);
+
+    if (InBudgetBytes <= 0)
+    {
+        Trim();
+    }
+}
+
+void FOmniCaptureFramePool::Trim()
+{
+    FScopeLock Lock(&PoolCS);
+    ClearBuckets(ColorBuckets);
+    ClearBuckets(HalfBuckets);
+    ClearBuckets(FloatBuckets);
+    IdleFrames.Reset();
+    PooledBytes = 0;
+}
+
+int64 FOmniCaptureFramePool::GetSizeClassBytes(int64 Bytes, bool bRoundUp)
+{
+    if (Bytes <= GMinSizeClassBytes)
+    {
+        return (bRoundUp || Bytes == GMinSizeClassBytes) ? GMinSizeClassBytes : 0;
+    }
+
+    // Four classes per power of two keeps the worst-case slack at 25%.
+    const uint32 Exponent = FMath::FloorLog2_64(static_cast<uint64>(Bytes));
+    const int64 Step = static_cast<int64>(1) << (Exponent - 2);
+    return bRoundUp ? ((Bytes + Step - 1) / Step) * Step : (Bytes / Step) * Step;
+}
+
+template <typename PixelType>
+void FOmniCaptureFramePool::AcquireFromBuckets(TBucketSet<PixelType>& Set, TArray64<PixelType>& OutStorage, int64 PixelCount)
+{
+    const int64 ClassBytes = GetSizeClassBytes(PixelCount * static_cast<int64>(sizeof(PixelType)), true);
+
+    {
+        FScopeLock Lock(&PoolCS);
+        if (TArray<TArray64<PixelType>>* Bucket = Set.Buckets.Find(ClassBytes))
+        {
+            if (Bucket->Num() > 0)
+            {
+                OutStorage = Bucket->Pop(EAllowShrinking::No);
+                PooledBytes -= OutStorage.GetAllocatedSize();
+            }
+        }
+    }
+
+    if (OutStorage.Max() >= PixelCount)
+    {
+        BufferHits.IncrementExchange();
+    }
+    else
+    {
+        BufferMisses.IncrementExchange();
+        OutStorage.Empty(BudgetBytes.Load() > 0 ? ClassBytes / static_cast<int64>(sizeof(PixelType)) : PixelCount);
+    }
+
+    OutStorage.SetNumUninitialized(PixelCount, EAllowShrinking::No);
+}
+
+template <typename PixelType>
+void FOmniCaptureFramePool::ReturnToBuckets(TBucketSet<PixelType>& Set, TArray64<PixelType>&& Storage)
+{
+    const int64 AllocatedBytes = Storage.GetAllocatedSize();
+    if (AllocatedBytes <= 0)
+    {
+        return;
+    }
+
+    // Bucket by the largest class the allocation can fully serve; the allocator may have added slack.
+    const int64 ClassBytes = GetSizeClassBytes(AllocatedBytes, false);
+    if (ClassBytes <= 0)
+    {
+        BuffersDiscarded.IncrementExchange();
+        return;
+    }
+
+    FScopeLock Lock(&PoolCS);
+    if (PooledBytes + AllocatedBytes > BudgetBytes.Load())
+    {
+        BuffersDiscarded.IncrementExchange();
+        return;
+    }
+
+    Storage.Reset();
+    Set.Buckets.FindOrAdd(ClassBytes).Add(MoveTemp(Storage));
+    PooledBytes += AllocatedBytes;
+}
+
+template <typename PixelType>
+void FOmniCaptureFramePool::ClearBuckets(TBucketSet<PixelType>& Set)
+{
+    Set.Buckets.Reset();
+}
+
+void FOmniCaptureFramePool::AcquireStorage(TArray64<FColor>& OutStorage, int64 PixelCount)
+{
+    AcquireFromBuckets(ColorBuckets, OutStorage, PixelCount);
+}
+
+void FOmniCaptureFramePool::AcquireStorage(TArray64<FFloat16Color>& OutStorage, int64 PixelCount)
+{
+    AcquireFromBuckets(HalfBuckets, OutStorage, PixelCount);
+}
+
+void FOmniCaptureFramePool::AcquireStorage(TArray64<FLinearColor>& OutStorage, int64 PixelCount)
+{
+    AcquireFromBuckets(FloatBuckets, OutStorage, PixelCount);
+}
+
+void FOmniCaptureFramePool::ReleasePixels(TUniquePtr<FImagePixelData>&& PixelData)
+{
+    TUniquePtr<FImagePixelData> Released = MoveTemp(PixelData);
+    if (!Released.IsValid() || BudgetBytes.Load() <= 0)
+    {
+        return;
+    }
+
+    switch (Released->GetType())
+    {
+    case EImagePixelType::Color:
+        ReturnToBuckets(ColorBuckets, MoveTemp(static_cast<TImagePixelData<FColor>*>(Released.Get())->Pixels));
+        break;
+    case EImagePixelType::Float16:
+        ReturnToBuckets(HalfBuckets, MoveTemp(static_cast<TImagePixelData<FFloat16Color>*>(Released.Get())->Pixels));
+        break;
+    case EImagePixelType::Float32:
+        // Scalar and vector float layers share the Float32 tag; only four-channel data can be recycled.
+        if (Released->GetNumChannels() == 4)
+        {
+            ReturnToBuckets(FloatBuckets, MoveTemp(static_cast<TImagePixelData<FLinearColor>*>(Released.Get())->Pixels));
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+TUniquePtr<FOmniCaptureFrame> FOmniCaptureFramePool::AcquireFrame()
+{
+    {
+        FScopeLock Lock(&PoolCS);
+        if (IdleFrames.Num() > 0)
+        {
+            FrameHits.IncrementExchange();
+            return IdleFrames.Pop(EAllowShrinking::No);
+        }
+    }
+
+    FrameMisses.IncrementExchange();
+    return MakeUnique<FOmniCaptureFrame>();
+}
+
+void FOmniCaptureFramePool::ReleaseFrame(TUniquePtr<FOmniCaptureFrame>&& Frame)
+{
+    TUniquePtr<FOmniCaptureFrame> Released = MoveTemp(Frame);
+    if (!Released.IsValid())
+    {
+        return;
+    }
+
+    ReleasePixels(MoveTemp(Released->PixelData));
+    for (TPair<FName, FOmniCaptureLayerPayload>& Pair : Released->AuxiliaryLayers)
+    {
+        ReleasePixels(MoveTemp(Pair.Value.PixelData));
+    }
+    Released->RowSource.Reset();
+
+    if (BudgetBytes.Load() <= 0)
+    {
+        return;
+    }
+
+    Released->Metadata = FOmniCaptureFrameMetadata();
+    Released->GPUSource.SafeRelease();
+    Released->Texture.SafeRelease();
+    Released->ReadyFence.SafeRelease();
+    Released->bLinearColor = false;
+    Released->bUsedCPUFallback = false;
+    Released->PixelPrecision = EOmniCapturePixelPrecision::Unknown;
+    Released->PixelDataType = EOmniCapturePixelDataType::Unknown;
+    for (FOmniAudioPacket& Packet : Released->AudioPackets)
+    {
+        Released->SpareAudioPCM.Add(MoveTemp(Packet.PCM16));
+    }
+    Released->AudioPackets.Reset();
+    Released->EncoderTextures.Reset();
+    Released->AuxiliaryLayers.Reset();
+    Released->ReservedBytes = 0;
+
+    FScopeLock Lock(&PoolCS);
+    if (IdleFrames.Num() < GMaxIdleFrames)
+    {
+        IdleFrames.Add(MoveTemp(Released));
+    }
+}
+
+FOmniCaptureFramePoolStats FOmniCaptureFramePool::GetStats() const
+{
+    FOmniCaptureFramePoolStats Stats;
+    {
+        FScopeLock Lock(&PoolCS);
+        Stats.PooledBytes = PooledBytes;
+        Stats.BudgetBytes = BudgetBytes.Load();
+    }
+    Stats.BufferHits = BufferHits.Load();
+    Stats.BufferMisses = BufferMisses.Load();
+    Stats.BuffersDiscarded = BuffersDiscarded.Load();
+    Stats.FrameHits = FrameHits.Load();
+    Stats.FrameMisses = FrameMisses.Load();
+    return Stats;
+}
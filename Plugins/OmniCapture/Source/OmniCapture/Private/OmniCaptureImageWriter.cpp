@@ -4,6 +4,9 @@
 #include "Async/Async.h"
 #include "Async/Future.h"
 #include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "Hash/xxhash.h"
 #include "IImageWrapperModule.h"
 #include "IImageWrapper.h"
 #include "ImageWriteQueue.h"
@@ -15,15 +18,31 @@
 #include "Internationalization/Internationalization.h"
 #include "Math/Vector2D.h"
 #include "OmniCaptureVersion.h"
+#include "OmniCaptureCPUKernels.h"
+#include "OmniCaptureCPUReprojection.h"
+#include "OmniCaptureFramePack.h"
+#include "OmniCaptureFramePool.h"
+#include "OmniCaptureIntermediateFormat.h"
+#include "OmniCaptureJPEGEncoder.h"
+#include "OmniCaptureMemoryBudget.h"
+#include "OmniCapturePNGEncoder.h"
+#include "Serialization/MemoryWriter.h"
 
 #include <exception>
 
+#if PLATFORM_WINDOWS
+#include "Windows/AllowWindowsPlatformTypes.h"
+#include "Windows/WindowsHWrapper.h"
+#include "Windows/HideWindowsPlatformTypes.h"
+#endif
+
 #ifndef WITH_OMNICAPTURE_OPENEXR
 #define WITH_OMNICAPTURE_OPENEXR 0
 #endif
 
 THIRD_PARTY_INCLUDES_START
 #include "png.h"
+#include "zlib.h"
 THIRD_PARTY_INCLUDES_END
 
 #if WITH_OMNICAPTURE_OPENEXR
@@ -36,13 +55,13 @@ THIRD_PARTY_INCLUDES_START
 #include "OpenEXR/ImfStringAttribute.h"
 #include "OpenEXR/ImfCompression.h"
 #include "OpenEXR/ImfNamespace.h"
+#include "OpenEXR/ImfThreading.h"
 #include "Imath/half.h"
 THIRD_PARTY_INCLUDES_END
 #endif
 
 namespace
 {
-    constexpr int32 DefaultJpegQuality = 85;
 
 #if WITH_OMNICAPTURE_OPENEXR
     OPENEXR_IMF_NAMESPACE::Compression ToOpenExrCompression(EOmniCaptureEXRCompression Compression)
@@ -82,30 +101,288 @@ namespace
         }
     }
 
+    static_assert(sizeof(FFloat16) == sizeof(IMATH_NAMESPACE::half), "FFloat16 and half must share a layout for EXR slices");
+
+    /** Describes where a layer's channels already sit in memory, so OpenEXR reads them through slices without a copy. */
     struct FPreparedExrLayer
     {
         std::string Name;
         OPENEXR_IMF_NAMESPACE::PixelType PixelType = OPENEXR_IMF_NAMESPACE::PixelType::HALF;
         int32 ChannelCount = 4;
-        TArray<float> FloatBuffer;
-        TArray<IMATH_NAMESPACE::half> HalfBuffer;
+        const char* BasePointer = nullptr;
+        size_t PixelStride = 0;
+        /** Byte offsets of R, G, B and A inside one pixel. */
+        size_t ChannelOffsets[4] = { 0, 0, 0, 0 };
+        /** Only 8-bit layers are converted, since OpenEXR has no 8-bit channel type. */
+        TArray64<FLinearColor> ConvertedPixels;
+
+        void SetSource(const void* Pixels, OPENEXR_IMF_NAMESPACE::PixelType InPixelType, size_t InPixelStride, size_t R, size_t G, size_t B, size_t A)
+        {
+            BasePointer = static_cast<const char*>(Pixels);
+            PixelType = InPixelType;
+            PixelStride = InPixelStride;
+            ChannelOffsets[0] = R;
+            ChannelOffsets[1] = G;
+            ChannelOffsets[2] = B;
+            ChannelOffsets[3] = A;
+        }
 
-        const char* GetBasePointer() const
+        OPENEXR_IMF_NAMESPACE::Slice MakeSlice(int32 ChannelIndex, int32 Width) const
         {
-            if (PixelType == OPENEXR_IMF_NAMESPACE::PixelType::FLOAT)
+            return OPENEXR_IMF_NAMESPACE::Slice(PixelType, const_cast<char*>(BasePointer) + ChannelOffsets[ChannelIndex], PixelStride, PixelStride * Width);
+        }
+    };
+
+    /** OpenEXR's pool compresses line blocks of one file in parallel; it is process-wide, so it only ever grows. */
+    int32 PrepareOpenExrThreads(int32 RequestedThreads)
+    {
+        const int32 ThreadCount = RequestedThreads > 0 ? RequestedThreads : FMath::Max(1, FPlatformMisc::NumberOfWorkerThreadsToSpawn());
+        if (ThreadCount <= 1)
+        {
+            // 0 makes OpenEXR compress on the calling thread.
+            return 0;
+        }
+
+        static FCriticalSection PoolCS;
+        static int32 PoolThreads = 0;
+        FScopeLock Lock(&PoolCS);
+        if (ThreadCount > PoolThreads)
+        {
+            OPENEXR_IMF_NAMESPACE::setGlobalThreadCount(ThreadCount);
+            PoolThreads = ThreadCount;
+        }
+        return ThreadCount;
+    }
+#endif
+
+    /**
+     * One queued frame on its way from the encode pool to the I/O pool. The encode job holds one reference and every
+     * file handed to the I/O pool another; whoever drops the last one completes the task.
+     */
+    struct FWriteTaskState : public TSharedFromThis<FWriteTaskState, ESPMode::ThreadSafe>
+    {
+        FOmniCaptureWorkerPool* IOPool = nullptr;
+        /** Files go into the segment's frame pack instead of the directory when set. */
+        FOmniCaptureFramePackWriter* FramePack = nullptr;
+        /** The writer's loose-file byte count; packed files are counted by the pack. */
+        TAtomic<int64>* BytesWritten = nullptr;
+        TUniqueFunction<void(const FWriteTaskState&)> OnComplete;
+        FString FilePath;
+        int32 FrameIndex = INDEX_NONE;
+        double EnqueueTime = 0.0;
+        double StartTime = 0.0;
+        double EncodeEndTime = 0.0;
+        TAtomic<int32> Outstanding { 1 };
+        TAtomic<bool> bFailed { false };
+        TAtomic<uint64> IOCycles { 0 };
+
+        void Release()
+        {
+            if (Outstanding.DecrementExchange() == 1)
             {
-                return reinterpret_cast<const char*>(FloatBuffer.GetData());
+                OnComplete(*this);
             }
+        }
+    };
 
-            return reinterpret_cast<const char*>(HalfBuffer.GetData());
+    /** Set while an encode-pool job runs, so the encoders below can hand their output on without it being threaded through every call. */
+    thread_local FWriteTaskState* GActiveWriteTask = nullptr;
+
+    /**
+     * Threads one PNG or JPEG is split over. 0 lets the encoder use the task graph, except on the encode pool: its jobs
+     * already run one file per thread, and fanning each out again would only crowd the engine's workers.
+     */
+    int32 ResolveStripThreads(int32 Setting)
+    {
+        return Setting > 0 ? Setting : (GActiveWriteTask ? 1 : 0);
+    }
+
+    bool IsDeferringFileWrites()
+    {
+        return GActiveWriteTask && (GActiveWriteTask->IOPool || GActiveWriteTask->FramePack);
+    }
+
+    void CountWrittenBytes(TAtomic<int64>* BytesWritten, int64 Size)
+    {
+        if (BytesWritten && Size > 0)
+        {
+            BytesWritten->AddExchange(Size);
         }
+    }
 
-        int32 GetComponentSize() const
+    bool WriteFileNow(const FString& FilePath, const TArray64<uint8>& Bytes, TAtomic<int64>* BytesWritten)
+    {
+        IFileManager::Get().Delete(*FilePath, false, true, false);
+        if (!FFileHelper::SaveArrayToFile(Bytes, *FilePath))
         {
-            return PixelType == OPENEXR_IMF_NAMESPACE::PixelType::FLOAT ? sizeof(float) : sizeof(IMATH_NAMESPACE::half);
+            return false;
+        }
+        CountWrittenBytes(BytesWritten, Bytes.Num());
+        return true;
+    }
+
+    bool StoreEncodedFile(const FWriteTaskState& Task, const FString& FilePath, const TArray64<uint8>& Bytes)
+    {
+        if (!Task.FramePack)
+        {
+            return WriteFileNow(FilePath, Bytes, Task.BytesWritten);
+        }
+
+        const bool bPrimary = FilePath == Task.FilePath;
+        return Task.FramePack->Append(Task.FrameIndex, FPaths::GetCleanFilename(FilePath), bPrimary, Bytes.GetData(), Bytes.Num());
+    }
+
+    /** Queues a finished file on the I/O pool when called from an encode job; otherwise writes it here. */
+    bool SaveEncodedFile(TArray64<uint8>&& Bytes, const FString& FilePath)
+    {
+        if (!IsDeferringFileWrites())
+        {
+            return WriteFileNow(FilePath, Bytes, GActiveWriteTask ? GActiveWriteTask->BytesWritten : nullptr);
+        }
+
+        FWriteTaskState& Task = *GActiveWriteTask;
+        if (!Task.IOPool)
+        {
+            return StoreEncodedFile(Task, FilePath, Bytes);
+        }
+
+        Task.Outstanding.IncrementExchange();
+        Task.IOPool->Enqueue([State = Task.AsShared(), FilePath, Bytes = MoveTemp(Bytes)]()
+        {
+            const uint64 StartCycles = FPlatformTime::Cycles64();
+            if (!StoreEncodedFile(*State, FilePath, Bytes))
+            {
+                UE_LOG(LogTemp, Warning, TEXT("OmniCapture could not write '%s'"), *FilePath);
+                State->bFailed = true;
+            }
+            State->IOCycles.AddExchange(FPlatformTime::Cycles64() - StartCycles);
+            State->Release();
+        });
+        return true;
+    }
+
+    /** OpenEXR only writes to paths; when packing, its output is read back into the pack and the loose file removed. */
+    bool AdoptWrittenFile(const FString& FilePath)
+    {
+        if (!GActiveWriteTask || !IFileManager::Get().FileExists(*FilePath))
+        {
+            return true;
+        }
+
+        if (!GActiveWriteTask->FramePack)
+        {
+            CountWrittenBytes(GActiveWriteTask->BytesWritten, IFileManager::Get().FileSize(*FilePath));
+            return true;
+        }
+
+        TArray64<uint8> Bytes;
+        if (!FFileHelper::LoadFileToArray(Bytes, *FilePath))
+        {
+            return false;
+        }
+        IFileManager::Get().Delete(*FilePath, false, true, true);
+        return SaveEncodedFile(MoveTemp(Bytes), FilePath);
+    }
+
+    /** Streamed encoders write into Buffer when the I/O pool will write the file, and into the file itself otherwise. */
+    TUniquePtr<FArchive> CreateEncodedFileWriter(const FString& FilePath, TArray64<uint8>& Buffer)
+    {
+        if (IsDeferringFileWrites())
+        {
+            return MakeUnique<FMemoryWriter64>(Buffer);
+        }
+
+        IFileManager::Get().Delete(*FilePath, false, true, false);
+        return TUniquePtr<FArchive>(IFileManager::Get().CreateFileWriter(*FilePath));
+    }
+
+    bool FinishEncodedFile(TUniquePtr<FArchive>& Archive, TArray64<uint8>& Buffer, const FString& FilePath, bool bEncoded)
+    {
+        const int64 StreamedBytes = Archive->Tell();
+        Archive->Close();
+        if (!bEncoded || Archive->IsError())
+        {
+            IFileManager::Get().Delete(*FilePath, false, true, true);
+            return false;
+        }
+
+        if (IsDeferringFileWrites())
+        {
+            return SaveEncodedFile(MoveTemp(Buffer), FilePath);
+        }
+        CountWrittenBytes(GActiveWriteTask ? GActiveWriteTask->BytesWritten : nullptr, StreamedBytes);
+        return true;
+    }
+
+    /** The auxiliary layers that carry pixels, in the order their files are hashed and listed. */
+    TArray<FName> GetHashedLayerNames(const TMap<FName, FOmniCaptureLayerPayload>& AuxiliaryLayers)
+    {
+        TArray<FName> LayerNames;
+        for (const TPair<FName, FOmniCaptureLayerPayload>& Pair : AuxiliaryLayers)
+        {
+            if (Pair.Value.PixelData.IsValid())
+            {
+                LayerNames.Add(Pair.Key);
+            }
+        }
+        LayerNames.Sort(FNameLexicalLess());
+        return LayerNames;
+    }
+
+    /** Covers everything the encoders read, so two frames with the same hash encode to the same files. Never 0. */
+    uint64 HashFrameContent(const FImagePixelData& PixelData, bool bIsLinear, EOmniCapturePixelPrecision PixelPrecision, EOmniCapturePixelDataType PixelDataType, const TMap<FName, FOmniCaptureLayerPayload>& AuxiliaryLayers, const TArray<FName>& LayerNames)
+    {
+        FXxHash64Builder Builder;
+        auto HashImage = [&Builder](const FImagePixelData& Image, bool bLinear, EOmniCapturePixelPrecision Precision, EOmniCapturePixelDataType DataType)
+        {
+            const FIntPoint Size = Image.GetSize();
+            const EImagePixelType PixelType = Image.GetType();
+            const void* RawData = nullptr;
+            int64 RawBytes = 0;
+            Image.GetRawData(RawData, RawBytes);
+
+            Builder.Update(&Size, sizeof(Size));
+            Builder.Update(&PixelType, sizeof(PixelType));
+            Builder.Update(&bLinear, sizeof(bLinear));
+            Builder.Update(&Precision, sizeof(Precision));
+            Builder.Update(&DataType, sizeof(DataType));
+            Builder.Update(&RawBytes, sizeof(RawBytes));
+            if (RawData && RawBytes > 0)
+            {
+                Builder.Update(RawData, static_cast<uint64>(RawBytes));
+            }
+        };
+
+        HashImage(PixelData, bIsLinear, PixelPrecision, PixelDataType);
+        for (const FName& LayerName : LayerNames)
+        {
+            const FString Name = LayerName.ToString();
+            Builder.Update(*Name, Name.Len() * sizeof(TCHAR));
+            const FOmniCaptureLayerPayload& Layer = AuxiliaryLayers.FindChecked(LayerName);
+            HashImage(*Layer.PixelData, Layer.bLinear, Layer.Precision, Layer.PixelDataType);
+        }
+
+        const uint64 Hash = Builder.Finalize().Hash;
+        return Hash != 0 ? Hash : 1;
+    }
+
+    /** Hard links cost no space or copy; volumes without them (FAT, some shares) get a plain copy. */
+    bool LinkOrCopyFile(const FString& SourcePath, const FString& LinkPath, TAtomic<int64>* BytesWritten)
+    {
+        IFileManager::Get().Delete(*LinkPath, false, true, true);
+#if PLATFORM_WINDOWS
+        if (::CreateHardLinkW(*FPaths::ConvertRelativePathToFull(LinkPath), *FPaths::ConvertRelativePathToFull(SourcePath), nullptr))
+        {
+            return true;
         }
-    };
 #endif
+        if (IFileManager::Get().Copy(*LinkPath, *SourcePath) != COPY_OK)
+        {
+            return false;
+        }
+        CountWrittenBytes(BytesWritten, IFileManager::Get().FileSize(*LinkPath));
+        return true;
+    }
 
     TSharedPtr<IImageWrapper> CreateImageWrapper(EImageFormat Format)
     {
@@ -131,14 +408,13 @@ namespace
             return false;
         }
 
-        const TArray64<uint8> CompressedData = ImageWrapper->GetCompressed(0);
+        TArray64<uint8> CompressedData = ImageWrapper->GetCompressed(0);
         if (CompressedData.Num() == 0)
         {
             return false;
         }
 
-        IFileManager::Get().Delete(*FilePath, false, true, false);
-        return FFileHelper::SaveArrayToFile(CompressedData, *FilePath);
+        return SaveEncodedFile(MoveTemp(CompressedData), FilePath);
     }
 
     FString NormalizeFilePath(const FString& InPath)
@@ -180,6 +456,86 @@ namespace
         }
     }
 
+    /** Runs a row source over the whole frame into pooled pixels, for writers that cannot take rows. */
+    TUniquePtr<FImagePixelData> MaterializeRowSource(const FOmniCaptureCPURowSource& RowSource)
+    {
+        void* Pixels = nullptr;
+        TUniquePtr<FImagePixelData> PixelData;
+        switch (RowSource.PixelDataType)
+        {
+        case EOmniCapturePixelDataType::LinearColorFloat32:
+        {
+            TUniquePtr<TImagePixelData<FLinearColor>> Typed = FOmniCaptureFramePool::Get().AcquirePixels<FLinearColor>(RowSource.Size);
+            Pixels = Typed->Pixels.GetData();
+            PixelData = MoveTemp(Typed);
+            break;
+        }
+        case EOmniCapturePixelDataType::LinearColorFloat16:
+        {
+            TUniquePtr<TImagePixelData<FFloat16Color>> Typed = FOmniCaptureFramePool::Get().AcquirePixels<FFloat16Color>(RowSource.Size);
+            Pixels = Typed->Pixels.GetData();
+            PixelData = MoveTemp(Typed);
+            break;
+        }
+        default:
+        {
+            TUniquePtr<TImagePixelData<FColor>> Typed = FOmniCaptureFramePool::Get().AcquirePixels<FColor>(RowSource.Size);
+            Pixels = Typed->Pixels.GetData();
+            PixelData = MoveTemp(Typed);
+            break;
+        }
+        }
+
+        RowSource.ProduceRows(0, RowSource.Size.Y, Pixels);
+        return PixelData;
+    }
+
+    /** Converts one row of row-source pixels into a BGRA PNG row, with the same rounding as the whole-frame writers. */
+    void ConvertRowToPNG(EOmniCapturePixelDataType PixelDataType, const uint8* Source, int32 Width, int32 BitDepth, uint8* Dest)
+    {
+        switch (PixelDataType)
+        {
+        case EOmniCapturePixelDataType::LinearColorFloat32:
+        {
+            const FLinearColor* Pixels = reinterpret_cast<const FLinearColor*>(Source);
+            if (BitDepth == 16)
+            {
+                FOmniCaptureCPUKernels::PackUNorm16BGRA(Pixels, reinterpret_cast<uint16*>(Dest), Width);
+            }
+            else
+            {
+                FOmniCaptureCPUKernels::PackSRGB(Pixels, reinterpret_cast<FColor*>(Dest), Width);
+            }
+            break;
+        }
+        case EOmniCapturePixelDataType::LinearColorFloat16:
+        {
+            const FFloat16Color* Pixels = reinterpret_cast<const FFloat16Color*>(Source);
+            if (BitDepth == 16)
+            {
+                FOmniCaptureCPUKernels::PackUNorm16BGRA(Pixels, reinterpret_cast<uint16*>(Dest), Width);
+            }
+            else
+            {
+                FOmniCaptureCPUKernels::PackSRGB(Pixels, reinterpret_cast<FColor*>(Dest), Width);
+            }
+            break;
+        }
+        default:
+        {
+            const FColor* Pixels = reinterpret_cast<const FColor*>(Source);
+            if (BitDepth != 16)
+            {
+                FMemory::Memcpy(Dest, Pixels, static_cast<int64>(Width) * sizeof(FColor));
+                break;
+            }
+
+            FOmniCaptureCPUKernels::ExpandUNorm16BGRA(Pixels, reinterpret_cast<uint16*>(Dest), Width);
+            break;
+        }
+        }
+    }
+
     void PngWriteDataCallback(png_structp PngPtr, png_bytep Data, png_size_t Length)
     {
         FArchive* Archive = static_cast<FArchive*>(png_get_io_ptr(PngPtr));
@@ -206,11 +562,76 @@ namespace
     }
 }
 
+/**
+ * A frame's link in the dedup chain. Frames are linked in FrameIndex order, by LinkFrame from the ring buffer's ordered
+ * stage or by EnqueueFrame for serial callers, so whether a frame repeats the one before it is settled before any job
+ * runs. A repeat skips encoding and waits for the first frame of its run to be stored, however late that one is enqueued.
+ */
+struct FOmniCaptureImageWriter::FDedupFrame
+{
+    /** Runs Follower once this frame's files are written, or right away if they already are. */
+    void WhenStored(TUniqueFunction<void(bool bStored)>&& Follower)
+    {
+        {
+            FScopeLock Lock(&StoredCS);
+            if (!bStoredKnown)
+            {
+                Followers.Add(MoveTemp(Follower));
+                return;
+            }
+        }
+        Follower(bStored);
+    }
+
+    void MarkStored(bool bSucceeded)
+    {
+        TArray<TUniqueFunction<void(bool)>> Pending;
+        {
+            FScopeLock Lock(&StoredCS);
+            bStoredKnown = true;
+            bStored = bSucceeded;
+            Pending = MoveTemp(Followers);
+        }
+        for (TUniqueFunction<void(bool)>& Follower : Pending)
+        {
+            Follower(bSucceeded);
+        }
+    }
+
+    int32 FrameIndex = INDEX_NONE;
+    /** 0 for a frame that was not hashed; it never matches, so the chain is cut there. */
+    uint64 Hash = 0;
+    /** The primary file first, then one per auxiliary layer in name order, so two frames' lists line up. Set on enqueue. */
+    TArray<FString> FilePaths;
+    /** The first frame of the run this one repeats; null when it has to be encoded. */
+    TSharedPtr<FDedupFrame, ESPMode::ThreadSafe> Source;
+
+private:
+    FCriticalSection StoredCS;
+    bool bStoredKnown = false;
+    bool bStored = false;
+    TArray<TUniqueFunction<void(bool)>> Followers;
+};
+
 FOmniCaptureImageWriter::FOmniCaptureImageWriter()
 {
     bStopRequested.Store(false);
+    InFlightTasks = 0;
+    PeakInFlightTasks = 0;
+    WaitingRepeats = 0;
+    WaitingForSlot = 0;
+    DuplicateFrames = 0;
+    LooseBytesWritten = 0;
+    bWorkerPoolsStarted = false;
+    TaskCompletedEvent = FPlatformProcess::GetSynchEventFromPool();
+}
+
+FOmniCaptureImageWriter::~FOmniCaptureImageWriter()
+{
+    Flush();
+    FPlatformProcess::ReturnSynchEventToPool(TaskCompletedEvent);
+    TaskCompletedEvent = nullptr;
 }
-FOmniCaptureImageWriter::~FOmniCaptureImageWriter() { Flush(); }
 
 void FOmniCaptureImageWriter::Initialize(const FOmniCaptureSettings& Settings, const FString& InOutputDirectory)
 {
@@ -224,22 +645,66 @@ void FOmniCaptureImageWriter::Initialize(const FOmniCaptureSettings& Settings, c
     bPackEXRAuxiliaryLayers = Settings.bPackEXRAuxiliaryLayers;
     bUseEXRMultiPart = Settings.bUseEXRMultiPart;
     TargetEXRCompression = Settings.EXRCompression;
+    EXRThreadCount = FMath::Max(0, Settings.EXRThreadCount);
+    StreamingBandRows = FMath::Max(1, Settings.CPUStreamingBandRows);
+    PNGEncodeThreads = FMath::Max(0, Settings.PNGEncodeThreads);
+    TargetPNGCompression = Settings.PNGCompression;
+    JPEGQuality = FMath::Clamp(Settings.JPEGQuality, 1, 100);
+    JPEGSubsampling = Settings.JPEGSubsampling;
+    bJPEGFastDCT = Settings.bJPEGFastDCT;
+    JPEGEncodeThreads = FMath::Max(0, Settings.JPEGEncodeThreads);
+    EncodeThreadCount = FMath::Max(0, Settings.EncodeThreadCount);
+    EncodeThreadAffinityMask = static_cast<uint64>(Settings.EncodeThreadAffinityMask);
+    IOThreadCount = FMath::Max(0, Settings.IOThreadCount);
+    bWriteFramePack = Settings.bWriteFramePack;
+    FramePackPreallocateBytes = static_cast<int64>(FMath::Max(0, Settings.FramePackPreallocateMB)) * 1024 * 1024;
+    bDeduplicateFrames = Settings.bDeduplicateFrames;
+    AbandonLinkedFrames();
     bStopRequested.Store(false);
     bInitialized = true;
 }
 
 void FOmniCaptureImageWriter::EnqueueFrame(TUniquePtr<FOmniCaptureFrame>&& Frame, const FString& FrameFileName)
 {
-    if (!bInitialized || !Frame.IsValid() || IsStopRequested())
+    if (!bInitialized || !Frame.IsValid())
     {
         return;
     }
 
-    PruneCompletedTasks();
-    WaitForAvailableTaskSlot();
+    TSharedPtr<FDedupFrame, ESPMode::ThreadSafe> Dedup;
+    if (bDeduplicateFrames)
+    {
+        FScopeLock Lock(&DedupCS);
+        LinkedDedupFrames.RemoveAndCopyValue(Frame->Metadata.FrameIndex, Dedup);
+    }
 
-    if (IsStopRequested())
+    if (IsStopRequested() || (!Frame->PixelData.IsValid() && !Frame->RowSource.IsValid()))
     {
+        if (Dedup.IsValid())
+        {
+            Dedup->MarkStored(false);
+        }
+        return;
+    }
+
+    if (bDeduplicateFrames && !Dedup.IsValid())
+    {
+        Dedup = LinkDedupFrame(*Frame);
+    }
+
+    // A repeat drops its pixels below, so it neither waits for a slot nor holds one; either could starve the frame it repeats.
+    const bool bDuplicate = Dedup.IsValid() && Dedup->Source.IsValid();
+    if (bDuplicate)
+    {
+        WaitingRepeats.IncrementExchange();
+        InFlightTasks.IncrementExchange();
+    }
+    else if (!AcquireTaskSlot())
+    {
+        if (Dedup.IsValid())
+        {
+            Dedup->MarkStored(false);
+        }
         return;
     }
 
@@ -248,74 +713,306 @@ void FOmniCaptureImageWriter::EnqueueFrame(TUniquePtr<FOmniCaptureFrame>&& Frame
     bool bIsLinear = Frame->bLinearColor;
 
     TUniquePtr<FImagePixelData> PixelData = MoveTemp(Frame->PixelData);
+    TSharedPtr<FOmniCaptureCPURowSource, ESPMode::ThreadSafe> RowSource = MoveTemp(Frame->RowSource);
     TMap<FName, FOmniCaptureLayerPayload> AuxiliaryLayers = MoveTemp(Frame->AuxiliaryLayers);
-    if (!PixelData.IsValid())
+    const EOmniCapturePixelPrecision PixelPrecision = Frame->PixelPrecision;
+    const EOmniCapturePixelDataType PixelDataType = Frame->PixelDataType;
+    const int64 ReservedBytes = Frame->ReservedBytes;
+    Frame->ReservedBytes = 0;
+
+    EnsureWorkerPools();
+
+    if (Dedup.IsValid())
     {
+        Dedup->FilePaths.Add(TargetPath);
+        const FString LayerDirectory = FPaths::GetPath(TargetPath);
+        const FString LayerBaseName = FPaths::GetBaseFilename(TargetPath);
+        const FString LayerExtension = FPaths::GetExtension(TargetPath, true);
+        for (const FName& LayerName : GetHashedLayerNames(AuxiliaryLayers))
+        {
+            Dedup->FilePaths.Add(FPaths::Combine(LayerDirectory, FString::Printf(TEXT("%s_%s%s"), *LayerBaseName, *LayerName.ToString(), *LayerExtension)));
+        }
+    }
+
+    TSharedRef<FWriteTaskState, ESPMode::ThreadSafe> Task = MakeShared<FWriteTaskState, ESPMode::ThreadSafe>();
+    Task->IOPool = IOPool.IsRunning() ? &IOPool : nullptr;
+    Task->FramePack = FramePack.IsValid() && FramePack->IsOpen() ? FramePack.Get() : nullptr;
+    Task->BytesWritten = &LooseBytesWritten;
+    Task->FilePath = TargetPath;
+    Task->FrameIndex = Metadata.FrameIndex;
+    Task->EnqueueTime = FPlatformTime::Seconds();
+    // Runs on whichever thread drops the last reference: the encode thread, or the I/O thread after the frame's last file.
+    Task->OnComplete = [this, Dedup](const FWriteTaskState& State)
+    {
+        // Repeats of this frame link to its files, so they go first while the files are known to be complete.
+        if (Dedup.IsValid())
+        {
+            Dedup->MarkStored(!State.bFailed.Load());
+        }
+
+        // Last use of the writer; Flush may destroy it as soon as the slot is back.
+        CompleteTask(State.FilePath, State.EnqueueTime, State.StartTime, State.EncodeEndTime, FPlatformTime::ToSeconds64(State.IOCycles.Load()), !State.bFailed.Load());
+    };
+
+    {
+        FScopeLock Lock(&MetadataCS);
+        CapturedMetadata.Add(Metadata);
+    }
+
+    if (bDuplicate)
+    {
+        // Nothing to encode: the pixels go now, and the files follow the first frame of the run onto disk.
+        PixelData.Reset();
+        AuxiliaryLayers.Reset();
+        if (MemoryBudget)
+        {
+            MemoryBudget->Release(ReservedBytes);
+        }
+        DuplicateFrames.IncrementExchange();
+        Task->StartTime = Task->EncodeEndTime = Task->EnqueueTime;
+
+        Dedup->Source->WhenStored([this, Task, Dedup](bool bSourceStored)
+        {
+            WaitingRepeats.DecrementExchange();
+            if (!bSourceStored || !StoreDuplicateFiles(*Dedup->Source, *Dedup, Task->FramePack, Task->BytesWritten))
+            {
+                UE_LOG(LogTemp, Warning, TEXT("OmniCapture could not reuse frame %d for repeated frame '%s'"), Dedup->Source->FrameIndex, *Task->FilePath);
+                Task->bFailed = true;
+            }
+            Task->Release();
+        });
         return;
     }
 
-    const EOmniCapturePixelPrecision PixelPrecision = Frame->PixelPrecision;
-    const EOmniCapturePixelDataType PixelDataType = Frame->PixelDataType;
-    const FString LayerDirectory = FPaths::GetPath(TargetPath);
-    const FString LayerBaseName = FPaths::GetBaseFilename(TargetPath);
-    const FString LayerExtension = FPaths::GetExtension(TargetPath, true);
+    // Encode jobs only compress; every finished file goes to the I/O pool, which writes them one after another in submission order.
+    EncodePool.Enqueue([this, Task, FilePath = MoveTemp(TargetPath), Format = TargetFormat, bIsLinear, PixelPrecision, PixelDataType, PixelData = MoveTemp(PixelData), RowSource = MoveTemp(RowSource), AuxiliaryLayers = MoveTemp(AuxiliaryLayers), ReservedBytes]() mutable
+    {
+        Task->StartTime = FPlatformTime::Seconds();
 
-    TFuture<bool> Future = Async(EAsyncExecution::ThreadPool, [this, FilePath = MoveTemp(TargetPath), Format = TargetFormat, bIsLinear, PixelPrecision, PixelDataType, PixelData = MoveTemp(PixelData), AuxiliaryLayers = MoveTemp(AuxiliaryLayers), LayerDirectory, LayerBaseName, LayerExtension]() mutable
+        GActiveWriteTask = &Task.Get();
+        const bool bResult = WriteFrameFiles(FilePath, Format, bIsLinear, PixelPrecision, PixelDataType, MoveTemp(PixelData), MoveTemp(RowSource), MoveTemp(AuxiliaryLayers));
+        GActiveWriteTask = nullptr;
+        Task->EncodeEndTime = FPlatformTime::Seconds();
+        if (!bResult)
+        {
+            Task->bFailed = true;
+        }
+
+        // The pixels are gone by now; only the encoded files are still waiting on the I/O pool.
+        if (MemoryBudget)
+        {
+            MemoryBudget->Release(ReservedBytes);
+        }
+        Task->Release();
+    });
+}
+
+void FOmniCaptureImageWriter::LinkFrame(const FOmniCaptureFrame& Frame)
+{
+    if (!bInitialized || !bDeduplicateFrames)
+    {
+        return;
+    }
+
+    TSharedPtr<FDedupFrame, ESPMode::ThreadSafe> Dedup = LinkDedupFrame(Frame);
+    FScopeLock Lock(&DedupCS);
+    LinkedDedupFrames.Add(Frame.Metadata.FrameIndex, MoveTemp(Dedup));
+}
+
+TSharedPtr<FOmniCaptureImageWriter::FDedupFrame, ESPMode::ThreadSafe> FOmniCaptureImageWriter::LinkDedupFrame(const FOmniCaptureFrame& Frame)
+{
+    TSharedPtr<FDedupFrame, ESPMode::ThreadSafe> Dedup = MakeShared<FDedupFrame, ESPMode::ThreadSafe>();
+    Dedup->FrameIndex = Frame.Metadata.FrameIndex;
+    // Row sources are never resident in one piece, so they are always encoded.
+    if (Frame.PixelData.IsValid() && !Frame.RowSource.IsValid())
     {
-        if (Format == EOmniCaptureImageFormat::EXR)
+        Dedup->Hash = HashFrameContent(*Frame.PixelData, Frame.bLinearColor, Frame.PixelPrecision, Frame.PixelDataType, Frame.AuxiliaryLayers, GetHashedLayerNames(Frame.AuxiliaryLayers));
+    }
+
+    FScopeLock Lock(&DedupCS);
+    if (Dedup->Hash != 0 && LastDedupFrame.IsValid() && LastDedupFrame->Hash == Dedup->Hash)
+    {
+        Dedup->Source = LastDedupFrame->Source.IsValid() ? LastDedupFrame->Source : LastDedupFrame;
+    }
+    LastDedupFrame = Dedup;
+    return Dedup;
+}
+
+void FOmniCaptureImageWriter::AbandonLinkedFrames()
+{
+    TArray<TSharedPtr<FDedupFrame, ESPMode::ThreadSafe>> Abandoned;
+    {
+        FScopeLock Lock(&DedupCS);
+        LinkedDedupFrames.GenerateValueArray(Abandoned);
+        LinkedDedupFrames.Reset();
+        LastDedupFrame.Reset();
+    }
+    for (const TSharedPtr<FDedupFrame, ESPMode::ThreadSafe>& Dedup : Abandoned)
+    {
+        Dedup->MarkStored(false);
+    }
+}
+
+bool FOmniCaptureImageWriter::WriteFrame(TUniquePtr<FOmniCaptureFrame>&& Frame, const FString& FrameFileName) const
+{
+    if (!bInitialized || !Frame.IsValid() || IsStopRequested() || (!Frame->PixelData.IsValid() && !Frame->RowSource.IsValid()))
+    {
+        return false;
+    }
+
+    return WriteFrameFiles(NormalizeFilePath(OutputDirectory / FrameFileName), TargetFormat, Frame->bLinearColor, Frame->PixelPrecision, Frame->PixelDataType, MoveTemp(Frame->PixelData), MoveTemp(Frame->RowSource), MoveTemp(Frame->AuxiliaryLayers));
+}
+
+bool FOmniCaptureImageWriter::WriteFrameFiles(const FString& FilePath, EOmniCaptureImageFormat Format, bool bIsLinear, EOmniCapturePixelPrecision PixelPrecision, EOmniCapturePixelDataType PixelDataType, TUniquePtr<FImagePixelData> PixelData, TSharedPtr<FOmniCaptureCPURowSource, ESPMode::ThreadSafe> RowSource, TMap<FName, FOmniCaptureLayerPayload>&& AuxiliaryLayers) const
+{
+    const FString LayerDirectory = FPaths::GetPath(FilePath);
+    const FString LayerBaseName = FPaths::GetBaseFilename(FilePath);
+    const FString LayerExtension = FPaths::GetExtension(FilePath, true);
+
+    bool bResult = false;
+    bool bWroteFromRowSource = false;
+    if (RowSource.IsValid())
+    {
+        // Packed EXR layers are written in one pass, so a streamed beauty pass with auxiliary layers beside it is materialised.
+        if (Format == EOmniCaptureImageFormat::EXR && AuxiliaryLayers.Num() > 0)
+        {
+            PixelData = MaterializeRowSource(*RowSource);
+        }
+        else
         {
-            return WriteEXRFrame(FilePath, bIsLinear, MoveTemp(PixelData), PixelPrecision, PixelDataType, MoveTemp(AuxiliaryLayers), LayerDirectory, LayerBaseName, LayerExtension);
+            bResult = WriteRowSourceToDisk(*RowSource, FilePath, Format);
+            bWroteFromRowSource = true;
         }
 
-        bool bResult = WritePixelDataToDisk(MoveTemp(PixelData), FilePath, Format, bIsLinear, PixelPrecision, PixelDataType);
+        // The faces are the bulk of a streamed frame; drop them before any auxiliary layers are written.
+        RowSource.Reset();
+    }
 
-        for (TPair<FName, FOmniCaptureLayerPayload>& Pair : AuxiliaryLayers)
+    if (Format == EOmniCaptureImageFormat::EXR)
+    {
+        TArray<FString> WrittenPaths;
+        WrittenPaths.Add(FilePath);
+        for (const TPair<FName, FOmniCaptureLayerPayload>& Pair : AuxiliaryLayers)
+        {
+            WrittenPaths.Add(FPaths::Combine(LayerDirectory, FString::Printf(TEXT("%s_%s%s"), *LayerBaseName, *Pair.Key.ToString(), *LayerExtension)));
+        }
+
+        bResult = bWroteFromRowSource
+            ? bResult
+            : WriteEXRFrame(FilePath, bIsLinear, MoveTemp(PixelData), PixelPrecision, PixelDataType, MoveTemp(AuxiliaryLayers), LayerDirectory, LayerBaseName, LayerExtension);
+        for (const FString& WrittenPath : WrittenPaths)
+        {
+            bResult &= AdoptWrittenFile(WrittenPath);
+        }
+        return bResult;
+    }
+
+    if (!bWroteFromRowSource)
+    {
+        bResult = WritePixelDataToDisk(MoveTemp(PixelData), FilePath, Format, bIsLinear, PixelPrecision, PixelDataType);
+    }
+
+    for (TPair<FName, FOmniCaptureLayerPayload>& Pair : AuxiliaryLayers)
+    {
+        if (!Pair.Value.PixelData.IsValid())
         {
-            if (!Pair.Value.PixelData.IsValid())
+            continue;
+        }
+
+        const FString LayerFileName = FString::Printf(TEXT("%s_%s%s"), *LayerBaseName, *Pair.Key.ToString(), *LayerExtension);
+        const FString LayerPath = FPaths::Combine(LayerDirectory, LayerFileName);
+        const bool bLayerLinear = Pair.Value.bLinear;
+        const EOmniCapturePixelPrecision LayerPrecision = (Pair.Value.Precision == EOmniCapturePixelPrecision::Unknown) ? PixelPrecision : Pair.Value.Precision;
+        EOmniCapturePixelDataType LayerType = Pair.Value.PixelDataType;
+        if (LayerType == EOmniCapturePixelDataType::Unknown)
+        {
+            if (bLayerLinear)
             {
-                continue;
+                LayerType = (LayerPrecision == EOmniCapturePixelPrecision::FullFloat)
+                    ? EOmniCapturePixelDataType::LinearColorFloat32
+                    : EOmniCapturePixelDataType::LinearColorFloat16;
             }
-
-            const FString LayerFileName = FString::Printf(TEXT("%s_%s%s"), *LayerBaseName, *Pair.Key.ToString(), *LayerExtension);
-            const FString LayerPath = FPaths::Combine(LayerDirectory, LayerFileName);
-            const bool bLayerLinear = Pair.Value.bLinear;
-            const EOmniCapturePixelPrecision LayerPrecision = (Pair.Value.Precision == EOmniCapturePixelPrecision::Unknown) ? PixelPrecision : Pair.Value.Precision;
-            EOmniCapturePixelDataType LayerType = Pair.Value.PixelDataType;
-            if (LayerType == EOmniCapturePixelDataType::Unknown)
+            else
             {
-                if (bLayerLinear)
-                {
-                    LayerType = (LayerPrecision == EOmniCapturePixelPrecision::FullFloat)
-                        ? EOmniCapturePixelDataType::LinearColorFloat32
-                        : EOmniCapturePixelDataType::LinearColorFloat16;
-                }
-                else
-                {
-                    LayerType = EOmniCapturePixelDataType::Color8;
-                }
+                LayerType = EOmniCapturePixelDataType::Color8;
             }
-            bResult &= WritePixelDataToDisk(MoveTemp(Pair.Value.PixelData), LayerPath, Format, bLayerLinear, LayerPrecision, LayerType);
         }
+        bResult &= WritePixelDataToDisk(MoveTemp(Pair.Value.PixelData), LayerPath, Format, bLayerLinear, LayerPrecision, LayerType);
+    }
 
-        return bResult;
-    });
+    return bResult;
+}
 
-    TrackPendingTask(MoveTemp(Future));
-    PruneCompletedTasks();
-    EnforcePendingTaskLimit();
+bool FOmniCaptureImageWriter::StoreDuplicateFiles(const FDedupFrame& Source, const FDedupFrame& Frame, FOmniCaptureFramePackWriter* Pack, TAtomic<int64>* BytesWritten)
+{
+    // Equal hashes cover the layer names, so both lists hold the same layers in the same order.
+    if (Source.FilePaths.Num() != Frame.FilePaths.Num())
+    {
+        return false;
+    }
 
+    bool bResult = true;
+    for (int32 FileIndex = 0; FileIndex < Frame.FilePaths.Num(); ++FileIndex)
     {
-        FScopeLock Lock(&MetadataCS);
-        CapturedMetadata.Add(Metadata);
+        const bool bPrimary = FileIndex == 0;
+        const FString& SourcePath = Source.FilePaths[FileIndex];
+        const FString& LinkPath = Frame.FilePaths[FileIndex];
+        if (Pack)
+        {
+            // Layers packed into the beauty EXR never became files of their own, so only the primary has to resolve.
+            bResult &= (Pack->AppendReference(Frame.FrameIndex, FPaths::GetCleanFilename(LinkPath), bPrimary, FPaths::GetCleanFilename(SourcePath)) || !bPrimary);
+        }
+        else if (bPrimary || IFileManager::Get().FileExists(*SourcePath))
+        {
+            bResult &= LinkOrCopyFile(SourcePath, LinkPath, BytesWritten);
+        }
+    }
+    return bResult;
+}
+
+void FOmniCaptureImageWriter::Flush()
+{
+    RequestStop();
+    // Enqueues from here on are refused, so repeats still waiting on a frame that was linked but never enqueued give up.
+    AbandonLinkedFrames();
+    WaitForAllTasks();
+
+    FScopeLock Lock(&WorkerPoolCS);
+    if (bWorkerPoolsStarted.Load())
+    {
+        // Keep the pool gauges readable once the threads are gone.
+        FScopeLock StatsLock(&TaskStatsCS);
+        TaskStats.EncodeThreads = EncodePool.GetThreadCount();
+        TaskStats.IOThreads = IOPool.GetThreadCount();
+        TaskStats.EncodeUtilization = EncodePool.GetUtilization();
+        TaskStats.IOUtilization = IOPool.GetUtilization();
+    }
+    EncodePool.Stop();
+    IOPool.Stop();
+    if (FramePack.IsValid() && FramePack->IsOpen())
+    {
+        if (!FramePack->Close())
+        {
+            UE_LOG(LogTemp, Warning, TEXT("OmniCapture could not finish frame pack '%s'; its frames are recovered when it is read"), *FramePack->GetFilePath());
+        }
     }
+    bWorkerPoolsStarted = false;
+    bInitialized = false;
 }
 
-void FOmniCaptureImageWriter::Flush()
+FOmniCapturePNGEncodeStats FOmniCaptureImageWriter::GetPNGEncodeStats() const
 {
-    RequestStop();
-    PruneCompletedTasks();
-    WaitForAllTasks();
-    bInitialized = false;
+    FScopeLock Lock(&PNGStatsCS);
+    return PNGStats;
+}
+
+void FOmniCaptureImageWriter::RecordPNGEncode(double Seconds, int64 RawBytes, int64 EncodedBytes) const
+{
+    FScopeLock Lock(&PNGStatsCS);
+    ++PNGStats.FrameCount;
+    PNGStats.EncodeSeconds += Seconds;
+    PNGStats.RawBytes += RawBytes;
+    PNGStats.EncodedBytes += EncodedBytes;
 }
 
 TArray<FOmniCaptureFrameMetadata> FOmniCaptureImageWriter::ConsumeCapturedFrames()
@@ -340,7 +1037,7 @@ bool FOmniCaptureImageWriter::WritePixelDataToDisk(TUniquePtr<FImagePixelData> P
 
     EOmniCapturePixelDataType EffectiveType = PixelDataType;
 
-    if (Format != EOmniCaptureImageFormat::EXR)
+    if (Format != EOmniCaptureImageFormat::EXR && Format != EOmniCaptureImageFormat::Intermediate)
     {
         if (EffectiveType == EOmniCapturePixelDataType::ScalarFloat32)
         {
@@ -466,6 +1163,14 @@ bool FOmniCaptureImageWriter::WritePixelDataToDisk(TUniquePtr<FImagePixelData> P
             }
         }
         break;
+    case EOmniCaptureImageFormat::Intermediate:
+        // Stored exactly as captured; the transcoder applies the same conversions when it writes the final format.
+        {
+            TArray64<uint8> Encoded;
+            bWriteSuccessful = FOmniCaptureIntermediateFormat::Encode(*PixelData, bIsLinear, PixelPrecision, EffectiveType, Encoded)
+                && SaveEncodedFile(MoveTemp(Encoded), FilePath);
+        }
+        break;
     case EOmniCaptureImageFormat::PNG:
     default:
         if (bIsLinear)
@@ -503,6 +1208,7 @@ bool FOmniCaptureImageWriter::WritePixelDataToDisk(TUniquePtr<FImagePixelData> P
         UE_LOG(LogTemp, Warning, TEXT("Unsupported pixel data type for OmniCapture image export (%s)"), *FilePath);
     }
 
+    FOmniCaptureFramePool::Get().ReleasePixels(MoveTemp(PixelData));
     return bWriteSuccessful;
 }
 
@@ -559,7 +1265,7 @@ bool FOmniCaptureImageWriter::WritePNGRaw(const FString& FilePath, const FIntPoi
     return false;
 }
 
-bool FOmniCaptureImageWriter::WritePNGWithRowSource(const FString& FilePath, const FIntPoint& Size, ERGBFormat Format, int32 BitDepth, TFunctionRef<void(int32 RowStart, int32 RowCount, int64 BytesPerRow, TArray64<uint8>& TempBuffer, TArray<uint8*>& RowPointers)> PrepareRows) const
+bool FOmniCaptureImageWriter::WritePNGWithRowSource(const FString& FilePath, const FIntPoint& Size, ERGBFormat Format, int32 BitDepth, TFunctionRef<void(int32 RowStart, int32 RowCount, int64 BytesPerRow, TArray64<uint8>& TempBuffer, TArray<uint8*>& RowPointers)> PrepareRows, int32 RowsPerChunk) const
 {
 #if WITH_LIBPNG
     const int32 Channels = GetChannelCountForFormat(Format);
@@ -591,13 +1297,53 @@ bool FOmniCaptureImageWriter::WritePNGWithRowSource(const FString& FilePath, con
         return false;
     }
 
-    IFileManager::Get().Delete(*FilePath, false, true, false);
-    TUniquePtr<FArchive> Archive(IFileManager::Get().CreateFileWriter(*FilePath));
+    const double EncodeStartTime = FPlatformTime::Seconds();
+    TArray64<uint8> EncodedFile;
+    TUniquePtr<FArchive> Archive = CreateEncodedFileWriter(FilePath, EncodedFile);
     if (!Archive.IsValid())
     {
         return false;
     }
 
+    const int64 DesiredChunkBytes = 64ll * 1024ll * 1024ll;
+    const int64 SafeRowSize = FMath::Max<int64>(BytesPerRow, 1);
+    const int32 MaxRowsPerChunk = RowsPerChunk > 0
+        ? FMath::Min(RowsPerChunk, Size.Y)
+        : FMath::Max<int32>(1, static_cast<int32>(FMath::Min<int64>(Size.Y, DesiredChunkBytes / SafeRowSize)));
+
+    TArray64<uint8> TempBuffer;
+    TArray<uint8*> RowPointers;
+    RowPointers.Reserve(MaxRowsPerChunk);
+
+    FOmniCapturePNGEncodeOptions EncodeOptions = FOmniCapturePNGEncodeOptions::ForProfile(TargetPNGCompression);
+    EncodeOptions.MaxThreads = ResolveStripThreads(PNGEncodeThreads);
+
+    if (PNGEncodeThreads != 1 && FOmniCapturePNGEncoder::SupportsFormat(Format, BitDepth))
+    {
+
+        FOmniCapturePNGEncoder Encoder(*Archive, Size, Format, BitDepth, EncodeOptions);
+        bool bEncoded = Encoder.Begin();
+        for (int32 RowIndex = 0; bEncoded && RowIndex < Size.Y;)
+        {
+            const int32 RowsThisPass = FMath::Min(MaxRowsPerChunk, Size.Y - RowIndex);
+            RowPointers.SetNum(RowsThisPass, EAllowShrinking::No);
+            PrepareRows(RowIndex, RowsThisPass, BytesPerRow, TempBuffer, RowPointers);
+            bEncoded = !IsStopRequested() && Encoder.WriteRows(RowPointers.GetData(), RowsThisPass);
+            RowIndex += RowsThisPass;
+        }
+
+        bEncoded = bEncoded && Encoder.End();
+        const int64 EncodedBytes = Archive->Tell();
+        const double EncodeSeconds = FPlatformTime::Seconds() - EncodeStartTime;
+        if (!FinishEncodedFile(Archive, EncodedFile, FilePath, bEncoded))
+        {
+            return false;
+        }
+
+        RecordPNGEncode(EncodeSeconds, BytesPerRow * Size.Y, EncodedBytes);
+        return true;
+    }
+
     png_structp PngPtr = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
     if (!PngPtr)
     {
@@ -634,15 +1380,14 @@ bool FOmniCaptureImageWriter::WritePNGWithRowSource(const FString& FilePath, con
         png_set_bgr(PngPtr);
     }
 
-    png_write_info(PngPtr, InfoPtr);
-
-    const int64 DesiredChunkBytes = 64ll * 1024ll * 1024ll;
-    const int64 SafeRowSize = FMath::Max<int64>(BytesPerRow, 1);
-    const int32 MaxRowsPerChunk = FMath::Max<int32>(1, static_cast<int32>(FMath::Min<int64>(Size.Y, DesiredChunkBytes / SafeRowSize)));
+    png_set_compression_level(PngPtr, EncodeOptions.CompressionLevel);
+    png_set_filter(PngPtr, PNG_FILTER_TYPE_BASE, EncodeOptions.bAdaptiveFilter ? PNG_ALL_FILTERS : PNG_FILTER_SUB);
+    if (EncodeOptions.bRunLengthMatching)
+    {
+        png_set_compression_strategy(PngPtr, Z_RLE);
+    }
 
-    TArray64<uint8> TempBuffer;
-    TArray<uint8*> RowPointers;
-    RowPointers.Reserve(MaxRowsPerChunk);
+    png_write_info(PngPtr, InfoPtr);
 
     int32 RowIndex = 0;
     while (RowIndex < Size.Y)
@@ -665,8 +1410,15 @@ bool FOmniCaptureImageWriter::WritePNGWithRowSource(const FString& FilePath, con
     png_write_end(PngPtr, InfoPtr);
     png_destroy_write_struct(&PngPtr, &InfoPtr);
 
-    Archive->Close();
-    return !Archive->IsError();
+    const int64 EncodedBytes = Archive->Tell();
+    const double EncodeSeconds = FPlatformTime::Seconds() - EncodeStartTime;
+    if (!FinishEncodedFile(Archive, EncodedFile, FilePath, true))
+    {
+        return false;
+    }
+
+    RecordPNGEncode(EncodeSeconds, BytesPerRow * Size.Y, EncodedBytes);
+    return true;
 #else
     return false;
 #endif
@@ -697,16 +1449,8 @@ bool FOmniCaptureImageWriter::WritePNG(const TImagePixelData<FColor>& PixelData,
             {
                 uint8* RowData = TempBuffer.GetData() + BytesPerRow * Row;
                 RowPointers[Row] = RowData;
-                uint16* Dest = reinterpret_cast<uint16*>(RowData);
                 const int64 PixelRowStart = static_cast<int64>(RowStart + Row) * Size.X;
-                for (int32 Column = 0; Column < Size.X; ++Column)
-                {
-                    const FColor& Pixel = Pixels[PixelRowStart + Column];
-                    *Dest++ = static_cast<uint16>(Pixel.B) * 257u;
-                    *Dest++ = static_cast<uint16>(Pixel.G) * 257u;
-                    *Dest++ = static_cast<uint16>(Pixel.R) * 257u;
-                    *Dest++ = static_cast<uint16>(Pixel.A) * 257u;
-                }
+                FOmniCaptureCPUKernels::ExpandUNorm16BGRA(Pixels.GetData() + PixelRowStart, reinterpret_cast<uint16*>(RowData), Size.X);
             }
         };
 
@@ -736,6 +1480,66 @@ bool FOmniCaptureImageWriter::WritePNG(const TImagePixelData<FColor>& PixelData,
     return WritePNGRaw(FilePath, Size, Pixels.GetData(), Pixels.Num() * sizeof(FColor), ERGBFormat::BGRA, 8);
 }
 
+bool FOmniCaptureImageWriter::WriteRowSourceToDisk(const FOmniCaptureCPURowSource& RowSource, const FString& FilePath, EOmniCaptureImageFormat Format) const
+{
+    if (!RowSource.IsValid() || IsStopRequested())
+    {
+        return false;
+    }
+
+#if WITH_LIBPNG
+    if (Format == EOmniCaptureImageFormat::PNG)
+    {
+        return WriteStreamedPNG(RowSource, FilePath);
+    }
+#endif
+
+#if WITH_OMNICAPTURE_OPENEXR
+    if (Format == EOmniCaptureImageFormat::EXR && RowSource.bIsLinear)
+    {
+        return WriteStreamedEXR(RowSource, FilePath);
+    }
+#endif
+
+    // No row interface for this format in this build; the frame is materialised after all.
+    return WritePixelDataToDisk(MaterializeRowSource(RowSource), FilePath, Format, RowSource.bIsLinear, RowSource.PixelPrecision, RowSource.PixelDataType);
+}
+
+bool FOmniCaptureImageWriter::WriteStreamedPNG(const FOmniCaptureCPURowSource& RowSource, const FString& FilePath) const
+{
+    const int32 BitDepth = TargetPNGBitDepth == EOmniCapturePNGBitDepth::BitDepth16 ? 16 : 8;
+    const int64 SourceBytesPerRow = RowSource.GetBytesPerRow();
+
+    // 8-bit sRGB rows are already PNG's BGRA layout and are projected straight into the encoder's buffer.
+    const bool bDirect = BitDepth == 8 && RowSource.PixelDataType == EOmniCapturePixelDataType::Color8;
+
+    TArray64<uint8> SourceBand;
+    auto PrepareRows = [&RowSource, BitDepth, SourceBytesPerRow, bDirect, &SourceBand](int32 RowStart, int32 RowCount, int64 BytesPerRow, TArray64<uint8>& TempBuffer, TArray<uint8*>& RowPointers)
+    {
+        TempBuffer.SetNum(BytesPerRow * RowCount, EAllowShrinking::No);
+        if (bDirect)
+        {
+            RowSource.ProduceRows(RowStart, RowCount, TempBuffer.GetData());
+        }
+        else
+        {
+            SourceBand.SetNum(SourceBytesPerRow * RowCount, EAllowShrinking::No);
+            RowSource.ProduceRows(RowStart, RowCount, SourceBand.GetData());
+            for (int32 Row = 0; Row < RowCount; ++Row)
+            {
+                ConvertRowToPNG(RowSource.PixelDataType, SourceBand.GetData() + SourceBytesPerRow * Row, RowSource.Size.X, BitDepth, TempBuffer.GetData() + BytesPerRow * Row);
+            }
+        }
+
+        for (int32 Row = 0; Row < RowCount; ++Row)
+        {
+            RowPointers[Row] = TempBuffer.GetData() + BytesPerRow * Row;
+        }
+    };
+
+    return WritePNGWithRowSource(FilePath, RowSource.Size, ERGBFormat::BGRA, BitDepth, PrepareRows, StreamingBandRows);
+}
+
 bool FOmniCaptureImageWriter::WriteBMP(const TImagePixelData<FColor>& PixelData, const FString& FilePath) const
 {
     const TSharedPtr<IImageWrapper> ImageWrapper = CreateImageWrapper(EImageFormat::BMP);
@@ -761,14 +1565,13 @@ bool FOmniCaptureImageWriter::WriteBMP(const TImagePixelData<FColor>& PixelData,
         return false;
     }
 
-    const TArray64<uint8> CompressedData = ImageWrapper->GetCompressed(0);
+    TArray64<uint8> CompressedData = ImageWrapper->GetCompressed(0);
     if (CompressedData.Num() == 0)
     {
         return false;
     }
 
-    IFileManager::Get().Delete(*FilePath, false, true, false);
-    return FFileHelper::SaveArrayToFile(CompressedData, *FilePath);
+    return SaveEncodedFile(MoveTemp(CompressedData), FilePath);
 }
 
 bool FOmniCaptureImageWriter::WritePNGFromLinear(const TImagePixelData<FFloat16Color>& PixelData, const FString& FilePath) const
@@ -792,26 +1595,12 @@ bool FOmniCaptureImageWriter::WritePNGFromLinear(const TImagePixelData<FFloat16C
             const int64 RequiredSize = BytesPerRow * RowCount;
             TempBuffer.SetNum(RequiredSize, EAllowShrinking::No);
 
-            const auto ToUInt16 = [](float Value) -> uint16
-            {
-                const float Clamped = FMath::Clamp(Value, 0.0f, 1.0f);
-                return static_cast<uint16>(FMath::RoundToInt(Clamped * 65535.0f));
-            };
-
             for (int32 Row = 0; Row < RowCount; ++Row)
             {
                 uint8* RowData = TempBuffer.GetData() + BytesPerRow * Row;
                 RowPointers[Row] = RowData;
-                uint16* Dest = reinterpret_cast<uint16*>(RowData);
                 const int64 PixelRowStart = static_cast<int64>(RowStart + Row) * Size.X;
-                for (int32 Column = 0; Column < Size.X; ++Column)
-                {
-                    const FFloat16Color& Pixel = PixelData.Pixels[PixelRowStart + Column];
-                    *Dest++ = ToUInt16(Pixel.B.GetFloat());
-                    *Dest++ = ToUInt16(Pixel.G.GetFloat());
-                    *Dest++ = ToUInt16(Pixel.R.GetFloat());
-                    *Dest++ = ToUInt16(Pixel.A.GetFloat());
-                }
+                FOmniCaptureCPUKernels::PackUNorm16BGRA(PixelData.Pixels.GetData() + PixelRowStart, reinterpret_cast<uint16*>(RowData), Size.X);
             }
         };
 
@@ -823,21 +1612,8 @@ bool FOmniCaptureImageWriter::WritePNGFromLinear(const TImagePixelData<FFloat16C
     TArray64<uint8> ConvertedPixels;
     ConvertedPixels.SetNum(PixelCount * 4, EAllowShrinking::No);
 
-    for (int64 PixelIndex = 0; PixelIndex < PixelCount; ++PixelIndex)
-    {
-        const FFloat16Color& Pixel = PixelData.Pixels[PixelIndex];
-        const FLinearColor Linear(
-            Pixel.R.GetFloat(),
-            Pixel.G.GetFloat(),
-            Pixel.B.GetFloat(),
-            Pixel.A.GetFloat());
-        const FColor Converted = Linear.ToFColor(true);
-        const int64 Offset = PixelIndex * 4;
-        ConvertedPixels[Offset + 0] = Converted.B;
-        ConvertedPixels[Offset + 1] = Converted.G;
-        ConvertedPixels[Offset + 2] = Converted.R;
-        ConvertedPixels[Offset + 3] = Converted.A;
-    }
+    // FColor is laid out B, G, R, A, which is already the PNG row order.
+    FOmniCaptureCPUKernels::PackSRGB(PixelData.Pixels.GetData(), reinterpret_cast<FColor*>(ConvertedPixels.GetData()), ExpectedCount);
 
     uint8* ConvertedBasePtr = ConvertedPixels.GetData();
     auto PrepareRows = [ConvertedBasePtr, BytesPerRow](int32 RowStart, int32 RowCount, int64, TArray64<uint8>& TempBuffer, TArray<uint8*>& RowPointers)
@@ -878,26 +1654,12 @@ bool FOmniCaptureImageWriter::WritePNGFromLinearFloat32(const TImagePixelData<FL
             const int64 RequiredSize = BytesPerRow * RowCount;
             TempBuffer.SetNum(RequiredSize, EAllowShrinking::No);
 
-            const auto ToUInt16 = [](float Value) -> uint16
-            {
-                const float Clamped = FMath::Clamp(Value, 0.0f, 1.0f);
-                return static_cast<uint16>(FMath::RoundToInt(Clamped * 65535.0f));
-            };
-
             for (int32 Row = 0; Row < RowCount; ++Row)
             {
                 uint8* RowData = TempBuffer.GetData() + BytesPerRow * Row;
                 RowPointers[Row] = RowData;
-                uint16* Dest = reinterpret_cast<uint16*>(RowData);
                 const int64 PixelRowStart = static_cast<int64>(RowStart + Row) * Size.X;
-                for (int32 Column = 0; Column < Size.X; ++Column)
-                {
-                    const FLinearColor& Pixel = PixelData.Pixels[PixelRowStart + Column];
-                    *Dest++ = ToUInt16(Pixel.B);
-                    *Dest++ = ToUInt16(Pixel.G);
-                    *Dest++ = ToUInt16(Pixel.R);
-                    *Dest++ = ToUInt16(Pixel.A);
-                }
+                FOmniCaptureCPUKernels::PackUNorm16BGRA(PixelData.Pixels.GetData() + PixelRowStart, reinterpret_cast<uint16*>(RowData), Size.X);
             }
         };
 
@@ -914,16 +1676,7 @@ bool FOmniCaptureImageWriter::WritePNGFromLinearFloat32(const TImagePixelData<FL
             uint8* RowData = TempBuffer.GetData() + BytesPerRow * Row;
             RowPointers[Row] = RowData;
             const int64 PixelRowStart = static_cast<int64>(RowStart + Row) * Size.X;
-            for (int32 Column = 0; Column < Size.X; ++Column)
-            {
-                const FLinearColor& Pixel = PixelData.Pixels[PixelRowStart + Column];
-                const FColor Converted = Pixel.ToFColor(true);
-                const int64 Offset = static_cast<int64>(Column) * 4;
-                RowData[Offset + 0] = Converted.B;
-                RowData[Offset + 1] = Converted.G;
-                RowData[Offset + 2] = Converted.R;
-                RowData[Offset + 3] = Converted.A;
-            }
+            FOmniCaptureCPUKernels::PackSRGB(PixelData.Pixels.GetData() + PixelRowStart, reinterpret_cast<FColor*>(RowData), Size.X);
         }
     };
 
@@ -944,21 +1697,9 @@ bool FOmniCaptureImageWriter::WriteBMPFromLinear(const TImagePixelData<FFloat16C
         return false;
     }
 
-    TArray<FColor> Converted;
-    Converted.SetNum(ExpectedCount);
-    for (int32 Index = 0; Index < ExpectedCount; ++Index)
-    {
-        const FFloat16Color& Pixel = PixelData.Pixels[Index];
-        const FLinearColor Linear(
-            Pixel.R.GetFloat(),
-            Pixel.G.GetFloat(),
-            Pixel.B.GetFloat(),
-            Pixel.A.GetFloat());
-        Converted[Index] = Linear.ToFColor(true);
-    }
-
     TUniquePtr<TImagePixelData<FColor>> TempData = MakeUnique<TImagePixelData<FColor>>(Size);
-    TempData->Pixels = MoveTemp(Converted);
+    TempData->Pixels.SetNumUninitialized(ExpectedCount);
+    FOmniCaptureCPUKernels::PackSRGB(PixelData.Pixels.GetData(), TempData->Pixels.GetData(), ExpectedCount);
     return WriteBMP(*TempData, FilePath);
 }
 
@@ -977,24 +1718,14 @@ bool FOmniCaptureImageWriter::WriteBMPFromLinearFloat32(const TImagePixelData<FL
     }
 
     TUniquePtr<TImagePixelData<FColor>> TempData = MakeUnique<TImagePixelData<FColor>>(Size);
-    TempData->Pixels.SetNum(ExpectedCount);
-
-    for (int32 Index = 0; Index < ExpectedCount; ++Index)
-    {
-        TempData->Pixels[Index] = PixelData.Pixels[Index].ToFColor(true);
-    }
+    TempData->Pixels.SetNumUninitialized(ExpectedCount);
+    FOmniCaptureCPUKernels::PackSRGB(PixelData.Pixels.GetData(), TempData->Pixels.GetData(), ExpectedCount);
 
     return WriteBMP(*TempData, FilePath);
 }
 
 bool FOmniCaptureImageWriter::WriteJPEG(const TImagePixelData<FColor>& PixelData, const FString& FilePath) const
 {
-    const TSharedPtr<IImageWrapper> ImageWrapper = CreateImageWrapper(EImageFormat::JPEG);
-    if (!ImageWrapper.IsValid())
-    {
-        return false;
-    }
-
     if (IsStopRequested())
     {
         return false;
@@ -1007,19 +1738,40 @@ bool FOmniCaptureImageWriter::WriteJPEG(const TImagePixelData<FColor>& PixelData
         return false;
     }
 
+    if (FOmniCaptureJPEGEncoder::IsAvailable())
+    {
+        FOmniCaptureJPEGEncodeOptions EncodeOptions;
+        EncodeOptions.Quality = JPEGQuality;
+        EncodeOptions.Subsampling = JPEGSubsampling;
+        EncodeOptions.bFastDCT = bJPEGFastDCT;
+        EncodeOptions.MaxThreads = ResolveStripThreads(JPEGEncodeThreads);
+
+        TArray64<uint8> EncodedData;
+        if (FOmniCaptureJPEGEncoder::Encode(Size, Pixels.GetData(), EncodeOptions, EncodedData))
+        {
+            return SaveEncodedFile(MoveTemp(EncodedData), FilePath);
+        }
+    }
+
+    // Without libjpeg-turbo only the quality setting carries over; subsampling is whatever the wrapper uses.
+    const TSharedPtr<IImageWrapper> ImageWrapper = CreateImageWrapper(EImageFormat::JPEG);
+    if (!ImageWrapper.IsValid())
+    {
+        return false;
+    }
+
     if (!ImageWrapper->SetRaw(reinterpret_cast<const uint8*>(Pixels.GetData()), Pixels.Num() * sizeof(FColor), Size.X, Size.Y, ERGBFormat::BGRA, 8))
     {
         return false;
     }
 
-    const TArray64<uint8> CompressedData = ImageWrapper->GetCompressed(DefaultJpegQuality);
+    TArray64<uint8> CompressedData = ImageWrapper->GetCompressed(JPEGQuality);
     if (CompressedData.Num() == 0)
     {
         return false;
     }
 
-    IFileManager::Get().Delete(*FilePath, false, true, false);
-    return FFileHelper::SaveArrayToFile(CompressedData, *FilePath);
+    return SaveEncodedFile(MoveTemp(CompressedData), FilePath);
 }
 
 bool FOmniCaptureImageWriter::WriteJPEGFromLinear(const TImagePixelData<FFloat16Color>& PixelData, const FString& FilePath) const
@@ -1036,21 +1788,9 @@ bool FOmniCaptureImageWriter::WriteJPEGFromLinear(const TImagePixelData<FFloat16
         return false;
     }
 
-    TArray<FColor> Converted;
-    Converted.SetNum(ExpectedCount);
-    for (int32 Index = 0; Index < ExpectedCount; ++Index)
-    {
-        const FFloat16Color& Pixel = PixelData.Pixels[Index];
-        const FLinearColor Linear(
-            Pixel.R.GetFloat(),
-            Pixel.G.GetFloat(),
-            Pixel.B.GetFloat(),
-            Pixel.A.GetFloat());
-        Converted[Index] = Linear.ToFColor(true);
-    }
-
     TUniquePtr<TImagePixelData<FColor>> TempData = MakeUnique<TImagePixelData<FColor>>(Size);
-    TempData->Pixels = MoveTemp(Converted);
+    TempData->Pixels.SetNumUninitialized(ExpectedCount);
+    FOmniCaptureCPUKernels::PackSRGB(PixelData.Pixels.GetData(), TempData->Pixels.GetData(), ExpectedCount);
     return WriteJPEG(*TempData, FilePath);
 }
 
@@ -1069,12 +1809,8 @@ bool FOmniCaptureImageWriter::WriteJPEGFromLinearFloat32(const TImagePixelData<F
     }
 
     TUniquePtr<TImagePixelData<FColor>> TempData = MakeUnique<TImagePixelData<FColor>>(Size);
-    TempData->Pixels.SetNum(ExpectedCount);
-
-    for (int32 Index = 0; Index < ExpectedCount; ++Index)
-    {
-        TempData->Pixels[Index] = PixelData.Pixels[Index].ToFColor(true);
-    }
+    TempData->Pixels.SetNumUninitialized(ExpectedCount);
+    FOmniCaptureCPUKernels::PackSRGB(PixelData.Pixels.GetData(), TempData->Pixels.GetData(), ExpectedCount);
 
     return WriteJPEG(*TempData, FilePath);
 }
@@ -1208,69 +1944,48 @@ bool FOmniCaptureImageWriter::WriteCombinedEXR(const FString& FilePath, TArray<F
             return false;
         }
 
+        const void* RawData = nullptr;
+        int64 RawBytes = 0;
+        if (!Layer.PixelData->GetRawData(RawData, RawBytes))
+        {
+            return false;
+        }
+
         FPreparedExrLayer& Prepared = PreparedLayers.Emplace_GetRef();
         FTCHARToUTF8 NameUtf8(*Layer.Name);
         Prepared.Name = std::string(NameUtf8.Length() > 0 ? NameUtf8.Get() : "");
         Prepared.ChannelCount = 4;
 
-        const FImagePixelData* PixelData = Layer.PixelData.Get();
-        EOmniCapturePixelPrecision Precision = Layer.Precision;
-        if (Precision == EOmniCapturePixelPrecision::Unknown)
-        {
-            Precision = EOmniCapturePixelPrecision::HalfFloat;
-        }
-
+        // Float layers are handed to OpenEXR where they lie; the slices pick R, G, B and A out of each pixel.
         switch (Layer.PixelDataType)
         {
         case EOmniCapturePixelDataType::LinearColorFloat32:
-        {
-            const TImagePixelData<FLinearColor>* Float32Data = static_cast<const TImagePixelData<FLinearColor>*>(PixelData);
-            Prepared.PixelType = OPENEXR_IMF_NAMESPACE::PixelType::FLOAT;
-            Prepared.FloatBuffer.SetNum(PixelCount * 4);
-
-            for (int64 Index = 0; Index < PixelCount; ++Index)
+            if (RawBytes < PixelCount * static_cast<int64>(sizeof(FLinearColor)))
             {
-                const FLinearColor& Src = Float32Data->Pixels[Index];
-                const int64 Base = Index * 4;
-                Prepared.FloatBuffer[Base + 0] = Src.R;
-                Prepared.FloatBuffer[Base + 1] = Src.G;
-                Prepared.FloatBuffer[Base + 2] = Src.B;
-                Prepared.FloatBuffer[Base + 3] = Src.A;
+                return false;
             }
+            Prepared.SetSource(RawData, OPENEXR_IMF_NAMESPACE::PixelType::FLOAT, sizeof(FLinearColor),
+                STRUCT_OFFSET(FLinearColor, R), STRUCT_OFFSET(FLinearColor, G), STRUCT_OFFSET(FLinearColor, B), STRUCT_OFFSET(FLinearColor, A));
             break;
-        }
         case EOmniCapturePixelDataType::LinearColorFloat16:
-        {
-            const TImagePixelData<FFloat16Color>* Float16Data = static_cast<const TImagePixelData<FFloat16Color>*>(PixelData);
-            Prepared.PixelType = OPENEXR_IMF_NAMESPACE::PixelType::HALF;
-            Prepared.HalfBuffer.SetNum(PixelCount * 4);
-
-            for (int64 Index = 0; Index < PixelCount; ++Index)
+            if (RawBytes < PixelCount * static_cast<int64>(sizeof(FFloat16Color)))
             {
-                const FFloat16Color& Src = Float16Data->Pixels[Index];
-                const int64 Base = Index * 4;
-                Prepared.HalfBuffer[Base + 0] = IMATH_NAMESPACE::half(Src.R.GetFloat());
-                Prepared.HalfBuffer[Base + 1] = IMATH_NAMESPACE::half(Src.G.GetFloat());
-                Prepared.HalfBuffer[Base + 2] = IMATH_NAMESPACE::half(Src.B.GetFloat());
-                Prepared.HalfBuffer[Base + 3] = IMATH_NAMESPACE::half(Src.A.GetFloat());
+                return false;
             }
+            Prepared.SetSource(RawData, OPENEXR_IMF_NAMESPACE::PixelType::HALF, sizeof(FFloat16Color),
+                STRUCT_OFFSET(FFloat16Color, R), STRUCT_OFFSET(FFloat16Color, G), STRUCT_OFFSET(FFloat16Color, B), STRUCT_OFFSET(FFloat16Color, A));
             break;
-        }
         case EOmniCapturePixelDataType::Color8:
         {
-            const TImagePixelData<FColor>* ColorData = static_cast<const TImagePixelData<FColor>*>(PixelData);
-            Prepared.PixelType = OPENEXR_IMF_NAMESPACE::PixelType::FLOAT;
-            Prepared.FloatBuffer.SetNum(PixelCount * 4);
-
-            for (int64 Index = 0; Index < PixelCount; ++Index)
+            if (RawBytes < PixelCount * static_cast<int64>(sizeof(FColor)))
             {
-                const FLinearColor Src = ColorData->Pixels[Index].ReinterpretAsLinear();
-                const int64 Base = Index * 4;
-                Prepared.FloatBuffer[Base + 0] = Src.R;
-                Prepared.FloatBuffer[Base + 1] = Src.G;
-                Prepared.FloatBuffer[Base + 2] = Src.B;
-                Prepared.FloatBuffer[Base + 3] = Src.A;
+                return false;
             }
+
+            Prepared.ConvertedPixels.SetNumUninitialized(PixelCount);
+            FOmniCaptureCPUKernels::UnpackColor(static_cast<const FColor*>(RawData), Prepared.ConvertedPixels.GetData(), static_cast<int32>(PixelCount));
+            Prepared.SetSource(Prepared.ConvertedPixels.GetData(), OPENEXR_IMF_NAMESPACE::PixelType::FLOAT, sizeof(FLinearColor),
+                STRUCT_OFFSET(FLinearColor, R), STRUCT_OFFSET(FLinearColor, G), STRUCT_OFFSET(FLinearColor, B), STRUCT_OFFSET(FLinearColor, A));
             break;
         }
         default:
@@ -1279,6 +1994,7 @@ bool FOmniCaptureImageWriter::WriteCombinedEXR(const FString& FilePath, TArray<F
         }
     }
 
+    const int32 ExrThreads = PrepareOpenExrThreads(EXRThreadCount);
     IFileManager::Get().Delete(*FilePath, false, true, false);
 
     bool bSucceeded = false;
@@ -1307,21 +2023,14 @@ bool FOmniCaptureImageWriter::WriteCombinedEXR(const FString& FilePath, TArray<F
                     const TCHAR* ChannelSuffix = GetChannelSuffix(ChannelIndex);
                     FTCHARToUTF8 ChannelUtf8(ChannelSuffix);
                     Header.channels().insert(ChannelUtf8.Get(), OPENEXR_IMF_NAMESPACE::Channel(Prepared.PixelType));
-
-                    const char* BasePtr = Prepared.GetBasePointer();
-                    const int32 ComponentSize = Prepared.GetComponentSize();
-                    const size_t PixelStride = static_cast<size_t>(ComponentSize) * Prepared.ChannelCount;
-                    const size_t RowStride = PixelStride * ExpectedSize.X;
-                    const size_t ChannelOffset = static_cast<size_t>(ComponentSize) * ChannelIndex;
-
-                    Buffer.insert(ChannelUtf8.Get(), OPENEXR_IMF_NAMESPACE::Slice(Prepared.PixelType, const_cast<char*>(BasePtr) + ChannelOffset, PixelStride, RowStride));
+                    Buffer.insert(ChannelUtf8.Get(), Prepared.MakeSlice(ChannelIndex, ExpectedSize.X));
                 }
 
                 Headers.Add(Header);
                 FrameBuffers.Add(Buffer);
             }
 
-            OPENEXR_IMF_NAMESPACE::MultiPartOutputFile OutputFile(TCHAR_TO_UTF8(*FilePath), Headers.GetData(), Headers.Num());
+            OPENEXR_IMF_NAMESPACE::MultiPartOutputFile OutputFile(TCHAR_TO_UTF8(*FilePath), Headers.GetData(), Headers.Num(), false, ExrThreads);
             for (int32 PartIndex = 0; PartIndex < Headers.Num(); ++PartIndex)
             {
                 OPENEXR_IMF_NAMESPACE::OutputPart Part(OutputFile, PartIndex);
@@ -1345,18 +2054,11 @@ bool FOmniCaptureImageWriter::WriteCombinedEXR(const FString& FilePath, TArray<F
                     const std::string ChannelName = Prefix + ChannelUtf8.Get();
 
                     Header.channels().insert(ChannelName.c_str(), OPENEXR_IMF_NAMESPACE::Channel(Prepared.PixelType));
-
-                    const char* BasePtr = Prepared.GetBasePointer();
-                    const int32 ComponentSize = Prepared.GetComponentSize();
-                    const size_t PixelStride = static_cast<size_t>(ComponentSize) * Prepared.ChannelCount;
-                    const size_t RowStride = PixelStride * ExpectedSize.X;
-                    const size_t ChannelOffset = static_cast<size_t>(ComponentSize) * ChannelIndex;
-
-                    FrameBuffer.insert(ChannelName.c_str(), OPENEXR_IMF_NAMESPACE::Slice(Prepared.PixelType, const_cast<char*>(BasePtr) + ChannelOffset, PixelStride, RowStride));
+                    FrameBuffer.insert(ChannelName.c_str(), Prepared.MakeSlice(ChannelIndex, ExpectedSize.X));
                 }
             }
 
-            OPENEXR_IMF_NAMESPACE::OutputFile OutputFile(TCHAR_TO_UTF8(*FilePath), Header);
+            OPENEXR_IMF_NAMESPACE::OutputFile OutputFile(TCHAR_TO_UTF8(*FilePath), Header, ExrThreads);
             OutputFile.setFrameBuffer(FrameBuffer);
             OutputFile.writePixels(ExpectedSize.Y);
         }
@@ -1372,8 +2074,71 @@ bool FOmniCaptureImageWriter::WriteCombinedEXR(const FString& FilePath, TArray<F
     {
         for (FExrLayerRequest& Layer : Layers)
         {
-            Layer.PixelData.Reset();
+            FOmniCaptureFramePool::Get().ReleasePixels(MoveTemp(Layer.PixelData));
+        }
+    }
+
+    return bSucceeded;
+}
+#endif // WITH_OMNICAPTURE_OPENEXR
+
+#if WITH_OMNICAPTURE_OPENEXR
+bool FOmniCaptureImageWriter::WriteStreamedEXR(const FOmniCaptureCPURowSource& RowSource, const FString& FilePath) const
+{
+    const FIntPoint Size = RowSource.Size;
+    const bool bFullFloat = RowSource.PixelDataType == EOmniCapturePixelDataType::LinearColorFloat32;
+    const OPENEXR_IMF_NAMESPACE::PixelType PixelType = bFullFloat ? OPENEXR_IMF_NAMESPACE::PixelType::FLOAT : OPENEXR_IMF_NAMESPACE::PixelType::HALF;
+    const int32 ComponentSize = bFullFloat ? sizeof(float) : sizeof(IMATH_NAMESPACE::half);
+    const size_t PixelStride = static_cast<size_t>(ComponentSize) * 4;
+    const size_t RowStride = static_cast<size_t>(RowSource.GetBytesPerRow());
+    const int32 BandRows = FMath::Clamp(StreamingBandRows, 1, Size.Y);
+
+    TArray64<uint8> Band;
+    Band.SetNumUninitialized(static_cast<int64>(RowStride) * BandRows);
+
+    IFileManager::Get().Delete(*FilePath, false, true, false);
+
+    bool bSucceeded = false;
+    try
+    {
+        OPENEXR_IMF_NAMESPACE::Header Header(Size.X, Size.Y);
+        Header.compression() = ToOpenExrCompression(TargetEXRCompression);
+        for (int32 ChannelIndex = 0; ChannelIndex < 4; ++ChannelIndex)
+        {
+            FTCHARToUTF8 ChannelUtf8(GetChannelSuffix(ChannelIndex));
+            Header.channels().insert(ChannelUtf8.Get(), OPENEXR_IMF_NAMESPACE::Channel(PixelType));
+        }
+
+        OPENEXR_IMF_NAMESPACE::OutputFile OutputFile(TCHAR_TO_UTF8(*FilePath), Header, PrepareOpenExrThreads(EXRThreadCount));
+        int32 RowStart = 0;
+        for (; RowStart < Size.Y && !IsStopRequested(); RowStart += BandRows)
+        {
+            const int32 RowCount = FMath::Min(BandRows, Size.Y - RowStart);
+            RowSource.ProduceRows(RowStart, RowCount, Band.GetData());
+
+            // Slices address absolute scanlines, so the base points to where row zero would sit relative to this band.
+            char* BasePtr = reinterpret_cast<char*>(Band.GetData()) - static_cast<ptrdiff_t>(RowStart) * RowStride;
+            OPENEXR_IMF_NAMESPACE::FrameBuffer FrameBuffer;
+            for (int32 ChannelIndex = 0; ChannelIndex < 4; ++ChannelIndex)
+            {
+                FTCHARToUTF8 ChannelUtf8(GetChannelSuffix(ChannelIndex));
+                FrameBuffer.insert(ChannelUtf8.Get(), OPENEXR_IMF_NAMESPACE::Slice(PixelType, BasePtr + static_cast<size_t>(ComponentSize) * ChannelIndex, PixelStride, RowStride));
+            }
+
+            OutputFile.setFrameBuffer(FrameBuffer);
+            OutputFile.writePixels(RowCount);
         }
+
+        bSucceeded = RowStart >= Size.Y;
+    }
+    catch (const std::exception& Exception)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Failed to write streamed EXR '%s': %s"), *FilePath, UTF8_TO_TCHAR(Exception.what()));
+    }
+
+    if (!bSucceeded)
+    {
+        IFileManager::Get().Delete(*FilePath, false, true, true);
     }
 
     return bSucceeded;
@@ -1386,6 +2151,12 @@ bool FOmniCaptureImageWriter::WriteCombinedEXR(const FString& FilePath, TArray<F
     UE_LOG(LogTemp, Verbose, TEXT("Skipping combined EXR output for %s because OpenEXR support is unavailable."), *FilePath);
     return false;
 }
+
+bool FOmniCaptureImageWriter::WriteStreamedEXR(const FOmniCaptureCPURowSource& RowSource, const FString& FilePath) const
+{
+    UE_LOG(LogTemp, Verbose, TEXT("Skipping streamed EXR output for %s because OpenEXR support is unavailable."), *FilePath);
+    return false;
+}
 #endif
 
 bool FOmniCaptureImageWriter::WriteEXR(TUniquePtr<FImagePixelData> PixelData, const FString& FilePath, EOmniCapturePixelPrecision PixelPrecision, EOmniCapturePixelDataType PixelDataType) const
@@ -1448,15 +2219,9 @@ bool FOmniCaptureImageWriter::WriteEXRFromColor(const TImagePixelData<FColor>& P
         return false;
     }
 
-    TArray<FFloat16Color> Converted;
-    Converted.SetNum(ExpectedCount);
-    for (int32 Index = 0; Index < ExpectedCount; ++Index)
-    {
-        Converted[Index] = FFloat16Color(PixelData.Pixels[Index].ReinterpretAsLinear());
-    }
-
     TUniquePtr<TImagePixelData<FFloat16Color>> TempData = MakeUnique<TImagePixelData<FFloat16Color>>(Size);
-    TempData->Pixels = MoveTemp(Converted);
+    TempData->Pixels.SetNumUninitialized(ExpectedCount);
+    FOmniCaptureCPUKernels::UnpackColor(PixelData.Pixels.GetData(), TempData->Pixels.GetData(), ExpectedCount);
     return WriteEXR(MoveTemp(TempData), FilePath, EOmniCapturePixelPrecision::HalfFloat, EOmniCapturePixelDataType::LinearColorFloat16);
 }
 
@@ -1472,8 +2237,8 @@ bool FOmniCaptureImageWriter::WriteEXRInternal(TUniquePtr<FImagePixelData> Pixel
         return false;
     }
 
-#if OMNICAPTURE_UE_VERSION_AT_LEAST(5, 5, 0)
 #if WITH_OMNICAPTURE_OPENEXR
+    // Written through OpenEXR directly whenever it is available, so single-layer frames get the same threaded compression.
     TArray<FExrLayerRequest> Layers;
     FExrLayerRequest& Layer = Layers.Emplace_GetRef();
     Layer.PixelData = MoveTemp(PixelData);
@@ -1481,12 +2246,14 @@ bool FOmniCaptureImageWriter::WriteEXRInternal(TUniquePtr<FImagePixelData> Pixel
     Layer.Precision = (PixelType == EImagePixelType::Float32)
         ? EOmniCapturePixelPrecision::FullFloat
         : EOmniCapturePixelPrecision::HalfFloat;
+    Layer.PixelDataType = (PixelType == EImagePixelType::Float32)
+        ? EOmniCapturePixelDataType::LinearColorFloat32
+        : EOmniCapturePixelDataType::LinearColorFloat16;
 
     return WriteCombinedEXR(FilePath, Layers);
-#else
+#elif OMNICAPTURE_UE_VERSION_AT_LEAST(5, 5, 0)
     UE_LOG(LogTemp, Warning, TEXT("EXR writing is unavailable: OpenEXR support is required when building against UE 5.5 or newer."));
     return false;
-#endif // WITH_OMNICAPTURE_OPENEXR
 #else
     IImageWriteQueueModule& ImageWriteModule = FModuleManager::LoadModuleChecked<IImageWriteQueueModule>(TEXT("ImageWriteQueue"));
     IImageWriteQueue& WriteQueue = ImageWriteModule.GetWriteQueue();
@@ -1508,7 +2275,7 @@ bool FOmniCaptureImageWriter::WriteEXRInternal(TUniquePtr<FImagePixelData> Pixel
 
     WriteQueue.Enqueue(MoveTemp(Task));
     return CompletionFuture.Get();
-#endif // OMNICAPTURE_UE_VERSION_AT_LEAST(5, 5, 0)
+#endif // WITH_OMNICAPTURE_OPENEXR
 }
 
 void FOmniCaptureImageWriter::RequestStop()
@@ -1521,108 +2288,177 @@ bool FOmniCaptureImageWriter::IsStopRequested() const
     return bStopRequested.Load();
 }
 
-void FOmniCaptureImageWriter::WaitForAvailableTaskSlot()
+bool FOmniCaptureImageWriter::TryAcquireTaskSlot()
 {
-    if (MaxPendingTasks <= 0)
+    int32 InFlight = InFlightTasks.Load();
+    while (MaxPendingTasks <= 0 || InFlight - WaitingRepeats.Load() < MaxPendingTasks)
     {
-        return;
-    }
-
-    while (!IsStopRequested())
-    {
-        TFuture<bool> TaskToWait;
+        if (InFlightTasks.CompareExchange(InFlight, InFlight + 1))
         {
-            FScopeLock Lock(&PendingTasksCS);
-            if (PendingTasks.Num() < MaxPendingTasks)
+            int32 Peak = PeakInFlightTasks.Load();
+            while (InFlight + 1 > Peak && !PeakInFlightTasks.CompareExchange(Peak, InFlight + 1))
             {
-                break;
             }
-
-            TaskToWait = MoveTemp(PendingTasks[0]);
-            PendingTasks.RemoveAt(0, 1, EAllowShrinking::No);
+            return true;
         }
+    }
+    return false;
+}
+
+bool FOmniCaptureImageWriter::AcquireTaskSlot()
+{
+    if (TryAcquireTaskSlot())
+    {
+        return true;
+    }
 
-        if (TaskToWait.IsValid())
+    const double WaitStart = FPlatformTime::Seconds();
+    bool bAcquired = false;
+    while (!bAcquired && !IsStopRequested())
+    {
+        // Registered before the retry so a task finishing in between either sees the waiter or leaves a slot to take.
+        WaitingForSlot.IncrementExchange();
+        bAcquired = TryAcquireTaskSlot();
+        if (!bAcquired)
         {
-            const bool bResult = TaskToWait.Get();
-            if (!bResult)
-            {
-                UE_LOG(LogTemp, Warning, TEXT("OmniCapture image write task failed"));
-            }
+            TaskCompletedEvent->Wait(SlotWaitTimeoutMilliseconds);
         }
+        WaitingForSlot.DecrementExchange();
     }
+
+    FScopeLock Lock(&TaskStatsCS);
+    ++TaskStats.SlotWaits;
+    TaskStats.SlotWaitMilliseconds += (FPlatformTime::Seconds() - WaitStart) * 1000.0;
+    return bAcquired;
 }
 
-void FOmniCaptureImageWriter::TrackPendingTask(TFuture<bool>&& TaskFuture)
+void FOmniCaptureImageWriter::CompleteTask(const FString& FilePath, double EnqueueTime, double StartTime, double EncodeEndTime, double IOSeconds, bool bSucceeded)
 {
-    FScopeLock Lock(&PendingTasksCS);
-    PendingTasks.Add(MoveTemp(TaskFuture));
+    const double EndTime = FPlatformTime::Seconds();
+    const double QueueSeconds = StartTime - EnqueueTime;
+    const double EncodeSeconds = EncodeEndTime - StartTime;
+    const double TotalSeconds = EndTime - EnqueueTime;
+
+    FScopeLock Lock(&TaskStatsCS);
+    ++TaskStats.CompletedTasks;
+    TotalQueueSeconds += QueueSeconds;
+    TotalEncodeSeconds += EncodeSeconds;
+    TotalIOSeconds += IOSeconds;
+    TaskStats.MaxQueueMilliseconds = FMath::Max(TaskStats.MaxQueueMilliseconds, QueueSeconds * 1000.0);
+    TaskStats.MaxEncodeMilliseconds = FMath::Max(TaskStats.MaxEncodeMilliseconds, EncodeSeconds * 1000.0);
+    TaskStats.MaxIOMilliseconds = FMath::Max(TaskStats.MaxIOMilliseconds, IOSeconds * 1000.0);
+    if (!bSucceeded)
+    {
+        ++TaskStats.FailedTasks;
+        UE_LOG(LogTemp, Warning, TEXT("OmniCapture image write task failed (%s)"), *FilePath);
+    }
+    if (TotalSeconds > StalledTaskSeconds)
+    {
+        ++TaskStats.StalledTasks;
+        UE_LOG(LogTemp, Warning, TEXT("OmniCapture image write stalled: %s took %.0f ms (%.0f ms queued, %.0f ms encoding, %.0f ms writing)"), *FilePath, TotalSeconds * 1000.0, QueueSeconds * 1000.0, EncodeSeconds * 1000.0, IOSeconds * 1000.0);
+    }
+
+    InFlightTasks.DecrementExchange();
+    if (WaitingForSlot.Load() > 0)
+    {
+        TaskCompletedEvent->Trigger();
+    }
 }
 
-void FOmniCaptureImageWriter::PruneCompletedTasks()
+void FOmniCaptureImageWriter::WaitForAllTasks()
 {
-    FScopeLock Lock(&PendingTasksCS);
-    for (int32 Index = PendingTasks.Num() - 1; Index >= 0; --Index)
+    while (InFlightTasks.Load() > 0)
     {
-        if (PendingTasks[Index].IsReady())
+        WaitingForSlot.IncrementExchange();
+        if (InFlightTasks.Load() > 0)
         {
-            const bool bResult = PendingTasks[Index].Get();
-            if (!bResult)
-            {
-                UE_LOG(LogTemp, Warning, TEXT("OmniCapture image write task failed"));
-            }
-            PendingTasks.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+            TaskCompletedEvent->Wait(SlotWaitTimeoutMilliseconds);
         }
+        WaitingForSlot.DecrementExchange();
     }
+
+    // The last task may still be inside CompleteTask; taking the lock waits it out.
+    FScopeLock Lock(&TaskStatsCS);
 }
 
-void FOmniCaptureImageWriter::EnforcePendingTaskLimit()
+FOmniCaptureImageWriterStats FOmniCaptureImageWriter::GetTaskStats() const
 {
-    if (MaxPendingTasks <= 0)
+    // The pools are started and stopped under WorkerPoolCS; taken before TaskStatsCS, in the same order as Flush.
+    FScopeLock PoolLock(&WorkerPoolCS);
+    FScopeLock Lock(&TaskStatsCS);
+    FOmniCaptureImageWriterStats Stats = TaskStats;
+    Stats.InFlightTasks = InFlightTasks.Load();
+    Stats.PeakInFlightTasks = PeakInFlightTasks.Load();
+    Stats.MaxPendingTasks = MaxPendingTasks;
+    if (Stats.CompletedTasks > 0)
     {
-        return;
+        Stats.AverageQueueMilliseconds = TotalQueueSeconds * 1000.0 / Stats.CompletedTasks;
+        Stats.AverageEncodeMilliseconds = TotalEncodeSeconds * 1000.0 / Stats.CompletedTasks;
+        Stats.AverageIOMilliseconds = TotalIOSeconds * 1000.0 / Stats.CompletedTasks;
     }
-
-    while (true)
+    if (EncodePool.IsRunning())
     {
-        TFuture<bool> TaskToWait;
-        {
-            FScopeLock Lock(&PendingTasksCS);
-            if (PendingTasks.Num() <= MaxPendingTasks)
-            {
-                break;
-            }
+        Stats.EncodeThreads = EncodePool.GetThreadCount();
+        Stats.EncodeUtilization = EncodePool.GetUtilization();
+    }
+    if (IOPool.IsRunning())
+    {
+        Stats.IOThreads = IOPool.GetThreadCount();
+        Stats.IOUtilization = IOPool.GetUtilization();
+    }
+    Stats.QueuedIOJobs = IOPool.GetQueuedJobs();
+    Stats.DuplicateFrames = DuplicateFrames.Load();
+    return Stats;
+}
 
-            TaskToWait = MoveTemp(PendingTasks[0]);
-            PendingTasks.RemoveAt(0, 1, EAllowShrinking::No);
-        }
+FString FOmniCaptureImageWriter::GetFramePackPath() const
+{
+    return OutputDirectory / (SequenceBaseName + FOmniCaptureFramePackWriter::GetExtension());
+}
 
-        if (TaskToWait.IsValid())
-        {
-            const bool bResult = TaskToWait.Get();
-            if (!bResult)
-            {
-                UE_LOG(LogTemp, Warning, TEXT("OmniCapture image write task failed"));
-            }
-        }
-    }
+int64 FOmniCaptureImageWriter::GetFramePackBytesWritten() const
+{
+    FScopeLock Lock(&WorkerPoolCS);
+    return FramePack.IsValid() ? FramePack->GetBytesWritten() : 0;
 }
 
-void FOmniCaptureImageWriter::WaitForAllTasks()
+int64 FOmniCaptureImageWriter::GetBytesWritten() const
+{
+    return LooseBytesWritten.Load() + GetFramePackBytesWritten();
+}
+
+void FOmniCaptureImageWriter::EnsureWorkerPools()
 {
-    TArray<TFuture<bool>> TasksToWait;
+    if (bWorkerPoolsStarted.Load())
     {
-        FScopeLock Lock(&PendingTasksCS);
-        TasksToWait = MoveTemp(PendingTasks);
-        PendingTasks.Reset();
+        return;
     }
 
-    for (TFuture<bool>& Task : TasksToWait)
+    FScopeLock Lock(&WorkerPoolCS);
+    if (bWorkerPoolsStarted.Load())
     {
-        const bool bResult = Task.Get();
-        if (!bResult)
+        return;
+    }
+
+    // More encode threads than task slots would only ever sit idle.
+    const int32 DefaultEncodeThreads = FMath::Max(1, FPlatformMisc::NumberOfWorkerThreadsToSpawn());
+    const int32 EncodeThreads = FMath::Min(EncodeThreadCount > 0 ? EncodeThreadCount : DefaultEncodeThreads, MaxPendingTasks);
+    if (!EncodePool.Start(TEXT("OmniCaptureEncode"), EncodeThreads, EncodeThreadAffinityMask, TPri_BelowNormal))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("OmniCapture could not start its encode threads; frames are written on the capture thread"));
+    }
+    if (IOThreadCount > 0 && !IOPool.Start(TEXT("OmniCaptureIO"), IOThreadCount))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("OmniCapture could not start its I/O threads; files are written by the encode threads"));
+    }
+    if (bWriteFramePack)
+    {
+        FramePack = MakeUnique<FOmniCaptureFramePackWriter>();
+        if (!FramePack->Open(GetFramePackPath(), FramePackPreallocateBytes))
         {
-            UE_LOG(LogTemp, Warning, TEXT("OmniCapture image write task failed"));
+            UE_LOG(LogTemp, Warning, TEXT("OmniCapture could not open a frame pack; frames are written as loose files"));
+            FramePack.Reset();
         }
     }
+    bWorkerPoolsStarted = true;
 }
@@ -0,0 +1,411 @@
+#include "OmniCaptureIntermediateFormat.h"
+
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "OmniCaptureFramePool.h"
+#include "Serialization/Archive.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace
+{
+    constexpr uint32 GIntermediateMagic = 0x57524D4F; // "OMRW"
+    constexpr uint16 GIntermediateVersion = 1;
+
+    enum class EIntermediateCodec : uint8
+    {
+        Raw = 0,
+        QOI = 1
+    };
+
+    struct FIntermediateHeader
+    {
+        uint32 Magic = GIntermediateMagic;
+        uint16 Version = GIntermediateVersion;
+        uint8 Codec = 0;
+        uint8 PixelDataType = 0;
+        int32 Width = 0;
+        int32 Height = 0;
+        uint8 bLinear = 0;
+        uint8 Precision = 0;
+        uint16 Reserved = 0;
+        int64 PayloadBytes = 0;
+        uint32 Reserved2 = 0;
+
+        friend FArchive& operator<<(FArchive& Ar, FIntermediateHeader& Header)
+        {
+            Ar << Header.Magic << Header.Version << Header.Codec << Header.PixelDataType << Header.Width << Header.Height;
+            Ar << Header.bLinear << Header.Precision << Header.Reserved << Header.PayloadBytes << Header.Reserved2;
+            return Ar;
+        }
+    };
+
+    int64 GetBytesPerPixel(EOmniCapturePixelDataType PixelDataType)
+    {
+        switch (PixelDataType)
+        {
+        case EOmniCapturePixelDataType::LinearColorFloat32:
+            return sizeof(FLinearColor);
+        case EOmniCapturePixelDataType::LinearColorFloat16:
+            return sizeof(FFloat16Color);
+        case EOmniCapturePixelDataType::Color8:
+            return sizeof(FColor);
+        case EOmniCapturePixelDataType::ScalarFloat32:
+            return sizeof(float);
+        case EOmniCapturePixelDataType::Vector2Float32:
+            return sizeof(FVector2f);
+        default:
+            return 0;
+        }
+    }
+
+    template <typename PixelType>
+    TUniquePtr<TImagePixelData<PixelType>> AllocatePixels(const FIntPoint& Size)
+    {
+        TUniquePtr<TImagePixelData<PixelType>> PixelData = MakeUnique<TImagePixelData<PixelType>>(Size);
+        PixelData->Pixels.SetNumUninitialized(static_cast<int64>(Size.X) * Size.Y);
+        return PixelData;
+    }
+
+    /** Allocates storage for the type and returns where the payload should land. */
+    TUniquePtr<FImagePixelData> AllocateForType(EOmniCapturePixelDataType PixelDataType, const FIntPoint& Size, void*& OutPixels)
+    {
+        FOmniCaptureFramePool& Pool = FOmniCaptureFramePool::Get();
+        switch (PixelDataType)
+        {
+        case EOmniCapturePixelDataType::LinearColorFloat32:
+        {
+            TUniquePtr<TImagePixelData<FLinearColor>> PixelData = Pool.AcquirePixels<FLinearColor>(Size);
+            OutPixels = PixelData->Pixels.GetData();
+            return PixelData;
+        }
+        case EOmniCapturePixelDataType::LinearColorFloat16:
+        {
+            TUniquePtr<TImagePixelData<FFloat16Color>> PixelData = Pool.AcquirePixels<FFloat16Color>(Size);
+            OutPixels = PixelData->Pixels.GetData();
+            return PixelData;
+        }
+        case EOmniCapturePixelDataType::Color8:
+        {
+            TUniquePtr<TImagePixelData<FColor>> PixelData = Pool.AcquirePixels<FColor>(Size);
+            OutPixels = PixelData->Pixels.GetData();
+            return PixelData;
+        }
+        case EOmniCapturePixelDataType::ScalarFloat32:
+        {
+            TUniquePtr<TImagePixelData<float>> PixelData = AllocatePixels<float>(Size);
+            OutPixels = PixelData->Pixels.GetData();
+            return PixelData;
+        }
+        case EOmniCapturePixelDataType::Vector2Float32:
+        {
+            TUniquePtr<TImagePixelData<FVector2f>> PixelData = AllocatePixels<FVector2f>(Size);
+            OutPixels = PixelData->Pixels.GetData();
+            return PixelData;
+        }
+        default:
+            OutPixels = nullptr;
+            return nullptr;
+        }
+    }
+
+    // QOI, per the 1.0 specification (qoiformat.org): 14-byte header, six ops, 64-entry colour index, 8-byte end marker.
+    constexpr uint8 QOIOpIndex = 0x00;
+    constexpr uint8 QOIOpDiff = 0x40;
+    constexpr uint8 QOIOpLuma = 0x80;
+    constexpr uint8 QOIOpRun = 0xC0;
+    constexpr uint8 QOIOpRGB = 0xFE;
+    constexpr uint8 QOIOpRGBA = 0xFF;
+    constexpr uint8 QOIMask = 0xC0;
+    constexpr int32 QOIHeaderBytes = 14;
+    constexpr uint8 QOIEndMarker[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+    FORCEINLINE int32 QOIHash(const FColor& Pixel)
+    {
+        return (Pixel.R * 3 + Pixel.G * 5 + Pixel.B * 7 + Pixel.A * 11) % 64;
+    }
+}
+
+bool FOmniCaptureIntermediateFormat::Write(const FString& FilePath, const FImagePixelData& PixelData, bool bIsLinear, EOmniCapturePixelPrecision Precision, EOmniCapturePixelDataType PixelDataType)
+{
+    TArray64<uint8> Encoded;
+    return Encode(PixelData, bIsLinear, Precision, PixelDataType, Encoded) && FFileHelper::SaveArrayToFile(Encoded, *FilePath);
+}
+
+bool FOmniCaptureIntermediateFormat::Encode(const FImagePixelData& PixelData, bool bIsLinear, EOmniCapturePixelPrecision Precision, EOmniCapturePixelDataType PixelDataType, TArray64<uint8>& OutFile)
+{
+    const FIntPoint Size = PixelData.GetSize();
+    const int64 BytesPerPixel = GetBytesPerPixel(PixelDataType);
+    const void* RawData = nullptr;
+    int64 RawBytes = 0;
+    if (BytesPerPixel <= 0 || Size.X <= 0 || Size.Y <= 0 || !PixelData.GetRawData(RawData, RawBytes) || RawBytes < BytesPerPixel * Size.X * Size.Y)
+    {
+        return false;
+    }
+
+    FIntermediateHeader Header;
+    Header.PixelDataType = static_cast<uint8>(PixelDataType);
+    Header.Width = Size.X;
+    Header.Height = Size.Y;
+    Header.bLinear = bIsLinear ? 1 : 0;
+    Header.Precision = static_cast<uint8>(Precision);
+
+    TArray64<uint8> QOI;
+    if (PixelDataType == EOmniCapturePixelDataType::Color8)
+    {
+        EncodeQOI(static_cast<const FColor*>(RawData), Size, QOI);
+        Header.Codec = static_cast<uint8>(EIntermediateCodec::QOI);
+        Header.PayloadBytes = QOI.Num();
+    }
+    else
+    {
+        Header.Codec = static_cast<uint8>(EIntermediateCodec::Raw);
+        Header.PayloadBytes = BytesPerPixel * Size.X * Size.Y;
+    }
+
+    OutFile.Reset();
+    FMemoryWriter64 Writer(OutFile);
+    Writer << Header;
+    OutFile.Reserve(OutFile.Num() + Header.PayloadBytes);
+    OutFile.Append(QOI.Num() > 0 ? QOI.GetData() : static_cast<const uint8*>(RawData), Header.PayloadBytes);
+    return true;
+}
+
+bool FOmniCaptureIntermediateFormat::Read(const FString& FilePath, TUniquePtr<FImagePixelData>& OutPixelData, bool& bOutIsLinear, EOmniCapturePixelPrecision& OutPrecision, EOmniCapturePixelDataType& OutPixelDataType)
+{
+    TUniquePtr<FArchive> Archive(IFileManager::Get().CreateFileReader(*FilePath));
+    if (!Archive.IsValid())
+    {
+        return false;
+    }
+
+    FIntermediateHeader Header;
+    *Archive << Header;
+    const EOmniCapturePixelDataType PixelDataType = static_cast<EOmniCapturePixelDataType>(Header.PixelDataType);
+    const int64 BytesPerPixel = GetBytesPerPixel(PixelDataType);
+    if (Archive->IsError() || Header.Magic != GIntermediateMagic || Header.Version != GIntermediateVersion || BytesPerPixel <= 0
+        || Header.Width <= 0 || Header.Height <= 0 || Header.PayloadBytes <= 0 || Header.PayloadBytes > Archive->TotalSize() - Archive->Tell())
+    {
+        return false;
+    }
+
+    const FIntPoint Size(Header.Width, Header.Height);
+    void* Pixels = nullptr;
+    TUniquePtr<FImagePixelData> PixelData = AllocateForType(PixelDataType, Size, Pixels);
+    if (!PixelData.IsValid())
+    {
+        return false;
+    }
+
+    bool bDecoded = false;
+    if (Header.Codec == static_cast<uint8>(EIntermediateCodec::QOI) && PixelDataType == EOmniCapturePixelDataType::Color8)
+    {
+        TArray64<uint8> Encoded;
+        Encoded.SetNumUninitialized(Header.PayloadBytes);
+        Archive->Serialize(Encoded.GetData(), Encoded.Num());
+        bDecoded = !Archive->IsError() && DecodeQOI(Encoded.GetData(), Encoded.Num(), Size, static_cast<FColor*>(Pixels));
+    }
+    else if (Header.Codec == static_cast<uint8>(EIntermediateCodec::Raw) && Header.PayloadBytes == BytesPerPixel * Size.X * Size.Y)
+    {
+        Archive->Serialize(Pixels, Header.PayloadBytes);
+        bDecoded = !Archive->IsError();
+    }
+
+    if (!bDecoded)
+    {
+        FOmniCaptureFramePool::Get().ReleasePixels(MoveTemp(PixelData));
+        return false;
+    }
+
+    OutPixelData = MoveTemp(PixelData);
+    bOutIsLinear = Header.bLinear != 0;
+    OutPrecision = static_cast<EOmniCapturePixelPrecision>(Header.Precision);
+    OutPixelDataType = PixelDataType;
+    return true;
+}
+
+void FOmniCaptureIntermediateFormat::EncodeQOI(const FColor* Pixels, const FIntPoint& Size, TArray64<uint8>& Out)
+{
+    const int64 PixelCount = static_cast<int64>(Size.X) * Size.Y;
+    const int64 Start = Out.Num();
+
+    // Worst case is one RGBA op per pixel; trimmed once the stream is done.
+    Out.SetNumUninitialized(Start + QOIHeaderBytes + PixelCount * 5 + sizeof(QOIEndMarker), EAllowShrinking::No);
+    uint8* Cursor = Out.GetData() + Start;
+
+    const uint8 Header[QOIHeaderBytes] =
+    {
+        'q', 'o', 'i', 'f',
+        static_cast<uint8>(Size.X >> 24), static_cast<uint8>(Size.X >> 16), static_cast<uint8>(Size.X >> 8), static_cast<uint8>(Size.X),
+        static_cast<uint8>(Size.Y >> 24), static_cast<uint8>(Size.Y >> 16), static_cast<uint8>(Size.Y >> 8), static_cast<uint8>(Size.Y),
+        4, 0
+    };
+    FMemory::Memcpy(Cursor, Header, QOIHeaderBytes);
+    Cursor += QOIHeaderBytes;
+
+    FColor Index[64];
+    FMemory::Memzero(Index);
+    FColor Previous(0, 0, 0, 255);
+    int32 Run = 0;
+
+    for (int64 PixelIndex = 0; PixelIndex < PixelCount; ++PixelIndex)
+    {
+        const FColor Pixel = Pixels[PixelIndex];
+        if (Pixel == Previous)
+        {
+            ++Run;
+            if (Run == 62 || PixelIndex == PixelCount - 1)
+            {
+                *Cursor++ = static_cast<uint8>(QOIOpRun | (Run - 1));
+                Run = 0;
+            }
+            continue;
+        }
+
+        if (Run > 0)
+        {
+            *Cursor++ = static_cast<uint8>(QOIOpRun | (Run - 1));
+            Run = 0;
+        }
+
+        const int32 Hash = QOIHash(Pixel);
+        if (Index[Hash] == Pixel)
+        {
+            *Cursor++ = static_cast<uint8>(QOIOpIndex | Hash);
+        }
+        else
+        {
+            Index[Hash] = Pixel;
+            if (Pixel.A == Previous.A)
+            {
+                const int8 DeltaR = static_cast<int8>(Pixel.R - Previous.R);
+                const int8 DeltaG = static_cast<int8>(Pixel.G - Previous.G);
+                const int8 DeltaB = static_cast<int8>(Pixel.B - Previous.B);
+                const int32 DeltaRG = DeltaR - DeltaG;
+                const int32 DeltaBG = DeltaB - DeltaG;
+
+                if (DeltaR > -3 && DeltaR < 2 && DeltaG > -3 && DeltaG < 2 && DeltaB > -3 && DeltaB < 2)
+                {
+                    *Cursor++ = static_cast<uint8>(QOIOpDiff | ((DeltaR + 2) << 4) | ((DeltaG + 2) << 2) | (DeltaB + 2));
+                }
+                else if (DeltaRG > -9 && DeltaRG < 8 && DeltaG > -33 && DeltaG < 32 && DeltaBG > -9 && DeltaBG < 8)
+                {
+                    *Cursor++ = static_cast<uint8>(QOIOpLuma | (DeltaG + 32));
+                    *Cursor++ = static_cast<uint8>(((DeltaRG + 8) << 4) | (DeltaBG + 8));
+                }
+                else
+                {
+                    *Cursor++ = QOIOpRGB;
+                    *Cursor++ = Pixel.R;
+                    *Cursor++ = Pixel.G;
+                    *Cursor++ = Pixel.B;
+                }
+            }
+            else
+            {
+                *Cursor++ = QOIOpRGBA;
+                *Cursor++ = Pixel.R;
+                *Cursor++ = Pixel.G;
+                *Cursor++ = Pixel.B;
+                *Cursor++ = Pixel.A;
+            }
+        }
+        Previous = Pixel;
+    }
+
+    FMemory::Memcpy(Cursor, QOIEndMarker, sizeof(QOIEndMarker));
+    Cursor += sizeof(QOIEndMarker);
+    Out.SetNum(Cursor - Out.GetData(), EAllowShrinking::No);
+}
+
+bool FOmniCaptureIntermediateFormat::DecodeQOI(const uint8* Data, int64 Length, const FIntPoint& Size, FColor* OutPixels)
+{
+    if (!Data || Length < QOIHeaderBytes + static_cast<int64>(sizeof(QOIEndMarker)) || FMemory::Memcmp(Data, "qoif", 4) != 0)
+    {
+        return false;
+    }
+
+    const int32 Width = (Data[4] << 24) | (Data[5] << 16) | (Data[6] << 8) | Data[7];
+    const int32 Height = (Data[8] << 24) | (Data[9] << 16) | (Data[10] << 8) | Data[11];
+    if (Width != Size.X || Height != Size.Y)
+    {
+        return false;
+    }
+
+    FColor Index[64];
+    FMemory::Memzero(Index);
+    FColor Pixel(0, 0, 0, 255);
+
+    const uint8* Cursor = Data + QOIHeaderBytes;
+    const uint8* End = Data + Length - sizeof(QOIEndMarker);
+    const int64 PixelCount = static_cast<int64>(Width) * Height;
+    int32 Run = 0;
+
+    for (int64 PixelIndex = 0; PixelIndex < PixelCount; ++PixelIndex)
+    {
+        if (Run > 0)
+        {
+            --Run;
+        }
+        else
+        {
+            if (Cursor >= End)
+            {
+                return false;
+            }
+
+            const uint8 Op = *Cursor++;
+            if (Op == QOIOpRGB)
+            {
+                if (End - Cursor < 3)
+                {
+                    return false;
+                }
+                Pixel.R = Cursor[0];
+                Pixel.G = Cursor[1];
+                Pixel.B = Cursor[2];
+                Cursor += 3;
+            }
+            else if (Op == QOIOpRGBA)
+            {
+                if (End - Cursor < 4)
+                {
+                    return false;
+                }
+                Pixel = FColor(Cursor[0], Cursor[1], Cursor[2], Cursor[3]);
+                Cursor += 4;
+            }
+            else if ((Op & QOIMask) == QOIOpIndex)
+            {
+                Pixel = Index[Op];
+            }
+            else if ((Op & QOIMask) == QOIOpDiff)
+            {
+                Pixel.R = static_cast<uint8>(Pixel.R + ((Op >> 4) & 0x03) - 2);
+                Pixel.G = static_cast<uint8>(Pixel.G + ((Op >> 2) & 0x03) - 2);
+                Pixel.B = static_cast<uint8>(Pixel.B + (Op & 0x03) - 2);
+            }
+            else if ((Op & QOIMask) == QOIOpLuma)
+            {
+                if (Cursor >= End)
+                {
+                    return false;
+                }
+                const uint8 Second = *Cursor++;
+                const int32 DeltaG = (Op & 0x3F) - 32;
+                Pixel.R = static_cast<uint8>(Pixel.R + DeltaG - 8 + ((Second >> 4) & 0x0F));
+                Pixel.G = static_cast<uint8>(Pixel.G + DeltaG);
+                Pixel.B = static_cast<uint8>(Pixel.B + DeltaG - 8 + (Second & 0x0F));
+            }
+            else
+            {
+                Run = Op & 0x3F;
+            }
+
+            Index[QOIHash(Pixel)] = Pixel;
+        }
+
+        OutPixels[PixelIndex] = Pixel;
+    }
+
+    return true;
+}
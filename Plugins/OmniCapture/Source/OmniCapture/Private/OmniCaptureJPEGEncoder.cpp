@@ -0,0 +1,236 @@
+#include "OmniCaptureJPEGEncoder.h"
+
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+
+#if WITH_OMNICAPTURE_LIBJPEGTURBO
+THIRD_PARTY_INCLUDES_START
+#include "turbojpeg.h"
+THIRD_PARTY_INCLUDES_END
+#endif
+
+#if WITH_OMNICAPTURE_LIBJPEGTURBO
+namespace
+{
+    constexpr int32 GMaxJPEGDimension = 65500;
+    constexpr int32 GMaxRestartInterval = MAX_uint16;
+
+    /** Where the parts of one strip's file sit: the SOS segment, its entropy-coded scan and the frame height field. */
+    struct FJPEGLayout
+    {
+        int64 ScanHeaderStart = 0;
+        int64 ScanStart = 0;
+        int64 HeightOffset = INDEX_NONE;
+    };
+
+    struct FJPEGStrip
+    {
+        int32 RowStart = 0;
+        int32 RowCount = 0;
+        TArray64<uint8> Encoded;
+        FJPEGLayout Layout;
+        bool bFailed = false;
+    };
+
+    int32 ToTurboSubsampling(EOmniCaptureJPEGSubsampling Subsampling)
+    {
+        switch (Subsampling)
+        {
+        case EOmniCaptureJPEGSubsampling::Subsampling444:
+            return TJSAMP_444;
+        case EOmniCaptureJPEGSubsampling::Subsampling422:
+            return TJSAMP_422;
+        default:
+            return TJSAMP_420;
+        }
+    }
+
+    bool CompressRows(tjhandle Handle, const FColor* Pixels, int32 Width, int32 RowCount, int32 Subsampling, const FOmniCaptureJPEGEncodeOptions& Options, TArray64<uint8>& Out)
+    {
+        const unsigned long Capacity = tjBufSize(Width, RowCount, Subsampling);
+        if (Capacity == static_cast<unsigned long>(-1))
+        {
+            return false;
+        }
+
+        // Compressing into a buffer sized for the worst case lets TurboJPEG write in place instead of allocating its own.
+        Out.SetNumUninitialized(static_cast<int64>(Capacity), EAllowShrinking::No);
+        unsigned char* Buffer = Out.GetData();
+        unsigned long EncodedBytes = Capacity;
+        const int Flags = TJFLAG_NOREALLOC | (Options.bFastDCT ? TJFLAG_FASTDCT : TJFLAG_ACCURATEDCT);
+        if (tjCompress2(Handle, reinterpret_cast<const unsigned char*>(Pixels), Width, Width * static_cast<int>(sizeof(FColor)), RowCount, TJPF_BGRA,
+            &Buffer, &EncodedBytes, Subsampling, FMath::Clamp(Options.Quality, 1, 100), Flags) != 0)
+        {
+            return false;
+        }
+
+        Out.SetNum(static_cast<int64>(EncodedBytes), EAllowShrinking::No);
+        return true;
+    }
+
+    bool ParseLayout(const TArray64<uint8>& JPEG, FJPEGLayout& OutLayout)
+    {
+        const int64 Size = JPEG.Num();
+        if (Size < 4 || JPEG[0] != 0xFF || JPEG[1] != 0xD8 || JPEG[Size - 2] != 0xFF || JPEG[Size - 1] != 0xD9)
+        {
+            return false;
+        }
+
+        int64 Offset = 2;
+        while (Offset + 4 <= Size)
+        {
+            if (JPEG[Offset] != 0xFF)
+            {
+                return false;
+            }
+
+            const uint8 Marker = JPEG[Offset + 1];
+            const int64 SegmentBytes = (static_cast<int64>(JPEG[Offset + 2]) << 8) | JPEG[Offset + 3];
+            if (Marker >= 0xC0 && Marker <= 0xC2)
+            {
+                // FF Cn, length, precision, then the 16-bit line count.
+                OutLayout.HeightOffset = Offset + 5;
+            }
+            else if (Marker == 0xDA)
+            {
+                OutLayout.ScanHeaderStart = Offset;
+                OutLayout.ScanStart = Offset + 2 + SegmentBytes;
+                return OutLayout.HeightOffset != INDEX_NONE && OutLayout.ScanStart <= Size - 2;
+            }
+            Offset += 2 + SegmentBytes;
+        }
+        return false;
+    }
+
+    /** True when two strips were written with identical tables and headers, apart from their heights. */
+    bool HasMatchingHeader(const FJPEGStrip& First, const FJPEGStrip& Other)
+    {
+        if (First.Layout.ScanStart != Other.Layout.ScanStart || First.Layout.HeightOffset != Other.Layout.HeightOffset)
+        {
+            return false;
+        }
+
+        const int64 HeightEnd = First.Layout.HeightOffset + 2;
+        return FMemory::Memcmp(First.Encoded.GetData(), Other.Encoded.GetData(), First.Layout.HeightOffset) == 0
+            && FMemory::Memcmp(First.Encoded.GetData() + HeightEnd, Other.Encoded.GetData() + HeightEnd, First.Layout.ScanStart - HeightEnd) == 0;
+    }
+}
+#endif
+
+bool FOmniCaptureJPEGEncoder::IsAvailable()
+{
+#if WITH_OMNICAPTURE_LIBJPEGTURBO
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool FOmniCaptureJPEGEncoder::Encode(const FIntPoint& Size, const FColor* Pixels, const FOmniCaptureJPEGEncodeOptions& Options, TArray64<uint8>& OutJPEG)
+{
+    OutJPEG.Reset();
+
+#if WITH_OMNICAPTURE_LIBJPEGTURBO
+    if (!Pixels || Size.X <= 0 || Size.Y <= 0 || Size.X > GMaxJPEGDimension || Size.Y > GMaxJPEGDimension)
+    {
+        return false;
+    }
+
+    const int32 Subsampling = ToTurboSubsampling(Options.Subsampling);
+    const int32 MCUHeight = tjMCUHeight[Subsampling];
+    const int32 MCUsPerRow = FMath::DivideAndRoundUp(Size.X, static_cast<int32>(tjMCUWidth[Subsampling]));
+    const int32 MCURows = FMath::DivideAndRoundUp(Size.Y, MCUHeight);
+
+    // DRI holds the interval as a 16-bit MCU count, which caps how many MCU rows one strip may span.
+    const int64 MinStripMCURows = FMath::DivideAndRoundUp<int64>(FMath::Max<int64>(Options.MinStripPixels, 1), static_cast<int64>(Size.X) * MCUHeight);
+    const int32 StripMCURows = static_cast<int32>(FMath::Clamp<int64>(MinStripMCURows, 1, FMath::Max(1, GMaxRestartInterval / MCUsPerRow)));
+    const int32 StripCount = FMath::DivideAndRoundUp(MCURows, StripMCURows);
+    const int32 MaxThreads = Options.MaxThreads > 0 ? Options.MaxThreads : (FTaskGraphInterface::IsRunning() ? FTaskGraphInterface::Get().GetNumWorkerThreads() + 1 : 1);
+    const int32 WorkerCount = FMath::Min(MaxThreads, StripCount);
+
+    const auto EncodeWhole = [&]() -> bool
+    {
+        tjhandle Handle = tjInitCompress();
+        if (!Handle)
+        {
+            return false;
+        }
+        const bool bEncoded = CompressRows(Handle, Pixels, Size.X, Size.Y, Subsampling, Options, OutJPEG);
+        tjDestroy(Handle);
+        return bEncoded;
+    };
+
+    if (WorkerCount <= 1 || MCUsPerRow > GMaxRestartInterval)
+    {
+        return EncodeWhole();
+    }
+
+    TArray<FJPEGStrip> Strips;
+    Strips.SetNum(StripCount);
+    for (int32 StripIndex = 0; StripIndex < StripCount; ++StripIndex)
+    {
+        Strips[StripIndex].RowStart = StripIndex * StripMCURows * MCUHeight;
+        Strips[StripIndex].RowCount = FMath::Min(StripMCURows * MCUHeight, Size.Y - Strips[StripIndex].RowStart);
+    }
+
+    TAtomic<int32> NextStrip { 0 };
+    ParallelFor(WorkerCount, [&](int32)
+    {
+        tjhandle Handle = tjInitCompress();
+        for (int32 StripIndex = NextStrip.IncrementExchange(); StripIndex < StripCount; StripIndex = NextStrip.IncrementExchange())
+        {
+            FJPEGStrip& Strip = Strips[StripIndex];
+            Strip.bFailed = !Handle
+                || !CompressRows(Handle, Pixels + static_cast<int64>(Strip.RowStart) * Size.X, Size.X, Strip.RowCount, Subsampling, Options, Strip.Encoded)
+                || !ParseLayout(Strip.Encoded, Strip.Layout);
+        }
+        if (Handle)
+        {
+            tjDestroy(Handle);
+        }
+    });
+
+    // Header, DRI segment and EOI, then each scan with its restart marker.
+    int64 TotalBytes = Strips[0].Layout.ScanStart + 8;
+    for (const FJPEGStrip& Strip : Strips)
+    {
+        // Strips can only be joined if they share tables; a library built to optimise Huffman codes per image would not.
+        if (Strip.bFailed || !HasMatchingHeader(Strips[0], Strip))
+        {
+            UE_LOG(LogTemp, Verbose, TEXT("JPEG strips could not be joined; encoding the frame in one piece."));
+            return EncodeWhole();
+        }
+        TotalBytes += Strip.Encoded.Num() - Strip.Layout.ScanStart;
+    }
+
+    const FJPEGStrip& First = Strips[0];
+    OutJPEG.Reserve(TotalBytes);
+    OutJPEG.Append(First.Encoded.GetData(), First.Layout.ScanHeaderStart);
+    OutJPEG[First.Layout.HeightOffset + 0] = static_cast<uint8>(Size.Y >> 8);
+    OutJPEG[First.Layout.HeightOffset + 1] = static_cast<uint8>(Size.Y);
+
+    const int32 RestartInterval = StripMCURows * MCUsPerRow;
+    const uint8 RestartSegment[6] = { 0xFF, 0xDD, 0x00, 0x04, static_cast<uint8>(RestartInterval >> 8), static_cast<uint8>(RestartInterval) };
+    OutJPEG.Append(RestartSegment, sizeof(RestartSegment));
+    OutJPEG.Append(First.Encoded.GetData() + First.Layout.ScanHeaderStart, First.Layout.ScanStart - First.Layout.ScanHeaderStart);
+
+    for (int32 StripIndex = 0; StripIndex < StripCount; ++StripIndex)
+    {
+        const FJPEGStrip& Strip = Strips[StripIndex];
+        if (StripIndex > 0)
+        {
+            OutJPEG.Add(0xFF);
+            OutJPEG.Add(static_cast<uint8>(0xD0 + ((StripIndex - 1) & 7)));
+        }
+
+        // Each scan already ends byte-aligned with one-bit padding, as the encoder would pad before a restart marker.
+        OutJPEG.Append(Strip.Encoded.GetData() + Strip.Layout.ScanStart, Strip.Encoded.Num() - Strip.Layout.ScanStart - 2);
+    }
+
+    OutJPEG.Add(0xFF);
+    OutJPEG.Add(0xD9);
+    return true;
+#else
+    return false;
+#endif
+}
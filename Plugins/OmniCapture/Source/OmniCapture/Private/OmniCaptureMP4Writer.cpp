@@ -0,0 +1,1171 @@
+#include "OmniCaptureMP4Writer.h"
+
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/Paths.h"
+#include "OmniCaptureTypes.h"
+
+namespace
+{
+    constexpr uint32 GVideoTimescale = 90000;
+    constexpr uint32 GMovieTimescale = 1000;
+    constexpr uint32 GVideoTrackId = 1;
+    constexpr uint32 GAudioTrackId = 2;
+    constexpr uint32 GSyncSampleFlags = 0x02000000;
+    constexpr uint32 GNonSyncSampleFlags = 0x01010000;
+    constexpr int64 GCopyChunkBytes = 4 * 1024 * 1024;
+
+    /** Big-endian box serialiser; EndBox fills in the size of the box opened by the matching BeginBox. */
+    class FMP4BoxWriter
+    {
+    public:
+        TArray<uint8> Bytes;
+
+        void U8(uint8 Value) { Bytes.Add(Value); }
+        void U16(uint16 Value) { U8(static_cast<uint8>(Value >> 8)); U8(static_cast<uint8>(Value)); }
+        void U32(uint32 Value) { U16(static_cast<uint16>(Value >> 16)); U16(static_cast<uint16>(Value)); }
+        void U64(uint64 Value) { U32(static_cast<uint32>(Value >> 32)); U32(static_cast<uint32>(Value)); }
+        void FourCC(const char* Type) { Bytes.Append(reinterpret_cast<const uint8*>(Type), 4); }
+        void Raw(const TArray<uint8>& Data) { Bytes.Append(Data); }
+        void Zeros(int32 Count) { Bytes.AddZeroed(Count); }
+
+        void BeginBox(const char* Type)
+        {
+            OpenBoxes.Push(Bytes.Num());
+            U32(0);
+            FourCC(Type);
+        }
+
+        void BeginFullBox(const char* Type, uint8 Version, uint32 Flags)
+        {
+            BeginBox(Type);
+            U32((static_cast<uint32>(Version) << 24) | (Flags & 0xFFFFFF));
+        }
+
+        void EndBox()
+        {
+            const int32 Start = OpenBoxes.Pop(EAllowShrinking::No);
+            PatchU32(Start, static_cast<uint32>(Bytes.Num() - Start));
+        }
+
+        int32 Tell() const { return Bytes.Num(); }
+
+        void PatchU32(int32 Offset, uint32 Value)
+        {
+            Bytes[Offset] = static_cast<uint8>(Value >> 24);
+            Bytes[Offset + 1] = static_cast<uint8>(Value >> 16);
+            Bytes[Offset + 2] = static_cast<uint8>(Value >> 8);
+            Bytes[Offset + 3] = static_cast<uint8>(Value);
+        }
+
+        void Matrix()
+        {
+            const uint32 Identity[9] = { 0x00010000, 0, 0, 0, 0x00010000, 0, 0, 0, 0x40000000 };
+            for (uint32 Value : Identity)
+            {
+                U32(Value);
+            }
+        }
+
+    private:
+        TArray<int32> OpenBoxes;
+    };
+
+    /** Reads the unescaped payload of a parameter set: fixed-width fields and Exp-Golomb codes. */
+    class FRBSPReader
+    {
+    public:
+        explicit FRBSPReader(const TArray<uint8>& InBytes)
+            : Bytes(InBytes)
+        {
+        }
+
+        uint32 Read(int32 Count)
+        {
+            uint32 Value = 0;
+            for (int32 Index = 0; Index < Count; ++Index)
+            {
+                const int64 ByteIndex = BitOffset >> 3;
+                const uint32 Bit = ByteIndex < Bytes.Num() ? (Bytes[ByteIndex] >> (7 - (BitOffset & 7))) & 1 : 0;
+                Value = (Value << 1) | Bit;
+                ++BitOffset;
+            }
+            return Value;
+        }
+
+        void Skip(int32 Count) { BitOffset += Count; }
+
+        uint32 ReadUE()
+        {
+            int32 LeadingZeros = 0;
+            while (Read(1) == 0 && LeadingZeros < 32 && IsValid())
+            {
+                ++LeadingZeros;
+            }
+            return LeadingZeros > 0 ? (1u << LeadingZeros) - 1 + Read(LeadingZeros) : 0;
+        }
+
+        bool IsValid() const { return BitOffset <= static_cast<int64>(Bytes.Num()) * 8; }
+
+    private:
+        const TArray<uint8>& Bytes;
+        int64 BitOffset = 0;
+    };
+
+    struct FNalUnit
+    {
+        const uint8* Data = nullptr;
+        int64 Size = 0;
+    };
+
+    /** Splits an Annex-B buffer at its start codes; zero bytes trailing a unit belong to the next start code. */
+    void SplitAnnexB(const uint8* Data, int64 Size, TArray<FNalUnit>& OutUnits)
+    {
+        int64 UnitStart = INDEX_NONE;
+        int64 Index = 0;
+        while (Index + 2 < Size)
+        {
+            if (Data[Index] == 0 && Data[Index + 1] == 0 && Data[Index + 2] == 1)
+            {
+                if (UnitStart != INDEX_NONE)
+                {
+                    int64 UnitEnd = Index;
+                    while (UnitEnd > UnitStart && Data[UnitEnd - 1] == 0)
+                    {
+                        --UnitEnd;
+                    }
+                    if (UnitEnd > UnitStart)
+                    {
+                        OutUnits.Add({ Data + UnitStart, UnitEnd - UnitStart });
+                    }
+                }
+                Index += 3;
+                UnitStart = Index;
+                continue;
+            }
+            ++Index;
+        }
+
+        if (UnitStart != INDEX_NONE && UnitStart < Size)
+        {
+            OutUnits.Add({ Data + UnitStart, Size - UnitStart });
+        }
+    }
+
+    /** Drops the emulation-prevention byte of every 00 00 03 sequence. */
+    TArray<uint8> UnescapeRBSP(const TArray<uint8>& Unit)
+    {
+        TArray<uint8> Result;
+        Result.Reserve(Unit.Num());
+        int32 Zeros = 0;
+        for (const uint8 Byte : Unit)
+        {
+            if (Zeros >= 2 && Byte == 3)
+            {
+                Zeros = 0;
+                continue;
+            }
+            Result.Add(Byte);
+            Zeros = Byte == 0 ? Zeros + 1 : 0;
+        }
+        return Result;
+    }
+
+    enum class ENalKind : uint8 { Picture, KeyPicture, VPS, SPS, PPS, Skip, Other };
+
+    ENalKind ClassifyNal(EOmniCaptureMP4Codec Codec, const FNalUnit& Unit)
+    {
+        if (Codec == EOmniCaptureMP4Codec::HEVC)
+        {
+            const int32 Type = (Unit.Data[0] >> 1) & 0x3F;
+            if (Type >= 16 && Type <= 21)
+            {
+                return ENalKind::KeyPicture;
+            }
+            if (Type < 32)
+            {
+                return ENalKind::Picture;
+            }
+            switch (Type)
+            {
+            case 32: return ENalKind::VPS;
+            case 33: return ENalKind::SPS;
+            case 34: return ENalKind::PPS;
+            case 35: return ENalKind::Skip;
+            default: return ENalKind::Other;
+            }
+        }
+
+        switch (Unit.Data[0] & 0x1F)
+        {
+        case 5: return ENalKind::KeyPicture;
+        case 1: return ENalKind::Picture;
+        case 7: return ENalKind::SPS;
+        case 8: return ENalKind::PPS;
+        case 9: return ENalKind::Skip;
+        default: return ENalKind::Other;
+        }
+    }
+
+    bool IsHighProfileH264(uint8 ProfileIdc)
+    {
+        switch (ProfileIdc)
+        {
+        case 100: case 110: case 122: case 244: case 44: case 83: case 86: case 118: case 128: case 138: case 139: case 134: case 135:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    void WriteAvcC(FMP4BoxWriter& Writer, const TArray<TArray<uint8>>& SPS, const TArray<TArray<uint8>>& PPS)
+    {
+        const TArray<uint8>& First = SPS[0];
+        Writer.BeginBox("avcC");
+        Writer.U8(1);
+        Writer.U8(First.Num() > 1 ? First[1] : 0);
+        Writer.U8(First.Num() > 2 ? First[2] : 0);
+        Writer.U8(First.Num() > 3 ? First[3] : 0);
+        Writer.U8(0xFF);
+        Writer.U8(static_cast<uint8>(0xE0 | SPS.Num()));
+        for (const TArray<uint8>& Unit : SPS)
+        {
+            Writer.U16(static_cast<uint16>(Unit.Num()));
+            Writer.Raw(Unit);
+        }
+        Writer.U8(static_cast<uint8>(PPS.Num()));
+        for (const TArray<uint8>& Unit : PPS)
+        {
+            Writer.U16(static_cast<uint16>(Unit.Num()));
+            Writer.Raw(Unit);
+        }
+
+        // High profiles carry their chroma format and bit depths too.
+        if (First.Num() > 3 && IsHighProfileH264(First[1]))
+        {
+            const TArray<uint8> Payload = UnescapeRBSP(First);
+            FRBSPReader Reader(Payload);
+            Reader.Skip(32);
+            Reader.ReadUE();
+            const uint32 ChromaFormat = Reader.ReadUE();
+            if (ChromaFormat == 3)
+            {
+                Reader.Skip(1);
+            }
+            const uint32 LumaBitDepthMinus8 = Reader.ReadUE();
+            const uint32 ChromaBitDepthMinus8 = Reader.ReadUE();
+            Writer.U8(static_cast<uint8>(0xFC | (ChromaFormat & 3)));
+            Writer.U8(static_cast<uint8>(0xF8 | (LumaBitDepthMinus8 & 7)));
+            Writer.U8(static_cast<uint8>(0xF8 | (ChromaBitDepthMinus8 & 7)));
+            Writer.U8(0);
+        }
+        Writer.EndBox();
+    }
+
+    void WriteHvcC(FMP4BoxWriter& Writer, const TArray<TArray<uint8>>& VPS, const TArray<TArray<uint8>>& SPS, const TArray<TArray<uint8>>& PPS)
+    {
+        // The general profile, tier and level sit at fixed offsets; chroma format and bit depths follow the sub-layer levels.
+        const TArray<uint8> Payload = UnescapeRBSP(SPS[0]);
+        FRBSPReader Reader(Payload);
+        Reader.Skip(16 + 4);
+        const uint32 MaxSubLayersMinus1 = Reader.Read(3);
+        const uint32 TemporalIdNesting = Reader.Read(1);
+        const uint32 ProfileSpaceTierIdc = Reader.Read(8);
+        const uint32 CompatibilityFlags = Reader.Read(32);
+        // Operands of | are unsequenced, so the two reads of the 48-bit field each get a statement of their own.
+        const uint64 ConstraintFlagsHigh = Reader.Read(16);
+        const uint64 ConstraintFlagsLow = Reader.Read(32);
+        const uint64 ConstraintFlags = (ConstraintFlagsHigh << 32) | ConstraintFlagsLow;
+        const uint32 LevelIdc = Reader.Read(8);
+
+        bool SubLayerProfile[8] = {};
+        bool SubLayerLevel[8] = {};
+        for (uint32 Index = 0; Index < MaxSubLayersMinus1; ++Index)
+        {
+            SubLayerProfile[Index] = Reader.Read(1) != 0;
+            SubLayerLevel[Index] = Reader.Read(1) != 0;
+        }
+        if (MaxSubLayersMinus1 > 0)
+        {
+            Reader.Skip(2 * (8 - MaxSubLayersMinus1));
+        }
+        for (uint32 Index = 0; Index < MaxSubLayersMinus1; ++Index)
+        {
+            Reader.Skip((SubLayerProfile[Index] ? 88 : 0) + (SubLayerLevel[Index] ? 8 : 0));
+        }
+
+        Reader.ReadUE();
+        const uint32 ChromaFormat = Reader.ReadUE();
+        if (ChromaFormat == 3)
+        {
+            Reader.Skip(1);
+        }
+        Reader.ReadUE();
+        Reader.ReadUE();
+        if (Reader.Read(1))
+        {
+            Reader.ReadUE();
+            Reader.ReadUE();
+            Reader.ReadUE();
+            Reader.ReadUE();
+        }
+        const uint32 LumaBitDepthMinus8 = Reader.ReadUE();
+        const uint32 ChromaBitDepthMinus8 = Reader.ReadUE();
+
+        Writer.BeginBox("hvcC");
+        Writer.U8(1);
+        Writer.U8(static_cast<uint8>(ProfileSpaceTierIdc));
+        Writer.U32(CompatibilityFlags);
+        Writer.U16(static_cast<uint16>(ConstraintFlags >> 32));
+        Writer.U32(static_cast<uint32>(ConstraintFlags));
+        Writer.U8(static_cast<uint8>(LevelIdc));
+        Writer.U16(0xF000);
+        Writer.U8(0xFC);
+        Writer.U8(static_cast<uint8>(0xFC | (ChromaFormat & 3)));
+        Writer.U8(static_cast<uint8>(0xF8 | (LumaBitDepthMinus8 & 7)));
+        Writer.U8(static_cast<uint8>(0xF8 | (ChromaBitDepthMinus8 & 7)));
+        Writer.U16(0);
+        Writer.U8(static_cast<uint8>(((MaxSubLayersMinus1 + 1) << 3) | (TemporalIdNesting << 2) | 3));
+
+        const TArray<TArray<uint8>>* Arrays[] = { &VPS, &SPS, &PPS };
+        const uint8 Types[] = { 32, 33, 34 };
+        Writer.U8(3);
+        for (int32 ArrayIndex = 0; ArrayIndex < 3; ++ArrayIndex)
+        {
+            Writer.U8(static_cast<uint8>(0x80 | Types[ArrayIndex]));
+            Writer.U16(static_cast<uint16>(Arrays[ArrayIndex]->Num()));
+            for (const TArray<uint8>& Unit : *Arrays[ArrayIndex])
+            {
+                Writer.U16(static_cast<uint16>(Unit.Num()));
+                Writer.Raw(Unit);
+            }
+        }
+        Writer.EndBox();
+    }
+
+    uint32 ToBoundFraction(double Fraction)
+    {
+        return static_cast<uint32>(FMath::Clamp(Fraction, 0.0, 1.0) * 4294967295.0);
+    }
+
+    void WriteSphericalVideo(FMP4BoxWriter& Writer, const FOmniCaptureMP4Spherical& Spherical)
+    {
+        Writer.BeginFullBox("st3d", 0, 0);
+        Writer.U8(Spherical.StereoMode);
+        Writer.EndBox();
+
+        Writer.BeginBox("sv3d");
+        Writer.BeginFullBox("svhd", 0, 0);
+        Writer.Bytes.Append(reinterpret_cast<const uint8*>("OmniCapture"), 12);
+        Writer.EndBox();
+        Writer.BeginBox("proj");
+        Writer.BeginFullBox("prhd", 0, 0);
+        Writer.U32(0);
+        Writer.U32(0);
+        Writer.U32(0);
+        Writer.EndBox();
+        Writer.BeginFullBox("equi", 0, 0);
+        Writer.U32(ToBoundFraction(Spherical.BoundTop));
+        Writer.U32(ToBoundFraction(Spherical.BoundBottom));
+        Writer.U32(ToBoundFraction(Spherical.BoundLeft));
+        Writer.U32(ToBoundFraction(Spherical.BoundRight));
+        Writer.EndBox();
+        Writer.EndBox();
+        Writer.EndBox();
+    }
+
+    /** 0 unless NumChannels is (order + 1)^2 for a first or higher order. */
+    int32 GetAmbisonicOrder(int32 NumChannels)
+    {
+        const int32 Root = FMath::RoundToInt(FMath::Sqrt(static_cast<float>(NumChannels)));
+        return Root >= 2 && Root * Root == NumChannels ? Root - 1 : 0;
+    }
+
+    void WriteFileType(FMP4BoxWriter& Writer, bool bFragmented)
+    {
+        Writer.BeginBox("ftyp");
+        Writer.FourCC("isom");
+        Writer.U32(0x200);
+        Writer.FourCC("isom");
+        Writer.FourCC(bFragmented ? "iso6" : "iso2");
+        Writer.FourCC("mp41");
+        Writer.EndBox();
+    }
+
+    /** stsc entries for chunks of the given sample counts, merging runs of equal counts; empty chunks are skipped. */
+    void WriteSampleToChunk(FMP4BoxWriter& Writer, const TArray<int64>& ChunkSamples)
+    {
+        TArray<TPair<uint32, uint32>> Runs;
+        uint32 ChunkNumber = 0;
+        for (const int64 Count : ChunkSamples)
+        {
+            if (Count <= 0)
+            {
+                continue;
+            }
+            ++ChunkNumber;
+            if (Runs.Num() == 0 || Runs.Last().Value != static_cast<uint32>(Count))
+            {
+                Runs.Add({ ChunkNumber, static_cast<uint32>(Count) });
+            }
+        }
+
+        Writer.BeginFullBox("stsc", 0, 0);
+        Writer.U32(Runs.Num());
+        for (const TPair<uint32, uint32>& Run : Runs)
+        {
+            Writer.U32(Run.Key);
+            Writer.U32(Run.Value);
+            Writer.U32(1);
+        }
+        Writer.EndBox();
+    }
+
+    void WriteChunkOffsets(FMP4BoxWriter& Writer, const TArray<int64>& Offsets)
+    {
+        Writer.BeginFullBox("co64", 0, 0);
+        Writer.U32(Offsets.Num());
+        for (const int64 Offset : Offsets)
+        {
+            Writer.U64(static_cast<uint64>(Offset));
+        }
+        Writer.EndBox();
+    }
+
+    void WriteEmptySampleTables(FMP4BoxWriter& Writer)
+    {
+        Writer.BeginFullBox("stts", 0, 0);
+        Writer.U32(0);
+        Writer.EndBox();
+        Writer.BeginFullBox("stsc", 0, 0);
+        Writer.U32(0);
+        Writer.EndBox();
+        Writer.BeginFullBox("stsz", 0, 0);
+        Writer.U32(0);
+        Writer.U32(0);
+        Writer.EndBox();
+        Writer.BeginFullBox("stco", 0, 0);
+        Writer.U32(0);
+        Writer.EndBox();
+    }
+
+    void WriteTrackHeader(FMP4BoxWriter& Writer, uint32 TrackId, uint64 MovieDuration, bool bAudio, int32 Width, int32 Height)
+    {
+        Writer.BeginFullBox("tkhd", 1, 0x3);
+        Writer.U64(0);
+        Writer.U64(0);
+        Writer.U32(TrackId);
+        Writer.U32(0);
+        Writer.U64(MovieDuration);
+        Writer.Zeros(8);
+        Writer.U16(0);
+        Writer.U16(bAudio ? 1 : 0);
+        Writer.U16(bAudio ? 0x0100 : 0);
+        Writer.U16(0);
+        Writer.Matrix();
+        Writer.U32(bAudio ? 0 : static_cast<uint32>(Width) << 16);
+        Writer.U32(bAudio ? 0 : static_cast<uint32>(Height) << 16);
+        Writer.EndBox();
+    }
+
+    void WriteMediaHeader(FMP4BoxWriter& Writer, uint32 Timescale, uint64 Duration, const char* Handler, const char* Name)
+    {
+        Writer.BeginFullBox("mdhd", 1, 0);
+        Writer.U64(0);
+        Writer.U64(0);
+        Writer.U32(Timescale);
+        Writer.U64(Duration);
+        Writer.U16(0x55C4); // "und"
+        Writer.U16(0);
+        Writer.EndBox();
+
+        Writer.BeginFullBox("hdlr", 0, 0);
+        Writer.U32(0);
+        Writer.FourCC(Handler);
+        Writer.Zeros(12);
+        Writer.Bytes.Append(reinterpret_cast<const uint8*>(Name), FCStringAnsi::Strlen(Name) + 1);
+        Writer.EndBox();
+    }
+
+    void WriteDataInformation(FMP4BoxWriter& Writer)
+    {
+        Writer.BeginBox("dinf");
+        Writer.BeginFullBox("dref", 0, 0);
+        Writer.U32(1);
+        Writer.BeginFullBox("url ", 0, 1);
+        Writer.EndBox();
+        Writer.EndBox();
+        Writer.EndBox();
+    }
+
+    void WriteTrackExtends(FMP4BoxWriter& Writer, uint32 TrackId)
+    {
+        Writer.BeginFullBox("trex", 0, 0);
+        Writer.U32(TrackId);
+        Writer.U32(1);
+        Writer.U32(0);
+        Writer.U32(0);
+        Writer.U32(0);
+        Writer.EndBox();
+    }
+}
+
+FOmniCaptureMP4Config FOmniCaptureMP4Config::FromSettings(const FOmniCaptureSettings& Settings)
+{
+    FOmniCaptureMP4Config Result;
+    Result.Codec = Settings.Codec == EOmniCaptureCodec::HEVC ? EOmniCaptureMP4Codec::HEVC : EOmniCaptureMP4Codec::H264;
+    const FIntPoint OutputSize = Settings.GetOutputResolution();
+    Result.Width = OutputSize.X;
+    Result.Height = OutputSize.Y;
+    Result.FrameRate = Settings.TargetFrameRate > 0.0f ? Settings.TargetFrameRate : 30.0;
+    Result.bConstantFrameRate = Settings.bForceConstantFrameRate;
+    Result.bWithAudio = Settings.bRecordAudio;
+
+    Result.Spherical.bEnabled = Settings.bWriteSpatialMetadata && Settings.SupportsSphericalMetadata();
+    if (Settings.IsStereo())
+    {
+        Result.Spherical.StereoMode = Settings.StereoLayout == EOmniCaptureStereoLayout::TopBottom ? 1 : 2;
+    }
+    if (Settings.IsVR180())
+    {
+        Result.Spherical.BoundLeft = 0.25;
+        Result.Spherical.BoundRight = 0.25;
+    }
+    Result.Spherical.bAmbisonicAudio = Settings.bAmbisonicAudio;
+    return Result;
+}
+
+FOmniCaptureMP4Writer::~FOmniCaptureMP4Writer()
+{
+    Close(false);
+}
+
+bool FOmniCaptureMP4Writer::Open(const FString& InFilePath, const FOmniCaptureMP4Config& InConfig)
+{
+    Close(false);
+
+    FilePath = InFilePath;
+    Config = InConfig;
+    Config.FrameRate = Config.FrameRate > 0.0 ? Config.FrameRate : 30.0;
+    WriteOffset = 0;
+    bHeaderWritten = false;
+    bFailed = false;
+    VPS.Reset();
+    SPS.Reset();
+    PPS.Reset();
+    bHasTimeOrigin = false;
+    LastVideoTicks = 0;
+    VideoSamples.Reset();
+    PendingVideo.Reset();
+    PendingVideoBytes.Reset();
+    VideoDecodeTicks = 0;
+    PendingVideoTicks = 0;
+    // The sample entry goes out with the first fragment, often before any audio has arrived, so the format is fixed up front.
+    if (Config.bWithAudio && (Config.AudioSampleRate <= 0 || Config.AudioChannels <= 0))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("MP4 output %s has no valid audio format (%d Hz, %d channels); it is written without audio."), *InFilePath, Config.AudioSampleRate, Config.AudioChannels);
+        Config.bWithAudio = false;
+    }
+    AudioSampleRate = Config.bWithAudio ? Config.AudioSampleRate : 0;
+    AudioChannels = Config.bWithAudio ? Config.AudioChannels : 0;
+    AudioFramesWritten = 0;
+    AudioFramesQueued = 0;
+    PendingAudioBytes.Reset();
+    DroppedAudioPackets = 0;
+    Fragments.Reset();
+
+    IFileManager::Get().MakeDirectory(*FPaths::GetPath(FilePath), true);
+    Handle.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*FilePath, false, false));
+    if (!Handle.IsValid())
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Unable to open MP4 output %s"), *FilePath);
+        return false;
+    }
+    return true;
+}
+
+bool FOmniCaptureMP4Writer::AddVideo(const uint8* AnnexB, int64 Size, bool bKeyFrame, double TimestampSeconds)
+{
+    if (!IsOpen() || bFailed || !AnnexB || Size <= 0)
+    {
+        return false;
+    }
+
+    TArray<FNalUnit> Units;
+    SplitAnnexB(AnnexB, Size, Units);
+
+    // Samples carry 4-byte lengths instead of start codes; parameter sets move into the sample description.
+    TArray<uint8> Sample;
+    bool bHasPicture = false;
+    bool bKeyPicture = false;
+    for (const FNalUnit& Unit : Units)
+    {
+        const ENalKind Kind = ClassifyNal(Config.Codec, Unit);
+        TArray<TArray<uint8>>* ParameterSets = Kind == ENalKind::VPS ? &VPS : Kind == ENalKind::SPS ? &SPS : Kind == ENalKind::PPS ? &PPS : nullptr;
+        if (ParameterSets)
+        {
+            // Sets repeated ahead of later key frames are the same ones; the sample description is already written.
+            TArray<uint8> Set(Unit.Data, static_cast<int32>(Unit.Size));
+            if (!bHeaderWritten && !ParameterSets->Contains(Set))
+            {
+                ParameterSets->Add(MoveTemp(Set));
+            }
+            continue;
+        }
+        if (Kind == ENalKind::Skip)
+        {
+            continue;
+        }
+
+        bHasPicture |= Kind == ENalKind::Picture || Kind == ENalKind::KeyPicture;
+        bKeyPicture |= Kind == ENalKind::KeyPicture;
+        const uint32 UnitSize = static_cast<uint32>(Unit.Size);
+        Sample.Add(static_cast<uint8>(UnitSize >> 24));
+        Sample.Add(static_cast<uint8>(UnitSize >> 16));
+        Sample.Add(static_cast<uint8>(UnitSize >> 8));
+        Sample.Add(static_cast<uint8>(UnitSize));
+        Sample.Append(Unit.Data, static_cast<int32>(Unit.Size));
+    }
+
+    if (!bHasPicture)
+    {
+        return true;
+    }
+
+    const bool bSync = bKeyFrame || bKeyPicture;
+    if (!bHasTimeOrigin)
+    {
+        if (!bSync)
+        {
+            return false;
+        }
+        TimeOrigin = TimestampSeconds;
+        bHasTimeOrigin = true;
+    }
+
+    const int64 SampleIndex = VideoSamples.Num() + PendingVideo.Num();
+    const int64 Ticks = Config.bConstantFrameRate
+        ? FMath::RoundToInt64(SampleIndex * GVideoTimescale / Config.FrameRate)
+        : FMath::RoundToInt64((TimestampSeconds - TimeOrigin) * GVideoTimescale);
+    if (PendingVideo.Num() > 0)
+    {
+        const uint32 Duration = static_cast<uint32>(FMath::Max<int64>(1, Ticks - LastVideoTicks));
+        PendingVideo.Last().Duration = Duration;
+        PendingVideoTicks += Duration;
+    }
+
+    if (bSync && PendingVideo.Num() > 0 && PendingVideoTicks >= Config.FragmentSeconds * GVideoTimescale && !FlushFragment())
+    {
+        return false;
+    }
+
+    FVideoSample& Added = PendingVideo.AddDefaulted_GetRef();
+    Added.Size = static_cast<uint32>(Sample.Num());
+    Added.bSync = bSync;
+    PendingVideoBytes.Append(Sample);
+    LastVideoTicks = FMath::Max(Ticks, LastVideoTicks + (SampleIndex > 0 ? 1 : 0));
+    return true;
+}
+
+bool FOmniCaptureMP4Writer::AddAudio(const int16* Samples, int32 FrameCount, int32 SampleRate, int32 NumChannels, double TimestampSeconds)
+{
+    if (!IsOpen() || bFailed || !Config.bWithAudio || !Samples || FrameCount <= 0 || SampleRate <= 0 || NumChannels <= 0)
+    {
+        return false;
+    }
+    // The shared clock starts with the first key frame; anything earlier has nothing to play against.
+    if (!bHasTimeOrigin)
+    {
+        return false;
+    }
+
+    if (SampleRate != AudioSampleRate || NumChannels != AudioChannels)
+    {
+        ++DroppedAudioPackets;
+        return false;
+    }
+
+    // A few samples of clock jitter between packets is not a gap.
+    const int64 NextFrame = AudioFramesWritten + AudioFramesQueued;
+    int64 StartFrame = FMath::RoundToInt64((TimestampSeconds - TimeOrigin) * AudioSampleRate);
+    if (FMath::Abs(StartFrame - NextFrame) <= AudioSampleRate / 100)
+    {
+        StartFrame = NextFrame;
+    }
+    const int64 SkipFrames = FMath::Clamp<int64>(NextFrame - StartFrame, 0, FrameCount);
+    const int64 SilenceFrames = FMath::Max<int64>(StartFrame - NextFrame, 0);
+    const int64 CopyFrames = FrameCount - SkipFrames;
+    if (CopyFrames <= 0)
+    {
+        return true;
+    }
+
+    const int64 BytesPerFrame = GetAudioBytesPerFrame();
+    const int32 Start = PendingAudioBytes.Num();
+    PendingAudioBytes.AddZeroed(static_cast<int32>((SilenceFrames + CopyFrames) * BytesPerFrame));
+    FMemory::Memcpy(PendingAudioBytes.GetData() + Start + SilenceFrames * BytesPerFrame, Samples + SkipFrames * AudioChannels, CopyFrames * BytesPerFrame);
+    AudioFramesQueued += SilenceFrames + CopyFrames;
+    return true;
+}
+
+bool FOmniCaptureMP4Writer::Close(bool bFastStart)
+{
+    if (!IsOpen())
+    {
+        return false;
+    }
+
+    if (PendingVideo.Num() > 0)
+    {
+        PendingVideo.Last().Duration = static_cast<uint32>(FMath::Max<int64>(1, FMath::RoundToInt64(GVideoTimescale / Config.FrameRate)));
+        PendingVideoTicks += PendingVideo.Last().Duration;
+    }
+    bool bSuccess = !bFailed && FlushFragment() && Fragments.Num() > 0;
+    bSuccess &= Handle->Flush();
+    Handle.Reset();
+
+    if (DroppedAudioPackets > 0)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("%d audio packets did not match the %d Hz, %d channel track of %s and were left out."), DroppedAudioPackets, AudioSampleRate, AudioChannels, *FilePath);
+    }
+    if (!bSuccess)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("MP4 output %s is incomplete."), *FilePath);
+        return false;
+    }
+    if (bFastStart && !RewriteFastStart())
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Could not relay %s out for fast start; the fragmented file is kept."), *FilePath);
+    }
+    return true;
+}
+
+bool FOmniCaptureMP4Writer::WriteBytes(const uint8* Data, int64 Size)
+{
+    if (!Handle->Write(Data, Size))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Failed writing MP4 output %s"), *FilePath);
+        bFailed = true;
+        return false;
+    }
+    WriteOffset += Size;
+    return true;
+}
+
+bool FOmniCaptureMP4Writer::WriteHeader()
+{
+    const bool bHasParameterSets = SPS.Num() > 0 && PPS.Num() > 0 && (Config.Codec == EOmniCaptureMP4Codec::H264 || VPS.Num() > 0);
+    if (!bHasParameterSets)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("The video stream for %s carried no parameter sets; the MP4 cannot describe it."), *FilePath);
+        return false;
+    }
+    FMP4BoxWriter Writer;
+    WriteFileType(Writer, true);
+    Writer.Raw(BuildMovie(false, 0));
+    bHeaderWritten = WriteBytes(Writer.Bytes.GetData(), Writer.Bytes.Num());
+    return bHeaderWritten;
+}
+
+bool FOmniCaptureMP4Writer::FlushFragment()
+{
+    if (PendingVideo.Num() == 0 && AudioFramesQueued == 0)
+    {
+        return true;
+    }
+    if (!bHeaderWritten && !WriteHeader())
+    {
+        bFailed = true;
+        return false;
+    }
+
+    FMP4BoxWriter Writer;
+    Writer.BeginBox("moof");
+    Writer.BeginFullBox("mfhd", 0, 0);
+    Writer.U32(Fragments.Num() + 1);
+    Writer.EndBox();
+
+    int32 VideoDataOffsetField = INDEX_NONE;
+    if (PendingVideo.Num() > 0)
+    {
+        Writer.BeginBox("traf");
+        Writer.BeginFullBox("tfhd", 0, 0x020000);
+        Writer.U32(GVideoTrackId);
+        Writer.EndBox();
+        Writer.BeginFullBox("tfdt", 1, 0);
+        Writer.U64(VideoDecodeTicks);
+        Writer.EndBox();
+        Writer.BeginFullBox("trun", 0, 0x000701);
+        Writer.U32(PendingVideo.Num());
+        VideoDataOffsetField = Writer.Tell();
+        Writer.U32(0);
+        for (const FVideoSample& Sample : PendingVideo)
+        {
+            Writer.U32(Sample.Duration);
+            Writer.U32(Sample.Size);
+            Writer.U32(Sample.bSync ? GSyncSampleFlags : GNonSyncSampleFlags);
+        }
+        Writer.EndBox();
+        Writer.EndBox();
+    }
+
+    // PCM needs no per-sample entries: every sample is one frame of fixed size and duration.
+    int32 AudioDataOffsetField = INDEX_NONE;
+    if (AudioFramesQueued > 0)
+    {
+        Writer.BeginBox("traf");
+        Writer.BeginFullBox("tfhd", 0, 0x020000 | 0x08 | 0x10 | 0x20);
+        Writer.U32(GAudioTrackId);
+        Writer.U32(1);
+        Writer.U32(static_cast<uint32>(GetAudioBytesPerFrame()));
+        Writer.U32(GSyncSampleFlags);
+        Writer.EndBox();
+        Writer.BeginFullBox("tfdt", 1, 0);
+        Writer.U64(AudioFramesWritten);
+        Writer.EndBox();
+        Writer.BeginFullBox("trun", 0, 0x000001);
+        Writer.U32(static_cast<uint32>(AudioFramesQueued));
+        AudioDataOffsetField = Writer.Tell();
+        Writer.U32(0);
+        Writer.EndBox();
+        Writer.EndBox();
+    }
+    Writer.EndBox();
+
+    // Data offsets count from the start of the moof, past the mdat header that follows it.
+    const int32 MoofBytes = Writer.Tell();
+    const int64 PayloadBytes = PendingVideoBytes.Num() + PendingAudioBytes.Num();
+    if (VideoDataOffsetField != INDEX_NONE)
+    {
+        Writer.PatchU32(VideoDataOffsetField, MoofBytes + 8);
+    }
+    if (AudioDataOffsetField != INDEX_NONE)
+    {
+        Writer.PatchU32(AudioDataOffsetField, MoofBytes + 8 + PendingVideoBytes.Num());
+    }
+    Writer.U32(static_cast<uint32>(PayloadBytes + 8));
+    Writer.FourCC("mdat");
+
+    FFragment& Fragment = Fragments.AddDefaulted_GetRef();
+    Fragment.PayloadOffset = WriteOffset + Writer.Tell();
+    Fragment.VideoBytes = PendingVideoBytes.Num();
+    Fragment.FirstVideoSample = VideoSamples.Num();
+    Fragment.VideoSampleCount = PendingVideo.Num();
+    Fragment.AudioFrames = AudioFramesQueued;
+
+    if (!WriteBytes(Writer.Bytes.GetData(), Writer.Bytes.Num())
+        || !WriteBytes(PendingVideoBytes.GetData(), PendingVideoBytes.Num())
+        || !WriteBytes(PendingAudioBytes.GetData(), PendingAudioBytes.Num()))
+    {
+        return false;
+    }
+
+    VideoSamples.Append(PendingVideo);
+    VideoDecodeTicks += PendingVideoTicks;
+    AudioFramesWritten += AudioFramesQueued;
+    PendingVideo.Reset();
+    PendingVideoBytes.Reset();
+    PendingVideoTicks = 0;
+    PendingAudioBytes.Reset();
+    AudioFramesQueued = 0;
+    return true;
+}
+
+TArray<uint8> FOmniCaptureMP4Writer::BuildMovie(bool bProgressive, int64 PayloadBase) const
+{
+    const bool bAudioTrack = Config.bWithAudio && AudioChannels > 0;
+    const uint64 VideoTicks = bProgressive ? VideoDecodeTicks : 0;
+    const uint64 AudioFrames = bProgressive ? AudioFramesWritten : 0;
+    const uint64 VideoMovieDuration = VideoTicks * GMovieTimescale / GVideoTimescale;
+    const uint64 AudioMovieDuration = bAudioTrack ? AudioFrames * GMovieTimescale / AudioSampleRate : 0;
+
+    // Chunk offsets in the relaid mdat, where each fragment's payload keeps its video-then-audio order.
+    TArray<int64> VideoChunkSamples;
+    TArray<int64> VideoChunkOffsets;
+    TArray<int64> AudioChunkSamples;
+    TArray<int64> AudioChunkOffsets;
+    if (bProgressive)
+    {
+        int64 Offset = PayloadBase;
+        for (const FFragment& Fragment : Fragments)
+        {
+            VideoChunkSamples.Add(Fragment.VideoSampleCount);
+            if (Fragment.VideoSampleCount > 0)
+            {
+                VideoChunkOffsets.Add(Offset);
+            }
+            AudioChunkSamples.Add(Fragment.AudioFrames);
+            if (Fragment.AudioFrames > 0)
+            {
+                AudioChunkOffsets.Add(Offset + Fragment.VideoBytes);
+            }
+            Offset += Fragment.VideoBytes + Fragment.AudioFrames * GetAudioBytesPerFrame();
+        }
+    }
+
+    FMP4BoxWriter Writer;
+    Writer.BeginBox("moov");
+
+    Writer.BeginFullBox("mvhd", 1, 0);
+    Writer.U64(0);
+    Writer.U64(0);
+    Writer.U32(GMovieTimescale);
+    Writer.U64(FMath::Max(VideoMovieDuration, AudioMovieDuration));
+    Writer.U32(0x00010000);
+    Writer.U16(0x0100);
+    Writer.Zeros(10);
+    Writer.Matrix();
+    Writer.Zeros(24);
+    Writer.U32(bAudioTrack ? GAudioTrackId + 1 : GVideoTrackId + 1);
+    Writer.EndBox();
+
+    // Video track.
+    Writer.BeginBox("trak");
+    WriteTrackHeader(Writer, GVideoTrackId, VideoMovieDuration, false, Config.Width, Config.Height);
+    Writer.BeginBox("mdia");
+    WriteMediaHeader(Writer, GVideoTimescale, VideoTicks, "vide", "OmniCapture Video");
+    Writer.BeginBox("minf");
+    Writer.BeginFullBox("vmhd", 0, 1);
+    Writer.Zeros(8);
+    Writer.EndBox();
+    WriteDataInformation(Writer);
+    Writer.BeginBox("stbl");
+    Writer.BeginFullBox("stsd", 0, 0);
+    Writer.U32(1);
+    Writer.BeginBox(Config.Codec == EOmniCaptureMP4Codec::HEVC ? "hvc1" : "avc1");
+    Writer.Zeros(6);
+    Writer.U16(1);
+    Writer.Zeros(16);
+    Writer.U16(static_cast<uint16>(Config.Width));
+    Writer.U16(static_cast<uint16>(Config.Height));
+    Writer.U32(0x00480000);
+    Writer.U32(0x00480000);
+    Writer.U32(0);
+    Writer.U16(1);
+    {
+        const char* CompressorName = "OmniCapture";
+        const int32 NameLength = FCStringAnsi::Strlen(CompressorName);
+        Writer.U8(static_cast<uint8>(NameLength));
+        Writer.Bytes.Append(reinterpret_cast<const uint8*>(CompressorName), NameLength);
+        Writer.Zeros(31 - NameLength);
+    }
+    Writer.U16(0x0018);
+    Writer.U16(0xFFFF);
+    if (Config.Codec == EOmniCaptureMP4Codec::HEVC)
+    {
+        WriteHvcC(Writer, VPS, SPS, PPS);
+    }
+    else
+    {
+        WriteAvcC(Writer, SPS, PPS);
+    }
+    if (Config.Spherical.bEnabled)
+    {
+        WriteSphericalVideo(Writer, Config.Spherical);
+    }
+    Writer.EndBox();
+    Writer.EndBox();
+
+    if (bProgressive)
+    {
+        TArray<TPair<uint32, uint32>> DurationRuns;
+        TArray<uint32> SyncSamples;
+        for (int32 Index = 0; Index < VideoSamples.Num(); ++Index)
+        {
+            const FVideoSample& Sample = VideoSamples[Index];
+            if (DurationRuns.Num() > 0 && DurationRuns.Last().Value == Sample.Duration)
+            {
+                ++DurationRuns.Last().Key;
+            }
+            else
+            {
+                DurationRuns.Add({ 1, Sample.Duration });
+            }
+            if (Sample.bSync)
+            {
+                SyncSamples.Add(Index + 1);
+            }
+        }
+
+        Writer.BeginFullBox("stts", 0, 0);
+        Writer.U32(DurationRuns.Num());
+        for (const TPair<uint32, uint32>& Run : DurationRuns)
+        {
+            Writer.U32(Run.Key);
+            Writer.U32(Run.Value);
+        }
+        Writer.EndBox();
+        if (SyncSamples.Num() < VideoSamples.Num())
+        {
+            Writer.BeginFullBox("stss", 0, 0);
+            Writer.U32(SyncSamples.Num());
+            for (const uint32 SampleNumber : SyncSamples)
+            {
+                Writer.U32(SampleNumber);
+            }
+            Writer.EndBox();
+        }
+        WriteSampleToChunk(Writer, VideoChunkSamples);
+        Writer.BeginFullBox("stsz", 0, 0);
+        Writer.U32(0);
+        Writer.U32(VideoSamples.Num());
+        for (const FVideoSample& Sample : VideoSamples)
+        {
+            Writer.U32(Sample.Size);
+        }
+        Writer.EndBox();
+        WriteChunkOffsets(Writer, VideoChunkOffsets);
+    }
+    else
+    {
+        WriteEmptySampleTables(Writer);
+    }
+    Writer.EndBox();
+    Writer.EndBox();
+    Writer.EndBox();
+    Writer.EndBox();
+
+    if (bAudioTrack)
+    {
+        Writer.BeginBox("trak");
+        WriteTrackHeader(Writer, GAudioTrackId, AudioMovieDuration, true, 0, 0);
+        Writer.BeginBox("mdia");
+        WriteMediaHeader(Writer, AudioSampleRate, AudioFrames, "soun", "OmniCapture Audio");
+        Writer.BeginBox("minf");
+        Writer.BeginFullBox("smhd", 0, 0);
+        Writer.U32(0);
+        Writer.EndBox();
+        WriteDataInformation(Writer);
+        Writer.BeginBox("stbl");
+        Writer.BeginFullBox("stsd", 0, 0);
+        Writer.U32(1);
+        Writer.BeginBox("sowt");
+        Writer.Zeros(6);
+        Writer.U16(1);
+        Writer.Zeros(8);
+        Writer.U16(static_cast<uint16>(AudioChannels));
+        Writer.U16(16);
+        Writer.U32(0);
+        Writer.U32(static_cast<uint32>(FMath::Min(AudioSampleRate, 65535)) << 16);
+        const int32 AmbisonicOrder = GetAmbisonicOrder(AudioChannels);
+        if (Config.Spherical.bEnabled && Config.Spherical.bAmbisonicAudio && AmbisonicOrder > 0)
+        {
+            Writer.BeginBox("SA3D");
+            Writer.U8(0);
+            Writer.U8(0);
+            Writer.U32(AmbisonicOrder);
+            Writer.U8(0);
+            Writer.U8(0);
+            Writer.U32(AudioChannels);
+            for (int32 Channel = 0; Channel < AudioChannels; ++Channel)
+            {
+                Writer.U32(Channel);
+            }
+            Writer.EndBox();
+        }
+        Writer.EndBox();
+        Writer.EndBox();
+
+        if (bProgressive)
+        {
+            Writer.BeginFullBox("stts", 0, 0);
+            Writer.U32(AudioFrames > 0 ? 1 : 0);
+            if (AudioFrames > 0)
+            {
+                Writer.U32(static_cast<uint32>(AudioFrames));
+                Writer.U32(1);
+            }
+            Writer.EndBox();
+            WriteSampleToChunk(Writer, AudioChunkSamples);
+            Writer.BeginFullBox("stsz", 0, 0);
+            Writer.U32(static_cast<uint32>(GetAudioBytesPerFrame()));
+            Writer.U32(static_cast<uint32>(AudioFrames));
+            Writer.EndBox();
+            WriteChunkOffsets(Writer, AudioChunkOffsets);
+        }
+        else
+        {
+            WriteEmptySampleTables(Writer);
+        }
+        Writer.EndBox();
+        Writer.EndBox();
+        Writer.EndBox();
+        Writer.EndBox();
+    }
+
+    if (!bProgressive)
+    {
+        Writer.BeginBox("mvex");
+        WriteTrackExtends(Writer, GVideoTrackId);
+        if (bAudioTrack)
+        {
+            WriteTrackExtends(Writer, GAudioTrackId);
+        }
+        Writer.EndBox();
+    }
+
+    Writer.EndBox();
+    return MoveTemp(Writer.Bytes);
+}
+
+bool FOmniCaptureMP4Writer::RewriteFastStart()
+{
+    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+    const FString TempPath = FilePath + TEXT(".faststart");
+    TUniquePtr<IFileHandle> Source(PlatformFile.OpenRead(*FilePath));
+    TUniquePtr<IFileHandle> Dest(PlatformFile.OpenWrite(*TempPath));
+    if (!Source.IsValid() || !Dest.IsValid())
+    {
+        return false;
+    }
+
+    int64 PayloadBytes = 0;
+    for (const FFragment& Fragment : Fragments)
+    {
+        PayloadBytes += Fragment.VideoBytes + Fragment.AudioFrames * GetAudioBytesPerFrame();
+    }
+    const bool bLargeMdat = PayloadBytes + 8 > MAX_uint32;
+
+    // Chunk offsets are fixed-width, so the movie is the same size once it knows where its payload starts.
+    FMP4BoxWriter Head;
+    WriteFileType(Head, false);
+    const int64 PayloadBase = Head.Tell() + BuildMovie(true, 0).Num() + (bLargeMdat ? 16 : 8);
+    Head.Raw(BuildMovie(true, PayloadBase));
+    if (bLargeMdat)
+    {
+        Head.U32(1);
+        Head.FourCC("mdat");
+        Head.U64(PayloadBytes + 16);
+    }
+    else
+    {
+        Head.U32(static_cast<uint32>(PayloadBytes + 8));
+        Head.FourCC("mdat");
+    }
+
+    bool bSuccess = Dest->Write(Head.Bytes.GetData(), Head.Bytes.Num());
+    TArray<uint8> Buffer;
+    for (const FFragment& Fragment : Fragments)
+    {
+        int64 Remaining = Fragment.VideoBytes + Fragment.AudioFrames * GetAudioBytesPerFrame();
+        bSuccess = bSuccess && Source->Seek(Fragment.PayloadOffset);
+        while (bSuccess && Remaining > 0)
+        {
+            const int64 ChunkBytes = FMath::Min(Remaining, GCopyChunkBytes);
+            Buffer.SetNumUninitialized(static_cast<int32>(ChunkBytes), EAllowShrinking::No);
+            bSuccess = Source->Read(Buffer.GetData(), ChunkBytes) && Dest->Write(Buffer.GetData(), ChunkBytes);
+            Remaining -= ChunkBytes;
+        }
+    }
+    bSuccess = bSuccess && Dest->Flush();
+    Source.Reset();
+    Dest.Reset();
+
+    if (!bSuccess || !IFileManager::Get().Move(*FilePath, *TempPath, true, true))
+    {
+        IFileManager::Get().Delete(*TempPath, false, true, true);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,119 @@
+#include "OmniCaptureMemoryBudget.h"
+
+#include "OmniCaptureCPUReprojection.h"
+
+#include "HAL/PlatformProcess.h"
+
+namespace
+{
+    int64 GetPixelDataBytes(const TUniquePtr<FImagePixelData>& PixelData)
+    {
+        if (!PixelData.IsValid())
+        {
+            return 0;
+        }
+
+        const FIntPoint Size = PixelData->GetSize();
+        return static_cast<int64>(Size.X) * Size.Y * PixelData->GetBitDepth() * PixelData->GetNumChannels() / 8;
+    }
+}
+
+FOmniCaptureMemoryBudget::FOmniCaptureMemoryBudget()
+{
+    LimitBytes = 0;
+    InFlightBytes = 0;
+    PeakBytes = 0;
+    WaitingProducers = 0;
+    ReleasedEvent = FPlatformProcess::GetSynchEventFromPool();
+}
+
+FOmniCaptureMemoryBudget::~FOmniCaptureMemoryBudget()
+{
+    if (ReleasedEvent)
+    {
+        FPlatformProcess::ReturnSynchEventToPool(ReleasedEvent);
+        ReleasedEvent = nullptr;
+    }
+}
+
+void FOmniCaptureMemoryBudget::Configure(int64 InLimitBytes)
+{
+    LimitBytes = FMath::Max<int64>(0, InLimitBytes);
+    PeakBytes = InFlightBytes.Load();
+
+    if (ReleasedEvent)
+    {
+        ReleasedEvent->Trigger();
+    }
+}
+
+int64 FOmniCaptureMemoryBudget::GetFrameBytes(const FOmniCaptureFrame& Frame)
+{
+    int64 Bytes = GetPixelDataBytes(Frame.PixelData);
+    if (Frame.RowSource.IsValid())
+    {
+        Bytes += Frame.RowSource->GetResidentBytes();
+    }
+    for (const TPair<FName, FOmniCaptureLayerPayload>& Pair : Frame.AuxiliaryLayers)
+    {
+        Bytes += GetPixelDataBytes(Pair.Value.PixelData);
+    }
+    return Bytes;
+}
+
+bool FOmniCaptureMemoryBudget::TryReserve(int64 Bytes)
+{
+    if (Bytes <= 0)
+    {
+        return true;
+    }
+
+    const int64 Limit = LimitBytes.Load();
+    int64 InFlight = InFlightBytes.Load();
+    for (;;)
+    {
+        if (Limit > 0 && InFlight > 0 && InFlight + Bytes > Limit)
+        {
+            return false;
+        }
+
+        if (InFlightBytes.CompareExchange(InFlight, InFlight + Bytes))
+        {
+            break;
+        }
+    }
+
+    const int64 NewTotal = InFlight + Bytes;
+    int64 Peak = PeakBytes.Load();
+    while (NewTotal > Peak && !PeakBytes.CompareExchange(Peak, NewTotal))
+    {
+    }
+    return true;
+}
+
+void FOmniCaptureMemoryBudget::Release(int64 Bytes)
+{
+    if (Bytes <= 0)
+    {
+        return;
+    }
+
+    InFlightBytes.SubExchange(Bytes);
+    if (WaitingProducers.Load() > 0 && ReleasedEvent)
+    {
+        ReleasedEvent->Trigger();
+    }
+}
+
+void FOmniCaptureMemoryBudget::ReleaseFrame(FOmniCaptureFrame& Frame)
+{
+    Release(Frame.ReservedBytes);
+    Frame.ReservedBytes = 0;
+}
+
+void FOmniCaptureMemoryBudget::WaitForRelease(uint32 TimeoutMilliseconds)
+{
+    WaitingProducers.IncrementExchange();
+    ReleasedEvent->Wait(TimeoutMilliseconds);
+    WaitingProducers.DecrementExchange();
+}
@@ -1,7 +1,11 @@
 #include "OmniCaptureMuxer.h"
+#include "OmniCaptureCPUKernels.h"
+#include "OmniCaptureCPUReprojection.h"
+#include "OmniCaptureFramePack.h"
 #include "OmniCaptureTypes.h"
 #include "Misc/EngineVersionComparison.h"
 
+#include "Async/ParallelFor.h"
 #include "HAL/FileManager.h"
 #include "HAL/PlatformProcess.h"
 #include "Misc/FileHelper.h"
@@ -95,6 +99,149 @@ namespace
 
         return TEXT("Mono");
     }
+
+    /** ffmpeg decoder for frames streamed out of a pack; nullptr when ffmpeg cannot read the format. */
+    const TCHAR* GetImagePipeCodec(EOmniCaptureImageFormat Format)
+    {
+        switch (Format)
+        {
+        case EOmniCaptureImageFormat::PNG:
+            return TEXT("png");
+        case EOmniCaptureImageFormat::JPG:
+            return TEXT("mjpeg");
+        case EOmniCaptureImageFormat::BMP:
+            return TEXT("bmp");
+        case EOmniCaptureImageFormat::EXR:
+            return TEXT("exr");
+        default:
+            return nullptr;
+        }
+    }
+
+    /** Streams the pack's beauty frames, in frame order, into ffmpeg's stdin. */
+    bool FeedFramePack(const FOmniCaptureFramePackReader& Reader, FProcHandle& ProcHandle, void* WritePipe)
+    {
+        constexpr int64 PipeChunkBytes = 1024 * 1024;
+        TArray64<uint8> FrameBytes;
+        for (const int32 EntryIndex : Reader.GetPrimaryEntriesInFrameOrder())
+        {
+            const FOmniCaptureFramePackEntry& Entry = Reader.GetEntries()[EntryIndex];
+            if (!Reader.ReadEntry(Entry, FrameBytes))
+            {
+                UE_LOG(LogTemp, Warning, TEXT("Could not read %s from the frame pack; stopping the FFmpeg feed."), *Entry.Name);
+                return false;
+            }
+
+            int64 Sent = 0;
+            while (Sent < FrameBytes.Num())
+            {
+                if (!FPlatformProcess::IsProcRunning(ProcHandle))
+                {
+                    return false;
+                }
+
+                int32 Written = 0;
+                const int32 ChunkBytes = static_cast<int32>(FMath::Min(PipeChunkBytes, FrameBytes.Num() - Sent));
+                FPlatformProcess::WritePipe(WritePipe, FrameBytes.GetData() + Sent, ChunkBytes, &Written);
+                if (Written <= 0)
+                {
+                    FPlatformProcess::Sleep(0.001f);
+                    continue;
+                }
+                Sent += Written;
+            }
+        }
+        return true;
+    }
+
+    constexpr int32 GLiveConvertBandRows = 64;
+
+    /** One frame as the live encode reads it: BGRA8, or planar G, B, R floats when bPlanarFloat. */
+    bool ConvertFrameForPipe(const void* Pixels, EOmniCapturePixelDataType PixelDataType, const FIntPoint& Size, bool bPlanarFloat, TArray64<uint8>& OutBytes)
+    {
+        if (!Pixels || Size.X <= 0 || Size.Y <= 0)
+        {
+            return false;
+        }
+        if (PixelDataType != EOmniCapturePixelDataType::Color8 && PixelDataType != EOmniCapturePixelDataType::LinearColorFloat32 && PixelDataType != EOmniCapturePixelDataType::LinearColorFloat16)
+        {
+            return false;
+        }
+
+        const int64 PixelCount = static_cast<int64>(Size.X) * Size.Y;
+        OutBytes.SetNumUninitialized(PixelCount * (bPlanarFloat ? 3 * sizeof(float) : sizeof(FColor)));
+
+        const int32 BandCount = FMath::DivideAndRoundUp(Size.Y, GLiveConvertBandRows);
+        ParallelFor(BandCount, [&](int32 BandIndex)
+        {
+            const int32 RowStart = BandIndex * GLiveConvertBandRows;
+            const int32 RowEnd = FMath::Min(Size.Y, RowStart + GLiveConvertBandRows);
+            TArray<FLinearColor> Scratch;
+            for (int32 Y = RowStart; Y < RowEnd; ++Y)
+            {
+                const int64 Offset = static_cast<int64>(Y) * Size.X;
+                if (!bPlanarFloat)
+                {
+                    FColor* Dest = reinterpret_cast<FColor*>(OutBytes.GetData()) + Offset;
+                    switch (PixelDataType)
+                    {
+                    case EOmniCapturePixelDataType::LinearColorFloat32:
+                        FOmniCaptureCPUKernels::PackSRGB(static_cast<const FLinearColor*>(Pixels) + Offset, Dest, Size.X);
+                        break;
+                    case EOmniCapturePixelDataType::LinearColorFloat16:
+                        FOmniCaptureCPUKernels::PackSRGB(static_cast<const FFloat16Color*>(Pixels) + Offset, Dest, Size.X);
+                        break;
+                    default:
+                        FMemory::Memcpy(Dest, static_cast<const FColor*>(Pixels) + Offset, Size.X * sizeof(FColor));
+                        break;
+                    }
+                    continue;
+                }
+
+                const FLinearColor* Row = nullptr;
+                switch (PixelDataType)
+                {
+                case EOmniCapturePixelDataType::LinearColorFloat32:
+                    Row = static_cast<const FLinearColor*>(Pixels) + Offset;
+                    break;
+                case EOmniCapturePixelDataType::LinearColorFloat16:
+                    Scratch.SetNumUninitialized(Size.X, EAllowShrinking::No);
+                    FOmniCaptureCPUKernels::WidenFloat16(static_cast<const FFloat16Color*>(Pixels) + Offset, Scratch.GetData(), Size.X);
+                    Row = Scratch.GetData();
+                    break;
+                default:
+                    Scratch.SetNumUninitialized(Size.X, EAllowShrinking::No);
+                    FOmniCaptureCPUKernels::UnpackColor(static_cast<const FColor*>(Pixels) + Offset, Scratch.GetData(), Size.X);
+                    Row = Scratch.GetData();
+                    break;
+                }
+
+                float* GreenPlane = reinterpret_cast<float*>(OutBytes.GetData()) + Offset;
+                float* BluePlane = GreenPlane + PixelCount;
+                float* RedPlane = BluePlane + PixelCount;
+                for (int32 X = 0; X < Size.X; ++X)
+                {
+                    GreenPlane[X] = Row[X].G;
+                    BluePlane[X] = Row[X].B;
+                    RedPlane[X] = Row[X].R;
+                }
+            }
+        });
+        return true;
+    }
+
+    const TCHAR* ToPNGCompressionString(EOmniCapturePNGCompression Compression)
+    {
+        switch (Compression)
+        {
+        case EOmniCapturePNGCompression::Realtime:
+            return TEXT("Realtime");
+        case EOmniCapturePNGCompression::Archive:
+            return TEXT("Archive");
+        default:
+            return TEXT("Balanced");
+        }
+    }
 }
 
 FString FOmniCaptureMuxer::ResolveFFmpegBinary(const FOmniCaptureSettings& Settings)
@@ -135,6 +282,15 @@ bool FOmniCaptureMuxer::IsFFmpegAvailable(const FOmniCaptureSettings& Settings,
     return FPaths::FileExists(AbsoluteResolved);
 }
 
+FOmniCaptureMuxer::FOmniCaptureMuxer()
+{
+}
+
+FOmniCaptureMuxer::~FOmniCaptureMuxer()
+{
+    FinishLiveEncode();
+}
+
 void FOmniCaptureMuxer::Initialize(const FOmniCaptureSettings& Settings, const FString& InOutputDirectory)
 {
     OutputDirectory = InOutputDirectory.IsEmpty() ? (FPaths::ProjectSavedDir() / TEXT("OmniCaptures")) : InOutputDirectory;
@@ -151,6 +307,14 @@ void FOmniCaptureMuxer::BeginRealtimeSession(const FOmniCaptureSettings& Setting
     LastAudioTimestamp = 0.0;
     DriftWarningThresholdMs = Settings.bForceConstantFrameRate ? 20.0 : 35.0;
     bRealtimeSessionActive = true;
+
+    // ffmpeg is launched by the first frame, once its size and pixel format are known; a resumed session keeps the running encode.
+    if (Settings.ShouldStreamToFFmpeg() && !LivePipe.IsValid())
+    {
+        LiveSettings = Settings;
+        bLiveEncodeRequested = true;
+        bLiveEncodeFailed = false;
+    }
 }
 
 void FOmniCaptureMuxer::EndRealtimeSession()
@@ -189,16 +353,229 @@ void FOmniCaptureMuxer::PushFrame(const FOmniCaptureFrame& Frame)
     AudioStats.DriftMilliseconds = (LastAudioTimestamp - LastVideoTimestamp) * 1000.0;
     AudioStats.MaxObservedDriftMilliseconds = FMath::Max(AudioStats.MaxObservedDriftMilliseconds, FMath::Abs(AudioStats.DriftMilliseconds));
     AudioStats.bInError = FMath::Abs(AudioStats.DriftMilliseconds) > DriftWarningThresholdMs;
+
+    if (!bLiveEncodeRequested || bLiveEncodeFailed)
+    {
+        return;
+    }
+    if (!LivePipe.IsValid() && !StartLiveEncode(Frame))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Live FFmpeg encode for %s could not start; frames are not being recorded."), *BaseFileName);
+        bLiveEncodeFailed = true;
+        return;
+    }
+
+    // Audio goes first so ffmpeg, which interleaves by timestamp, never waits on the video input for samples it already has.
+    PushLiveAudio(Frame);
+
+    TArray64<uint8> FrameBytes;
+    bool bConverted = false;
+    if (Frame.RowSource.IsValid())
+    {
+        const FOmniCaptureCPURowSource& RowSource = *Frame.RowSource;
+        if (RowSource.Size == LiveFrameSize)
+        {
+            TArray64<uint8> Rows;
+            Rows.SetNumUninitialized(RowSource.GetBytesPerRow() * RowSource.Size.Y);
+            RowSource.ProduceRows(0, RowSource.Size.Y, Rows.GetData());
+            bConverted = ConvertFrameForPipe(Rows.GetData(), RowSource.PixelDataType, LiveFrameSize, bLivePlanarFloat, FrameBytes);
+        }
+    }
+    else if (Frame.PixelData.IsValid() && Frame.PixelData->GetSize() == LiveFrameSize)
+    {
+        const void* RawData = nullptr;
+        int64 RawSize = 0;
+        Frame.PixelData->GetRawData(RawData, RawSize);
+        bConverted = ConvertFrameForPipe(RawData, Frame.PixelDataType, LiveFrameSize, bLivePlanarFloat, FrameBytes);
+    }
+
+    if (!bConverted || !LivePipe->PushVideo(MoveTemp(FrameBytes)))
+    {
+        ++LiveDroppedVideoFrames;
+    }
+}
+
+bool FOmniCaptureMuxer::StartLiveEncode(const FOmniCaptureFrame& Frame)
+{
+    const FString Binary = CachedFFmpegPath.IsEmpty() ? BuildFFmpegBinaryPath() : CachedFFmpegPath;
+    if (Binary.IsEmpty())
+    {
+        UE_LOG(LogTemp, Warning, TEXT("FFmpeg not configured; cannot stream frames to it."));
+        return false;
+    }
+
+    EOmniCapturePixelDataType PixelDataType = Frame.PixelDataType;
+    if (Frame.RowSource.IsValid())
+    {
+        LiveFrameSize = Frame.RowSource->Size;
+        PixelDataType = Frame.RowSource->PixelDataType;
+    }
+    else if (Frame.PixelData.IsValid())
+    {
+        LiveFrameSize = Frame.PixelData->GetSize();
+    }
+    else
+    {
+        return false;
+    }
+
+    // Float frames keep their precision for wide-gamut output; everything else is encoded from sRGB BGRA.
+    const bool bFloatSource = PixelDataType == EOmniCapturePixelDataType::LinearColorFloat32 || PixelDataType == EOmniCapturePixelDataType::LinearColorFloat16;
+    bLivePlanarFloat = bFloatSource && LiveSettings.ColorSpace != EOmniCaptureColorSpace::BT709;
+    LiveFrameRate = LiveSettings.TargetFrameRate > 0.0f ? LiveSettings.TargetFrameRate : 30.0;
+
+    FString CommandLine = FString::Printf(TEXT("-y -f rawvideo -pix_fmt %s -s %dx%d -framerate %.3f -thread_queue_size 64 -i pipe:0"),
+        bLivePlanarFloat ? TEXT("gbrpf32le") : TEXT("bgra"), LiveFrameSize.X, LiveFrameSize.Y, LiveFrameRate);
+
+    const bool bWithAudio = PLATFORM_WINDOWS && LiveSettings.bRecordAudio;
+    if (bWithAudio)
+    {
+        // The PCM input format is fixed for the whole encode, so guessing it wrong would drop every packet that follows.
+        if (!bLiveAudioFormatKnown && Frame.AudioPackets.Num() > 0)
+        {
+            LiveAudioSampleRate = Frame.AudioPackets[0].SampleRate;
+            LiveAudioChannels = Frame.AudioPackets[0].NumChannels;
+        }
+        else if (!bLiveAudioFormatKnown)
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Live FFmpeg encode for %s started before its audio format was known; assuming %d Hz with %d channels."), *BaseFileName, LiveAudioSampleRate, LiveAudioChannels);
+        }
+        CommandLine += FString::Printf(TEXT(" -f s16le -ar %d -ac %d -thread_queue_size 1024 -i \"%s\" -c:a aac -b:a 192k"), LiveAudioSampleRate, LiveAudioChannels, FOmniCaptureFFmpegPipe::GetAudioPipeToken());
+    }
+    else
+    {
+        CommandLine += TEXT(" -an");
+    }
+    CommandLine += BuildOutputArguments(LiveSettings);
+
+    LivePipe = MakeUnique<FOmniCaptureFFmpegPipe>();
+    if (!LivePipe->Start(Binary, CommandLine, OutputDirectory, bWithAudio, static_cast<int64>(LiveSettings.FFmpegPipeBufferMB) * 1024 * 1024))
+    {
+        LivePipe.Reset();
+        return false;
+    }
+
+    LiveAudioFramesWritten = 0;
+    LiveDroppedVideoFrames = 0;
+    LiveDroppedAudioPackets = 0;
+    return true;
+}
+
+void FOmniCaptureMuxer::SetLiveAudioFormat(int32 SampleRate, int32 NumChannels)
+{
+    // A running encode keeps the format its audio input was opened with.
+    if (LivePipe.IsValid() || SampleRate <= 0 || NumChannels <= 0)
+    {
+        return;
+    }
+
+    LiveAudioSampleRate = SampleRate;
+    LiveAudioChannels = NumChannels;
+    bLiveAudioFormatKnown = true;
 }
 
-bool FOmniCaptureMuxer::FinalizeCapture(const FOmniCaptureSettings& Settings, const TArray<FOmniCaptureFrameMetadata>& Frames, const FString& AudioPath, const FString& VideoPath, int32 DroppedFrames)
+void FOmniCaptureMuxer::PushLiveAudio(const FOmniCaptureFrame& Frame)
+{
+    if (!LivePipe->HasAudio())
+    {
+        return;
+    }
+
+    // ffmpeg times the video by frame count at LiveFrameRate, not by when frames were captured, so audio is anchored to
+    // the frame it arrived with: this frame's place in the output plus the packet's offset from the frame's timecode.
+    // A capture running behind or ahead of its target rate then trims or pads audio instead of drifting from the video.
+    const double FrameOutputSeconds = static_cast<double>(LivePipe->GetStats().VideoPushes) / LiveFrameRate;
+    const int64 BytesPerFrame = static_cast<int64>(LiveAudioChannels) * sizeof(int16);
+    const int64 Tolerance = LiveAudioSampleRate / 100;
+    for (const FOmniAudioPacket& Packet : Frame.AudioPackets)
+    {
+        if (Packet.SampleRate != LiveAudioSampleRate || Packet.NumChannels != LiveAudioChannels)
+        {
+            if (LiveDroppedAudioPackets++ == 0)
+            {
+                UE_LOG(LogTemp, Warning, TEXT("Live FFmpeg encode for %s expects %d Hz with %d channels but received %d Hz with %d; such audio is skipped."), *BaseFileName, LiveAudioSampleRate, LiveAudioChannels, Packet.SampleRate, Packet.NumChannels);
+            }
+            continue;
+        }
+
+        // Gaps become silence and overlaps are trimmed, while the clock jitter of a few samples between packets is ignored.
+        const int64 PacketFrames = Packet.PCM16.Num() / LiveAudioChannels;
+        int64 StartFrame = FMath::RoundToInt64((FrameOutputSeconds + Packet.Timestamp - Frame.Metadata.Timecode) * LiveAudioSampleRate);
+        if (FMath::Abs(StartFrame - LiveAudioFramesWritten) <= Tolerance)
+        {
+            StartFrame = LiveAudioFramesWritten;
+        }
+        const int64 SkipFrames = FMath::Clamp<int64>(LiveAudioFramesWritten - StartFrame, 0, PacketFrames);
+        const int64 SilenceFrames = FMath::Max<int64>(StartFrame - LiveAudioFramesWritten, 0);
+        const int64 CopyFrames = PacketFrames - SkipFrames;
+        if (CopyFrames <= 0)
+        {
+            continue;
+        }
+
+        TArray64<uint8> Bytes;
+        Bytes.SetNumZeroed((SilenceFrames + CopyFrames) * BytesPerFrame);
+        FMemory::Memcpy(Bytes.GetData() + SilenceFrames * BytesPerFrame, Packet.PCM16.GetData() + SkipFrames * LiveAudioChannels, CopyFrames * BytesPerFrame);
+        if (LivePipe->PushAudio(MoveTemp(Bytes)))
+        {
+            LiveAudioFramesWritten += SilenceFrames + CopyFrames;
+        }
+    }
+}
+
+bool FOmniCaptureMuxer::FinishLiveEncode(FOmniCaptureFFmpegPipeStats* OutStats)
+{
+    bLiveEncodeRequested = false;
+    bLiveEncodeFailed = false;
+    if (!LivePipe.IsValid())
+    {
+        return false;
+    }
+
+    // The output is cut at the shorter stream, so silence carries the audio through to the last frame.
+    if (LivePipe->HasAudio())
+    {
+        const int64 VideoFrames = LivePipe->GetStats().VideoPushes;
+        const int64 TargetAudioFrames = FMath::RoundToInt64(static_cast<double>(VideoFrames) / LiveFrameRate * LiveAudioSampleRate);
+        if (TargetAudioFrames > LiveAudioFramesWritten)
+        {
+            TArray64<uint8> Silence;
+            Silence.SetNumZeroed((TargetAudioFrames - LiveAudioFramesWritten) * LiveAudioChannels * sizeof(int16));
+            LivePipe->PushAudio(MoveTemp(Silence));
+            LiveAudioFramesWritten = TargetAudioFrames;
+        }
+    }
+
+    const int32 ReturnCode = LivePipe->Finish();
+    const FOmniCaptureFFmpegPipeStats Stats = LivePipe->GetStats();
+    LivePipe.Reset();
+    if (OutStats)
+    {
+        *OutStats = Stats;
+    }
+
+    if (LiveDroppedVideoFrames > 0 || LiveDroppedAudioPackets > 0)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Live FFmpeg encode for %s skipped %d frames and %d audio packets it could not convert or deliver."), *BaseFileName, LiveDroppedVideoFrames, LiveDroppedAudioPackets);
+    }
+    if (ReturnCode != 0)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Live FFmpeg encode returned non-zero exit code %d"), ReturnCode);
+        return false;
+    }
+
+    UE_LOG(LogTemp, Log, TEXT("Live FFmpeg encode complete: %s (%d frames, waited on ffmpeg %d times for %.2f s)"), *(OutputDirectory / (BaseFileName + TEXT(".mp4"))), Stats.VideoPushes, Stats.BlockedPushes, Stats.BlockedSeconds);
+    return true;
+}
+
+bool FOmniCaptureMuxer::FinalizeCapture(const FOmniCaptureSettings& Settings, const TArray<FOmniCaptureFrameMetadata>& Frames, const FString& AudioPath, const FString& VideoPath, int32 DroppedFrames, const FOmniCapturePNGEncodeStats& PNGEncodeStats, int32 DuplicateFrames)
 {
     bool bSuccess = true;
 
     if (Settings.bGenerateManifest)
     {
         FString ManifestPath;
-        if (WriteManifest(Settings, Frames, AudioPath, VideoPath, DroppedFrames, ManifestPath))
+        if (WriteManifest(Settings, Frames, AudioPath, VideoPath, DroppedFrames, PNGEncodeStats, DuplicateFrames, ManifestPath))
         {
             UE_LOG(LogTemp, Log, TEXT("OmniCapture manifest written to %s"), *ManifestPath);
         }
@@ -215,11 +592,40 @@ bool FOmniCaptureMuxer::FinalizeCapture(const FOmniCaptureSettings& Settings, co
         bSuccess = false;
     }
 
+    if (Settings.ShouldStreamToFFmpeg())
+    {
+        // The live encode already wrote the file; no frames were kept on disk to mux.
+        const FString OutputFile = OutputDirectory / (BaseFileName + TEXT(".mp4"));
+        if (!FPaths::FileExists(OutputFile))
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Live FFmpeg encode did not produce %s"), *OutputFile);
+            return false;
+        }
+        return bSuccess;
+    }
+
+    if (Settings.OutputFormat == EOmniOutputFormat::NVENCHardware && Settings.bMuxNVENCToMP4)
+    {
+        // The encoder muxed its packets and the recorded audio as it went.
+        const FString OutputFile = OutputDirectory / (BaseFileName + TEXT(".mp4"));
+        if (FPaths::FileExists(OutputFile))
+        {
+            return bSuccess;
+        }
+        UE_LOG(LogTemp, Warning, TEXT("NVENC MP4 output %s is missing; falling back to FFmpeg."), *OutputFile);
+    }
+
+    // ffmpeg cannot read intermediates, loose or packed; they are transcoded first and muxed from the result.
+    if (Settings.ImageFormat == EOmniCaptureImageFormat::Intermediate && IsImageSequenceFormat(Settings.OutputFormat))
+    {
+        return bSuccess;
+    }
+
     const bool bMuxed = TryInvokeFFmpeg(Settings, Frames, AudioPath, VideoPath);
     return bSuccess && bMuxed;
 }
 
-bool FOmniCaptureMuxer::WriteManifest(const FOmniCaptureSettings& Settings, const TArray<FOmniCaptureFrameMetadata>& Frames, const FString& AudioPath, const FString& VideoPath, int32 DroppedFrames, FString& OutManifestPath) const
+bool FOmniCaptureMuxer::WriteManifest(const FOmniCaptureSettings& Settings, const TArray<FOmniCaptureFrameMetadata>& Frames, const FString& AudioPath, const FString& VideoPath, int32 DroppedFrames, const FOmniCapturePNGEncodeStats& PNGEncodeStats, int32 DuplicateFrames, FString& OutManifestPath) const
 {
     TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
 
@@ -231,6 +637,12 @@ bool FOmniCaptureMuxer::WriteManifest(const FOmniCaptureSettings& Settings, cons
         OutputFormatString = TEXT("ImageSequence");
     }
     Root->SetStringField(TEXT("outputFormat"), OutputFormatString);
+    Root->SetStringField(TEXT("imageExtension"), Settings.GetImageFileExtension());
+    if (Settings.bWriteFramePack && IsImageSequenceFormat(Settings.OutputFormat))
+    {
+        Root->SetStringField(TEXT("framePack"), BaseFileName + FOmniCaptureFramePackWriter::GetExtension());
+    }
+    Root->SetBoolField(TEXT("liveEncode"), Settings.ShouldStreamToFFmpeg());
     Root->SetStringField(TEXT("mode"), Settings.Mode == EOmniCaptureMode::Stereo ? TEXT("Stereo") : TEXT("Mono"));
     Root->SetStringField(TEXT("coverage"), ToCoverageString(Settings.Coverage));
     Root->SetStringField(TEXT("gamma"), Settings.Gamma == EOmniCaptureGamma::Linear ? TEXT("Linear") : TEXT("sRGB"));
@@ -238,6 +650,7 @@ bool FOmniCaptureMuxer::WriteManifest(const FOmniCaptureSettings& Settings, cons
     Root->SetNumberField(TEXT("frameCount"), Frames.Num());
     Root->SetNumberField(TEXT("frameRate"), CalculateFrameRate(Frames));
     Root->SetNumberField(TEXT("droppedFrames"), DroppedFrames);
+    Root->SetNumberField(TEXT("duplicateFrames"), DuplicateFrames);
     Root->SetStringField(TEXT("stereoLayout"), Settings.StereoLayout == EOmniCaptureStereoLayout::TopBottom ? TEXT("TopBottom") : TEXT("SideBySide"));
     const FIntPoint OutputSize = Settings.GetOutputResolution();
     Root->SetNumberField(TEXT("outputWidth"), OutputSize.X);
@@ -332,6 +745,21 @@ bool FOmniCaptureMuxer::WriteManifest(const FOmniCaptureSettings& Settings, cons
         break;
     }
 
+    if (PNGEncodeStats.FrameCount > 0)
+    {
+        // Per-file rates; with several writer tasks in flight the node writes proportionally more.
+        const double EncodeSeconds = FMath::Max(PNGEncodeStats.EncodeSeconds, 1.0e-9);
+        TSharedRef<FJsonObject> PNGEncoding = MakeShared<FJsonObject>();
+        PNGEncoding->SetStringField(TEXT("profile"), ToPNGCompressionString(Settings.PNGCompression));
+        PNGEncoding->SetNumberField(TEXT("encodeThreads"), Settings.PNGEncodeThreads);
+        PNGEncoding->SetNumberField(TEXT("frames"), PNGEncodeStats.FrameCount);
+        PNGEncoding->SetNumberField(TEXT("averageMilliseconds"), PNGEncodeStats.EncodeSeconds * 1000.0 / PNGEncodeStats.FrameCount);
+        PNGEncoding->SetNumberField(TEXT("framesPerSecond"), PNGEncodeStats.FrameCount / EncodeSeconds);
+        PNGEncoding->SetNumberField(TEXT("rawMegabytesPerSecond"), PNGEncodeStats.RawBytes / (1024.0 * 1024.0) / EncodeSeconds);
+        PNGEncoding->SetNumberField(TEXT("compressionRatio"), PNGEncodeStats.EncodedBytes > 0 ? static_cast<double>(PNGEncodeStats.RawBytes) / PNGEncodeStats.EncodedBytes : 0.0);
+        Root->SetObjectField(TEXT("pngEncoding"), PNGEncoding);
+    }
+
     TArray<TSharedPtr<FJsonValue>> FrameArray;
     FrameArray.Reserve(Frames.Num());
     for (const FOmniCaptureFrameMetadata& Metadata : Frames)
@@ -487,33 +915,29 @@ bool FOmniCaptureMuxer::TryInvokeFFmpeg(const FOmniCaptureSettings& Settings, co
     const double FrameRate = CalculateFrameRate(Frames);
     const double EffectiveFrameRate = FrameRate <= 0.0 ? 30.0 : FrameRate;
 
-    FString ColorSpaceArg = TEXT("bt709");
-    FString ColorPrimariesArg = TEXT("bt709");
-    FString ColorTransferArg = TEXT("bt709");
-    FString PixelFormatArg = TEXT("yuv420p");
-
-    switch (Settings.ColorSpace)
-    {
-    case EOmniCaptureColorSpace::BT2020:
-        ColorSpaceArg = TEXT("bt2020nc");
-        ColorPrimariesArg = TEXT("bt2020");
-        ColorTransferArg = TEXT("bt2020-10");
-        PixelFormatArg = TEXT("yuv420p10le");
-        break;
-    case EOmniCaptureColorSpace::HDR10:
-        ColorSpaceArg = TEXT("bt2020nc");
-        ColorPrimariesArg = TEXT("bt2020");
-        ColorTransferArg = TEXT("smpte2084");
-        PixelFormatArg = TEXT("yuv420p10le");
-        break;
-    default:
-        break;
-    }
-
     FString OutputFile = OutputDirectory / (BaseFileName + TEXT(".mp4"));
     FString CommandLine;
+    FOmniCaptureFramePackReader PackReader;
+    const bool bFramePackInput = bImageSequenceOutput && Settings.bWriteFramePack;
 
-    if (bImageSequenceOutput)
+    if (bFramePackInput)
+    {
+        // Frames stay in the pack; ffmpeg decodes them as a stream of images on stdin.
+        const TCHAR* PipeCodec = GetImagePipeCodec(Settings.ImageFormat);
+        const FString PackPath = OutputDirectory / (BaseFileName + FOmniCaptureFramePackWriter::GetExtension());
+        if (!PipeCodec)
+        {
+            UE_LOG(LogTemp, Warning, TEXT("FFmpeg cannot read the frames in %s; extract and transcode them first."), *PackPath);
+            return false;
+        }
+        if (!PackReader.Open(PackPath) || PackReader.GetPrimaryEntriesInFrameOrder().Num() == 0)
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Frame pack %s is missing or empty; skipping FFmpeg mux."), *PackPath);
+            return false;
+        }
+        CommandLine = FString::Printf(TEXT("-y -f image2pipe -framerate %.3f -c:v %s -i pipe:0"), EffectiveFrameRate, PipeCodec);
+    }
+    else if (bImageSequenceOutput)
     {
         const FString Extension = Settings.GetImageFileExtension();
         FString Pattern = OutputDirectory / FString::Printf(TEXT("%s_%%06d%s"), *BaseFileName, *Extension);
@@ -547,6 +971,75 @@ bool FOmniCaptureMuxer::TryInvokeFFmpeg(const FOmniCaptureSettings& Settings, co
         }
     }
 
+    CommandLine += BuildOutputArguments(Settings);
+
+    UE_LOG(LogTemp, Log, TEXT("Invoking FFmpeg: %s %s"), *Binary, *CommandLine);
+
+    void* StdInRead = nullptr;
+    void* StdInWrite = nullptr;
+    if (bFramePackInput && !FPlatformProcess::CreatePipe(StdInRead, StdInWrite, true))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Failed to create the FFmpeg input pipe."));
+        return false;
+    }
+
+    FProcHandle ProcHandle = FPlatformProcess::CreateProc(*Binary, *CommandLine, true, true, true, nullptr, 0, *OutputDirectory, nullptr, StdInRead);
+    if (!ProcHandle.IsValid())
+    {
+        FPlatformProcess::ClosePipe(StdInRead, StdInWrite);
+        UE_LOG(LogTemp, Warning, TEXT("Failed to launch FFmpeg process."));
+        return false;
+    }
+
+    if (bFramePackInput)
+    {
+        const bool bFed = FeedFramePack(PackReader, ProcHandle, StdInWrite);
+        // Closing stdin is ffmpeg's end-of-input.
+        FPlatformProcess::ClosePipe(StdInRead, StdInWrite);
+        if (!bFed)
+        {
+            UE_LOG(LogTemp, Warning, TEXT("FFmpeg stopped before every packed frame was sent."));
+        }
+    }
+
+    FPlatformProcess::WaitForProc(ProcHandle);
+    int32 ReturnCode = 0;
+    FPlatformProcess::GetProcReturnCode(ProcHandle, &ReturnCode);
+    if (ReturnCode != 0)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("FFmpeg returned non-zero exit code %d"), ReturnCode);
+        return false;
+    }
+
+    UE_LOG(LogTemp, Log, TEXT("FFmpeg muxing complete: %s"), *OutputFile);
+    return true;
+}
+
+FString FOmniCaptureMuxer::BuildOutputArguments(const FOmniCaptureSettings& Settings) const
+{
+    FString ColorSpaceArg = TEXT("bt709");
+    FString ColorPrimariesArg = TEXT("bt709");
+    FString ColorTransferArg = TEXT("bt709");
+    FString PixelFormatArg = TEXT("yuv420p");
+
+    switch (Settings.ColorSpace)
+    {
+    case EOmniCaptureColorSpace::BT2020:
+        ColorSpaceArg = TEXT("bt2020nc");
+        ColorPrimariesArg = TEXT("bt2020");
+        ColorTransferArg = TEXT("bt2020-10");
+        PixelFormatArg = TEXT("yuv420p10le");
+        break;
+    case EOmniCaptureColorSpace::HDR10:
+        ColorSpaceArg = TEXT("bt2020nc");
+        ColorPrimariesArg = TEXT("bt2020");
+        ColorTransferArg = TEXT("smpte2084");
+        PixelFormatArg = TEXT("yuv420p10le");
+        break;
+    default:
+        break;
+    }
+
     const FString StereoModeTag = Settings.GetStereoModeMetadataTag();
     const TCHAR* StereoMode = *StereoModeTag;
     const bool bHalfSphere = Settings.IsVR180();
@@ -557,14 +1050,15 @@ bool FOmniCaptureMuxer::TryInvokeFFmpeg(const FOmniCaptureSettings& Settings, co
     const int32 CroppedTop = 0;
     const TCHAR* ViewTag = bHalfSphere ? TEXT("VR180") : TEXT("VR360");
 
+    FString Arguments;
     if (IsImageSequenceFormat(Settings.OutputFormat))
     {
         const TCHAR* CodecName = Settings.Codec == EOmniCaptureCodec::HEVC ? TEXT("libx265") : TEXT("libx264");
-        CommandLine += FString::Printf(TEXT(" -c:v %s -pix_fmt %s"), CodecName, *PixelFormatArg);
+        Arguments += FString::Printf(TEXT(" -c:v %s -pix_fmt %s"), CodecName, *PixelFormatArg);
     }
     else if (Settings.OutputFormat == EOmniOutputFormat::NVENCHardware)
     {
-        CommandLine += TEXT(" -c:v copy");
+        Arguments += TEXT(" -c:v copy");
     }
 
     if (Settings.bInjectFFmpegMetadata && Settings.SupportsSphericalMetadata())
@@ -592,41 +1086,21 @@ bool FOmniCaptureMuxer::TryInvokeFFmpeg(const FOmniCaptureSettings& Settings, co
         MetadataArgs += FString::Printf(TEXT(" -metadata:s:v:0 gpano:CroppedAreaTopPixels=%d"), CroppedTop);
         MetadataArgs += FString::Printf(TEXT(" -metadata:s:v:0 gpano:InitialHorizontalFOVDegrees=%.2f"), static_cast<double>(Settings.GetHorizontalFOVDegrees()));
         MetadataArgs += FString::Printf(TEXT(" -metadata:s:v:0 gpano:InitialVerticalFOVDegrees=%.2f"), static_cast<double>(Settings.GetVerticalFOVDegrees()));
-        CommandLine += MetadataArgs;
+        Arguments += MetadataArgs;
     }
-    CommandLine += FString::Printf(TEXT(" -colorspace %s -color_primaries %s -color_trc %s"), *ColorSpaceArg, *ColorPrimariesArg, *ColorTransferArg);
+    Arguments += FString::Printf(TEXT(" -colorspace %s -color_primaries %s -color_trc %s"), *ColorSpaceArg, *ColorPrimariesArg, *ColorTransferArg);
 
     if (Settings.bForceConstantFrameRate)
     {
-        CommandLine += TEXT(" -vsync cfr");
+        Arguments += TEXT(" -vsync cfr");
     }
     if (Settings.bEnableFastStart)
     {
-        CommandLine += TEXT(" -movflags +faststart");
-    }
-
-    CommandLine += FString::Printf(TEXT(" -shortest \"%s\""), *OutputFile);
-
-    UE_LOG(LogTemp, Log, TEXT("Invoking FFmpeg: %s %s"), *Binary, *CommandLine);
-
-    FProcHandle ProcHandle = FPlatformProcess::CreateProc(*Binary, *CommandLine, true, true, true, nullptr, 0, *OutputDirectory, nullptr);
-    if (!ProcHandle.IsValid())
-    {
-        UE_LOG(LogTemp, Warning, TEXT("Failed to launch FFmpeg process."));
-        return false;
+        Arguments += TEXT(" -movflags +faststart");
     }
 
-    FPlatformProcess::WaitForProc(ProcHandle);
-    int32 ReturnCode = 0;
-    FPlatformProcess::GetProcReturnCode(ProcHandle, &ReturnCode);
-    if (ReturnCode != 0)
-    {
-        UE_LOG(LogTemp, Warning, TEXT("FFmpeg returned non-zero exit code %d"), ReturnCode);
-        return false;
-    }
-
-    UE_LOG(LogTemp, Log, TEXT("FFmpeg muxing complete: %s"), *OutputFile);
-    return true;
+    Arguments += FString::Printf(TEXT(" -shortest \"%s\""), *(OutputDirectory / (BaseFileName + TEXT(".mp4"))));
+    return Arguments;
 }
 
 FString FOmniCaptureMuxer::BuildFFmpegBinaryPath() const
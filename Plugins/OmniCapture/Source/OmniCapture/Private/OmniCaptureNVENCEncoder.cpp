@@ -1,4 +1,5 @@
 #include "OmniCaptureNVENCEncoder.h"
+#include "OmniCaptureMP4Writer.h"
 
 #include "HAL/FileManager.h"
 #include "HAL/PlatformFileManager.h"
@@ -858,7 +859,12 @@ void FOmniCaptureNVENCEncoder::Initialize(const FOmniCaptureSettings& Settings,
 #if OMNI_WITH_NVENC
     AnnexB.Reset();
     bAnnexBHeaderWritten = false;
+    MP4BytesCounted = 0;
+    MP4TimeOrigin = -1.0;
+    bMP4Requested = false;
+    bMP4AudioFormatKnown = false;
 #endif
+    BytesWritten = 0;
 
     const FString FileName = FString::Printf(TEXT("%s.%s"), *Settings.OutputFileName, Settings.Codec == EOmniCaptureCodec::HEVC ? TEXT("h265") : TEXT("h264"));
     OutputFilePath = FPaths::Combine(OutputDirectory, FileName);
@@ -924,6 +930,15 @@ void FOmniCaptureNVENCEncoder::Initialize(const FOmniCaptureSettings& Settings,
         return;
     }
 
+    // The MP4 is opened by the first frame, once the audio recorder has reported the format its track must declare.
+    if (Settings.bMuxNVENCToMP4)
+    {
+        MP4Path = FPaths::Combine(OutputDirectory, Settings.OutputFileName + TEXT(".mp4"));
+        MP4Config = FOmniCaptureMP4Config::FromSettings(Settings);
+        bMP4Requested = true;
+        bMP4FastStart = Settings.bEnableFastStart;
+    }
+
     bInitialized = true;
     UE_LOG(LogOmniCaptureNVENC, Log, TEXT("NVENC encoder primed – waiting for first frame to initialise session (%dx%d, %s)."),
         ActiveParameters.Width,
@@ -1076,7 +1091,11 @@ namespace
         OmniNVENC::FNVENCEncodedPacket Packet;
         if (Encoder.Bitstream.ExtractPacket(Packet) && Packet.Data.Num() > 0 && Encoder.BitstreamFile)
         {
-            Encoder.BitstreamFile->Write(Packet.Data.GetData(), Packet.Data.Num());
+            if (Encoder.BitstreamFile->Write(Packet.Data.GetData(), Packet.Data.Num()))
+            {
+                Encoder.BytesWritten.AddExchange(Packet.Data.Num());
+            }
+            Encoder.WriteToMP4(Packet.Data.GetData(), Packet.Data.Num(), Packet.bKeyFrame, Packet.Timestamp / 1'000'000.0);
         }
 
         Encoder.Bitstream.Unlock();
@@ -1236,7 +1255,11 @@ namespace
         OmniNVENC::FNVENCEncodedPacket Packet;
         if (Encoder.Bitstream.ExtractPacket(Packet) && Packet.Data.Num() > 0 && Encoder.BitstreamFile)
         {
-            Encoder.BitstreamFile->Write(Packet.Data.GetData(), Packet.Data.Num());
+            if (Encoder.BitstreamFile->Write(Packet.Data.GetData(), Packet.Data.Num()))
+            {
+                Encoder.BytesWritten.AddExchange(Packet.Data.Num());
+            }
+            Encoder.WriteToMP4(Packet.Data.GetData(), Packet.Data.Num(), Packet.bKeyFrame, Packet.Timestamp / 1'000'000.0);
         }
 
         Encoder.Bitstream.Unlock();
@@ -1302,12 +1325,58 @@ void FOmniCaptureNVENCEncoder::EnqueueFrame(const FOmniCaptureFrame& Frame)
     }
 
     FScopeLock Lock(&EncoderCS);
+    if (MP4TimeOrigin < 0.0)
+    {
+        MP4TimeOrigin = Frame.Metadata.Timecode;
+        if (bMP4Requested)
+        {
+            MP4Config.bWithAudio &= bMP4AudioFormatKnown;
+            MP4Writer = MakeUnique<FOmniCaptureMP4Writer>();
+            if (!MP4Writer->Open(MP4Path, MP4Config))
+            {
+                UE_LOG(LogOmniCaptureNVENC, Warning, TEXT("Unable to open %s; only the raw %s stream will be written."), *MP4Path, RequestedCodec == EOmniCaptureCodec::HEVC ? TEXT("HEVC") : TEXT("H.264"));
+                MP4Writer.Reset();
+            }
+        }
+    }
     EncodeFrameInternal(*this, Frame);
+
+    // Audio rides on the frame it was gathered with, so it reaches the MP4 right behind its picture. Its timestamps
+    // share the capture clock with the frame timecodes that NVENC hands back as packet timestamps.
+    if (MP4Writer)
+    {
+        for (const FOmniAudioPacket& Packet : Frame.AudioPackets)
+        {
+            if (Packet.NumChannels > 0)
+            {
+                MP4Writer->AddAudio(Packet.PCM16.GetData(), Packet.PCM16.Num() / Packet.NumChannels, Packet.SampleRate, Packet.NumChannels, Packet.Timestamp - MP4TimeOrigin);
+            }
+        }
+        CountMP4Bytes();
+    }
 #else
     (void)Frame;
 #endif
 }
 
+void FOmniCaptureNVENCEncoder::SetAudioFormat(int32 SampleRate, int32 NumChannels)
+{
+#if PLATFORM_WINDOWS && OMNI_WITH_NVENC
+    FScopeLock Lock(&EncoderCS);
+    // An MP4 already open keeps the format its sample entry was written with.
+    if (MP4Writer || SampleRate <= 0 || NumChannels <= 0)
+    {
+        return;
+    }
+    MP4Config.AudioSampleRate = SampleRate;
+    MP4Config.AudioChannels = NumChannels;
+    bMP4AudioFormatKnown = true;
+#else
+    (void)SampleRate;
+    (void)NumChannels;
+#endif
+}
+
 void FOmniCaptureNVENCEncoder::Finalize()
 {
 #if PLATFORM_WINDOWS && OMNI_WITH_NVENC
@@ -1319,6 +1388,12 @@ void FOmniCaptureNVENCEncoder::Finalize()
         BitstreamFile.Reset();
     }
 
+    if (MP4Writer)
+    {
+        MP4Writer->Close(bMP4FastStart);
+        MP4Writer.Reset();
+    }
+
     Bitstream.Release();
     D3D11Input.Shutdown();
     D3D12Input.Shutdown();
@@ -1353,11 +1428,32 @@ bool FOmniCaptureNVENCEncoder::WriteAnnexBHeader()
         return false;
     }
 
-    BitstreamFile->Write(Header.GetData(), Header.Num());
+    if (BitstreamFile->Write(Header.GetData(), Header.Num()))
+    {
+        BytesWritten.AddExchange(Header.Num());
+    }
+    WriteToMP4(Header.GetData(), Header.Num(), false, 0.0);
     bAnnexBHeaderWritten = true;
     UE_LOG(LogOmniCaptureNVENC, Verbose, TEXT("Wrote NVENC Annex B header (%d bytes)."), Header.Num());
     return true;
 }
+
+void FOmniCaptureNVENCEncoder::WriteToMP4(const uint8* Data, int64 Size, bool bKeyFrame, double TimestampSeconds)
+{
+    if (MP4Writer)
+    {
+        MP4Writer->AddVideo(Data, Size, bKeyFrame, TimestampSeconds - FMath::Max(MP4TimeOrigin, 0.0));
+        CountMP4Bytes();
+    }
+}
+
+void FOmniCaptureNVENCEncoder::CountMP4Bytes()
+{
+    // The MP4 writer's offset is only safe to read under EncoderCS; the atomic total is what other threads see.
+    const int64 MP4Bytes = MP4Writer->GetBytesWritten();
+    BytesWritten.AddExchange(MP4Bytes - MP4BytesCounted);
+    MP4BytesCounted = MP4Bytes;
+}
 #else
 bool FOmniCaptureNVENCEncoder::WriteAnnexBHeader()
 {
@@ -0,0 +1,476 @@
+#include "OmniCapturePNGEncoder.h"
+
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Serialization/Archive.h"
+#include "Serialization/MemoryWriter.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "zlib.h"
+THIRD_PARTY_INCLUDES_END
+
+namespace
+{
+    constexpr uint8 GPNGSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    constexpr int64 GDeflateWindowBytes = 32 * 1024;
+
+    enum EPNGFilter : uint8
+    {
+        PNGFilter_None = 0,
+        PNGFilter_Sub,
+        PNGFilter_Up,
+        PNGFilter_Average,
+        PNGFilter_Paeth,
+        PNGFilter_Count
+    };
+
+    void WriteBigEndian32(uint8* Out, uint32 Value)
+    {
+        Out[0] = static_cast<uint8>(Value >> 24);
+        Out[1] = static_cast<uint8>(Value >> 16);
+        Out[2] = static_cast<uint8>(Value >> 8);
+        Out[3] = static_cast<uint8>(Value);
+    }
+
+    /** Brings one source row into PNG order: RGBA channel order and big-endian 16-bit samples. */
+    void ConvertRow(const uint8* Source, ERGBFormat Format, int32 BitDepth, int32 Width, uint8* Out)
+    {
+        if (Format == ERGBFormat::BGRA && BitDepth == 8)
+        {
+            for (int32 X = 0; X < Width; ++X, Source += 4, Out += 4)
+            {
+                Out[0] = Source[2];
+                Out[1] = Source[1];
+                Out[2] = Source[0];
+                Out[3] = Source[3];
+            }
+        }
+        else if (BitDepth == 16)
+        {
+            const int32 Channels = Format == ERGBFormat::Gray ? 1 : 4;
+            const bool bSwapRedBlue = Format == ERGBFormat::BGRA;
+            for (int32 X = 0; X < Width; ++X, Source += Channels * 2, Out += Channels * 2)
+            {
+                for (int32 Channel = 0; Channel < Channels; ++Channel)
+                {
+                    const int32 SourceChannel = bSwapRedBlue && Channel != 1 && Channel != 3 ? 2 - Channel : Channel;
+                    Out[Channel * 2 + 0] = Source[SourceChannel * 2 + 1];
+                    Out[Channel * 2 + 1] = Source[SourceChannel * 2 + 0];
+                }
+            }
+        }
+        else
+        {
+            FMemory::Memcpy(Out, Source, static_cast<int64>(Width) * (Format == ERGBFormat::Gray ? 1 : 4));
+        }
+    }
+
+    FORCEINLINE uint8 PaethPredictor(int32 Left, int32 Up, int32 UpLeft)
+    {
+        const int32 Estimate = Left + Up - UpLeft;
+        const int32 DistanceLeft = FMath::Abs(Estimate - Left);
+        const int32 DistanceUp = FMath::Abs(Estimate - Up);
+        const int32 DistanceUpLeft = FMath::Abs(Estimate - UpLeft);
+        if (DistanceLeft <= DistanceUp && DistanceLeft <= DistanceUpLeft)
+        {
+            return static_cast<uint8>(Left);
+        }
+        return static_cast<uint8>(DistanceUp <= DistanceUpLeft ? Up : UpLeft);
+    }
+
+    /** Residual cost used by libpng's adaptive filter choice: bytes read as signed, summed by magnitude. */
+    FORCEINLINE uint32 ResidualCost(uint8 Value)
+    {
+        return Value < 128 ? Value : 256u - Value;
+    }
+
+    /** Filters one row with a fixed filter into Out and returns its residual cost. Prior is null for the first image row. */
+    template <uint8 Filter>
+    uint64 ApplyFilter(const uint8* Row, const uint8* Prior, int64 RowBytes, int32 BytesPerPixel, uint8* Out)
+    {
+        uint64 Cost = 0;
+        for (int64 Index = 0; Index < RowBytes; ++Index)
+        {
+            const int32 Left = Index >= BytesPerPixel ? Row[Index - BytesPerPixel] : 0;
+            const int32 Up = Prior ? Prior[Index] : 0;
+            const int32 UpLeft = Prior && Index >= BytesPerPixel ? Prior[Index - BytesPerPixel] : 0;
+
+            uint8 Residual = Row[Index];
+            if constexpr (Filter == PNGFilter_Sub)
+            {
+                Residual = static_cast<uint8>(Row[Index] - Left);
+            }
+            else if constexpr (Filter == PNGFilter_Up)
+            {
+                Residual = static_cast<uint8>(Row[Index] - Up);
+            }
+            else if constexpr (Filter == PNGFilter_Average)
+            {
+                Residual = static_cast<uint8>(Row[Index] - ((Left + Up) >> 1));
+            }
+            else if constexpr (Filter == PNGFilter_Paeth)
+            {
+                Residual = static_cast<uint8>(Row[Index] - PaethPredictor(Left, Up, UpLeft));
+            }
+
+            Out[Index] = Residual;
+            Cost += ResidualCost(Residual);
+        }
+        return Cost;
+    }
+
+    /** Writes the filter byte and the cheapest filtered row to Out, which holds RowBytes + 1 bytes. */
+    void FilterRow(const uint8* Row, const uint8* Prior, int64 RowBytes, int32 BytesPerPixel, bool bAdaptive, uint8* Scratch, uint8* Out)
+    {
+        if (!bAdaptive)
+        {
+            ApplyFilter<PNGFilter_Sub>(Row, Prior, RowBytes, BytesPerPixel, Out + 1);
+            Out[0] = PNGFilter_Sub;
+            return;
+        }
+
+        uint8* Best = Out + 1;
+        uint64 BestCost = ApplyFilter<PNGFilter_None>(Row, Prior, RowBytes, BytesPerPixel, Best);
+        uint8 BestFilter = PNGFilter_None;
+
+        auto TryFilter = [&](uint8 Filter, uint64 Cost)
+        {
+            if (Cost < BestCost)
+            {
+                BestCost = Cost;
+                BestFilter = Filter;
+                Swap(Best, Scratch);
+            }
+        };
+
+        TryFilter(PNGFilter_Sub, ApplyFilter<PNGFilter_Sub>(Row, Prior, RowBytes, BytesPerPixel, Scratch));
+        // Without a prior row Up is None and Paeth is Sub, so only the distinct candidates are tried.
+        if (Prior)
+        {
+            TryFilter(PNGFilter_Up, ApplyFilter<PNGFilter_Up>(Row, Prior, RowBytes, BytesPerPixel, Scratch));
+        }
+        TryFilter(PNGFilter_Average, ApplyFilter<PNGFilter_Average>(Row, Prior, RowBytes, BytesPerPixel, Scratch));
+        if (Prior)
+        {
+            TryFilter(PNGFilter_Paeth, ApplyFilter<PNGFilter_Paeth>(Row, Prior, RowBytes, BytesPerPixel, Scratch));
+        }
+
+        if (Best != Out + 1)
+        {
+            FMemory::Memcpy(Out + 1, Best, RowBytes);
+        }
+        Out[0] = BestFilter;
+    }
+
+    struct FPNGStrip
+    {
+        int32 RowStart = 0;
+        int32 RowCount = 0;
+        uint32 Adler = 0;
+        TArray64<uint8> Compressed;
+        bool bFailed = false;
+    };
+
+    /** Deflates one strip as a raw stream seeded with the preceding window, ending byte-aligned so strips concatenate. */
+    bool DeflateStrip(const uint8* Data, int64 Length, const uint8* Dictionary, int64 DictionaryLength, const FOmniCapturePNGEncodeOptions& Options, bool bFinal, TArray64<uint8>& Out)
+    {
+        z_stream Stream;
+        FMemory::Memzero(Stream);
+        if (deflateInit2(&Stream, Options.CompressionLevel, Z_DEFLATED, -MAX_WBITS, 8, Options.bRunLengthMatching ? Z_RLE : Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            return false;
+        }
+
+        // Unprimed, the strip would not pick up where the one before it left off.
+        if (DictionaryLength > 0 && deflateSetDictionary(&Stream, Dictionary, static_cast<uInt>(DictionaryLength)) != Z_OK)
+        {
+            deflateEnd(&Stream);
+            return false;
+        }
+
+        // The bound covers the data; the flush marker or final block needs a few bytes more.
+        Out.SetNumUninitialized(static_cast<int64>(deflateBound(&Stream, static_cast<uLong>(Length))) + 16);
+        Stream.next_in = const_cast<Bytef*>(Data);
+        Stream.avail_in = static_cast<uInt>(Length);
+
+        int64 Produced = 0;
+        int Result = Z_OK;
+        for (;;)
+        {
+            Stream.next_out = Out.GetData() + Produced;
+            Stream.avail_out = static_cast<uInt>(Out.Num() - Produced);
+            Result = deflate(&Stream, bFinal ? Z_FINISH : Z_FULL_FLUSH);
+            Produced = Out.Num() - Stream.avail_out;
+            if (Result == Z_STREAM_ERROR || (bFinal ? Result == Z_STREAM_END : Stream.avail_out > 0))
+            {
+                break;
+            }
+            Out.SetNumUninitialized(Out.Num() * 2);
+        }
+
+        deflateEnd(&Stream);
+        Out.SetNum(Produced, EAllowShrinking::No);
+        return Result != Z_STREAM_ERROR;
+    }
+}
+
+FOmniCapturePNGEncodeOptions FOmniCapturePNGEncodeOptions::ForProfile(EOmniCapturePNGCompression Profile)
+{
+    FOmniCapturePNGEncodeOptions Options;
+    switch (Profile)
+    {
+    case EOmniCapturePNGCompression::Realtime:
+        Options.CompressionLevel = 1;
+        Options.bAdaptiveFilter = false;
+        Options.bRunLengthMatching = true;
+        break;
+    case EOmniCapturePNGCompression::Archive:
+        Options.CompressionLevel = 9;
+        break;
+    default:
+        break;
+    }
+    return Options;
+}
+
+FOmniCapturePNGEncoder::FOmniCapturePNGEncoder(FArchive& InArchive, const FIntPoint& InSize, ERGBFormat InFormat, int32 InBitDepth, const FOmniCapturePNGEncodeOptions& InOptions)
+    : Archive(InArchive)
+    , Size(InSize)
+    , Format(InFormat)
+    , BitDepth(InBitDepth)
+    , Options(InOptions)
+{
+}
+
+bool FOmniCapturePNGEncoder::Begin()
+{
+    if (bBegun || Size.X <= 0 || Size.Y <= 0 || !SupportsFormat(Format, BitDepth))
+    {
+        return false;
+    }
+
+    Channels = Format == ERGBFormat::Gray ? 1 : 4;
+    const uint8 ColorType = Format == ERGBFormat::Gray ? 0 : 6;
+
+    BytesPerPixel = Channels * BitDepth / 8;
+    RowBytes = static_cast<int64>(Size.X) * BytesPerPixel;
+    Options.CompressionLevel = FMath::Clamp(Options.CompressionLevel, 0, 9);
+
+    Archive.Serialize(const_cast<uint8*>(GPNGSignature), sizeof(GPNGSignature));
+
+    uint8 Header[13];
+    WriteBigEndian32(Header + 0, static_cast<uint32>(Size.X));
+    WriteBigEndian32(Header + 4, static_cast<uint32>(Size.Y));
+    Header[8] = static_cast<uint8>(BitDepth);
+    Header[9] = ColorType;
+    Header[10] = 0; // Deflate
+    Header[11] = 0; // Adaptive filtering
+    Header[12] = 0; // Not interlaced
+    WriteChunk("IHDR", Header, sizeof(Header));
+
+    // The zlib stream header, with the level hint libpng would write for the same setting.
+    const uint8 Method = 0x78;
+    uint8 Flags = static_cast<uint8>((Options.bRunLengthMatching || Options.CompressionLevel < 2 ? 0 : Options.CompressionLevel < 6 ? 1 : Options.CompressionLevel == 6 ? 2 : 3) << 6);
+    const int32 Remainder = (Method * 256 + Flags) % 31;
+    Flags += Remainder ? static_cast<uint8>(31 - Remainder) : 0;
+    const uint8 StreamHeader[2] = { Method, Flags };
+    WriteChunk("IDAT", StreamHeader, sizeof(StreamHeader));
+
+    Adler = adler32(0L, Z_NULL, 0);
+    RowsWritten = 0;
+    PriorRow.Reset();
+    Window.Reset();
+    bBegun = true;
+    return !Archive.IsError();
+}
+
+bool FOmniCapturePNGEncoder::WriteRows(const uint8* const* Rows, int32 RowCount)
+{
+    if (!bBegun || RowCount <= 0 || RowsWritten + RowCount > Size.Y)
+    {
+        return false;
+    }
+
+    // On one thread a strip boundary buys nothing and costs a full flush, so the rows go out as one strip.
+    const int32 MaxThreads = Options.MaxThreads > 0 ? Options.MaxThreads : (FTaskGraphInterface::IsRunning() ? FTaskGraphInterface::Get().GetNumWorkerThreads() + 1 : 1);
+    const int64 FilteredRowBytes = RowBytes + 1;
+    const int32 RowsPerStrip = MaxThreads <= 1 ? RowCount : static_cast<int32>(FMath::Clamp<int64>(FMath::DivideAndRoundUp<int64>(Options.MinStripBytes, FilteredRowBytes), 1, RowCount));
+    const int32 StripCount = FMath::DivideAndRoundUp(RowCount, RowsPerStrip);
+    const bool bLastRows = RowsWritten + RowCount == Size.Y;
+
+    TArray<FPNGStrip> Strips;
+    Strips.SetNum(StripCount);
+    for (int32 StripIndex = 0; StripIndex < StripCount; ++StripIndex)
+    {
+        Strips[StripIndex].RowStart = StripIndex * RowsPerStrip;
+        Strips[StripIndex].RowCount = FMath::Min(RowsPerStrip, RowCount - Strips[StripIndex].RowStart);
+    }
+
+    const int32 WorkerCount = FMath::Min(MaxThreads, StripCount);
+    auto ForEachStrip = [&Strips, StripCount, WorkerCount](const TFunctionRef<void(FPNGStrip&)>& ProcessStrip)
+    {
+        if (WorkerCount <= 1)
+        {
+            for (FPNGStrip& Strip : Strips)
+            {
+                ProcessStrip(Strip);
+            }
+            return;
+        }
+
+        TAtomic<int32> NextStrip { 0 };
+        ParallelFor(WorkerCount, [&](int32)
+        {
+            for (int32 StripIndex = NextStrip.IncrementExchange(); StripIndex < StripCount; StripIndex = NextStrip.IncrementExchange())
+            {
+                ProcessStrip(Strips[StripIndex]);
+            }
+        });
+    };
+
+    // Filtering first, for the whole chunk, so every strip can then be deflated against the bytes before it like one stream would.
+    TArray64<uint8> Filtered;
+    Filtered.SetNumUninitialized(FilteredRowBytes * RowCount);
+    ForEachStrip([&](FPNGStrip& Strip)
+    {
+        TArray64<uint8> Converted;
+        TArray64<uint8> Scratch;
+        Converted.SetNumUninitialized(RowBytes * 2);
+        Scratch.SetNumUninitialized(RowBytes);
+        uint8* Current = Converted.GetData();
+        uint8* Previous = Converted.GetData() + RowBytes;
+
+        const uint8* Prior = nullptr;
+        if (Strip.RowStart > 0)
+        {
+            ConvertRow(Rows[Strip.RowStart - 1], Format, BitDepth, Size.X, Previous);
+            Prior = Previous;
+        }
+        else if (PriorRow.Num() == RowBytes)
+        {
+            Prior = PriorRow.GetData();
+        }
+
+        for (int32 Row = Strip.RowStart; Row < Strip.RowStart + Strip.RowCount; ++Row)
+        {
+            ConvertRow(Rows[Row], Format, BitDepth, Size.X, Current);
+            FilterRow(Current, Prior, RowBytes, BytesPerPixel, Options.bAdaptiveFilter, Scratch.GetData(), Filtered.GetData() + FilteredRowBytes * Row);
+            Prior = Current;
+            Swap(Current, Previous);
+        }
+
+        const int64 StripBytes = FilteredRowBytes * Strip.RowCount;
+        Strip.Adler = adler32(adler32(0L, Z_NULL, 0), Filtered.GetData() + FilteredRowBytes * Strip.RowStart, static_cast<uInt>(StripBytes));
+    });
+
+    ForEachStrip([&](FPNGStrip& Strip)
+    {
+        const int64 StripOffset = FilteredRowBytes * Strip.RowStart;
+        const bool bFinal = bLastRows && Strip.RowStart + Strip.RowCount == RowCount;
+        const uint8* Dictionary = StripOffset > 0 ? Filtered.GetData() + FMath::Max<int64>(0, StripOffset - GDeflateWindowBytes) : Window.GetData();
+        const int64 DictionaryLength = StripOffset > 0 ? FMath::Min(StripOffset, GDeflateWindowBytes) : Window.Num();
+        Strip.bFailed = !DeflateStrip(Filtered.GetData() + StripOffset, FilteredRowBytes * Strip.RowCount, Dictionary, DictionaryLength, Options, bFinal, Strip.Compressed);
+    });
+
+    // A failed strip sends the chunk through the serial path instead: one strip, deflated against the previous chunk only.
+    if (Strips.Num() > 1 && Strips.ContainsByPredicate([](const FPNGStrip& Strip) { return Strip.bFailed; }))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("OmniCapture PNG strip compression failed; deflating rows %d-%d serially"), RowsWritten, RowsWritten + RowCount - 1);
+        FPNGStrip Serial;
+        Serial.RowCount = RowCount;
+        Serial.Adler = adler32(adler32(0L, Z_NULL, 0), Filtered.GetData(), static_cast<uInt>(Filtered.Num()));
+        Serial.bFailed = !DeflateStrip(Filtered.GetData(), Filtered.Num(), Window.GetData(), Window.Num(), Options, bLastRows, Serial.Compressed);
+        Strips.Reset();
+        Strips.Add(MoveTemp(Serial));
+    }
+
+    for (FPNGStrip& Strip : Strips)
+    {
+        if (Strip.bFailed)
+        {
+            return false;
+        }
+
+        Adler = adler32_combine(Adler, Strip.Adler, static_cast<z_off_t>(FilteredRowBytes * Strip.RowCount));
+        WriteChunk("IDAT", Strip.Compressed.GetData(), Strip.Compressed.Num());
+    }
+
+    RowsWritten += RowCount;
+    if (bLastRows)
+    {
+        uint8 Trailer[4];
+        WriteBigEndian32(Trailer, Adler);
+        WriteChunk("IDAT", Trailer, sizeof(Trailer));
+    }
+    else
+    {
+        PriorRow.SetNumUninitialized(RowBytes);
+        ConvertRow(Rows[RowCount - 1], Format, BitDepth, Size.X, PriorRow.GetData());
+
+        const int64 WindowBytes = FMath::Min(Filtered.Num(), GDeflateWindowBytes);
+        Window.SetNumUninitialized(WindowBytes);
+        FMemory::Memcpy(Window.GetData(), Filtered.GetData() + Filtered.Num() - WindowBytes, WindowBytes);
+    }
+
+    return !Archive.IsError();
+}
+
+bool FOmniCapturePNGEncoder::End()
+{
+    if (!bBegun || RowsWritten != Size.Y)
+    {
+        return false;
+    }
+
+    WriteChunk("IEND", nullptr, 0);
+    bBegun = false;
+    return !Archive.IsError();
+}
+
+bool FOmniCapturePNGEncoder::SupportsFormat(ERGBFormat Format, int32 BitDepth)
+{
+    return (Format == ERGBFormat::RGBA || Format == ERGBFormat::BGRA || Format == ERGBFormat::Gray) && (BitDepth == 8 || BitDepth == 16);
+}
+
+bool FOmniCapturePNGEncoder::EncodeToMemory(const FIntPoint& Size, ERGBFormat Format, int32 BitDepth, const uint8* Pixels, int64 BytesPerRow, const FOmniCapturePNGEncodeOptions& Options, TArray64<uint8>& OutPNG)
+{
+    OutPNG.Reset();
+    FMemoryWriter64 Writer(OutPNG);
+    FOmniCapturePNGEncoder Encoder(Writer, Size, Format, BitDepth, Options);
+    if (!Encoder.Begin() || !Pixels)
+    {
+        return false;
+    }
+
+    TArray<const uint8*> Rows;
+    Rows.SetNumUninitialized(Size.Y);
+    for (int32 Row = 0; Row < Size.Y; ++Row)
+    {
+        Rows[Row] = Pixels + BytesPerRow * Row;
+    }
+    return Encoder.WriteRows(Rows.GetData(), Size.Y) && Encoder.End();
+}
+
+void FOmniCapturePNGEncoder::WriteChunk(const char* Type, const uint8* Data, int64 Length)
+{
+    uint8 Prefix[8];
+    WriteBigEndian32(Prefix, static_cast<uint32>(Length));
+    FMemory::Memcpy(Prefix + 4, Type, 4);
+
+    uLong Crc = crc32(0L, Z_NULL, 0);
+    Crc = crc32(Crc, Prefix + 4, 4);
+    if (Length > 0)
+    {
+        Crc = crc32(Crc, Data, static_cast<uInt>(Length));
+    }
+
+    uint8 Suffix[4];
+    WriteBigEndian32(Suffix, static_cast<uint32>(Crc));
+
+    Archive.Serialize(Prefix, sizeof(Prefix));
+    if (Length > 0)
+    {
+        Archive.Serialize(const_cast<uint8*>(Data), Length);
+    }
+    Archive.Serialize(Suffix, sizeof(Suffix));
+}
@@ -1,11 +1,15 @@
 #include "OmniCapturePreviewActor.h"
 
+#include "Async/ParallelFor.h"
 #include "Components/StaticMeshComponent.h"
-#include "OmniCaptureEquirectConverter.h"
 #include "Engine/StaticMesh.h"
 #include "Engine/Texture2D.h"
+#include "ImagePixelData.h"
 #include "Materials/MaterialInstanceDynamic.h"
 #include "Materials/MaterialInterface.h"
+#include "RenderingThread.h"
+#include "RHICommandList.h"
+#include "TextureResource.h"
 #include "OmniCaptureIncludeFixes.h"
 
 namespace
@@ -29,6 +33,97 @@ namespace
         }
         return CachedMaterial.Get();
     }
+
+    constexpr int32 GPreviewMaxTapsPerAxis = 4;
+
+    /** Up to GPreviewMaxTapsPerAxis source coordinates spread evenly over [Start, End). */
+    int32 GetBoxTaps(int32 Start, int32 End, int32 (&OutTaps)[GPreviewMaxTapsPerAxis])
+    {
+        const int32 Extent = FMath::Max(1, End - Start);
+        const int32 TapCount = FMath::Min(Extent, GPreviewMaxTapsPerAxis);
+        for (int32 Tap = 0; Tap < TapCount; ++Tap)
+        {
+            OutTaps[Tap] = Start + ((2 * Tap + 1) * Extent) / (2 * TapCount);
+        }
+        return TapCount;
+    }
+
+    FORCEINLINE FLinearColor LoadTap(const FColor& Pixel)
+    {
+        // 8-bit frames are already sRGB encoded; averaging the encoded bytes is plenty for a preview.
+        return FLinearColor(Pixel.R, Pixel.G, Pixel.B, Pixel.A);
+    }
+
+    FORCEINLINE FLinearColor LoadTap(const FFloat16Color& Pixel)
+    {
+        return FLinearColor(Pixel);
+    }
+
+    FORCEINLINE FLinearColor LoadTap(const FLinearColor& Pixel)
+    {
+        return Pixel;
+    }
+
+    template <typename PixelType>
+    void DownsampleTyped(const TImagePixelData<PixelType>& Source, const FIntRect& SourceRect, const FIntPoint& TargetSize, FColor* OutPixels)
+    {
+        const int64 SourceWidth = Source.GetSize().X;
+        const PixelType* SourcePixels = Source.Pixels.GetData();
+        const int32 RectWidth = SourceRect.Width();
+        const int32 RectHeight = SourceRect.Height();
+
+        TArray<int32> ColumnTaps;
+        TArray<int32> ColumnTapCounts;
+        ColumnTaps.SetNumUninitialized(TargetSize.X * GPreviewMaxTapsPerAxis);
+        ColumnTapCounts.SetNumUninitialized(TargetSize.X);
+        for (int32 X = 0; X < TargetSize.X; ++X)
+        {
+            int32 Taps[GPreviewMaxTapsPerAxis];
+            const int32 Start = SourceRect.Min.X + static_cast<int32>(static_cast<int64>(X) * RectWidth / TargetSize.X);
+            const int32 End = SourceRect.Min.X + static_cast<int32>(static_cast<int64>(X + 1) * RectWidth / TargetSize.X);
+            ColumnTapCounts[X] = GetBoxTaps(Start, End, Taps);
+            FMemory::Memcpy(&ColumnTaps[X * GPreviewMaxTapsPerAxis], Taps, sizeof(Taps));
+        }
+
+        ParallelFor(TargetSize.Y, [&](int32 Y)
+        {
+            int32 RowTaps[GPreviewMaxTapsPerAxis];
+            const int32 Start = SourceRect.Min.Y + static_cast<int32>(static_cast<int64>(Y) * RectHeight / TargetSize.Y);
+            const int32 End = SourceRect.Min.Y + static_cast<int32>(static_cast<int64>(Y + 1) * RectHeight / TargetSize.Y);
+            const int32 RowTapCount = GetBoxTaps(Start, End, RowTaps);
+
+            for (int32 X = 0; X < TargetSize.X; ++X)
+            {
+                const int32* Taps = &ColumnTaps[X * GPreviewMaxTapsPerAxis];
+                const int32 TapCount = ColumnTapCounts[X];
+
+                FLinearColor Sum = FLinearColor::Transparent;
+                for (int32 RowTap = 0; RowTap < RowTapCount; ++RowTap)
+                {
+                    const PixelType* SourceRow = SourcePixels + RowTaps[RowTap] * SourceWidth;
+                    for (int32 Tap = 0; Tap < TapCount; ++Tap)
+                    {
+                        Sum += LoadTap(SourceRow[Taps[Tap]]);
+                    }
+                }
+
+                const FLinearColor Average = Sum / static_cast<float>(RowTapCount * TapCount);
+                FColor& Out = OutPixels[static_cast<int64>(Y) * TargetSize.X + X];
+                if constexpr (std::is_same_v<PixelType, FColor>)
+                {
+                    Out = FColor(
+                        static_cast<uint8>(FMath::RoundToInt(Average.R)),
+                        static_cast<uint8>(FMath::RoundToInt(Average.G)),
+                        static_cast<uint8>(FMath::RoundToInt(Average.B)),
+                        static_cast<uint8>(FMath::RoundToInt(Average.A)));
+                }
+                else
+                {
+                    Out = Average.ToFColor(true);
+                }
+            }
+        });
+    }
 }
 
 AOmniCapturePreviewActor::AOmniCapturePreviewActor()
@@ -141,83 +236,107 @@ void AOmniCapturePreviewActor::SetPreviewView(EOmniCapturePreviewView InView)
     PreviewViewMode = InView;
 }
 
-void AOmniCapturePreviewActor::UpdatePreviewTexture(const FOmniCaptureEquirectResult& Result, const FOmniCaptureSettings& Settings)
+FIntPoint AOmniCapturePreviewActor::GetDecimatedSize(const FIntPoint& SourceSize, int32 MaxResolution)
 {
-    const FIntPoint Size = Result.Size;
-    if (Size.X <= 0 || Size.Y <= 0)
+    const int32 LongestSide = FMath::Max(SourceSize.X, SourceSize.Y);
+    if (MaxResolution <= 0 || LongestSide <= MaxResolution)
     {
-        return;
+        return SourceSize;
     }
 
-    const bool bStereo = Settings.IsStereo();
-    const bool bShowSingleEye = bStereo && PreviewViewMode != EOmniCapturePreviewView::StereoComposite;
+    const double Scale = static_cast<double>(MaxResolution) / LongestSide;
+    return FIntPoint(
+        FMath::Max(1, FMath::RoundToInt(SourceSize.X * Scale)),
+        FMath::Max(1, FMath::RoundToInt(SourceSize.Y * Scale)));
+}
 
-    FIntPoint TargetSize = Size;
-    if (bShowSingleEye)
-    {
-        if (Settings.StereoLayout == EOmniCaptureStereoLayout::SideBySide)
-        {
-            TargetSize.X = FMath::Max(1, Size.X / 2);
-        }
-        else
-        {
-            TargetSize.Y = FMath::Max(1, Size.Y / 2);
-        }
-    }
+void AOmniCapturePreviewActor::DownsamplePreview(const FImagePixelData& Source, const FIntRect& SourceRect, const FIntPoint& TargetSize, TArray<FColor>& OutPixels)
+{
+    OutPixels.Reset();
 
-    ResizePreviewTexture(TargetSize);
-    if (!PreviewTexture)
+    const FIntRect ClampedRect(SourceRect.Min.ComponentMax(FIntPoint::ZeroValue), SourceRect.Max.ComponentMin(Source.GetSize()));
+    if (TargetSize.X <= 0 || TargetSize.Y <= 0 || ClampedRect.Width() <= 0 || ClampedRect.Height() <= 0)
     {
         return;
     }
 
-    FTexture2DMipMap& Mip = PreviewTexture->GetPlatformData()->Mips[0];
-    void* TextureMemory = Mip.BulkData.Lock(LOCK_READ_WRITE);
+    OutPixels.SetNumUninitialized(TargetSize.X * TargetSize.Y);
+    switch (Source.GetType())
+    {
+    case EImagePixelType::Color:
+        DownsampleTyped(static_cast<const TImagePixelData<FColor>&>(Source), ClampedRect, TargetSize, OutPixels.GetData());
+        break;
+    case EImagePixelType::Float16:
+        DownsampleTyped(static_cast<const TImagePixelData<FFloat16Color>&>(Source), ClampedRect, TargetSize, OutPixels.GetData());
+        break;
+    case EImagePixelType::Float32:
+        DownsampleTyped(static_cast<const TImagePixelData<FLinearColor>&>(Source), ClampedRect, TargetSize, OutPixels.GetData());
+        break;
+    default:
+        OutPixels.Reset();
+        break;
+    }
+}
 
-    if (Result.PreviewPixels.Num() != Size.X * Size.Y)
+bool AOmniCapturePreviewActor::BuildPreview(const FImagePixelData& PixelData, const FOmniCaptureSettings& Settings, EOmniCapturePreviewView View, FOmniCapturePreviewImage& OutImage)
+{
+    const FIntPoint Size = PixelData.GetSize();
+    if (Size.X <= 0 || Size.Y <= 0)
     {
-        Mip.BulkData.Unlock();
-        return;
+        return false;
     }
 
+    const bool bShowSingleEye = Settings.IsStereo() && View != EOmniCapturePreviewView::StereoComposite;
+    const bool bShowLeftEye = View == EOmniCapturePreviewView::LeftEye;
+
+    FIntRect SourceRect(FIntPoint::ZeroValue, Size);
     if (bShowSingleEye)
     {
-        const int32 OutputPixels = TargetSize.X * TargetSize.Y;
-        PreviewScratchBuffer.SetNum(OutputPixels, EAllowShrinking::No);
-
         if (Settings.StereoLayout == EOmniCaptureStereoLayout::SideBySide)
         {
-            const int32 EyeWidth = TargetSize.X;
-            const int32 SourceWidth = Size.X;
-            const int32 StartX = PreviewViewMode == EOmniCapturePreviewView::LeftEye ? 0 : EyeWidth;
-            for (int32 Row = 0; Row < Size.Y; ++Row)
-            {
-                const int32 DestIndex = Row * EyeWidth;
-                const int32 SourceIndex = Row * SourceWidth + StartX;
-                FMemory::Memcpy(PreviewScratchBuffer.GetData() + DestIndex, Result.PreviewPixels.GetData() + SourceIndex, EyeWidth * sizeof(FColor));
-            }
+            const int32 EyeWidth = FMath::Max(1, Size.X / 2);
+            SourceRect.Min.X = bShowLeftEye ? 0 : EyeWidth;
+            SourceRect.Max.X = SourceRect.Min.X + EyeWidth;
         }
         else
         {
-            const int32 EyeHeight = TargetSize.Y;
-            const int32 SourceWidth = Size.X;
-            const int32 StartRow = PreviewViewMode == EOmniCapturePreviewView::LeftEye ? 0 : EyeHeight;
-            for (int32 Row = 0; Row < EyeHeight; ++Row)
-            {
-                const int32 DestIndex = Row * TargetSize.X;
-                const int32 SourceIndex = (StartRow + Row) * SourceWidth;
-                FMemory::Memcpy(PreviewScratchBuffer.GetData() + DestIndex, Result.PreviewPixels.GetData() + SourceIndex, TargetSize.X * sizeof(FColor));
-            }
+            const int32 EyeHeight = FMath::Max(1, Size.Y / 2);
+            SourceRect.Min.Y = bShowLeftEye ? 0 : EyeHeight;
+            SourceRect.Max.Y = SourceRect.Min.Y + EyeHeight;
         }
+    }
 
-        FMemory::Memcpy(TextureMemory, PreviewScratchBuffer.GetData(), PreviewScratchBuffer.Num() * sizeof(FColor));
+    OutImage.Size = GetDecimatedSize(SourceRect.Size(), Settings.PreviewMaxResolution);
+    DownsamplePreview(PixelData, SourceRect, OutImage.Size, OutImage.Pixels);
+    return OutImage.Pixels.Num() == OutImage.Size.X * OutImage.Size.Y && OutImage.Pixels.Num() > 0;
+}
+
+bool AOmniCapturePreviewActor::UploadPreview(FOmniCapturePreviewImage&& Image)
+{
+    const FIntPoint TargetSize = Image.Size;
+    if (TargetSize.X <= 0 || TargetSize.Y <= 0 || Image.Pixels.Num() != TargetSize.X * TargetSize.Y || IsUploadPending())
+    {
+        return false;
     }
-    else
+
+    ResizePreviewTexture(TargetSize);
+    FTextureResource* Resource = PreviewTexture ? PreviewTexture->GetResource() : nullptr;
+    if (!Resource)
     {
-        const int32 CopyCount = FMath::Min(Result.PreviewPixels.Num(), TargetSize.X * TargetSize.Y);
-        FMemory::Memcpy(TextureMemory, Result.PreviewPixels.GetData(), CopyCount * sizeof(FColor));
+        return false;
     }
 
-    Mip.BulkData.Unlock();
-    PreviewTexture->UpdateResource();
+    // Uploading through the RHI keeps the game thread out of BulkData locks and texture resource rebuilds.
+    PendingUploads->IncrementExchange();
+    ENQUEUE_RENDER_COMMAND(OmniCapturePreviewUpload)([Resource, TargetSize, UploadPixels = MoveTemp(Image.Pixels), Pending = PendingUploads](FRHICommandListImmediate& RHICmdList)
+    {
+        if (FRHITexture* TextureRHI = Resource->GetTexture2DRHI())
+        {
+            const FUpdateTextureRegion2D Region(0, 0, 0, 0, TargetSize.X, TargetSize.Y);
+            RHICmdList.UpdateTexture2D(TextureRHI, 0, Region, TargetSize.X * sizeof(FColor), reinterpret_cast<const uint8*>(UploadPixels.GetData()));
+        }
+        Pending->DecrementExchange();
+    });
+
+    return true;
 }
@@ -1,215 +1,496 @@
 #include "OmniCaptureRingBuffer.h"
 
+#include "OmniCaptureFramePool.h"
+#include "OmniCaptureMemoryBudget.h"
 #include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
 #include "HAL/Runnable.h"
 #include "HAL/RunnableThread.h"
 #include "Math/UnrealMathUtility.h"
 
+namespace
+{
+    // A capacity of zero used to mean an unbounded queue. The lock-free ring needs a fixed slot count,
+    // so "unbounded" maps to a generous ring that, once exhausted, follows the policy like any other.
+    constexpr int32 GUnboundedRingSlots = 256;
+
+    // Upper bound for a single producer wait so a missed wake-up can never stall the game thread indefinitely.
+    constexpr uint32 GProducerWaitMilliseconds = 2;
+
+    constexpr int32 GMaxRingBufferWorkers = 16;
+}
+
 class FOmniCaptureRingBufferWorker final : public FRunnable
 {
 public:
-    FOmniCaptureRingBufferWorker(TQueue<TUniquePtr<FOmniCaptureFrame>, EQueueMode::Mpsc>& InQueue, FEvent* InEvent, const TFunction<void(TUniquePtr<FOmniCaptureFrame>&&)>& InConsumer, FCriticalSection& InQueueCS, TAtomic<bool>& InRunning, TAtomic<int32>& InPending)
-        : Queue(InQueue)
-        , DataEvent(InEvent)
-        , Consumer(InConsumer)
-        , QueueCS(InQueueCS)
-        , bRunning(InRunning)
-        , Pending(InPending)
+    explicit FOmniCaptureRingBufferWorker(FOmniCaptureRingBuffer& InOwner)
+        : Owner(InOwner)
     {
+        BusyCycles = 0;
+        StartCycles = FPlatformTime::Cycles64();
     }
 
     virtual uint32 Run() override
     {
-        while (bRunning.Load())
+        while (Owner.bRunning.Load())
         {
-            DataEvent->Wait();
+            Owner.DataEvent->Wait();
 
-            if (!bRunning.Load())
+            if (!Owner.bRunning.Load())
             {
                 break;
             }
 
-            Drain();
+            DrainTimed();
         }
 
-        Drain();
+        DrainTimed();
+        Owner.ActiveWorkers.DecrementExchange();
 
+        // DataEvent is auto-reset and wakes one waiter, so each exiting worker passes the stop signal on to the next.
+        Owner.DataEvent->Trigger();
         return 0;
     }
 
-private:
-    void Drain()
+    float GetUtilization() const
     {
-        if (!Consumer)
-        {
-            return;
-        }
+        const uint64 Elapsed = FPlatformTime::Cycles64() - StartCycles;
+        return Elapsed > 0 ? FMath::Clamp(static_cast<float>(static_cast<double>(BusyCycles.Load()) / static_cast<double>(Elapsed)), 0.0f, 1.0f) : 0.0f;
+    }
 
-        for (;;)
+private:
+    void DrainTimed()
+    {
+        // Only the consumers count as busy; time spent waiting for a turn in the ordered stage is idle.
+        uint64 WorkCycles = 0;
+        while (Owner.ProcessNextFrame(&WorkCycles))
         {
-            TUniquePtr<FOmniCaptureFrame> Frame;
-            {
-                FScopeLock Lock(&QueueCS);
-                if (!Queue.Dequeue(Frame))
-                {
-                    break;
-                }
-            }
-
-            if (Frame.IsValid())
-            {
-                Consumer(MoveTemp(Frame));
-                Pending.DecrementExchange();
-            }
+            BusyCycles.AddExchange(WorkCycles);
+            WorkCycles = 0;
         }
     }
 
 private:
-    TQueue<TUniquePtr<FOmniCaptureFrame>, EQueueMode::Mpsc>& Queue;
-    FEvent* DataEvent = nullptr;
-    TFunction<void(TUniquePtr<FOmniCaptureFrame>&&)> Consumer;
-    FCriticalSection& QueueCS;
-    TAtomic<bool>& bRunning;
-    TAtomic<int32>& Pending;
+    FOmniCaptureRingBuffer& Owner;
+    TAtomic<uint64> BusyCycles;
+    uint64 StartCycles = 0;
 };
 
 FOmniCaptureRingBuffer::FOmniCaptureRingBuffer()
 {
+    EnqueuePosition = 0;
+    DequeuePosition = 0;
     bRunning = false;
+    ActiveWorkers = 0;
+    ReorderDepth = 0;
+    MaxReorderDepth = 0;
+    WaitingProducers = 0;
     PendingCount = 0;
     DroppedCount = 0;
     BlockedCount = 0;
+    BudgetBlockedCount = 0;
 }
 
 FOmniCaptureRingBuffer::~FOmniCaptureRingBuffer()
 {
-    StopWorker();
+    StopWorkers();
     Flush();
+    ReleaseSlots();
 
     if (DataEvent)
     {
         FPlatformProcess::ReturnSynchEventToPool(DataEvent);
         DataEvent = nullptr;
     }
+
+    if (SpaceEvent)
+    {
+        FPlatformProcess::ReturnSynchEventToPool(SpaceEvent);
+        SpaceEvent = nullptr;
+    }
+
+    if (DrainedEvent)
+    {
+        FPlatformProcess::ReturnSynchEventToPool(DrainedEvent);
+        DrainedEvent = nullptr;
+    }
 }
 
-void FOmniCaptureRingBuffer::Initialize(const FOmniCaptureSettings& Settings, const TFunction<void(TUniquePtr<FOmniCaptureFrame>&&)>& InConsumer)
+void FOmniCaptureRingBuffer::Initialize(const FOmniCaptureSettings& Settings, const TFunction<void(TUniquePtr<FOmniCaptureFrame>&&)>& InConsumer, const TFunction<void(const FOmniCaptureFrame&)>& InOrderedConsumer)
 {
     Consumer = InConsumer;
+    OrderedConsumer = InOrderedConsumer;
     Capacity = FMath::Max(0, Settings.RingBufferCapacity);
     Policy = Settings.RingBufferPolicy;
-    StartWorker();
+    AllocateSlots(Capacity > 0 ? Capacity : GUnboundedRingSlots);
+    StartWorkers(FMath::Clamp(Settings.RingBufferWorkerCount, 1, GMaxRingBufferWorkers));
 }
 
-void FOmniCaptureRingBuffer::Enqueue(TUniquePtr<FOmniCaptureFrame>&& Frame)
+void FOmniCaptureRingBuffer::AllocateSlots(int32 InSlotCount)
 {
-    if (!Consumer)
+    ReleaseSlots();
+
+    SlotCount = static_cast<uint64>(FMath::Max(1, InSlotCount));
+    Slots = MakeUnique<FSlot[]>(SlotCount);
+    for (uint64 Index = 0; Index < SlotCount; ++Index)
+    {
+        Slots[Index].Sequence = Index;
+        Slots[Index].Frame = nullptr;
+    }
+
+    EnqueuePosition = 0;
+    DequeuePosition = 0;
+}
+
+void FOmniCaptureRingBuffer::ReleaseSlots()
+{
+    if (!Slots.IsValid())
     {
         return;
     }
 
-    if (Capacity > 0)
+    FOmniCaptureFrame* Frame = nullptr;
+    while (TryPop(Frame))
+    {
+        DiscardFrame(Frame);
+        PendingCount.DecrementExchange();
+    }
+
+    Slots.Reset();
+    SlotCount = 0;
+}
+
+bool FOmniCaptureRingBuffer::TryPush(FOmniCaptureFrame* Frame)
+{
+    uint64 Position = EnqueuePosition.Load(EMemoryOrder::Relaxed);
+    FSlot* Slot = nullptr;
+
+    for (;;)
     {
-        for (;;)
+        Slot = &Slots[Position % SlotCount];
+        const uint64 Sequence = Slot->Sequence.Load();
+        const int64 Difference = static_cast<int64>(Sequence) - static_cast<int64>(Position);
+
+        if (Difference == 0)
         {
-            const int32 Current = PendingCount.Load();
-            if (Current < Capacity)
+            if (EnqueuePosition.CompareExchange(Position, Position + 1))
             {
                 break;
             }
+        }
+        else if (Difference < 0)
+        {
+            return false;
+        }
+        else
+        {
+            Position = EnqueuePosition.Load(EMemoryOrder::Relaxed);
+        }
+    }
+
+    Slot->Frame = Frame;
+    Slot->Sequence.Store(Position + 1);
+    return true;
+}
+
+bool FOmniCaptureRingBuffer::TryPop(FOmniCaptureFrame*& OutFrame)
+{
+    uint64 Position = DequeuePosition.Load(EMemoryOrder::Relaxed);
+    FSlot* Slot = nullptr;
 
-            if (Policy == EOmniCaptureRingBufferPolicy::DropOldest)
+    for (;;)
+    {
+        Slot = &Slots[Position % SlotCount];
+        const uint64 Sequence = Slot->Sequence.Load();
+        const int64 Difference = static_cast<int64>(Sequence) - static_cast<int64>(Position + 1);
+
+        if (Difference == 0)
+        {
+            if (DequeuePosition.CompareExchange(Position, Position + 1))
             {
-                TUniquePtr<FOmniCaptureFrame> Discarded;
-                {
-                    FScopeLock Lock(&QueueCriticalSection);
-                    if (Queue.Dequeue(Discarded))
-                    {
-                        PendingCount.DecrementExchange();
-                    }
-                }
-                DroppedCount.IncrementExchange();
                 break;
             }
-            else
-            {
-                BlockedCount.IncrementExchange();
-                FPlatformProcess::Sleep(0.001f);
-            }
+        }
+        else if (Difference < 0)
+        {
+            return false;
+        }
+        else
+        {
+            Position = DequeuePosition.Load(EMemoryOrder::Relaxed);
         }
     }
 
+    OutFrame = Slot->Frame;
+    Slot->Frame = nullptr;
+    Slot->Sequence.Store(Position + SlotCount);
+
+    if (WaitingProducers.Load() > 0 && SpaceEvent)
     {
-        FScopeLock Lock(&QueueCriticalSection);
-        Queue.Enqueue(MoveTemp(Frame));
-        PendingCount.IncrementExchange();
+        SpaceEvent->Trigger();
     }
 
+    return true;
+}
+
+void FOmniCaptureRingBuffer::Enqueue(TUniquePtr<FOmniCaptureFrame>&& Frame)
+{
+    if (!Consumer || !Slots.IsValid() || !Frame.IsValid())
+    {
+        return;
+    }
+
+    if (MemoryBudget && !ReserveFrameBytes(*Frame))
+    {
+        FOmniCaptureFramePool::Get().ReleaseFrame(MoveTemp(Frame));
+        DroppedCount.IncrementExchange();
+        return;
+    }
+
+    FOmniCaptureFrame* RawFrame = Frame.Release();
+    bool bCountedBlock = false;
+
+    while (!TryPush(RawFrame))
+    {
+        if (Policy == EOmniCaptureRingBufferPolicy::DropOldest)
+        {
+            FOmniCaptureFrame* Discarded = nullptr;
+            if (TryPop(Discarded))
+            {
+                DiscardFrame(Discarded);
+                PendingCount.DecrementExchange();
+                DroppedCount.IncrementExchange();
+            }
+            continue;
+        }
+
+        if (!bCountedBlock)
+        {
+            BlockedCount.IncrementExchange();
+            bCountedBlock = true;
+        }
+
+        WaitingProducers.IncrementExchange();
+        if (!TryPush(RawFrame))
+        {
+            SpaceEvent->Wait(GProducerWaitMilliseconds);
+            WaitingProducers.DecrementExchange();
+            continue;
+        }
+
+        WaitingProducers.DecrementExchange();
+        break;
+    }
+
+    PendingCount.IncrementExchange();
+
     if (DataEvent)
     {
         DataEvent->Trigger();
     }
 }
 
-void FOmniCaptureRingBuffer::Flush()
+bool FOmniCaptureRingBuffer::ReserveFrameBytes(FOmniCaptureFrame& Frame)
 {
-    if (!Consumer)
-    {
-        return;
-    }
+    const int64 FrameBytes = FOmniCaptureMemoryBudget::GetFrameBytes(Frame);
+    bool bCountedBlock = false;
 
-    TUniquePtr<FOmniCaptureFrame> Frame;
-    for (;;)
+    while (!MemoryBudget->TryReserve(FrameBytes))
     {
+        if (Policy == EOmniCaptureRingBufferPolicy::DropOldest)
         {
-            FScopeLock Lock(&QueueCriticalSection);
-            if (!Queue.Dequeue(Frame))
+            FOmniCaptureFrame* Discarded = nullptr;
+            if (TryPop(Discarded))
             {
-                break;
+                DiscardFrame(Discarded);
+                PendingCount.DecrementExchange();
+                DroppedCount.IncrementExchange();
+                continue;
             }
+
+            // Everything in flight is already owned by writer tasks, so the newest frame is the only one left to drop.
+            return false;
+        }
+
+        if (!bCountedBlock)
+        {
+            BudgetBlockedCount.IncrementExchange();
+            bCountedBlock = true;
+        }
+
+        MemoryBudget->WaitForRelease(GProducerWaitMilliseconds);
+    }
+
+    Frame.ReservedBytes = FrameBytes;
+    return true;
+}
+
+void FOmniCaptureRingBuffer::DiscardFrame(FOmniCaptureFrame* Frame)
+{
+    if (MemoryBudget && Frame)
+    {
+        MemoryBudget->ReleaseFrame(*Frame);
+    }
+    FOmniCaptureFramePool::Get().ReleaseFrame(TUniquePtr<FOmniCaptureFrame>(Frame));
+}
+
+bool FOmniCaptureRingBuffer::ProcessNextFrame(uint64* OutWorkCycles)
+{
+    if (!Consumer || !Slots.IsValid())
+    {
+        return false;
+    }
+
+    FOmniCaptureFrame* RawFrame = nullptr;
+    FEvent* TurnEvent = nullptr;
+
+    if (OrderedConsumer)
+    {
+        // Popping and joining the reorder window happen under one lock so the window always reflects ring order.
+        FScopeLock Lock(&ReorderCS);
+        if (!TryPop(RawFrame))
+        {
+            return false;
+        }
+
+        FReorderEntry Entry;
+        Entry.FrameIndex = RawFrame->Metadata.FrameIndex;
+        if (ReorderWindow.Num() > 0)
+        {
+            Entry.TurnEvent = FPlatformProcess::GetSynchEventFromPool();
+            TurnEvent = Entry.TurnEvent;
+        }
+
+        // Keyed on FrameIndex, but never ahead of the head entry which may already be inside the ordered stage.
+        int32 InsertIndex = ReorderWindow.Num();
+        while (InsertIndex > 1 && ReorderWindow[InsertIndex - 1].FrameIndex > Entry.FrameIndex)
+        {
+            --InsertIndex;
+        }
+        ReorderWindow.Insert(Entry, InsertIndex);
+
+        ReorderDepth = ReorderWindow.Num();
+        if (ReorderWindow.Num() > MaxReorderDepth.Load())
+        {
+            MaxReorderDepth = ReorderWindow.Num();
+        }
+    }
+    else if (!TryPop(RawFrame))
+    {
+        return false;
+    }
+
+    TUniquePtr<FOmniCaptureFrame> Frame(RawFrame);
+    uint64 WorkCycles = 0;
+
+    if (OrderedConsumer)
+    {
+        if (TurnEvent)
+        {
+            TurnEvent->Wait();
+            FPlatformProcess::ReturnSynchEventToPool(TurnEvent);
         }
 
-        if (Frame.IsValid())
+        const uint64 OrderedStart = FPlatformTime::Cycles64();
+        OrderedConsumer(*Frame);
+        WorkCycles += FPlatformTime::Cycles64() - OrderedStart;
+
+        FScopeLock Lock(&ReorderCS);
+        ReorderWindow.RemoveAt(0, 1, EAllowShrinking::No);
+        ReorderDepth = ReorderWindow.Num();
+        if (ReorderWindow.Num() > 0 && ReorderWindow[0].TurnEvent)
         {
-            Consumer(MoveTemp(Frame));
-            PendingCount.DecrementExchange();
+            ReorderWindow[0].TurnEvent->Trigger();
         }
     }
+
+    const uint64 ConsumerStart = FPlatformTime::Cycles64();
+    Consumer(MoveTemp(Frame));
+    WorkCycles += FPlatformTime::Cycles64() - ConsumerStart;
+    if (OutWorkCycles)
+    {
+        *OutWorkCycles += WorkCycles;
+    }
+
+    if (PendingCount.DecrementExchange() == 1 && DrainedEvent)
+    {
+        DrainedEvent->Trigger();
+    }
+
+    return true;
 }
 
-void FOmniCaptureRingBuffer::StartWorker()
+void FOmniCaptureRingBuffer::Drain()
 {
-    if (WorkerThread.IsValid())
+    while (ProcessNextFrame())
+    {
+    }
+}
+
+void FOmniCaptureRingBuffer::Flush()
+{
+    Drain();
+
+    // Frames already claimed by other workers still count as pending until their consumers return.
+    while (PendingCount.Load() > 0 && ActiveWorkers.Load() > 0 && DrainedEvent)
+    {
+        DrainedEvent->Wait(GProducerWaitMilliseconds);
+        Drain();
+    }
+}
+
+void FOmniCaptureRingBuffer::StartWorkers(int32 InWorkerCount)
+{
+    if (WorkerThreads.Num() > 0)
     {
         return;
     }
 
     DataEvent = FPlatformProcess::GetSynchEventFromPool();
+    SpaceEvent = FPlatformProcess::GetSynchEventFromPool();
+    DrainedEvent = FPlatformProcess::GetSynchEventFromPool();
     bRunning = true;
 
-    Worker = new FOmniCaptureRingBufferWorker(Queue, DataEvent, Consumer, QueueCriticalSection, bRunning, PendingCount);
-    WorkerThread.Reset(FRunnableThread::Create(Worker, TEXT("OmniCaptureRingBuffer")));
+    for (int32 WorkerIndex = 0; WorkerIndex < InWorkerCount; ++WorkerIndex)
+    {
+        FOmniCaptureRingBufferWorker* Worker = new FOmniCaptureRingBufferWorker(*this);
+        const FString ThreadName = WorkerIndex == 0 ? FString(TEXT("OmniCaptureRingBuffer")) : FString::Printf(TEXT("OmniCaptureRingBuffer%d"), WorkerIndex);
+        ActiveWorkers.IncrementExchange();
+        FRunnableThread* Thread = FRunnableThread::Create(Worker, *ThreadName);
+        if (!Thread)
+        {
+            ActiveWorkers.DecrementExchange();
+            delete Worker;
+            continue;
+        }
+
+        Workers.Add(Worker);
+        WorkerThreads.Emplace(Thread);
+    }
 }
 
-void FOmniCaptureRingBuffer::StopWorker()
+void FOmniCaptureRingBuffer::StopWorkers()
 {
-    if (!WorkerThread.IsValid())
+    if (WorkerThreads.Num() == 0)
     {
         return;
     }
 
+    // One trigger wakes the first waiting worker, which hands it on as it exits; the joins then block rather than spin.
     bRunning = false;
+    DataEvent->Trigger();
 
-    if (DataEvent)
+    for (TUniquePtr<FRunnableThread>& Thread : WorkerThreads)
     {
-        DataEvent->Trigger();
+        Thread->WaitForCompletion();
     }
+    WorkerThreads.Reset();
 
-    WorkerThread->WaitForCompletion();
-    WorkerThread.Reset();
-
-    delete Worker;
-    Worker = nullptr;
+    for (FOmniCaptureRingBufferWorker* Worker : Workers)
+    {
+        delete Worker;
+    }
+    Workers.Reset();
 }
 
 FOmniCaptureRingBufferStats FOmniCaptureRingBuffer::GetStats() const
@@ -218,6 +499,20 @@ FOmniCaptureRingBufferStats FOmniCaptureRingBuffer::GetStats() const
     Stats.PendingFrames = PendingCount.Load();
     Stats.DroppedFrames = DroppedCount.Load();
     Stats.BlockedPushes = BlockedCount.Load();
+    Stats.WorkerCount = Workers.Num();
+    Stats.WorkerUtilization.Reserve(Workers.Num());
+    for (const FOmniCaptureRingBufferWorker* Worker : Workers)
+    {
+        Stats.WorkerUtilization.Add(Worker->GetUtilization());
+    }
+    Stats.ReorderWindowDepth = ReorderDepth.Load();
+    Stats.MaxReorderWindowDepth = MaxReorderDepth.Load();
+    if (MemoryBudget)
+    {
+        Stats.BytesInFlight = MemoryBudget->GetInFlightBytes();
+        Stats.PeakBytesInFlight = MemoryBudget->GetPeakBytes();
+        Stats.MemoryBudgetBytes = MemoryBudget->GetLimitBytes();
+    }
+    Stats.BudgetBlockedPushes = BudgetBlockedCount.Load();
     return Stats;
 }
-
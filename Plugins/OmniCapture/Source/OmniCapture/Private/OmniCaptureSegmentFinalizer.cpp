@@ -0,0 +1,303 @@
+#include "OmniCaptureSegmentFinalizer.h"
+
+#include "OmniCaptureImageWriter.h"
+#include "OmniCaptureMuxer.h"
+#include "OmniCaptureNVENCEncoder.h"
+#include "OmniCaptureTranscoder.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+
+namespace
+{
+    /** The engine may still be writing a segment's WAV when the finalizer reaches it. */
+    constexpr double GAudioFileWaitSeconds = 5.0;
+
+    // Where each step of a finalize ends on its progress bar; a step that has nothing to do is skipped over.
+    constexpr float GDrainedProgress = 0.3f;
+    constexpr float GTranscodedProgress = 0.8f;
+    constexpr float GMuxedProgress = 0.95f;
+
+    void AddMessage(FOmniCaptureSegmentFinalizeResult& Result, ELogVerbosity::Type Verbosity, const TCHAR* Step, const FString& Message, bool bLog)
+    {
+        FOmniCaptureSegmentFinalizeMessage& Entry = Result.Messages.AddDefaulted_GetRef();
+        Entry.Verbosity = Verbosity;
+        Entry.Step = Step;
+        Entry.Message = Message;
+        Entry.bLog = bLog;
+    }
+
+    void WaitForAudioFile(const FString& AudioPath)
+    {
+        const double Deadline = FPlatformTime::Seconds() + GAudioFileWaitSeconds;
+        while (!AudioPath.IsEmpty() && !FPaths::FileExists(AudioPath) && FPlatformTime::Seconds() < Deadline)
+        {
+            FPlatformProcess::Sleep(0.05f);
+        }
+    }
+}
+
+FOmniCaptureSegmentFinalizeJob::FOmniCaptureSegmentFinalizeJob() = default;
+FOmniCaptureSegmentFinalizeJob::FOmniCaptureSegmentFinalizeJob(FOmniCaptureSegmentFinalizeJob&&) = default;
+FOmniCaptureSegmentFinalizeJob& FOmniCaptureSegmentFinalizeJob::operator=(FOmniCaptureSegmentFinalizeJob&&) = default;
+FOmniCaptureSegmentFinalizeJob::~FOmniCaptureSegmentFinalizeJob() = default;
+
+FOmniCaptureSegmentFinalizer::FOmniCaptureSegmentFinalizer() = default;
+
+FOmniCaptureSegmentFinalizer::~FOmniCaptureSegmentFinalizer()
+{
+    // The pool's jobs report back into this object, so they have to finish before any of it goes away.
+    Pool.Stop();
+}
+
+bool FOmniCaptureSegmentFinalizer::Start(int32 InMaxConcurrent)
+{
+    MaxConcurrent = FMath::Max(1, InMaxConcurrent);
+    return Pool.Start(TEXT("OmniCaptureSegmentFinalize"), MaxConcurrent, 0, TPri_BelowNormal);
+}
+
+void FOmniCaptureSegmentFinalizer::Enqueue(FOmniCaptureSegmentFinalizeJob&& Job)
+{
+    {
+        FScopeLock Lock(&StateCS);
+        ++QueuedJobs;
+    }
+
+    Pool.Enqueue([this, Job = MoveTemp(Job)]() mutable
+    {
+        TSharedPtr<FActiveJob> Active = MakeShared<FActiveJob>();
+        Active->SegmentIndex = Job.Segment.SegmentIndex;
+        {
+            FScopeLock Lock(&StateCS);
+            --QueuedJobs;
+            ActiveJobs.Add(Active);
+        }
+
+        FOmniCaptureSegmentFinalizeResult Result;
+        Finalize(Job, Result, [this, &Active](float Progress)
+        {
+            // Transcode workers report as they finish frames, not necessarily in order.
+            FScopeLock Lock(&StateCS);
+            Active->Progress = FMath::Max(Active->Progress, Progress);
+        });
+
+        FScopeLock Lock(&StateCS);
+        ActiveJobs.Remove(Active);
+        if (Result.bFinalized && Result.bSuccess)
+        {
+            ++Stats.CompletedSegments;
+        }
+        else if (Result.bFinalized)
+        {
+            ++Stats.FailedSegments;
+        }
+        Stats.LastFinalizeSeconds = Result.Seconds;
+        Stats.MaxFinalizeSeconds = FMath::Max(Stats.MaxFinalizeSeconds, Result.Seconds);
+        Results.Add(MoveTemp(Result));
+    });
+}
+
+void FOmniCaptureSegmentFinalizer::WaitForAll()
+{
+    if (!Pool.IsRunning())
+    {
+        return;
+    }
+
+    Pool.Stop();
+    Pool.Start(TEXT("OmniCaptureSegmentFinalize"), MaxConcurrent, 0, TPri_BelowNormal);
+}
+
+TArray<FOmniCaptureSegmentFinalizeResult> FOmniCaptureSegmentFinalizer::ConsumeResults()
+{
+    FScopeLock Lock(&StateCS);
+    return MoveTemp(Results);
+}
+
+FOmniCaptureSegmentFinalizeStats FOmniCaptureSegmentFinalizer::GetStats() const
+{
+    FScopeLock Lock(&StateCS);
+    FOmniCaptureSegmentFinalizeStats Result = Stats;
+    Result.QueuedSegments = QueuedJobs;
+    Result.ActiveSegments = ActiveJobs.Num();
+    for (const TSharedPtr<FActiveJob>& Active : ActiveJobs)
+    {
+        Result.ActiveProgress += Active->Progress / ActiveJobs.Num();
+    }
+    return Result;
+}
+
+void FOmniCaptureSegmentFinalizer::Finalize(FOmniCaptureSegmentFinalizeJob& Job, FOmniCaptureSegmentFinalizeResult& OutResult, TFunctionRef<void(float)> ReportProgress)
+{
+    const double StartTime = FPlatformTime::Seconds();
+    OutResult.SegmentIndex = Job.Segment.SegmentIndex;
+    ReportProgress(0.0f);
+
+    DrainWriters(Job, OutResult);
+    ReportProgress(GDrainedProgress);
+
+    if (Job.bFinalize && Job.Segment.Frames.Num() > 0)
+    {
+        FinalizeOutputs(Job, OutResult, ReportProgress);
+        OutResult.bFinalized = true;
+    }
+    ReportProgress(1.0f);
+    OutResult.Seconds = FPlatformTime::Seconds() - StartTime;
+}
+
+void FOmniCaptureSegmentFinalizer::DrainWriters(FOmniCaptureSegmentFinalizeJob& Job, FOmniCaptureSegmentFinalizeResult& OutResult)
+{
+    if (Job.ImageWriter)
+    {
+        Job.ImageWriter->Flush();
+
+        const FOmniCapturePNGEncodeStats WriterStats = Job.ImageWriter->GetPNGEncodeStats();
+        FOmniCapturePNGEncodeStats& SegmentStats = Job.Segment.PNGEncodeStats;
+        SegmentStats.FrameCount += WriterStats.FrameCount;
+        SegmentStats.EncodeSeconds += WriterStats.EncodeSeconds;
+        SegmentStats.RawBytes += WriterStats.RawBytes;
+        SegmentStats.EncodedBytes += WriterStats.EncodedBytes;
+
+        const FOmniCaptureImageWriterStats TaskStats = Job.ImageWriter->GetTaskStats();
+        Job.Segment.DuplicateFrames += TaskStats.DuplicateFrames;
+        if (TaskStats.DuplicateFrames > 0)
+        {
+            AddMessage(OutResult, ELogVerbosity::Log, TEXT("ShutdownOutputWriters"), FString::Printf(TEXT("Image writer: %d repeated frames linked instead of encoded."), TaskStats.DuplicateFrames), false);
+        }
+        if (TaskStats.CompletedTasks > 0)
+        {
+            AddMessage(OutResult, TaskStats.StalledTasks > 0 ? ELogVerbosity::Warning : ELogVerbosity::Log, TEXT("ShutdownOutputWriters"),
+                FString::Printf(TEXT("Image writer: %d tasks (%d failed, %d stalled), avg %.1f ms queued / %.1f ms encoding / %.1f ms writing, max %.1f / %.1f / %.1f ms, producer blocked %d times for %.0f ms, peak %d/%d slots, %d encode threads %.0f%% busy, %d I/O threads %.0f%% busy."),
+                    TaskStats.CompletedTasks, TaskStats.FailedTasks, TaskStats.StalledTasks, TaskStats.AverageQueueMilliseconds, TaskStats.AverageEncodeMilliseconds, TaskStats.AverageIOMilliseconds,
+                    TaskStats.MaxQueueMilliseconds, TaskStats.MaxEncodeMilliseconds, TaskStats.MaxIOMilliseconds, TaskStats.SlotWaits, TaskStats.SlotWaitMilliseconds, TaskStats.PeakInFlightTasks, TaskStats.MaxPendingTasks,
+                    TaskStats.EncodeThreads, TaskStats.EncodeUtilization * 100.0f, TaskStats.IOThreads, TaskStats.IOUtilization * 100.0f),
+                false);
+        }
+        Job.ImageWriter.Reset();
+    }
+
+    if (Job.LiveMuxer && Job.LiveMuxer->IsLiveEncodeActive())
+    {
+        FOmniCaptureFFmpegPipeStats PipeStats;
+        const bool bEncoded = Job.LiveMuxer->FinishLiveEncode(&PipeStats);
+        AddMessage(OutResult, bEncoded ? ELogVerbosity::Log : ELogVerbosity::Warning, TEXT("ShutdownOutputWriters"),
+            FString::Printf(TEXT("Live FFmpeg encode %s: %d frames (%.1f MB video, %.1f MB audio), capture waited on ffmpeg %d times for %.2f s, %d pushes dropped."),
+                bEncoded ? TEXT("finished") : TEXT("failed"), PipeStats.VideoPushes, PipeStats.VideoBytes / (1024.0 * 1024.0), PipeStats.AudioBytes / (1024.0 * 1024.0),
+                PipeStats.BlockedPushes, PipeStats.BlockedSeconds, PipeStats.DroppedPushes),
+            false);
+    }
+    Job.LiveMuxer.Reset();
+
+    if (Job.NVENCEncoder)
+    {
+        if (Job.bFinalize)
+        {
+            Job.NVENCEncoder->Finalize();
+        }
+        Job.NVENCEncoder.Reset();
+    }
+}
+
+void FOmniCaptureSegmentFinalizer::FinalizeOutputs(FOmniCaptureSegmentFinalizeJob& Job, FOmniCaptureSegmentFinalizeResult& OutResult, TFunctionRef<void(float)> ReportProgress)
+{
+    const FOmniCaptureSegmentRecord& Segment = Job.Segment;
+    FOmniCaptureSettings& SegmentSettings = Job.Settings;
+    SegmentSettings.OutputDirectory = Segment.Directory;
+    SegmentSettings.OutputFileName = Segment.BaseFileName;
+
+    // Intermediates are converted before muxing so ffmpeg and the manifest see the final image format.
+    // Packed intermediates stay packed; ExtractFramePack followed by TranscodeIntermediateSequence converts them.
+    const bool bIntermediateSequence = SegmentSettings.ImageFormat == EOmniCaptureImageFormat::Intermediate && Segment.bHasImageSequence && !SegmentSettings.bWriteFramePack;
+    FOmniCaptureTranscodeResult TranscodeResult;
+    TranscodeResult.TargetFormat = FOmniCaptureTranscoder::ResolveTargetFormat(SegmentSettings);
+    if (bIntermediateSequence)
+    {
+        if (SegmentSettings.bTranscodeIntermediatesOnFinalize)
+        {
+            TranscodeResult = FOmniCaptureTranscoder::TranscodeSequence(SegmentSettings, Segment.Directory, 0, [&ReportProgress](float Fraction)
+            {
+                ReportProgress(FMath::Lerp(GDrainedProgress, GTranscodedProgress, Fraction));
+            });
+        }
+        else
+        {
+            TranscodeResult.FramesPending = FOmniCaptureTranscoder::CountPendingFrames(SegmentSettings, Segment.Directory);
+        }
+
+        if (TranscodeResult.IsComplete())
+        {
+            SegmentSettings.ImageFormat = TranscodeResult.TargetFormat;
+        }
+    }
+
+    ReportProgress(GTranscodedProgress);
+
+    // The muxer skips frames that are still intermediates, since ffmpeg cannot read them; this is the one place that says why.
+    const bool bUnreadableFrames = Segment.bHasImageSequence && SegmentSettings.ImageFormat == EOmniCaptureImageFormat::Intermediate
+        && SegmentSettings.OutputFormat == EOmniOutputFormat::ImageSequence && !SegmentSettings.ShouldStreamToFFmpeg();
+    if (bUnreadableFrames)
+    {
+        const FString Remedy = SegmentSettings.bWriteFramePack
+            ? FString(TEXT("call ExtractFramePack, then TranscodeIntermediateSequence"))
+            : FString::Printf(TEXT("%d frames are still waiting; call TranscodeIntermediateSequence"), TranscodeResult.FramesPending);
+        AddMessage(OutResult, ELogVerbosity::Warning, TEXT("FinalizeOutputs"),
+            FString::Printf(TEXT("Segment %d was not muxed because its frames in %s are still intermediates: %s to convert them, then mux the result."), Segment.SegmentIndex, *Segment.Directory, *Remedy), true);
+    }
+
+    WaitForAudioFile(Segment.AudioPath);
+
+    FOmniCaptureMuxer Muxer;
+    Muxer.Initialize(SegmentSettings, Segment.Directory);
+    Muxer.BeginRealtimeSession(SegmentSettings);
+
+    const bool bMuxingExpected = SegmentSettings.OutputFormat != EOmniOutputFormat::ImageSequence || SegmentSettings.ShouldStreamToFFmpeg();
+    const bool bFallbackFromNVENC = (Job.RequestedOutputFormat == EOmniOutputFormat::NVENCHardware && SegmentSettings.OutputFormat == EOmniOutputFormat::ImageSequence);
+    const bool bSuccess = Muxer.FinalizeCapture(SegmentSettings, Segment.Frames, Segment.AudioPath, Segment.VideoPath, Segment.DroppedFrames, Segment.PNGEncodeStats, Segment.DuplicateFrames);
+    Muxer.EndRealtimeSession();
+    ReportProgress(GMuxedProgress);
+
+    if (bIntermediateSequence && SegmentSettings.bGenerateManifest)
+    {
+        FOmniCaptureTranscoder::UpdateManifest(SegmentSettings, Segment.Directory, TranscodeResult);
+    }
+
+    const FString FinalVideoPath = Segment.Directory / (Segment.BaseFileName + TEXT(".mp4"));
+    const bool bFinalFileExists = bMuxingExpected ? FPaths::FileExists(FinalVideoPath) : true;
+
+    if (!bSuccess || (bMuxingExpected && !bFinalFileExists))
+    {
+        OutResult.bSuccess = false;
+        AddMessage(OutResult, ELogVerbosity::Warning, TEXT("FinalizeOutputs"), FString::Printf(TEXT("Output muxing failed for segment %d. Check OmniCapture manifest for details."), Segment.SegmentIndex), true);
+        if (Segment.bHasImageSequence)
+        {
+            AddMessage(OutResult, ELogVerbosity::Warning, TEXT("FinalizeOutputs"), FString::Printf(TEXT("Image sequence frames saved to %s with base name %s."), *Segment.Directory, *Segment.BaseFileName), true);
+            OutResult.ImageSequenceDirectory = Segment.Directory;
+            OutResult.bImageSequenceFallback = Job.RequestedOutputFormat == EOmniOutputFormat::NVENCHardware;
+        }
+        else
+        {
+            AddMessage(OutResult, ELogVerbosity::Warning, TEXT("FinalizeOutputs"), TEXT("No image sequence fallback was recorded for this segment."), true);
+        }
+    }
+    else if (Segment.bHasImageSequence)
+    {
+        if (!bMuxingExpected)
+        {
+            AddMessage(OutResult, bFallbackFromNVENC ? ELogVerbosity::Warning : ELogVerbosity::Log, TEXT("FinalizeOutputs"), FString::Printf(TEXT("Image sequence frames saved to %s with base name %s."), *Segment.Directory, *Segment.BaseFileName), true);
+            OutResult.ImageSequenceDirectory = Segment.Directory;
+            OutResult.bImageSequenceFallback = bFallbackFromNVENC;
+        }
+        else if (SegmentSettings.OutputFormat == EOmniOutputFormat::NVENCHardware)
+        {
+            AddMessage(OutResult, ELogVerbosity::Log, TEXT("FinalizeOutputs"), FString::Printf(TEXT("Image sequence fallback saved alongside NVENC output in %s."), *Segment.Directory), false);
+        }
+    }
+
+    OutResult.OutputPath = (bSuccess && bMuxingExpected && bFinalFileExists) ? FinalVideoPath : FString();
+    if (!OutResult.OutputPath.IsEmpty())
+    {
+        AddMessage(OutResult, ELogVerbosity::Log, TEXT("FinalizeOutputs"), FString::Printf(TEXT("Muxed output ready: %s"), *OutResult.OutputPath), false);
+    }
+    OutResult.bOpenPreview = SegmentSettings.bOpenPreviewOnFinalize && !OutResult.OutputPath.IsEmpty();
+}
@@ -3,13 +3,17 @@
 #include "OmniCaptureAudioRecorder.h"
 #include "OmniCaptureDirectorActor.h"
 #include "OmniCaptureEquirectConverter.h"
+#include "OmniCaptureFramePack.h"
+#include "OmniCaptureFramePool.h"
 #include "OmniCaptureNVENCEncoder.h"
 #include "OmniCaptureImageWriter.h"
 #include "OmniCaptureRigActor.h"
 #include "OmniCaptureRingBuffer.h"
 #include "OmniCapturePreviewActor.h"
 #include "OmniCaptureMuxer.h"
+#include "OmniCaptureSegmentFinalizer.h"
 #include "OmniCaptureSettingsValidator.h"
+#include "OmniCaptureTranscoder.h"
 
 #include "Curves/CurveFloat.h"
 #include "Engine/World.h"
@@ -285,7 +289,6 @@ void UOmniCaptureSubsystem::BeginCapture(const FOmniCaptureSettings& InSettings)
     BaseOutputFileName = ActiveSettings.OutputFileName.IsEmpty() ? TEXT("OmniCapture") : ActiveSettings.OutputFileName;
     CurrentSegmentIndex = 0;
     CapturedFrameMetadata.Empty();
-    CompletedSegments.Empty();
     RecordedAudioPath.Reset();
     RecordedVideoPath.Reset();
     LastFinalizedOutput.Empty();
@@ -395,10 +398,22 @@ void UOmniCaptureSubsystem::BeginCapture(const FOmniCaptureSettings& InSettings)
 
     SpawnPreviewActor();
 
+    if (!MemoryBudget)
+    {
+        MemoryBudget = MakeUnique<FOmniCaptureMemoryBudget>();
+    }
+    MemoryBudget->Configure(static_cast<int64>(ActiveSettings.InFlightMemoryBudgetMB) * 1024 * 1024);
+
     SetDiagnosticContext(TEXT("InitializeOutputs"));
     AppendDiagnostic(EOmniCaptureDiagnosticLevel::Info, TEXT("Initializing output writers."), TEXT("InitializeOutputs"));
     InitializeOutputWriters();
 
+    SegmentFinalizer = MakeUnique<FOmniCaptureSegmentFinalizer>();
+    if (!SegmentFinalizer->Start(ActiveSettings.MaxConcurrentSegmentFinalizations))
+    {
+        LogDiagnosticMessage(ELogVerbosity::Warning, TEXT("InitializeOutputs"), TEXT("Segment finalizer threads could not be started; segments will be finalized on the game thread."));
+    }
+
     OutputMuxer = MakeUnique<FOmniCaptureMuxer>();
     if (OutputMuxer)
     {
@@ -406,46 +421,61 @@ void UOmniCaptureSubsystem::BeginCapture(const FOmniCaptureSettings& InSettings)
         OutputMuxer->BeginRealtimeSession(ActiveSettings);
     }
 
+    FOmniCaptureFramePool::Get().Configure(static_cast<int64>(ActiveSettings.FramePoolBudgetMB) * 1024 * 1024);
+
     RingBuffer = MakeUnique<FOmniCaptureRingBuffer>();
-    RingBuffer->Initialize(ActiveSettings, [this](TUniquePtr<FOmniCaptureFrame>&& Frame)
+    RingBuffer->SetMemoryBudget(MemoryBudget.Get());
+    const auto ShouldWriteImages = [this]()
+    {
+        return ActiveSettings.OutputFormat == EOmniOutputFormat::ImageSequence
+            || (ActiveSettings.OutputFormat == EOmniOutputFormat::NVENCHardware && bUsingNVENCImageFallback.Load());
+    };
+    RingBuffer->Initialize(ActiveSettings, [this, ShouldWriteImages](TUniquePtr<FOmniCaptureFrame>&& Frame)
     {
         if (!Frame.IsValid())
         {
             return;
         }
 
+        // Before the writer takes the pixels.
+        BuildRequestedPreview(*Frame);
+
+        if (ShouldWriteImages() && ImageWriter)
+        {
+            const FString FileName = BuildFrameFileName(Frame->Metadata.FrameIndex, ActiveSettings.GetImageFileExtension());
+            ImageWriter->EnqueueFrame(MoveTemp(Frame), FileName);
+        }
+
+        // The writer takes the pixel payload and its byte reservation; the ordered stage has already handed the frame to NVENC.
+        if (MemoryBudget)
+        {
+            MemoryBudget->ReleaseFrame(*Frame);
+        }
+        FOmniCaptureFramePool::Get().ReleaseFrame(MoveTemp(Frame));
+    },
+    [this, ShouldWriteImages](const FOmniCaptureFrame& Frame)
+    {
+        // Several workers may enqueue frames out of order, so repeated frames are found here, against the previous FrameIndex.
+        if (ShouldWriteImages() && ImageWriter)
+        {
+            ImageWriter->LinkFrame(Frame);
+        }
+
         if (OutputMuxer)
         {
-            OutputMuxer->PushFrame(*Frame);
+            OutputMuxer->PushFrame(Frame);
             AudioStats = OutputMuxer->GetAudioStats();
             if (AudioRecorder)
             {
                 AudioStats.PendingPackets += AudioRecorder->GetPendingPacketCount();
+                AudioStats.OverflowCount = AudioRecorder->GetOverflowCount();
+                AudioStats.UnderflowCount = AudioRecorder->GetUnderflowCount();
             }
         }
 
-        switch (ActiveSettings.OutputFormat)
+        if (ActiveSettings.OutputFormat == EOmniOutputFormat::NVENCHardware && NVENCEncoder)
         {
-        case EOmniOutputFormat::ImageSequence:
-            if (ImageWriter)
-            {
-                const FString FileName = BuildFrameFileName(Frame->Metadata.FrameIndex, ActiveSettings.GetImageFileExtension());
-                ImageWriter->EnqueueFrame(MoveTemp(Frame), FileName);
-            }
-            break;
-        case EOmniOutputFormat::NVENCHardware:
-            if (NVENCEncoder)
-            {
-                NVENCEncoder->EnqueueFrame(*Frame);
-            }
-            if (bUsingNVENCImageFallback.Load() && ImageWriter && Frame.IsValid())
-            {
-                const FString FileName = BuildFrameFileName(Frame->Metadata.FrameIndex, ActiveSettings.GetImageFileExtension());
-                ImageWriter->EnqueueFrame(MoveTemp(Frame), FileName);
-            }
-            break;
-        default:
-            break;
+            NVENCEncoder->EnqueueFrame(Frame);
         }
 
         if (RingBuffer.IsValid())
@@ -459,18 +489,24 @@ void UOmniCaptureSubsystem::BeginCapture(const FOmniCaptureSettings& InSettings)
         }
     });
 
+    // The recorder stamps its audio against the same clock as Metadata.Timecode, so the origin comes first.
+    CaptureStartTime = FPlatformTime::Seconds();
     InitializeAudioRecording();
 
     bIsCapturing = true;
     bDroppedFrames = false;
     DroppedFrameCount = 0;
     FrameCounter = 0;
-    CaptureStartTime = FPlatformTime::Seconds();
     CurrentSegmentStartTime = CaptureStartTime;
     LastSegmentSizeCheckTime = CurrentSegmentStartTime;
     LastRuntimeWarningCheckTime = CurrentSegmentStartTime;
     PreviewFrameInterval = (ActiveSettings.bEnablePreviewWindow && ActiveSettings.PreviewFrameRate > 0.f) ? (1.0 / FMath::Max(1.0f, ActiveSettings.PreviewFrameRate)) : 0.0;
     LastPreviewUpdateTime = CaptureStartTime;
+    {
+        FScopeLock Lock(&PreviewCS);
+        PreviewRequestFrameIndex = INDEX_NONE;
+        PublishedPreview.Reset();
+    }
     State = EOmniCaptureState::Recording;
 
     const FIntPoint OutputDimensions = ActiveSettings.GetOutputResolution();
@@ -533,12 +569,12 @@ void UOmniCaptureSubsystem::EndCapture(bool bFinalize)
         RingBuffer.Reset();
     }
 
-    ShutdownOutputWriters(bFinalize);
     if (OutputMuxer)
     {
         OutputMuxer->EndRealtimeSession();
     }
     FinalizeOutputs(bFinalize);
+    FOmniCaptureFramePool::Get().Trim();
 
     RecordCaptureCompletion(bFinalize);
 
@@ -636,6 +672,11 @@ bool UOmniCaptureSubsystem::CapturePanoramaStill(const FOmniCaptureSettings& InS
 
     FOmniCaptureSettings StillSettings = InSettings;
     StillSettings.OutputFormat = EOmniOutputFormat::ImageSequence;
+    if (StillSettings.ImageFormat == EOmniCaptureImageFormat::Intermediate)
+    {
+        // A single frame gains nothing from the intermediate; write the final format straight away.
+        StillSettings.ImageFormat = FOmniCaptureTranscoder::ResolveTargetFormat(StillSettings);
+    }
 
     {
         TArray<FString> CompatibilityWarnings;
@@ -692,6 +733,10 @@ bool UOmniCaptureSubsystem::CapturePanoramaStill(const FOmniCaptureSettings& InS
     TMap<FName, FOmniCaptureLayerPayload> AuxiliaryLayers;
     if (StillSettings.AuxiliaryPasses.Num() > 0)
     {
+        // Auxiliary layers are always materialised; only the beauty pass streams to the writer.
+        FOmniCaptureSettings AuxiliarySettings = StillSettings;
+        AuxiliarySettings.bStreamCPUConversionToWriter = false;
+
         auto BuildAuxEye = [](const FOmniEyeCapture& SourceEye, EOmniCaptureAuxiliaryPassType PassType)
         {
             FOmniEyeCapture AuxEye;
@@ -712,7 +757,7 @@ bool UOmniCaptureSubsystem::CapturePanoramaStill(const FOmniCaptureSettings& InS
 
             const FOmniEyeCapture AuxLeft = BuildAuxEye(LeftEye, PassType);
             const FOmniEyeCapture AuxRight = BuildAuxEye(RightEye, PassType);
-            FOmniCaptureEquirectResult AuxResult = ConvertFrame(StillSettings, AuxLeft, AuxRight);
+            FOmniCaptureEquirectResult AuxResult = ConvertFrame(AuxiliarySettings, AuxLeft, AuxRight);
             if (AuxResult.PixelData.IsValid())
             {
                 FOmniCaptureLayerPayload Payload;
@@ -727,7 +772,7 @@ bool UOmniCaptureSubsystem::CapturePanoramaStill(const FOmniCaptureSettings& InS
 
     World->DestroyActor(TempRig);
 
-    if (!Result.PixelData.IsValid())
+    if (!Result.PixelData.IsValid() && !Result.RowSource.IsValid())
     {
         LogDiagnosticMessage(ELogVerbosity::Warning, TEXT("StillCapture"), TEXT("Still capture did not generate pixel data. Check cubemap rig configuration."));
         return false;
@@ -751,6 +796,8 @@ bool UOmniCaptureSubsystem::CapturePanoramaStill(const FOmniCaptureSettings& InS
     FOmniCaptureSettings WriterSettings = StillSettings;
     WriterSettings.OutputDirectory = OutputDirectory;
     WriterSettings.OutputFileName = BaseName;
+    // A still is one file; packing it would only hide it.
+    WriterSettings.bWriteFramePack = false;
     Writer.Initialize(WriterSettings, OutputDirectory);
 
     TUniquePtr<FOmniCaptureFrame> Frame = MakeUnique<FOmniCaptureFrame>();
@@ -758,6 +805,7 @@ bool UOmniCaptureSubsystem::CapturePanoramaStill(const FOmniCaptureSettings& InS
     Frame->Metadata.Timecode = 0.0;
     Frame->Metadata.bKeyFrame = true;
     Frame->PixelData = MoveTemp(Result.PixelData);
+    Frame->RowSource = MoveTemp(Result.RowSource);
     Frame->bLinearColor = Result.bIsLinear;
     Frame->bUsedCPUFallback = Result.bUsedCPUFallback;
     Frame->PixelDataType = Result.PixelDataType;
@@ -774,6 +822,40 @@ bool UOmniCaptureSubsystem::CapturePanoramaStill(const FOmniCaptureSettings& InS
     return true;
 }
 
+bool UOmniCaptureSubsystem::TranscodeIntermediateSequence(const FOmniCaptureSettings& InSettings, const FString& Directory, int32& OutFramesPending)
+{
+    const FString SequenceDirectory = FPaths::ConvertRelativePathToFull(Directory.IsEmpty() ? InSettings.OutputDirectory : Directory);
+    const FOmniCaptureTranscodeResult Result = FOmniCaptureTranscoder::TranscodeSequence(InSettings, SequenceDirectory);
+    if (InSettings.bGenerateManifest)
+    {
+        FOmniCaptureTranscoder::UpdateManifest(InSettings, SequenceDirectory, Result);
+    }
+
+    OutFramesPending = Result.FramesPending;
+    AppendDiagnostic(Result.IsComplete() ? EOmniCaptureDiagnosticLevel::Info : EOmniCaptureDiagnosticLevel::Warning,
+        FString::Printf(TEXT("Transcoded %d intermediate frames in %s (%d pending)."), Result.FramesTranscoded, *SequenceDirectory, Result.FramesPending), TEXT("Transcode"));
+    return Result.IsComplete();
+}
+
+bool UOmniCaptureSubsystem::ExtractFramePack(const FString& PackPath, const FString& Directory, int32& OutFilesWritten)
+{
+    OutFilesWritten = 0;
+    const FString FullPackPath = FPaths::ConvertRelativePathToFull(PackPath);
+    const FString TargetDirectory = FPaths::ConvertRelativePathToFull(Directory.IsEmpty() ? FPaths::GetPath(FullPackPath) : Directory);
+
+    FOmniCaptureFramePackReader Reader;
+    if (!Reader.Open(FullPackPath))
+    {
+        LogDiagnosticMessage(ELogVerbosity::Warning, TEXT("FramePack"), FString::Printf(TEXT("Could not open frame pack %s."), *FullPackPath));
+        return false;
+    }
+
+    const bool bExtracted = Reader.ExtractToDirectory(TargetDirectory, &OutFilesWritten);
+    AppendDiagnostic(bExtracted ? EOmniCaptureDiagnosticLevel::Info : EOmniCaptureDiagnosticLevel::Warning,
+        FString::Printf(TEXT("Extracted %d of %d files from %s into %s%s."), OutFilesWritten, Reader.GetEntries().Num(), *FullPackPath, *TargetDirectory, Reader.WasRecovered() ? TEXT(" (index rebuilt from chunks)") : TEXT("")), TEXT("FramePack"));
+    return bExtracted;
+}
+
 bool UOmniCaptureSubsystem::CanPause() const
 {
     return bIsCapturing && !bIsPaused;
@@ -833,8 +915,23 @@ FString UOmniCaptureSubsystem::GetStatusString() const
     }
 
     Status += FString::Printf(TEXT(" | Frames:%d Pending:%d Dropped:%d Blocked:%d"), FrameCounter, LatestRingBufferStats.PendingFrames, LatestRingBufferStats.DroppedFrames, LatestRingBufferStats.BlockedPushes);
+    if (LatestRingBufferStats.MemoryBudgetBytes > 0)
+    {
+        Status += FString::Printf(TEXT(" | InFlight:%.0f/%.0fMB"), LatestRingBufferStats.BytesInFlight / (1024.0 * 1024.0), LatestRingBufferStats.MemoryBudgetBytes / (1024.0 * 1024.0));
+    }
     Status += FString::Printf(TEXT(" | FPS:%.2f"), CurrentCaptureFPS);
     Status += FString::Printf(TEXT(" | Segment:%d"), CurrentSegmentIndex);
+    if (SegmentFinalizer)
+    {
+        const FOmniCaptureSegmentFinalizeStats FinalizeStats = SegmentFinalizer->GetStats();
+        if (FinalizeStats.QueuedSegments + FinalizeStats.ActiveSegments > 0)
+        {
+            Status += FString::Printf(TEXT(" | Finalizing:%d (%.0f%%) Waiting:%d"), FinalizeStats.ActiveSegments, FinalizeStats.ActiveProgress * 100.0f, FinalizeStats.QueuedSegments);
+        }
+    }
+
+    const FOmniCaptureFramePoolStats PoolStats = FOmniCaptureFramePool::Get().GetStats();
+    Status += FString::Printf(TEXT(" | Pool Hits:%lld Misses:%lld Idle:%.1fMB"), PoolStats.BufferHits, PoolStats.BufferMisses, PoolStats.PooledBytes / (1024.0 * 1024.0));
 
     Status += FString::Printf(TEXT(" | Audio Drift:%.2fms (Max %.2fms) Pending:%d"), AudioStats.DriftMilliseconds, AudioStats.MaxObservedDriftMilliseconds, AudioStats.PendingPackets);
     if (AudioStats.bInError)
@@ -855,11 +952,26 @@ FString UOmniCaptureSubsystem::GetStatusString() const
     return Status;
 }
 
+FOmniCaptureFramePoolStats UOmniCaptureSubsystem::GetFramePoolStats() const
+{
+    return FOmniCaptureFramePool::Get().GetStats();
+}
+
+FOmniCaptureImageWriterStats UOmniCaptureSubsystem::GetImageWriterStats() const
+{
+    return ImageWriter ? ImageWriter->GetTaskStats() : FOmniCaptureImageWriterStats();
+}
+
 FOmniAudioSyncStats UOmniCaptureSubsystem::GetAudioSyncStats() const
 {
     return AudioStats;
 }
 
+FOmniCaptureSegmentFinalizeStats UOmniCaptureSubsystem::GetSegmentFinalizeStats() const
+{
+    return SegmentFinalizer ? SegmentFinalizer->GetStats() : FOmniCaptureSegmentFinalizeStats();
+}
+
 UTexture2D* UOmniCaptureSubsystem::GetPreviewTexture() const
 {
     if (const AOmniCapturePreviewActor* Preview = PreviewActor.Get())
@@ -1000,6 +1112,42 @@ void UOmniCaptureSubsystem::SpawnPreviewActor()
     }
 }
 
+void UOmniCaptureSubsystem::BuildRequestedPreview(const FOmniCaptureFrame& Frame)
+{
+    EOmniCapturePreviewView View = EOmniCapturePreviewView::StereoComposite;
+    {
+        FScopeLock Lock(&PreviewCS);
+        if (Frame.Metadata.FrameIndex != PreviewRequestFrameIndex || !Frame.PixelData.IsValid())
+        {
+            return;
+        }
+        PreviewRequestFrameIndex = INDEX_NONE;
+        View = PreviewRequestView;
+    }
+
+    FOmniCapturePreviewImage Image;
+    if (AOmniCapturePreviewActor::BuildPreview(*Frame.PixelData, ActiveSettings, View, Image))
+    {
+        FScopeLock Lock(&PreviewCS);
+        PublishedPreview = MoveTemp(Image);
+    }
+}
+
+void UOmniCaptureSubsystem::UploadPublishedPreview()
+{
+    TOptional<FOmniCapturePreviewImage> Image;
+    {
+        FScopeLock Lock(&PreviewCS);
+        Image = MoveTemp(PublishedPreview);
+        PublishedPreview.Reset();
+    }
+
+    if (Image.IsSet() && PreviewActor.IsValid())
+    {
+        PreviewActor->UploadPreview(MoveTemp(Image.GetValue()));
+    }
+}
+
 void UOmniCaptureSubsystem::DestroyPreviewActor()
 {
     if (AActor* Preview = PreviewActor.Get())
@@ -1018,8 +1166,19 @@ void UOmniCaptureSubsystem::InitializeOutputWriters()
     switch (ActiveSettings.OutputFormat)
     {
     case EOmniOutputFormat::ImageSequence:
+        if (ActiveSettings.ShouldStreamToFFmpeg())
+        {
+            if (FOmniCaptureMuxer::IsFFmpegAvailable(ActiveSettings))
+            {
+                AppendDiagnostic(EOmniCaptureDiagnosticLevel::Info, TEXT("Frames will be streamed to a live FFmpeg encode."), TEXT("InitializeOutputs"));
+                break;
+            }
+            LogDiagnosticMessage(ELogVerbosity::Warning, TEXT("InitializeOutputs"), TEXT("FFmpeg is not available for live encoding; writing an image sequence instead."));
+            ActiveSettings.bStreamToFFmpeg = false;
+        }
         ImageWriter = MakeUnique<FOmniCaptureImageWriter>();
         ImageWriter->Initialize(ActiveSettings, ActiveSettings.OutputDirectory);
+        ImageWriter->SetMemoryBudget(MemoryBudget.Get());
         AppendDiagnostic(EOmniCaptureDiagnosticLevel::Info, TEXT("Image sequence writer initialized."), TEXT("InitializeOutputs"));
         break;
     case EOmniOutputFormat::NVENCHardware:
@@ -1040,6 +1199,7 @@ void UOmniCaptureSubsystem::InitializeOutputWriters()
         {
             ImageWriter = MakeUnique<FOmniCaptureImageWriter>();
             ImageWriter->Initialize(ActiveSettings, ActiveSettings.OutputDirectory);
+            ImageWriter->SetMemoryBudget(MemoryBudget.Get());
             bUsingNVENCImageFallback.Store(true);
             AppendDiagnostic(EOmniCaptureDiagnosticLevel::Info, TEXT("Image sequence writer initialized for NVENC fallback."), TEXT("InitializeOutputs"));
         }
@@ -1049,150 +1209,91 @@ void UOmniCaptureSubsystem::InitializeOutputWriters()
     }
 }
 
-void UOmniCaptureSubsystem::ShutdownOutputWriters(bool bFinalizeOutputs)
+void UOmniCaptureSubsystem::FinalizeOutputs(bool bFinalizeOutputs)
 {
-    if (ImageWriter)
+    SetDiagnosticContext(TEXT("FinalizeOutputs"));
+    AppendDiagnostic(EOmniCaptureDiagnosticLevel::Info, FString::Printf(TEXT("Finalize outputs requested (Finalize=%s)."), bFinalizeOutputs ? TEXT("true") : TEXT("false")), TEXT("FinalizeOutputs"));
+
+    if (!SegmentFinalizer)
     {
-        ImageWriter->Flush();
-        ImageWriter.Reset();
+        SegmentFinalizer = MakeUnique<FOmniCaptureSegmentFinalizer>();
     }
 
-    bUsingNVENCImageFallback.Store(false);
+    // The last segment is finished here like the rotated ones, after which nothing is left running in the background.
+    SegmentFinalizer->Enqueue(DetachActiveSegment(bFinalizeOutputs));
+    SegmentFinalizer->WaitForAll();
+    ReportFinalizedSegments();
 
-    if (NVENCEncoder)
+    const FOmniCaptureSegmentFinalizeStats FinalizeStats = SegmentFinalizer->GetStats();
+    if (!bFinalizeOutputs || FinalizeStats.CompletedSegments + FinalizeStats.FailedSegments == 0)
     {
         if (bFinalizeOutputs)
         {
-            NVENCEncoder->Finalize();
+            LogDiagnosticMessage(ELogVerbosity::Warning, TEXT("FinalizeOutputs"), TEXT("FinalizeOutputs called with no captured frames"));
         }
-        NVENCEncoder.Reset();
-    }
-}
-
-void UOmniCaptureSubsystem::FinalizeOutputs(bool bFinalizeOutputs)
-{
-    SetDiagnosticContext(TEXT("FinalizeOutputs"));
-    AppendDiagnostic(EOmniCaptureDiagnosticLevel::Info, FString::Printf(TEXT("Finalize outputs requested (Finalize=%s)."), bFinalizeOutputs ? TEXT("true") : TEXT("false")), TEXT("FinalizeOutputs"));
-    bLastCaptureUsedImageSequenceFallback = false;
-    LastImageSequenceFallbackDirectory.Reset();
-
-    if (!bFinalizeOutputs)
-    {
-        CapturedFrameMetadata.Empty();
-        CompletedSegments.Empty();
-        RecordedAudioPath.Reset();
-        RecordedVideoPath.Reset();
         LastFinalizedOutput.Empty();
         LastStillImagePath.Empty();
-        OutputMuxer.Reset();
-        RecordedSegmentDroppedFrames = 0;
-        return;
     }
-
-    if (CapturedFrameMetadata.Num() > 0)
+    else if (FinalizeStats.CompletedSegments + FinalizeStats.FailedSegments > 1)
     {
-        CompleteActiveSegment(true);
+        AppendDiagnostic(EOmniCaptureDiagnosticLevel::Info, FString::Printf(TEXT("%d segments finalized (%d failed), slowest took %.2f s."),
+            FinalizeStats.CompletedSegments + FinalizeStats.FailedSegments, FinalizeStats.FailedSegments, FinalizeStats.MaxFinalizeSeconds), TEXT("FinalizeOutputs"));
     }
 
-    if (CompletedSegments.Num() == 0)
+    SegmentFinalizer.Reset();
+    CapturedFrameMetadata.Reset();
+    RecordedAudioPath.Reset();
+    RecordedVideoPath.Reset();
+    OutputMuxer.Reset();
+    RecordedSegmentDroppedFrames = 0;
+}
+
+void UOmniCaptureSubsystem::ReportFinalizedSegments()
+{
+    if (!SegmentFinalizer)
     {
-        LogDiagnosticMessage(ELogVerbosity::Warning, TEXT("FinalizeOutputs"), TEXT("FinalizeOutputs called with no captured frames"));
-        OutputMuxer.Reset();
-        RecordedAudioPath.Reset();
-        RecordedVideoPath.Reset();
-        LastFinalizedOutput.Empty();
-        LastStillImagePath.Empty();
         return;
     }
 
-    if (!OutputMuxer)
+    const TArray<FOmniCaptureSegmentFinalizeResult> Results = SegmentFinalizer->ConsumeResults();
+    if (Results.Num() > 0 && bIsCapturing)
     {
-        OutputMuxer = MakeUnique<FOmniCaptureMuxer>();
+        // Whatever the finalized segments wrote or removed is now on disk.
+        RefreshFreeDiskBaseline();
     }
 
-    LastFinalizedOutput.Empty();
-
-    for (const FOmniCaptureSegmentRecord& Segment : CompletedSegments)
+    for (const FOmniCaptureSegmentFinalizeResult& Result : Results)
     {
-        if (!OutputMuxer)
+        for (const FOmniCaptureSegmentFinalizeMessage& Message : Result.Messages)
         {
-            break;
-        }
-
-        FOmniCaptureSettings SegmentSettings = ActiveSettings;
-        SegmentSettings.OutputDirectory = Segment.Directory;
-        SegmentSettings.OutputFileName = Segment.BaseFileName;
-
-        OutputMuxer->Initialize(SegmentSettings, Segment.Directory);
-        OutputMuxer->BeginRealtimeSession(SegmentSettings);
-
-        const bool bMuxingExpected = SegmentSettings.OutputFormat != EOmniOutputFormat::ImageSequence;
-        const bool bFallbackFromNVENC = (OriginalSettings.OutputFormat == EOmniOutputFormat::NVENCHardware && SegmentSettings.OutputFormat == EOmniOutputFormat::ImageSequence);
-        const bool bSuccess = OutputMuxer->FinalizeCapture(SegmentSettings, Segment.Frames, Segment.AudioPath, Segment.VideoPath, Segment.DroppedFrames);
-        OutputMuxer->EndRealtimeSession();
-
-        const FString FinalVideoPath = Segment.Directory / (Segment.BaseFileName + TEXT(".mp4"));
-        const bool bFinalFileExists = bMuxingExpected ? FPaths::FileExists(FinalVideoPath) : true;
-
-        if (!bSuccess || (bMuxingExpected && !bFinalFileExists))
-        {
-            LogDiagnosticMessage(ELogVerbosity::Warning, TEXT("FinalizeOutputs"), FString::Printf(TEXT("Output muxing failed for segment %d. Check OmniCapture manifest for details."), Segment.SegmentIndex));
-            if (Segment.bHasImageSequence)
+            if (Message.bLog)
             {
-                LogDiagnosticMessage(ELogVerbosity::Warning, TEXT("FinalizeOutputs"), FString::Printf(TEXT("Image sequence frames saved to %s with base name %s."), *Segment.Directory, *Segment.BaseFileName));
-                if (LastImageSequenceFallbackDirectory.IsEmpty())
-                {
-                    LastImageSequenceFallbackDirectory = Segment.Directory;
-                }
-                if (OriginalSettings.OutputFormat == EOmniOutputFormat::NVENCHardware)
-                {
-                    bLastCaptureUsedImageSequenceFallback = true;
-                }
+                LogDiagnosticMessage(Message.Verbosity, Message.Step, Message.Message);
             }
             else
             {
-                LogDiagnosticMessage(ELogVerbosity::Warning, TEXT("FinalizeOutputs"), TEXT("No image sequence fallback was recorded for this segment."));
+                AppendDiagnosticFromVerbosity(Message.Verbosity, Message.Message, Message.Step);
             }
         }
-        else if (Segment.bHasImageSequence)
+
+        if (!Result.bFinalized)
         {
-            if (!bMuxingExpected)
-            {
-                const ELogVerbosity::Type Verbosity = bFallbackFromNVENC ? ELogVerbosity::Warning : ELogVerbosity::Log;
-                LogDiagnosticMessage(Verbosity, TEXT("FinalizeOutputs"), FString::Printf(TEXT("Image sequence frames saved to %s with base name %s."), *Segment.Directory, *Segment.BaseFileName));
-                if (LastImageSequenceFallbackDirectory.IsEmpty())
-                {
-                    LastImageSequenceFallbackDirectory = Segment.Directory;
-                }
-                if (bFallbackFromNVENC)
-                {
-                    bLastCaptureUsedImageSequenceFallback = true;
-                }
-            }
-            else if (SegmentSettings.OutputFormat == EOmniOutputFormat::NVENCHardware)
-            {
-                AppendDiagnostic(EOmniCaptureDiagnosticLevel::Info, FString::Printf(TEXT("Image sequence fallback saved alongside NVENC output in %s."), *Segment.Directory), TEXT("FinalizeOutputs"));
-            }
+            continue;
         }
 
-        LastFinalizedOutput = (bSuccess && bMuxingExpected && bFinalFileExists) ? FinalVideoPath : FString();
-        if (!LastFinalizedOutput.IsEmpty())
+        AppendDiagnostic(EOmniCaptureDiagnosticLevel::Info, FString::Printf(TEXT("Segment %d finalized in %.2f s."), Result.SegmentIndex, Result.Seconds), TEXT("FinalizeOutputs"));
+        if (!Result.ImageSequenceDirectory.IsEmpty() && LastImageSequenceFallbackDirectory.IsEmpty())
         {
-            AppendDiagnostic(EOmniCaptureDiagnosticLevel::Info, FString::Printf(TEXT("Muxed output ready: %s"), *LastFinalizedOutput), TEXT("FinalizeOutputs"));
+            LastImageSequenceFallbackDirectory = Result.ImageSequenceDirectory;
         }
+        bLastCaptureUsedImageSequenceFallback |= Result.bImageSequenceFallback;
 
-        if (SegmentSettings.bOpenPreviewOnFinalize && !LastFinalizedOutput.IsEmpty())
+        LastFinalizedOutput = Result.OutputPath;
+        if (Result.bOpenPreview)
         {
             FPlatformProcess::LaunchFileInDefaultExternalApplication(*LastFinalizedOutput);
         }
     }
-
-    CompletedSegments.Empty();
-    CapturedFrameMetadata.Reset();
-    RecordedAudioPath.Reset();
-    RecordedVideoPath.Reset();
-    OutputMuxer.Reset();
-    RecordedSegmentDroppedFrames = 0;
 }
 
 bool UOmniCaptureSubsystem::ValidateEnvironment()
@@ -1447,7 +1548,8 @@ void UOmniCaptureSubsystem::InitializeAudioRecording()
     const bool bIsPNGSequence = ActiveSettings.OutputFormat == EOmniOutputFormat::ImageSequence &&
         ActiveSettings.ImageFormat == EOmniCaptureImageFormat::PNG;
 
-    if (bIsPNGSequence)
+    // Streaming to FFmpeg takes the frames off the PNG path, so the drift that guard avoids does not apply.
+    if (bIsPNGSequence && !ActiveSettings.ShouldStreamToFFmpeg())
     {
         if (ActiveSettings.bRecordAudio)
         {
@@ -1474,8 +1576,23 @@ void UOmniCaptureSubsystem::InitializeAudioRecording()
     AudioRecorder = MakeUnique<FOmniCaptureAudioRecorder>();
     if (AudioRecorder->Initialize(World, ActiveSettings))
     {
-        AudioRecorder->Start();
+        AudioRecorder->Start(CaptureStartTime);
         AppendDiagnostic(EOmniCaptureDiagnosticLevel::Info, TEXT("Audio recorder started."), TEXT("Audio"));
+
+        // The live encode and the NVENC MP4 declare their audio format on the first frame, which may arrive before any audio does.
+        int32 AudioSampleRate = 0;
+        int32 AudioChannels = 0;
+        if (AudioRecorder->GetAudioFormat(AudioSampleRate, AudioChannels))
+        {
+            if (OutputMuxer)
+            {
+                OutputMuxer->SetLiveAudioFormat(AudioSampleRate, AudioChannels);
+            }
+            if (NVENCEncoder)
+            {
+                NVENCEncoder->SetAudioFormat(AudioSampleRate, AudioChannels);
+            }
+        }
     }
     else
     {
@@ -1510,7 +1627,9 @@ void UOmniCaptureSubsystem::TickCapture(float DeltaTime)
     if (!bIsPaused)
     {
         UpdateDynamicStereoParameters();
+        ReportFinalizedSegments();
         RotateSegmentIfNeeded();
+        UploadPublishedPreview();
         CaptureFrame();
     }
 
@@ -1551,6 +1670,10 @@ void UOmniCaptureSubsystem::CaptureFrame()
     TMap<FName, FOmniCaptureLayerPayload> AuxiliaryLayers;
     if (ActiveSettings.AuxiliaryPasses.Num() > 0)
     {
+        // Auxiliary layers are always materialised; only the beauty pass streams to the writer.
+        FOmniCaptureSettings AuxiliarySettings = ActiveSettings;
+        AuxiliarySettings.bStreamCPUConversionToWriter = false;
+
         auto BuildAuxiliaryEye = [](const FOmniEyeCapture& SourceEye, EOmniCaptureAuxiliaryPassType PassType)
         {
             FOmniEyeCapture AuxEye;
@@ -1571,7 +1694,7 @@ void UOmniCaptureSubsystem::CaptureFrame()
 
             const FOmniEyeCapture AuxLeft = BuildAuxiliaryEye(LeftEye, PassType);
             const FOmniEyeCapture AuxRight = BuildAuxiliaryEye(RightEye, PassType);
-            FOmniCaptureEquirectResult AuxResult = ConvertActiveFrame(ActiveSettings, AuxLeft, AuxRight);
+            FOmniCaptureEquirectResult AuxResult = ConvertActiveFrame(AuxiliarySettings, AuxLeft, AuxRight);
             if (AuxResult.PixelData.IsValid())
             {
                 FOmniCaptureLayerPayload Payload;
@@ -1584,7 +1707,7 @@ void UOmniCaptureSubsystem::CaptureFrame()
         }
     }
     const bool bRequiresGPU = ActiveSettings.OutputFormat == EOmniOutputFormat::NVENCHardware;
-    if (!ConversionResult.PixelData.IsValid())
+    if (!ConversionResult.PixelData.IsValid() && !ConversionResult.RowSource.IsValid())
     {
         HandleDroppedFrame();
         return;
@@ -1596,7 +1719,7 @@ void UOmniCaptureSubsystem::CaptureFrame()
         return;
     }
 
-    TUniquePtr<FOmniCaptureFrame> Frame = MakeUnique<FOmniCaptureFrame>();
+    TUniquePtr<FOmniCaptureFrame> Frame = FOmniCaptureFramePool::Get().AcquireFrame();
     Frame->Metadata.FrameIndex = FrameCounter++;
     Frame->Metadata.Timecode = FPlatformTime::Seconds() - CaptureStartTime;
     Frame->Metadata.bKeyFrame = (Frame->Metadata.FrameIndex % ActiveSettings.Quality.GOPLength) == 0;
@@ -1616,7 +1739,19 @@ void UOmniCaptureSubsystem::CaptureFrame()
         LastFpsSampleTime = NowSeconds;
     }
 
+    // When the preview is due, the capture worker that gets this frame downsamples it; the next tick uploads the result.
+    // Streamed frames have no pixels until the writer pulls them, and GPU-only frames have none at all, so both leave the
+    // preview as it was.
+    if (PreviewActor.IsValid() && !PreviewActor->IsUploadPending() && ConversionResult.PixelData.IsValid() && (PreviewFrameInterval <= 0.0 || (NowSeconds - LastPreviewUpdateTime) >= PreviewFrameInterval))
+    {
+        FScopeLock Lock(&PreviewCS);
+        PreviewRequestFrameIndex = Frame->Metadata.FrameIndex;
+        PreviewRequestView = PreviewActor->GetPreviewView();
+        LastPreviewUpdateTime = NowSeconds;
+    }
+
     Frame->PixelData = MoveTemp(ConversionResult.PixelData);
+    Frame->RowSource = MoveTemp(ConversionResult.RowSource);
     Frame->GPUSource = ConversionResult.OutputTarget;
     Frame->Texture = ConversionResult.Texture;
     Frame->ReadyFence = ConversionResult.ReadyFence;
@@ -1645,7 +1780,7 @@ void UOmniCaptureSubsystem::CaptureFrame()
 
     if (AudioRecorder)
     {
-        AudioRecorder->GatherAudio(Frame->Metadata.Timecode, Frame->AudioPackets);
+        AudioRecorder->GatherAudio(Frame->Metadata.Timecode, *Frame);
     }
 
     CapturedFrameMetadata.Add(Frame->Metadata);
@@ -1661,16 +1796,6 @@ void UOmniCaptureSubsystem::CaptureFrame()
     {
         LatestRingBufferStats = RingBuffer->GetStats();
     }
-
-    if (PreviewActor.IsValid())
-    {
-        const double Now = FPlatformTime::Seconds();
-        if (PreviewFrameInterval <= 0.0 || (Now - LastPreviewUpdateTime) >= PreviewFrameInterval)
-        {
-            PreviewActor->UpdatePreviewTexture(ConversionResult, ActiveSettings);
-            LastPreviewUpdateTime = Now;
-        }
-    }
 }
 
 void UOmniCaptureSubsystem::FlushRingBuffer()
@@ -1981,6 +2106,17 @@ void UOmniCaptureSubsystem::ConfigureActiveSegment()
 
     CurrentSegmentStartTime = FPlatformTime::Seconds();
     LastSegmentSizeCheckTime = CurrentSegmentStartTime;
+
+    RefreshFreeDiskBaseline();
+}
+
+void UOmniCaptureSubsystem::RefreshFreeDiskBaseline()
+{
+    // Queried at segment start and around background finalizes, whose output no writer counter sees; in between, free
+    // space is estimated from what the writers report.
+    uint64 TotalDiskBytes = 0;
+    bHasFreeDiskBaseline = FPlatformMisc::GetDiskTotalAndFreeSpace(*ActiveSettings.OutputDirectory, TotalDiskBytes, FreeDiskBaselineBytes);
+    SegmentBytesAtFreeDiskBaseline = CalculateActiveSegmentSizeBytes();
 }
 
 void UOmniCaptureSubsystem::RotateSegmentIfNeeded()
@@ -2042,8 +2178,15 @@ void UOmniCaptureSubsystem::RotateSegmentIfNeeded()
     }
 
     ShutdownAudioRecording();
-    ShutdownOutputWriters(true);
-    CompleteActiveSegment(true);
+
+    // Draining, closing and muxing the old segment happens on the finalizer threads; capture continues meanwhile.
+    const double HandoffStartTime = FPlatformTime::Seconds();
+    const FOmniCaptureSegmentFinalizeStats FinalizeStats = SegmentFinalizer->GetStats();
+    if (FinalizeStats.QueuedSegments > 0)
+    {
+        LogDiagnosticMessage(ELogVerbosity::Warning, TEXT("SegmentRotation"), FString::Printf(TEXT("Segment finalization is falling behind: %d segments still waiting, %d in progress."), FinalizeStats.QueuedSegments, FinalizeStats.ActiveSegments));
+    }
+    SegmentFinalizer->Enqueue(DetachActiveSegment(true));
 
     ++CurrentSegmentIndex;
     ConfigureActiveSegment();
@@ -2068,106 +2211,72 @@ void UOmniCaptureSubsystem::RotateSegmentIfNeeded()
     LastSegmentSizeCheckTime = CurrentSegmentStartTime;
     LastFpsSampleTime = 0.0;
     FramesSinceLastFpsSample = 0;
+    AppendDiagnostic(EOmniCaptureDiagnosticLevel::Info, FString::Printf(TEXT("Segment %d started %.1f ms after the handoff."), CurrentSegmentIndex, (CurrentSegmentStartTime - HandoffStartTime) * 1000.0), TEXT("SegmentRotation"));
 }
 
-void UOmniCaptureSubsystem::CompleteActiveSegment(bool bStoreResults)
+FOmniCaptureSegmentFinalizeJob UOmniCaptureSubsystem::DetachActiveSegment(bool bFinalizeOutputs)
 {
-    if (!bStoreResults)
+    FOmniCaptureSegmentFinalizeJob Job;
+    Job.Settings = ActiveSettings;
+    Job.RequestedOutputFormat = OriginalSettings.OutputFormat;
+    Job.bFinalize = bFinalizeOutputs;
+    Job.ImageWriter = MoveTemp(ImageWriter);
+    Job.NVENCEncoder = MoveTemp(NVENCEncoder);
+    if (OutputMuxer && OutputMuxer->IsLiveEncodeActive())
     {
-        CapturedFrameMetadata.Empty();
-        RecordedAudioPath.Reset();
-        RecordedVideoPath.Reset();
-        bCapturedImageSequenceThisSegment = false;
-        return;
+        Job.LiveMuxer = MoveTemp(OutputMuxer);
     }
+    bUsingNVENCImageFallback.Store(false);
 
-    if (CapturedFrameMetadata.Num() == 0)
+    if (bFinalizeOutputs && CapturedFrameMetadata.Num() > 0)
     {
-        CapturedFrameMetadata.Empty();
-        RecordedAudioPath.Reset();
-        RecordedVideoPath.Reset();
-        bCapturedImageSequenceThisSegment = false;
-        return;
+        FOmniCaptureSegmentRecord& SegmentRecord = Job.Segment;
+        SegmentRecord.SegmentIndex = CurrentSegmentIndex;
+        SegmentRecord.Directory = ActiveSettings.OutputDirectory;
+        SegmentRecord.BaseFileName = ActiveSettings.OutputFileName;
+        SegmentRecord.AudioPath = RecordedAudioPath;
+        SegmentRecord.VideoPath = RecordedVideoPath;
+        const int32 TotalDroppedFrames = DroppedFrameCount;
+        const int32 SegmentDroppedFrames = FMath::Max(0, TotalDroppedFrames - RecordedSegmentDroppedFrames);
+        SegmentRecord.DroppedFrames = SegmentDroppedFrames;
+        RecordedSegmentDroppedFrames = TotalDroppedFrames;
+        SegmentRecord.Frames = MoveTemp(CapturedFrameMetadata);
+        SegmentRecord.bHasImageSequence = bCapturedImageSequenceThisSegment || (ActiveSettings.OutputFormat == EOmniOutputFormat::ImageSequence && !ActiveSettings.ShouldStreamToFFmpeg());
     }
 
-    FOmniCaptureSegmentRecord SegmentRecord;
-    SegmentRecord.SegmentIndex = CurrentSegmentIndex;
-    SegmentRecord.Directory = ActiveSettings.OutputDirectory;
-    SegmentRecord.BaseFileName = ActiveSettings.OutputFileName;
-    SegmentRecord.AudioPath = RecordedAudioPath;
-    SegmentRecord.VideoPath = RecordedVideoPath;
-    const int32 TotalDroppedFrames = DroppedFrameCount;
-    const int32 SegmentDroppedFrames = FMath::Max(0, TotalDroppedFrames - RecordedSegmentDroppedFrames);
-    SegmentRecord.DroppedFrames = SegmentDroppedFrames;
-    RecordedSegmentDroppedFrames = TotalDroppedFrames;
-    SegmentRecord.Frames = MoveTemp(CapturedFrameMetadata);
-    SegmentRecord.bHasImageSequence = bCapturedImageSequenceThisSegment || ActiveSettings.OutputFormat == EOmniOutputFormat::ImageSequence;
-
-    CompletedSegments.Add(MoveTemp(SegmentRecord));
-
     CapturedFrameMetadata.Reset();
     RecordedAudioPath.Reset();
     RecordedVideoPath.Reset();
     bCapturedImageSequenceThisSegment = false;
+    return Job;
 }
 
 int64 UOmniCaptureSubsystem::CalculateActiveSegmentSizeBytes() const
 {
     int64 TotalBytes = 0;
-    IFileManager& FileManager = IFileManager::Get();
 
-    if (ActiveSettings.OutputFormat == EOmniOutputFormat::NVENCHardware)
+    if (ImageWriter)
     {
-        if (!RecordedVideoPath.IsEmpty())
-        {
-            const int64 BitstreamSize = FileManager.FileSize(*RecordedVideoPath);
-            if (BitstreamSize > 0)
-            {
-                TotalBytes += BitstreamSize;
-            }
-        }
+        TotalBytes += ImageWriter->GetBytesWritten();
     }
-    else
-    {
-        class FSegmentStatVisitor final : public IPlatformFile::FDirectoryStatVisitor
-        {
-        public:
-            FSegmentStatVisitor(const FString& InPrefix, int64& InTotal)
-                : Prefix(InPrefix)
-                , Total(InTotal)
-            {
-            }
-
-            virtual bool Visit(const TCHAR* FilenameOrDirectory, const FFileStatData& StatData) override
-            {
-                if (StatData.bIsDirectory)
-                {
-                    return true;
-                }
-
-                const FString FileName = FPaths::GetCleanFilename(FilenameOrDirectory);
-                if (Prefix.IsEmpty() || FileName.StartsWith(Prefix))
-                {
-                    Total += StatData.FileSize;
-                }
-                return true;
-            }
 
-        private:
-            FString Prefix;
-            int64& Total;
-        };
+    if (NVENCEncoder)
+    {
+        TotalBytes += NVENCEncoder->GetBytesWritten();
+    }
 
-        FSegmentStatVisitor Visitor(ActiveSettings.OutputFileName, TotalBytes);
-        FileManager.IterateDirectoryStat(*ActiveSettings.OutputDirectory, Visitor);
+    if (AudioRecorder)
+    {
+        TotalBytes += AudioRecorder->GetRecordedBytes();
     }
 
-    if (!RecordedAudioPath.IsEmpty())
+    // ffmpeg writes the live encode itself, so its one known output file is the only thing still stat'ed.
+    if (OutputMuxer && OutputMuxer->IsLiveEncodeActive())
     {
-        const int64 AudioSize = FileManager.FileSize(*RecordedAudioPath);
-        if (AudioSize > 0)
+        const int64 LiveBytes = IFileManager::Get().FileSize(*(ActiveSettings.OutputDirectory / (ActiveSettings.OutputFileName + TEXT(".mp4"))));
+        if (LiveBytes > 0)
         {
-            TotalBytes += AudioSize;
+            TotalBytes += LiveBytes;
         }
     }
 
@@ -2184,12 +2293,19 @@ void UOmniCaptureSubsystem::UpdateRuntimeWarnings()
 
     LastRuntimeWarningCheckTime = Now;
 
-    if (ActiveSettings.MinimumFreeDiskSpaceGB > 0)
+    // A segment being finalized in the background writes its transcode and mux outputs unmetered, so free space is
+    // re-queried while one runs.
+    if (ActiveSettings.MinimumFreeDiskSpaceGB > 0 && SegmentFinalizer && SegmentFinalizer->GetStats().ActiveSegments > 0)
+    {
+        RefreshFreeDiskBaseline();
+    }
+
+    if (ActiveSettings.MinimumFreeDiskSpaceGB > 0 && bHasFreeDiskBaseline)
     {
-        uint64 FreeBytes = 0;
-        uint64 TotalBytes = 0;
         const uint64 ThresholdBytes = static_cast<uint64>(ActiveSettings.MinimumFreeDiskSpaceGB) * 1024ull * 1024ull * 1024ull;
-        if (ThresholdBytes > 0 && FPlatformMisc::GetDiskTotalAndFreeSpace(*ActiveSettings.OutputDirectory, TotalBytes, FreeBytes))
+        const uint64 SegmentBytes = static_cast<uint64>(FMath::Max<int64>(0, CalculateActiveSegmentSizeBytes() - SegmentBytesAtFreeDiskBaseline));
+        const uint64 FreeBytes = FreeDiskBaselineBytes > SegmentBytes ? FreeDiskBaselineBytes - SegmentBytes : 0;
+        if (ThresholdBytes > 0)
         {
             if (FreeBytes < ThresholdBytes)
             {
@@ -0,0 +1,273 @@
+#include "OmniCaptureTranscoder.h"
+
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Dom/JsonObject.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "OmniCaptureImageWriter.h"
+#include "OmniCaptureIntermediateFormat.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+namespace
+{
+    struct FPendingFrame
+    {
+        /** <Base>_NNNNNN, shared by the beauty file and its layers. */
+        FString Stem;
+        bool bHasBeauty = false;
+        TArray<TPair<FName, FString>> Layers;
+    };
+
+    void FindPendingFrames(const FString& Directory, const FString& BaseName, TArray<FPendingFrame>& OutFrames)
+    {
+        const FString Extension = FOmniCaptureIntermediateFormat::GetExtension();
+        const FString Prefix = BaseName + TEXT("_");
+
+        TArray<FString> FileNames;
+        IFileManager::Get().FindFiles(FileNames, *(Directory / (Prefix + TEXT("*") + Extension)), true, false);
+        FileNames.Sort();
+
+        TMap<FString, int32> FrameByStem;
+        for (const FString& FileName : FileNames)
+        {
+            const FString Name = FPaths::GetBaseFilename(FileName);
+            if (!Name.StartsWith(Prefix))
+            {
+                continue;
+            }
+
+            const FString Suffix = Name.RightChop(Prefix.Len());
+            int32 Separator = INDEX_NONE;
+            Suffix.FindChar(TEXT('_'), Separator);
+            const FString FrameIndex = Separator == INDEX_NONE ? Suffix : Suffix.Left(Separator);
+            if (FrameIndex.IsEmpty() || !FrameIndex.IsNumeric())
+            {
+                continue;
+            }
+
+            const FString Stem = Prefix + FrameIndex;
+            int32& PendingIndex = FrameByStem.FindOrAdd(Stem, INDEX_NONE);
+            if (PendingIndex == INDEX_NONE)
+            {
+                PendingIndex = OutFrames.AddDefaulted();
+                OutFrames[PendingIndex].Stem = Stem;
+            }
+
+            if (Separator == INDEX_NONE)
+            {
+                OutFrames[PendingIndex].bHasBeauty = true;
+            }
+            else
+            {
+                OutFrames[PendingIndex].Layers.Emplace(FName(*Suffix.RightChop(Separator + 1)), Directory / FileName);
+            }
+        }
+    }
+
+    TUniquePtr<FOmniCaptureFrame> ReadFrame(const FString& FilePath)
+    {
+        TUniquePtr<FOmniCaptureFrame> Frame = MakeUnique<FOmniCaptureFrame>();
+        if (!FOmniCaptureIntermediateFormat::Read(FilePath, Frame->PixelData, Frame->bLinearColor, Frame->PixelPrecision, Frame->PixelDataType))
+        {
+            UE_LOG(LogTemp, Warning, TEXT("OmniCapture transcode could not read intermediate '%s'"), *FilePath);
+            return nullptr;
+        }
+        return Frame;
+    }
+
+    bool DeleteIntermediate(const FString& FilePath)
+    {
+        return IFileManager::Get().Delete(*FilePath, false, true, true);
+    }
+
+    bool TranscodeFrame(const FOmniCaptureImageWriter& Writer, const FString& Directory, const FPendingFrame& Pending, const FString& TargetExtension)
+    {
+        // A layer without its beauty file has no frame to hang off; it is converted on its own under its own name.
+        if (!Pending.bHasBeauty)
+        {
+            bool bAllWritten = true;
+            for (const TPair<FName, FString>& Layer : Pending.Layers)
+            {
+                TUniquePtr<FOmniCaptureFrame> Frame = ReadFrame(Layer.Value);
+                const FString FileName = FString::Printf(TEXT("%s_%s%s"), *Pending.Stem, *Layer.Key.ToString(), *TargetExtension);
+                const bool bWritten = Frame.IsValid() && Writer.WriteFrame(MoveTemp(Frame), FileName) && DeleteIntermediate(Layer.Value);
+                bAllWritten &= bWritten;
+            }
+            return bAllWritten;
+        }
+
+        const FString BeautyPath = Directory / (Pending.Stem + FOmniCaptureIntermediateFormat::GetExtension());
+        TUniquePtr<FOmniCaptureFrame> Frame = ReadFrame(BeautyPath);
+        if (!Frame.IsValid())
+        {
+            return false;
+        }
+
+        for (const TPair<FName, FString>& Layer : Pending.Layers)
+        {
+            FOmniCaptureLayerPayload Payload;
+            if (!FOmniCaptureIntermediateFormat::Read(Layer.Value, Payload.PixelData, Payload.bLinear, Payload.Precision, Payload.PixelDataType))
+            {
+                UE_LOG(LogTemp, Warning, TEXT("OmniCapture transcode could not read intermediate '%s'"), *Layer.Value);
+                return false;
+            }
+            Frame->AuxiliaryLayers.Add(Layer.Key, MoveTemp(Payload));
+        }
+
+        if (!Writer.WriteFrame(MoveTemp(Frame), Pending.Stem + TargetExtension))
+        {
+            return false;
+        }
+
+        // Layers before the beauty file: a pass interrupted in between leaves the beauty file, and the frame is simply redone.
+        bool bDeleted = true;
+        for (const TPair<FName, FString>& Layer : Pending.Layers)
+        {
+            bDeleted &= DeleteIntermediate(Layer.Value);
+        }
+        return DeleteIntermediate(BeautyPath) && bDeleted;
+    }
+
+    const TCHAR* ToImageFormatString(EOmniCaptureImageFormat Format)
+    {
+        switch (Format)
+        {
+        case EOmniCaptureImageFormat::JPG:
+            return TEXT("JPG");
+        case EOmniCaptureImageFormat::EXR:
+            return TEXT("EXR");
+        case EOmniCaptureImageFormat::BMP:
+            return TEXT("BMP");
+        case EOmniCaptureImageFormat::Intermediate:
+            return TEXT("Intermediate");
+        case EOmniCaptureImageFormat::PNG:
+        default:
+            return TEXT("PNG");
+        }
+    }
+}
+
+EOmniCaptureImageFormat FOmniCaptureTranscoder::ResolveTargetFormat(const FOmniCaptureSettings& Settings)
+{
+    return Settings.IntermediateTranscodeFormat == EOmniCaptureImageFormat::Intermediate ? EOmniCaptureImageFormat::PNG : Settings.IntermediateTranscodeFormat;
+}
+
+FOmniCaptureTranscodeResult FOmniCaptureTranscoder::TranscodeSequence(const FOmniCaptureSettings& Settings, const FString& Directory, int32 MaxThreads, const TFunction<void(float)>& ReportProgress)
+{
+    const double StartTime = FPlatformTime::Seconds();
+
+    FOmniCaptureTranscodeResult Result;
+    Result.TargetFormat = ResolveTargetFormat(Settings);
+
+    TArray<FPendingFrame> Frames;
+    FindPendingFrames(Directory, Settings.OutputFileName, Frames);
+    if (Frames.Num() == 0)
+    {
+        return Result;
+    }
+
+    FOmniCaptureSettings TargetSettings = Settings;
+    TargetSettings.ImageFormat = Result.TargetFormat;
+    const FString TargetExtension = TargetSettings.GetImageFileExtension();
+
+    FOmniCaptureImageWriter Writer;
+    Writer.Initialize(TargetSettings, Directory);
+
+    const int32 ThreadLimit = MaxThreads > 0 ? MaxThreads : (FTaskGraphInterface::IsRunning() ? FTaskGraphInterface::Get().GetNumWorkerThreads() + 1 : 1);
+    const int32 WorkerCount = FMath::Clamp(ThreadLimit, 1, Frames.Num());
+    const int32 FrameCount = Frames.Num();
+
+    TAtomic<int32> NextFrame { 0 };
+    TAtomic<int32> Transcoded { 0 };
+    TAtomic<int32> Failed { 0 };
+    TAtomic<int32> Finished { 0 };
+    ParallelFor(WorkerCount, [&](int32)
+    {
+        for (int32 FrameIndex = NextFrame.IncrementExchange(); FrameIndex < FrameCount; FrameIndex = NextFrame.IncrementExchange())
+        {
+            if (TranscodeFrame(Writer, Directory, Frames[FrameIndex], TargetExtension))
+            {
+                Transcoded.IncrementExchange();
+            }
+            else
+            {
+                Failed.IncrementExchange();
+            }
+
+            const int32 FinishedFrames = Finished.IncrementExchange() + 1;
+            if (ReportProgress)
+            {
+                ReportProgress(static_cast<float>(FinishedFrames) / FrameCount);
+            }
+        }
+    }, WorkerCount <= 1 ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+
+    Result.FramesTranscoded = Transcoded.Load();
+    Result.FramesFailed = Failed.Load();
+    Result.FramesPending = CountPendingFrames(Settings, Directory);
+    Result.Seconds = FPlatformTime::Seconds() - StartTime;
+
+    UE_LOG(LogTemp, Log, TEXT("OmniCapture transcoded %d intermediate frames to %s in %.2fs on %d threads (%d failed, %d pending)"),
+        Result.FramesTranscoded, ToImageFormatString(Result.TargetFormat), Result.Seconds, WorkerCount, Result.FramesFailed, Result.FramesPending);
+    return Result;
+}
+
+int32 FOmniCaptureTranscoder::CountPendingFrames(const FOmniCaptureSettings& Settings, const FString& Directory)
+{
+    TArray<FPendingFrame> Frames;
+    FindPendingFrames(Directory, Settings.OutputFileName, Frames);
+    return Frames.Num();
+}
+
+bool FOmniCaptureTranscoder::UpdateManifest(const FOmniCaptureSettings& Settings, const FString& Directory, const FOmniCaptureTranscodeResult& Result)
+{
+    const FString ManifestPath = Directory / (Settings.OutputFileName + TEXT("_Manifest.json"));
+    FString ManifestText;
+    if (!FFileHelper::LoadFileToString(ManifestText, *ManifestPath))
+    {
+        return false;
+    }
+
+    TSharedPtr<FJsonObject> Root;
+    TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(ManifestText);
+    if (!FJsonSerializer::Deserialize(Reader, Root) || !Root.IsValid())
+    {
+        return false;
+    }
+
+    int32 PreviousFrames = 0;
+    double PreviousSeconds = 0.0;
+    const TSharedPtr<FJsonObject>* Previous = nullptr;
+    if (Root->TryGetObjectField(TEXT("intermediateTranscode"), Previous) && Previous && Previous->IsValid())
+    {
+        (*Previous)->TryGetNumberField(TEXT("framesTranscoded"), PreviousFrames);
+        (*Previous)->TryGetNumberField(TEXT("seconds"), PreviousSeconds);
+    }
+
+    TSharedRef<FJsonObject> Transcode = MakeShared<FJsonObject>();
+    Transcode->SetStringField(TEXT("sourceFormat"), ToImageFormatString(EOmniCaptureImageFormat::Intermediate));
+    Transcode->SetStringField(TEXT("targetFormat"), ToImageFormatString(Result.TargetFormat));
+    Transcode->SetNumberField(TEXT("framesTranscoded"), PreviousFrames + Result.FramesTranscoded);
+    Transcode->SetNumberField(TEXT("framesFailed"), Result.FramesFailed);
+    Transcode->SetNumberField(TEXT("framesPending"), Result.FramesPending);
+    Transcode->SetNumberField(TEXT("seconds"), PreviousSeconds + Result.Seconds);
+    Transcode->SetBoolField(TEXT("complete"), Result.IsComplete());
+    Root->SetObjectField(TEXT("intermediateTranscode"), Transcode);
+
+    FOmniCaptureSettings TargetSettings = Settings;
+    TargetSettings.ImageFormat = Result.IsComplete() ? Result.TargetFormat : EOmniCaptureImageFormat::Intermediate;
+    Root->SetStringField(TEXT("imageExtension"), TargetSettings.GetImageFileExtension());
+
+    FString OutputString;
+    TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&OutputString);
+    if (!FJsonSerializer::Serialize(Root.ToSharedRef(), Writer))
+    {
+        return false;
+    }
+    return FFileHelper::SaveStringToFile(OutputString, *ManifestPath);
+}
@@ -1,6 +1,7 @@
 #include "OmniCaptureTypes.h"
 
 #include "Math/UnrealMathUtility.h"
+#include "OmniCaptureIntermediateFormat.h"
 #include "UObject/UnrealType.h"
 
 namespace
@@ -247,6 +248,11 @@ bool FOmniCaptureSettings::SupportsSphericalMetadata() const
     return true;
 }
 
+bool FOmniCaptureSettings::ShouldStreamToFFmpeg() const
+{
+    return bStreamToFFmpeg && OutputFormat == EOmniOutputFormat::ImageSequence;
+}
+
 bool FOmniCaptureSettings::IsVR180() const
 {
     return Coverage == EOmniCaptureCoverage::HalfSphere;
@@ -392,6 +398,8 @@ FString FOmniCaptureSettings::GetImageFileExtension() const
         return TEXT(".exr");
     case EOmniCaptureImageFormat::BMP:
         return TEXT(".bmp");
+    case EOmniCaptureImageFormat::Intermediate:
+        return FOmniCaptureIntermediateFormat::GetExtension();
     case EOmniCaptureImageFormat::PNG:
     default:
         return TEXT(".png");
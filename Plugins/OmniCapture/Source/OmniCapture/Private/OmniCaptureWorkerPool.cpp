@@ -0,0 +1,220 @@
+#include "OmniCaptureWorkerPool.h"
+
+#include "HAL/PlatformAffinity.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+
+namespace
+{
+    constexpr int32 GMaxPoolThreads = 64;
+}
+
+class FOmniCaptureWorkerPoolThread final : public FRunnable
+{
+public:
+    explicit FOmniCaptureWorkerPoolThread(FOmniCaptureWorkerPool& InOwner)
+        : Owner(InOwner)
+    {
+        BusyCycles = 0;
+        StartCycles = FPlatformTime::Cycles64();
+    }
+
+    virtual uint32 Run() override
+    {
+        while (Owner.bRunning.Load())
+        {
+            Owner.JobEvent->Wait();
+            DrainTimed();
+        }
+
+        DrainTimed();
+        Owner.ActiveThreads.DecrementExchange();
+
+        // JobEvent is auto-reset and wakes one waiter, so each exiting thread passes the stop signal on to the next.
+        Owner.JobEvent->Trigger();
+        return 0;
+    }
+
+    float GetUtilization() const
+    {
+        const uint64 Elapsed = FPlatformTime::Cycles64() - StartCycles;
+        return Elapsed > 0 ? FMath::Clamp(static_cast<float>(static_cast<double>(BusyCycles.Load()) / static_cast<double>(Elapsed)), 0.0f, 1.0f) : 0.0f;
+    }
+
+private:
+    void DrainTimed()
+    {
+        for (;;)
+        {
+            const uint64 JobStart = FPlatformTime::Cycles64();
+            if (!Owner.RunNextJob())
+            {
+                break;
+            }
+            BusyCycles.AddExchange(FPlatformTime::Cycles64() - JobStart);
+        }
+    }
+
+private:
+    FOmniCaptureWorkerPool& Owner;
+    TAtomic<uint64> BusyCycles;
+    uint64 StartCycles = 0;
+};
+
+FOmniCaptureWorkerPool::FOmniCaptureWorkerPool()
+{
+    QueuedJobs = 0;
+    ActiveThreads = 0;
+    bRunning = false;
+}
+
+FOmniCaptureWorkerPool::~FOmniCaptureWorkerPool()
+{
+    Stop();
+}
+
+bool FOmniCaptureWorkerPool::Start(const FString& Name, int32 ThreadCount, uint64 AffinityMask, EThreadPriority Priority)
+{
+    if (Threads.Num() > 0)
+    {
+        return true;
+    }
+
+    {
+        FScopeLock Lock(&RunStateCS);
+        JobEvent = FPlatformProcess::GetSynchEventFromPool();
+        bRunning = true;
+    }
+
+    const uint64 ThreadAffinity = AffinityMask != 0 ? AffinityMask : FPlatformAffinity::GetNoAffinityMask();
+    const int32 Count = FMath::Clamp(ThreadCount, 1, GMaxPoolThreads);
+    for (int32 ThreadIndex = 0; ThreadIndex < Count; ++ThreadIndex)
+    {
+        FOmniCaptureWorkerPoolThread* Worker = new FOmniCaptureWorkerPoolThread(*this);
+        const FString ThreadName = ThreadIndex == 0 ? Name : FString::Printf(TEXT("%s%d"), *Name, ThreadIndex);
+        ActiveThreads.IncrementExchange();
+        FRunnableThread* Thread = FRunnableThread::Create(Worker, *ThreadName, 0, Priority, ThreadAffinity);
+        if (!Thread)
+        {
+            ActiveThreads.DecrementExchange();
+            delete Worker;
+            continue;
+        }
+
+        Workers.Add(Worker);
+        Threads.Emplace(Thread);
+    }
+
+    if (Threads.Num() == 0)
+    {
+        {
+            FScopeLock Lock(&RunStateCS);
+            bRunning = false;
+        }
+        // Anything enqueued before the flag dropped has no thread to run it.
+        while (RunNextJob())
+        {
+        }
+        FPlatformProcess::ReturnSynchEventToPool(JobEvent);
+        JobEvent = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void FOmniCaptureWorkerPool::Stop()
+{
+    if (Threads.Num() == 0)
+    {
+        return;
+    }
+
+    // Once the flag drops under the lock, Enqueue runs jobs inline, so nothing can be queued behind the drain below.
+    {
+        FScopeLock Lock(&RunStateCS);
+        bRunning = false;
+    }
+
+    // One trigger wakes the first idle thread, which hands it on as it exits; the joins then block rather than spin.
+    JobEvent->Trigger();
+
+    for (TUniquePtr<FRunnableThread>& Thread : Threads)
+    {
+        Thread->WaitForCompletion();
+    }
+    Threads.Reset();
+
+    for (FOmniCaptureWorkerPoolThread* Worker : Workers)
+    {
+        delete Worker;
+    }
+    Workers.Reset();
+
+    // Jobs queued while the threads were exiting run on the caller rather than being dropped.
+    while (RunNextJob())
+    {
+    }
+
+    FPlatformProcess::ReturnSynchEventToPool(JobEvent);
+    JobEvent = nullptr;
+}
+
+void FOmniCaptureWorkerPool::Enqueue(TUniqueFunction<void()>&& Job)
+{
+    {
+        FScopeLock Lock(&RunStateCS);
+        if (bRunning.Load())
+        {
+            QueuedJobs.IncrementExchange();
+            Jobs.Enqueue(MoveTemp(Job));
+            JobEvent->Trigger();
+            return;
+        }
+    }
+
+    // Outside the lock, since the job may enqueue more work.
+    Job();
+}
+
+float FOmniCaptureWorkerPool::GetUtilization() const
+{
+    if (Workers.Num() == 0)
+    {
+        return 0.0f;
+    }
+
+    float Total = 0.0f;
+    for (const FOmniCaptureWorkerPoolThread* Worker : Workers)
+    {
+        Total += Worker->GetUtilization();
+    }
+    return Total / Workers.Num();
+}
+
+bool FOmniCaptureWorkerPool::RunNextJob()
+{
+    TUniqueFunction<void()> Job;
+    bool bMoreQueued = false;
+    {
+        // The queue takes many producers but a single consumer at a time.
+        FScopeLock Lock(&DequeueCS);
+        if (!Jobs.Dequeue(Job))
+        {
+            return false;
+        }
+        bMoreQueued = !Jobs.IsEmpty();
+    }
+
+    QueuedJobs.DecrementExchange();
+
+    // Pass the wake-up on so an idle thread picks up the next job while this one runs.
+    if (bMoreQueued && JobEvent)
+    {
+        JobEvent->Trigger();
+    }
+
+    Job();
+    return true;
+}
@@ -0,0 +1,147 @@
+#include "Misc/AutomationTest.h"
+
+#include "OmniCaptureAudioRing.h"
+#include "OmniCaptureCPUKernels.h"
+
+namespace
+{
+    constexpr int32 GTestSampleRate = 48000;
+    constexpr int32 GTestChannels = 2;
+
+    /** Interleaved samples whose values depend on where they sit in the whole stream, so misplaced copies show up. */
+    TArray<float> MakeSamples(int64 FirstSample, int32 Count)
+    {
+        TArray<float> Samples;
+        Samples.SetNumUninitialized(Count);
+        for (int32 Index = 0; Index < Count; ++Index)
+        {
+            Samples[Index] = static_cast<float>(((FirstSample + Index) * 7) % 2001 - 1000) / 1000.0f;
+        }
+        return Samples;
+    }
+
+    double GetSeconds(int32 SampleCount)
+    {
+        return static_cast<double>(SampleCount) / (GTestSampleRate * GTestChannels);
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureAudioRingWrapTest, "OmniCapture.AudioRing.WrapsAroundSampleCapacity", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCaptureAudioRingWrapTest::RunTest(const FString& Parameters)
+{
+    FOmniCaptureAudioRing Ring;
+    Ring.Initialize();
+
+    // 50 ms buffers that don't divide the ring evenly, pushed and gathered one per frame until well past its end.
+    constexpr int32 ChunkSamples = 4800;
+    const int32 ChunkCount = FOmniCaptureAudioRing::DefaultSampleCapacity / ChunkSamples + 3;
+    int32 Mismatches = 0;
+    int32 BadPackets = 0;
+    TArray<int16> Expected;
+    Expected.SetNumUninitialized(ChunkSamples);
+    for (int32 ChunkIndex = 0; ChunkIndex < ChunkCount; ++ChunkIndex)
+    {
+        const int64 FirstSample = static_cast<int64>(ChunkIndex) * ChunkSamples;
+        const TArray<float> Samples = MakeSamples(FirstSample, ChunkSamples);
+        const double Timestamp = GetSeconds(ChunkSamples) * ChunkIndex;
+        TestTrue(TEXT("Buffer fits once the previous one is gathered"), Ring.Push(Samples.GetData(), ChunkSamples, GTestChannels, GTestSampleRate, 1.0f, Timestamp));
+
+        FOmniCaptureFrame Frame;
+        Ring.Gather(Timestamp, Frame, true);
+        if (Frame.AudioPackets.Num() != 1 || Frame.AudioPackets[0].PCM16.Num() != ChunkSamples || Frame.AudioPackets[0].Timestamp != Timestamp)
+        {
+            ++BadPackets;
+            continue;
+        }
+
+        FOmniCaptureCPUKernels::PackPCM16Reference(Samples.GetData(), 1.0f, Expected.GetData(), ChunkSamples);
+        Mismatches += FMemory::Memcmp(Frame.AudioPackets[0].PCM16.GetData(), Expected.GetData(), ChunkSamples * sizeof(int16)) == 0 ? 0 : 1;
+    }
+
+    TestTrue(TEXT("The stream crossed the end of the ring"), static_cast<int64>(ChunkCount) * ChunkSamples > FOmniCaptureAudioRing::DefaultSampleCapacity);
+    TestEqual(TEXT("Each frame gathers its one buffer"), BadPackets, 0);
+    TestEqual(TEXT("Samples survive the wrap unchanged"), Mismatches, 0);
+    TestEqual(TEXT("Nothing overflowed"), Ring.GetOverflowCount(), 0);
+    TestEqual(TEXT("Nothing underflowed"), Ring.GetUnderflowCount(), 0);
+    TestEqual(TEXT("Nothing is left pending"), Ring.GetPendingChunkCount(), 0);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureAudioRingMergeTest, "OmniCapture.AudioRing.MergesContiguousBuffers", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCaptureAudioRingMergeTest::RunTest(const FString& Parameters)
+{
+    FOmniCaptureAudioRing Ring;
+    Ring.Initialize(4096, 16);
+
+    // Three back-to-back 5 ms buffers, then one after a gap.
+    constexpr int32 ChunkSamples = 480;
+    const TArray<float> Samples = MakeSamples(0, ChunkSamples);
+    const double ChunkSeconds = GetSeconds(ChunkSamples);
+    for (int32 ChunkIndex = 0; ChunkIndex < 3; ++ChunkIndex)
+    {
+        Ring.Push(Samples.GetData(), ChunkSamples, GTestChannels, GTestSampleRate, 1.0f, ChunkSeconds * ChunkIndex);
+    }
+    Ring.Push(Samples.GetData(), ChunkSamples, GTestChannels, GTestSampleRate, 1.0f, 0.1);
+    Ring.Push(Samples.GetData(), ChunkSamples, GTestChannels, GTestSampleRate, 1.0f, 0.5);
+
+    FOmniCaptureFrame Frame;
+    Frame.SpareAudioPCM.AddDefaulted();
+    Ring.Gather(0.1, Frame, true);
+    TestEqual(TEXT("A gap starts a new packet"), Frame.AudioPackets.Num(), 2);
+    if (Frame.AudioPackets.Num() == 2)
+    {
+        TestEqual(TEXT("Contiguous buffers share one packet"), Frame.AudioPackets[0].PCM16.Num(), ChunkSamples * 3);
+        TestEqual(TEXT("The merged packet keeps the first timestamp"), Frame.AudioPackets[0].Timestamp, 0.0);
+        TestEqual(TEXT("The packet after the gap keeps its own timestamp"), Frame.AudioPackets[1].Timestamp, 0.1);
+    }
+    TestEqual(TEXT("Spare PCM arrays are reused"), Frame.SpareAudioPCM.Num(), 0);
+    TestEqual(TEXT("Audio past the frame waits for a later one"), Ring.GetPendingChunkCount(), 1);
+
+    // A format change splits packets even when the buffers are back to back.
+    FOmniCaptureFrame Later;
+    Ring.Push(Samples.GetData(), ChunkSamples, GTestChannels, 44100, 1.0f, 0.5 + ChunkSeconds);
+    Ring.Gather(0.6, Later, true);
+    TestEqual(TEXT("A new sample rate starts a new packet"), Later.AudioPackets.Num(), 2);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureAudioRingOverflowTest, "OmniCapture.AudioRing.CountsOverflowAndUnderflow", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCaptureAudioRingOverflowTest::RunTest(const FString& Parameters)
+{
+    FOmniCaptureAudioRing Ring;
+    Ring.Initialize(1024, 4);
+    const TArray<float> Samples = MakeSamples(0, 2048);
+
+    // Out of chunk records first, then out of samples.
+    for (int32 ChunkIndex = 0; ChunkIndex < 4; ++ChunkIndex)
+    {
+        TestTrue(TEXT("Buffers fit while records are free"), Ring.Push(Samples.GetData(), 16, GTestChannels, GTestSampleRate, 1.0f, GetSeconds(16) * ChunkIndex));
+    }
+    TestFalse(TEXT("A fifth buffer finds no record"), Ring.Push(Samples.GetData(), 16, GTestChannels, GTestSampleRate, 1.0f, GetSeconds(16) * 4));
+    TestEqual(TEXT("The dropped buffer is counted"), Ring.GetOverflowCount(), 1);
+
+    FOmniCaptureFrame Frame;
+    Ring.Gather(1.0, Frame, true);
+    TestEqual(TEXT("Everything that fit is gathered"), Ring.GetPendingChunkCount(), 0);
+    TestFalse(TEXT("A buffer larger than the free samples is dropped"), Ring.Push(Samples.GetData(), 1025, GTestChannels, GTestSampleRate, 1.0f, 1.0));
+    TestTrue(TEXT("One that fits still goes in"), Ring.Push(Samples.GetData(), 1000, GTestChannels, GTestSampleRate, 1.0f, 1.0));
+    TestEqual(TEXT("Both drops are counted"), Ring.GetOverflowCount(), 2);
+
+    // The last gathered audio ends shortly after 1.01 s.
+    FOmniCaptureFrame Gathered;
+    Ring.Gather(1.0, Gathered, true);
+    FOmniCaptureFrame Early;
+    Ring.Gather(1.03, Early, true);
+    TestEqual(TEXT("A frame just past the audio is not an underflow"), Ring.GetUnderflowCount(), 0);
+    FOmniCaptureFrame Paused;
+    Ring.Gather(1.5, Paused, false);
+    TestEqual(TEXT("No underflow while audio is not expected"), Ring.GetUnderflowCount(), 0);
+    FOmniCaptureFrame Starved;
+    Ring.Gather(1.5, Starved, true);
+    TestEqual(TEXT("A frame well past the audio is an underflow"), Ring.GetUnderflowCount(), 1);
+    TestEqual(TEXT("An underflowing frame carries no audio"), Starved.AudioPackets.Num(), 0);
+
+    Ring.Reset();
+    TestTrue(TEXT("Reset clears the counters"), Ring.GetOverflowCount() == 0 && Ring.GetUnderflowCount() == 0 && Ring.GetPendingChunkCount() == 0);
+    return true;
+}
@@ -0,0 +1,295 @@
+#include "Misc/AutomationTest.h"
+
+#include "OmniCaptureCPUKernels.h"
+#include "Math/RandomStream.h"
+
+namespace
+{
+    constexpr int32 GTestFaceResolution = 17;
+    constexpr int32 GTestSampleCount = 4099; // Not a multiple of the lane count, so the tail loop runs too.
+
+    struct FTestCubemap
+    {
+        TArray<FLinearColor> Faces[6];
+        FOmniCaptureCubemapView View;
+
+        explicit FTestCubemap(FRandomStream& Random)
+        {
+            View.Resolution = GTestFaceResolution;
+            for (int32 FaceIndex = 0; FaceIndex < 6; ++FaceIndex)
+            {
+                Faces[FaceIndex].SetNum(GTestFaceResolution * GTestFaceResolution);
+                for (FLinearColor& Texel : Faces[FaceIndex])
+                {
+                    // Slightly out of [0,1] on purpose so packing has to clamp.
+                    Texel = FLinearColor(Random.FRandRange(-0.1f, 1.2f), Random.FRandRange(-0.1f, 1.2f), Random.FRandRange(-0.1f, 1.2f), Random.FRandRange(-0.1f, 1.2f));
+                }
+                View.Faces[FaceIndex] = Faces[FaceIndex].GetData();
+            }
+        }
+    };
+
+    TArray<FOmniCaptureCubemapSample> BuildSamples(FRandomStream& Random)
+    {
+        TArray<FOmniCaptureCubemapSample> Samples;
+        Samples.SetNum(GTestSampleCount);
+        for (int32 Index = 0; Index < Samples.Num(); ++Index)
+        {
+            FOmniCaptureCubemapSample& Sample = Samples[Index];
+            if (Index % 13 == 0)
+            {
+                continue;
+            }
+
+            const int32 X = Random.RandRange(0, GTestFaceResolution - 1);
+            const int32 Y = Random.RandRange(0, GTestFaceResolution - 1);
+            Sample.Texel = (static_cast<uint32>(Random.RandRange(0, 5)) << FOmniCaptureCubemapSample::FaceShift) | static_cast<uint32>(Y * GTestFaceResolution + X);
+
+            // Edge texels only ever carry a zero fraction towards the missing neighbour.
+            Sample.WeightX = X < GTestFaceResolution - 1 ? static_cast<uint16>(Random.RandRange(0, MAX_uint16)) : 0;
+            Sample.WeightY = Y < GTestFaceResolution - 1 ? static_cast<uint16>(Random.RandRange(0, MAX_uint16)) : 0;
+        }
+        return Samples;
+    }
+
+    TArray<FLinearColor> BuildColors(FRandomStream& Random)
+    {
+        TArray<FLinearColor> Colors;
+        Colors.SetNum(GTestSampleCount);
+        for (int32 Index = 0; Index < Colors.Num(); ++Index)
+        {
+            Colors[Index] = FLinearColor(Random.FRandRange(-0.2f, 1.5f), Random.FRandRange(-0.2f, 1.5f), Random.FRandRange(-0.2f, 1.5f), Random.FRandRange(-0.2f, 1.5f));
+        }
+
+        // Exact endpoints and the sRGB linear-segment knee.
+        Colors[0] = FLinearColor(0.0f, 1.0f, 0.0031308f, 0.5f);
+        Colors[1] = FLinearColor::Transparent;
+        Colors[2] = FLinearColor::White;
+        return Colors;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureCPUKernelsGatherTest, "OmniCapture.CPUKernels.GatherMatchesReference", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCaptureCPUKernelsGatherTest::RunTest(const FString& Parameters)
+{
+    FRandomStream Random(0x0C0FFEE);
+    const FTestCubemap Cubemap(Random);
+    const TArray<FOmniCaptureCubemapSample> Samples = BuildSamples(Random);
+
+    TArray<FLinearColor> Vector;
+    TArray<FLinearColor> Reference;
+    Vector.SetNumZeroed(Samples.Num());
+    Reference.SetNumZeroed(Samples.Num());
+
+    FOmniCaptureCPUKernels::GatherBilinear(Cubemap.View, Samples.GetData(), Samples.Num(), Vector.GetData());
+    FOmniCaptureCPUKernels::GatherBilinearReference(Cubemap.View, Samples.GetData(), Samples.Num(), Reference.GetData());
+
+    int32 Mismatches = 0;
+    for (int32 Index = 0; Index < Samples.Num(); ++Index)
+    {
+        // Fused multiply-add may round differently from the scalar lerp.
+        Mismatches += Vector[Index].Equals(Reference[Index], 1.0e-5f) ? 0 : 1;
+    }
+    TestEqual(TEXT("Bilinear gather matches the scalar reference"), Mismatches, 0);
+
+    FOmniCaptureCPUKernels::GatherNearest(Cubemap.View, Samples.GetData(), Samples.Num(), Vector.GetData());
+    Mismatches = 0;
+    for (int32 Index = 0; Index < Samples.Num(); ++Index)
+    {
+        const FOmniCaptureCubemapSample& Sample = Samples[Index];
+        const FLinearColor Expected = Sample.Texel == FOmniCaptureCubemapSample::Transparent
+            ? FLinearColor::Transparent
+            : Cubemap.Faces[Sample.Texel >> FOmniCaptureCubemapSample::FaceShift][Sample.Texel & FOmniCaptureCubemapSample::TexelMask];
+        Mismatches += FMemory::Memcmp(&Vector[Index], &Expected, sizeof(FLinearColor)) == 0 ? 0 : 1;
+    }
+    TestEqual(TEXT("Nearest gather is bit-exact"), Mismatches, 0);
+
+    // Half faces must gather exactly what their widened float copies gather.
+    TArray<FFloat16Color> HalfFaces[6];
+    TArray<FLinearColor> WidenedFaces[6];
+    FOmniCaptureCubemapView HalfView;
+    FOmniCaptureCubemapView WidenedView;
+    HalfView.Resolution = WidenedView.Resolution = GTestFaceResolution;
+    HalfView.bHalf = true;
+    for (int32 FaceIndex = 0; FaceIndex < 6; ++FaceIndex)
+    {
+        for (const FLinearColor& Texel : Cubemap.Faces[FaceIndex])
+        {
+            const FFloat16Color& Half = HalfFaces[FaceIndex].Add_GetRef(FFloat16Color(Texel));
+            WidenedFaces[FaceIndex].Add(FLinearColor(Half));
+        }
+        HalfView.HalfFaces[FaceIndex] = HalfFaces[FaceIndex].GetData();
+        WidenedView.Faces[FaceIndex] = WidenedFaces[FaceIndex].GetData();
+    }
+
+    TArray<FLinearColor> FromWidened;
+    FromWidened.SetNumZeroed(Samples.Num());
+    FOmniCaptureCPUKernels::GatherNearest(HalfView, Samples.GetData(), Samples.Num(), Vector.GetData());
+    FOmniCaptureCPUKernels::GatherNearest(WidenedView, Samples.GetData(), Samples.Num(), FromWidened.GetData());
+    TestTrue(TEXT("Nearest gather from half faces matches widened faces"), FMemory::Memcmp(Vector.GetData(), FromWidened.GetData(), Samples.Num() * sizeof(FLinearColor)) == 0);
+
+    FOmniCaptureCPUKernels::GatherBilinear(HalfView, Samples.GetData(), Samples.Num(), Vector.GetData());
+    FOmniCaptureCPUKernels::GatherBilinearReference(HalfView, Samples.GetData(), Samples.Num(), Reference.GetData());
+    FOmniCaptureCPUKernels::GatherBilinear(WidenedView, Samples.GetData(), Samples.Num(), FromWidened.GetData());
+    Mismatches = 0;
+    for (int32 Index = 0; Index < Samples.Num(); ++Index)
+    {
+        Mismatches += Vector[Index].Equals(Reference[Index], 1.0e-5f) && FMemory::Memcmp(&Vector[Index], &FromWidened[Index], sizeof(FLinearColor)) == 0 ? 0 : 1;
+    }
+    TestEqual(TEXT("Bilinear gather from half faces matches the reference and widened faces"), Mismatches, 0);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureCPUKernelsPackTest, "OmniCapture.CPUKernels.PackMatchesReference", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCaptureCPUKernelsPackTest::RunTest(const FString& Parameters)
+{
+    FRandomStream Random(0x5EED);
+    const TArray<FLinearColor> Colors = BuildColors(Random);
+
+    TArray<FFloat16Color> HalfVector;
+    TArray<FFloat16Color> HalfReference;
+    HalfVector.SetNumZeroed(Colors.Num());
+    HalfReference.SetNumZeroed(Colors.Num());
+    FOmniCaptureCPUKernels::PackFloat16(Colors.GetData(), HalfVector.GetData(), Colors.Num());
+    FOmniCaptureCPUKernels::PackFloat16Reference(Colors.GetData(), HalfReference.GetData(), Colors.Num());
+
+    int32 HalfMismatches = 0;
+    for (int32 Index = 0; Index < Colors.Num(); ++Index)
+    {
+        const uint16* VectorHalves = reinterpret_cast<const uint16*>(&HalfVector[Index]);
+        const uint16* ReferenceHalves = reinterpret_cast<const uint16*>(&HalfReference[Index]);
+        for (int32 Channel = 0; Channel < 4; ++Channel)
+        {
+            // Both go through the platform half conversion; allow one ulp for builds where FFloat16 rounds differently.
+            HalfMismatches += FMath::Abs(static_cast<int32>(VectorHalves[Channel]) - static_cast<int32>(ReferenceHalves[Channel])) <= 1 ? 0 : 1;
+        }
+    }
+    TestEqual(TEXT("Half packing matches FFloat16Color"), HalfMismatches, 0);
+
+    TArray<FColor> SRGBVector;
+    TArray<FColor> SRGBReference;
+    SRGBVector.SetNumZeroed(Colors.Num());
+    SRGBReference.SetNumZeroed(Colors.Num());
+    FOmniCaptureCPUKernels::PackSRGB(Colors.GetData(), SRGBVector.GetData(), Colors.Num());
+    FOmniCaptureCPUKernels::PackSRGBReference(Colors.GetData(), SRGBReference.GetData(), Colors.Num());
+
+    int32 MaxError = 0;
+    for (int32 Index = 0; Index < Colors.Num(); ++Index)
+    {
+        MaxError = FMath::Max(MaxError, FMath::Abs(SRGBVector[Index].R - SRGBReference[Index].R));
+        MaxError = FMath::Max(MaxError, FMath::Abs(SRGBVector[Index].G - SRGBReference[Index].G));
+        MaxError = FMath::Max(MaxError, FMath::Abs(SRGBVector[Index].B - SRGBReference[Index].B));
+        MaxError = FMath::Max(MaxError, FMath::Abs(SRGBVector[Index].A - SRGBReference[Index].A));
+    }
+    TestTrue(FString::Printf(TEXT("sRGB packing stays within one code value (max error %d)"), MaxError), MaxError <= 1);
+    TestEqual(TEXT("Transparent stays transparent"), SRGBVector[1], FColor(0, 0, 0, 0));
+    TestEqual(TEXT("White stays white"), SRGBVector[2], FColor::White);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureCPUKernelsConvertTest, "OmniCapture.CPUKernels.ConversionsMatchReference", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCaptureCPUKernelsConvertTest::RunTest(const FString& Parameters)
+{
+    FRandomStream Random(0xC010);
+    const TArray<FLinearColor> Colors = BuildColors(Random);
+    const int32 Count = Colors.Num();
+
+    TArray<uint16> Wide;
+    TArray<uint16> WideReference;
+    Wide.SetNumZeroed(Count * 4);
+    WideReference.SetNumZeroed(Count * 4);
+    FOmniCaptureCPUKernels::PackUNorm16BGRA(Colors.GetData(), Wide.GetData(), Count);
+    FOmniCaptureCPUKernels::PackUNorm16BGRAReference(Colors.GetData(), WideReference.GetData(), Count);
+    TestTrue(TEXT("16-bit packing is bit-exact"), Wide == WideReference);
+    TestTrue(TEXT("16-bit packing writes B, G, R, A"), Wide[0] == 205 && Wide[1] == 65535 && Wide[2] == 0 && Wide[3] == 32768);
+
+    TArray<FFloat16Color> Halves;
+    Halves.SetNumZeroed(Count);
+    FOmniCaptureCPUKernels::PackFloat16Reference(Colors.GetData(), Halves.GetData(), Count);
+
+    TArray<FLinearColor> Widened;
+    TArray<FLinearColor> WidenedReference;
+    Widened.SetNumZeroed(Count);
+    WidenedReference.SetNumZeroed(Count);
+    FOmniCaptureCPUKernels::WidenFloat16(Halves.GetData(), Widened.GetData(), Count);
+    FOmniCaptureCPUKernels::WidenFloat16Reference(Halves.GetData(), WidenedReference.GetData(), Count);
+    TestTrue(TEXT("Half widening is bit-exact"), FMemory::Memcmp(Widened.GetData(), WidenedReference.GetData(), Count * sizeof(FLinearColor)) == 0);
+
+    // Half sources must convert exactly like their widened floats do.
+    FOmniCaptureCPUKernels::PackUNorm16BGRA(Halves.GetData(), Wide.GetData(), Count);
+    FOmniCaptureCPUKernels::PackUNorm16BGRAReference(WidenedReference.GetData(), WideReference.GetData(), Count);
+    TestTrue(TEXT("16-bit packing from halves is bit-exact"), Wide == WideReference);
+
+    TArray<FColor> SRGB;
+    TArray<FColor> SRGBReference;
+    SRGB.SetNumZeroed(Count);
+    SRGBReference.SetNumZeroed(Count);
+    FOmniCaptureCPUKernels::PackSRGB(Halves.GetData(), SRGB.GetData(), Count);
+    FOmniCaptureCPUKernels::PackSRGBReference(WidenedReference.GetData(), SRGBReference.GetData(), Count);
+    int32 MaxError = 0;
+    for (int32 Index = 0; Index < Count; ++Index)
+    {
+        MaxError = FMath::Max(MaxError, FMath::Abs(SRGB[Index].R - SRGBReference[Index].R));
+        MaxError = FMath::Max(MaxError, FMath::Abs(SRGB[Index].G - SRGBReference[Index].G));
+        MaxError = FMath::Max(MaxError, FMath::Abs(SRGB[Index].B - SRGBReference[Index].B));
+        MaxError = FMath::Max(MaxError, FMath::Abs(SRGB[Index].A - SRGBReference[Index].A));
+    }
+    TestTrue(FString::Printf(TEXT("sRGB packing from halves stays within one code value (max error %d)"), MaxError), MaxError <= 1);
+
+    TArray<FColor> Bytes;
+    Bytes.SetNumUninitialized(Count);
+    for (FColor& Pixel : Bytes)
+    {
+        Pixel = FColor(Random.RandRange(0, 255), Random.RandRange(0, 255), Random.RandRange(0, 255), Random.RandRange(0, 255));
+    }
+    Bytes[0] = FColor(0, 128, 255, 1);
+
+    FOmniCaptureCPUKernels::UnpackColor(Bytes.GetData(), Widened.GetData(), Count);
+    FOmniCaptureCPUKernels::UnpackColorReference(Bytes.GetData(), WidenedReference.GetData(), Count);
+    TestTrue(TEXT("8-bit unpacking is bit-exact"), FMemory::Memcmp(Widened.GetData(), WidenedReference.GetData(), Count * sizeof(FLinearColor)) == 0);
+
+    TArray<FFloat16Color> UnpackedHalves;
+    UnpackedHalves.SetNumZeroed(Count);
+    FOmniCaptureCPUKernels::UnpackColor(Bytes.GetData(), UnpackedHalves.GetData(), Count);
+    FOmniCaptureCPUKernels::PackFloat16Reference(WidenedReference.GetData(), Halves.GetData(), Count);
+    int32 HalfMismatches = 0;
+    for (int32 Index = 0; Index < Count * 4; ++Index)
+    {
+        // Same one-ulp allowance as the half packing test.
+        HalfMismatches += FMath::Abs(static_cast<int32>(reinterpret_cast<const uint16*>(UnpackedHalves.GetData())[Index]) - static_cast<int32>(reinterpret_cast<const uint16*>(Halves.GetData())[Index])) <= 1 ? 0 : 1;
+    }
+    TestEqual(TEXT("8-bit unpacking to halves matches FFloat16Color"), HalfMismatches, 0);
+
+    FOmniCaptureCPUKernels::ExpandUNorm16BGRA(Bytes.GetData(), Wide.GetData(), Count);
+    TestTrue(TEXT("8-bit expansion replicates bytes in B, G, R, A order"), Wide[0] == 255 * 257 && Wide[1] == 128 * 257 && Wide[2] == 0 && Wide[3] == 257);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureCPUKernelsPCMTest, "OmniCapture.CPUKernels.PCMMatchesReference", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCaptureCPUKernelsPCMTest::RunTest(const FString& Parameters)
+{
+    FRandomStream Random(0xA0D10);
+    TArray<float> Samples;
+    Samples.SetNumUninitialized(GTestSampleCount);
+    for (float& Sample : Samples)
+    {
+        // Past full scale on both sides, so saturation is covered.
+        Sample = Random.FRandRange(-1.5f, 1.5f);
+    }
+    Samples[0] = 1.0f;
+    Samples[1] = -1.0f;
+    Samples[2] = 4.0f;
+    Samples[3] = -4.0f;
+
+    TArray<int16> PCM;
+    TArray<int16> PCMReference;
+    PCM.SetNumZeroed(GTestSampleCount);
+    PCMReference.SetNumZeroed(GTestSampleCount);
+    FOmniCaptureCPUKernels::PackPCM16(Samples.GetData(), 0.8f, PCM.GetData(), GTestSampleCount);
+    FOmniCaptureCPUKernels::PackPCM16Reference(Samples.GetData(), 0.8f, PCMReference.GetData(), GTestSampleCount);
+    TestTrue(TEXT("PCM conversion is bit-exact"), PCM == PCMReference);
+
+    FOmniCaptureCPUKernels::PackPCM16(Samples.GetData(), 1.0f, PCM.GetData(), 4);
+    TestTrue(TEXT("Full scale maps to the 16-bit limits"), PCM[0] == 32767 && PCM[1] == -32767 && PCM[2] == 32767 && PCM[3] == -32768);
+    return true;
+}
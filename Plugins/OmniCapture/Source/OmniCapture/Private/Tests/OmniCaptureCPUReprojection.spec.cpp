@@ -0,0 +1,244 @@
+#include "Misc/AutomationTest.h"
+
+#include "OmniCaptureCPUReprojection.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+
+namespace
+{
+    void BuildSyntheticCubemap(int32 FaceResolution, FOmniCaptureCPUCubemap& OutCubemap)
+    {
+        OutCubemap.Precision = EOmniCapturePixelPrecision::FullFloat;
+        for (int32 FaceIndex = 0; FaceIndex < 6; ++FaceIndex)
+        {
+            FOmniCaptureCPUFace& Face = OutCubemap.Faces[FaceIndex];
+            Face.Resolution = FaceResolution;
+            Face.Precision = EOmniCapturePixelPrecision::FullFloat;
+            Face.Pixels.SetNum(FaceResolution * FaceResolution);
+            for (int32 Y = 0; Y < FaceResolution; ++Y)
+            {
+                for (int32 X = 0; X < FaceResolution; ++X)
+                {
+                    Face.Pixels[Y * FaceResolution + X] = FLinearColor(
+                        static_cast<float>(X) / FaceResolution,
+                        static_cast<float>(Y) / FaceResolution,
+                        (FaceIndex + 1) / 6.0f,
+                        1.0f);
+                }
+            }
+        }
+    }
+
+    template <typename PixelType>
+    bool PixelsMatch(const FOmniCaptureEquirectResult& A, const FOmniCaptureEquirectResult& B)
+    {
+        const TImagePixelData<PixelType>* PixelsA = static_cast<const TImagePixelData<PixelType>*>(A.PixelData.Get());
+        const TImagePixelData<PixelType>* PixelsB = static_cast<const TImagePixelData<PixelType>*>(B.PixelData.Get());
+        return PixelsA && PixelsB
+            && PixelsA->Pixels.Num() == PixelsB->Pixels.Num()
+            && FMemory::Memcmp(PixelsA->Pixels.GetData(), PixelsB->Pixels.GetData(), PixelsA->Pixels.Num() * sizeof(PixelType)) == 0;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureCPUReprojectionParallelTest, "OmniCapture.CPUReprojection.ParallelMatchesSerial", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCaptureCPUReprojectionParallelTest::RunTest(const FString& Parameters)
+{
+    FOmniCaptureCPUCubemap LeftCubemap;
+    FOmniCaptureCPUCubemap RightCubemap;
+    BuildSyntheticCubemap(128, LeftCubemap);
+    BuildSyntheticCubemap(128, RightCubemap);
+
+    FOmniCaptureSettings Settings;
+    Settings.Resolution = 1024;
+    Settings.Mode = EOmniCaptureMode::Stereo;
+    Settings.StereoLayout = EOmniCaptureStereoLayout::TopBottom;
+
+    const EOmniCaptureGamma Gammas[] = { EOmniCaptureGamma::SRGB, EOmniCaptureGamma::Linear };
+    for (EOmniCaptureGamma Gamma : Gammas)
+    {
+        Settings.Gamma = Gamma;
+
+        FOmniCaptureEquirectResult Serial;
+        FOmniCaptureEquirectResult Parallel;
+        FOmniCaptureCPUReprojection::ConvertToEquirectangular(Settings, LeftCubemap, RightCubemap, Serial, 1);
+        FOmniCaptureCPUReprojection::ConvertToEquirectangular(Settings, LeftCubemap, RightCubemap, Parallel, 0);
+
+        const bool bMatch = Gamma == EOmniCaptureGamma::Linear
+            ? PixelsMatch<FLinearColor>(Serial, Parallel)
+            : PixelsMatch<FColor>(Serial, Parallel);
+        TestTrue(FString::Printf(TEXT("Equirect output is identical (%s)"), Gamma == EOmniCaptureGamma::Linear ? TEXT("linear") : TEXT("sRGB")), bMatch);
+
+        FOmniCaptureEquirectResult SerialFisheye;
+        FOmniCaptureEquirectResult ParallelFisheye;
+        FOmniCaptureCPUReprojection::ConvertToFisheye(Settings, LeftCubemap, RightCubemap, SerialFisheye, 1);
+        FOmniCaptureCPUReprojection::ConvertToFisheye(Settings, LeftCubemap, RightCubemap, ParallelFisheye, 0);
+
+        const bool bFisheyeMatch = Gamma == EOmniCaptureGamma::Linear
+            ? PixelsMatch<FLinearColor>(SerialFisheye, ParallelFisheye)
+            : PixelsMatch<FColor>(SerialFisheye, ParallelFisheye);
+        TestTrue(FString::Printf(TEXT("Fisheye output is identical (%s)"), Gamma == EOmniCaptureGamma::Linear ? TEXT("linear") : TEXT("sRGB")), bFisheyeMatch);
+    }
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureCPUReprojectionLUTTest, "OmniCapture.CPUReprojection.CachedLUTMatchesDirect", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCaptureCPUReprojectionLUTTest::RunTest(const FString& Parameters)
+{
+    FOmniCaptureCPUCubemap LeftCubemap;
+    FOmniCaptureCPUCubemap RightCubemap;
+    BuildSyntheticCubemap(96, LeftCubemap);
+    BuildSyntheticCubemap(96, RightCubemap);
+
+    FOmniCaptureSettings Settings;
+    Settings.Resolution = 512;
+    Settings.Mode = EOmniCaptureMode::Stereo;
+    Settings.StereoLayout = EOmniCaptureStereoLayout::SideBySide;
+    Settings.Gamma = EOmniCaptureGamma::SRGB;
+
+    FOmniCaptureCPUReprojection::ResetLUTCache();
+
+    const EOmniCaptureCoverage Coverages[] = { EOmniCaptureCoverage::FullSphere, EOmniCaptureCoverage::HalfSphere };
+    for (EOmniCaptureCoverage Coverage : Coverages)
+    {
+        Settings.Coverage = Coverage;
+
+        Settings.bCacheCPUReprojectionLUT = false;
+        FOmniCaptureEquirectResult Direct;
+        FOmniCaptureEquirectResult DirectFisheye;
+        FOmniCaptureCPUReprojection::ConvertToEquirectangular(Settings, LeftCubemap, RightCubemap, Direct);
+        FOmniCaptureCPUReprojection::ConvertToFisheye(Settings, LeftCubemap, RightCubemap, DirectFisheye);
+
+        Settings.bCacheCPUReprojectionLUT = true;
+        FOmniCaptureEquirectResult Cached;
+        FOmniCaptureEquirectResult CachedFisheye;
+        FOmniCaptureCPUReprojection::ConvertToEquirectangular(Settings, LeftCubemap, RightCubemap, Cached);
+        FOmniCaptureCPUReprojection::ConvertToFisheye(Settings, LeftCubemap, RightCubemap, CachedFisheye);
+
+        TestTrue(TEXT("Equirect through the cached map matches direct sampling"), PixelsMatch<FColor>(Direct, Cached));
+        TestTrue(TEXT("Fisheye through the cached map matches direct sampling"), PixelsMatch<FColor>(DirectFisheye, CachedFisheye));
+    }
+
+    const int32 CachedCount = FOmniCaptureCPUReprojection::GetCachedLUTCount();
+    FOmniCaptureEquirectResult Repeat;
+    FOmniCaptureCPUReprojection::ConvertToFisheye(Settings, LeftCubemap, RightCubemap, Repeat);
+    TestEqual(TEXT("Repeated settings reuse the cached map"), FOmniCaptureCPUReprojection::GetCachedLUTCount(), CachedCount);
+
+    // A map reloaded from disk must produce the same frame as the one it was built from.
+    const FString CacheDirectory = FOmniCaptureCPUReprojection::GetLUTCacheDirectory();
+    IFileManager::Get().DeleteDirectory(*CacheDirectory, false, true);
+    Settings.bPersistCPUReprojectionLUT = true;
+
+    FOmniCaptureCPUReprojection::ResetLUTCache();
+    FOmniCaptureEquirectResult Built;
+    FOmniCaptureCPUReprojection::ConvertToEquirectangular(Settings, LeftCubemap, RightCubemap, Built);
+
+    TArray<FString> CacheFiles;
+    IFileManager::Get().FindFiles(CacheFiles, *(CacheDirectory / TEXT("*.omnilut")), true, false);
+    TestEqual(TEXT("Persisting writes one map file"), CacheFiles.Num(), 1);
+
+    FOmniCaptureCPUReprojection::ResetLUTCache();
+    FOmniCaptureEquirectResult Reloaded;
+    FOmniCaptureCPUReprojection::ConvertToEquirectangular(Settings, LeftCubemap, RightCubemap, Reloaded);
+    TestTrue(TEXT("Reloaded map matches the freshly built one"), PixelsMatch<FColor>(Built, Reloaded));
+
+    IFileManager::Get().DeleteDirectory(*CacheDirectory, false, true);
+    FOmniCaptureCPUReprojection::ResetLUTCache();
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureCPUReprojectionStreamTest, "OmniCapture.CPUReprojection.StreamedBandsMatchFullFrame", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCaptureCPUReprojectionStreamTest::RunTest(const FString& Parameters)
+{
+    FOmniCaptureCPUCubemap LeftCubemap;
+    FOmniCaptureCPUCubemap RightCubemap;
+    BuildSyntheticCubemap(64, LeftCubemap);
+    BuildSyntheticCubemap(64, RightCubemap);
+
+    FOmniCaptureSettings Settings;
+    Settings.Resolution = 256;
+    Settings.Mode = EOmniCaptureMode::Stereo;
+    Settings.StereoLayout = EOmniCaptureStereoLayout::TopBottom;
+
+    // Not a divisor of the output height, so the last band is short.
+    constexpr int32 BandRows = 13;
+
+    const EOmniCaptureGamma Gammas[] = { EOmniCaptureGamma::SRGB, EOmniCaptureGamma::Linear };
+    for (EOmniCaptureGamma Gamma : Gammas)
+    {
+        Settings.Gamma = Gamma;
+
+        FOmniCaptureEquirectResult Full;
+        FOmniCaptureCPUReprojection::ConvertToEquirectangular(Settings, LeftCubemap, RightCubemap, Full);
+
+        FOmniCaptureCPUCubemap StreamedLeft = LeftCubemap;
+        FOmniCaptureCPUCubemap StreamedRight = RightCubemap;
+        FOmniCaptureEquirectResult Streamed;
+        FOmniCaptureCPUReprojection::StreamToEquirectangular(Settings, MoveTemp(StreamedLeft), MoveTemp(StreamedRight), Streamed);
+
+        TestFalse(TEXT("Streaming leaves the pixel payload empty"), Streamed.PixelData.IsValid());
+        if (!TestTrue(TEXT("Streaming hands back a row source"), Streamed.RowSource.IsValid() && Streamed.RowSource->IsValid()))
+        {
+            return false;
+        }
+
+        const FOmniCaptureCPURowSource& RowSource = *Streamed.RowSource;
+        TestEqual(TEXT("Row source has the full frame size"), RowSource.Size, Full.Size);
+        TestTrue(TEXT("Row source reports the full frame pixel type"), RowSource.PixelDataType == Full.PixelDataType);
+
+        const int64 BytesPerRow = RowSource.GetBytesPerRow();
+        TArray64<uint8> Band;
+        Band.SetNumUninitialized(BytesPerRow * BandRows);
+
+        const uint8* FullBytes = Gamma == EOmniCaptureGamma::Linear
+            ? reinterpret_cast<const uint8*>(static_cast<const TImagePixelData<FLinearColor>*>(Full.PixelData.Get())->Pixels.GetData())
+            : reinterpret_cast<const uint8*>(static_cast<const TImagePixelData<FColor>*>(Full.PixelData.Get())->Pixels.GetData());
+
+        int32 MismatchedBands = 0;
+        for (int32 RowStart = 0; RowStart < RowSource.Size.Y; RowStart += BandRows)
+        {
+            const int32 RowCount = FMath::Min(BandRows, RowSource.Size.Y - RowStart);
+            RowSource.ProduceRows(RowStart, RowCount, Band.GetData());
+            MismatchedBands += FMemory::Memcmp(Band.GetData(), FullBytes + BytesPerRow * RowStart, BytesPerRow * RowCount) == 0 ? 0 : 1;
+        }
+        TestEqual(FString::Printf(TEXT("Streamed bands match the full frame (%s)"), Gamma == EOmniCaptureGamma::Linear ? TEXT("linear") : TEXT("sRGB")), MismatchedBands, 0);
+    }
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureCPUReprojectionBenchmark, "OmniCapture.CPUReprojection.Throughput", EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+bool FOmniCaptureCPUReprojectionBenchmark::RunTest(const FString& Parameters)
+{
+    FOmniCaptureCPUCubemap Cubemap;
+    BuildSyntheticCubemap(512, Cubemap);
+
+    FOmniCaptureSettings Settings;
+    Settings.Resolution = 2048;
+    Settings.Mode = EOmniCaptureMode::Mono;
+    Settings.Gamma = EOmniCaptureGamma::SRGB;
+
+    const int32 MaxWorkers = FOmniCaptureCPUReprojection::GetMaxWorkerCount();
+    TArray<int32> WorkerCounts = { 1, 2, 4, 8, 16 };
+    WorkerCounts.RemoveAll([MaxWorkers](int32 Count) { return Count > MaxWorkers; });
+    WorkerCounts.AddUnique(MaxWorkers);
+
+    constexpr int32 Iterations = 3;
+    for (int32 WorkerCount : WorkerCounts)
+    {
+        double BestSeconds = TNumericLimits<double>::Max();
+        int64 PixelCount = 0;
+        for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+        {
+            FOmniCaptureEquirectResult Result;
+            const double Start = FPlatformTime::Seconds();
+            FOmniCaptureCPUReprojection::ConvertToEquirectangular(Settings, Cubemap, Cubemap, Result, WorkerCount);
+            BestSeconds = FMath::Min(BestSeconds, FPlatformTime::Seconds() - Start);
+            PixelCount = static_cast<int64>(Result.Size.X) * Result.Size.Y;
+        }
+
+        AddInfo(FString::Printf(TEXT("CPU equirect %lld px with %d thread(s): %.1f Mpix/s"), PixelCount, WorkerCount, PixelCount / FMath::Max(BestSeconds, 1.0e-9) / 1.0e6));
+    }
+
+    return true;
+}
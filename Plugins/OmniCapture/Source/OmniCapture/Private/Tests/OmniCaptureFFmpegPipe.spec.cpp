@@ -0,0 +1,74 @@
+#include "Misc/AutomationTest.h"
+
+#include "OmniCaptureFFmpegPipe.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+
+#if PLATFORM_WINDOWS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureFFmpegPipeFeedTest, "OmniCapture.FFmpegPipe.FeedsBothInputs", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCaptureFFmpegPipeFeedTest::RunTest(const FString& Parameters)
+{
+    const FString Directory = FPaths::ConvertRelativePathToFull(FPaths::AutomationTransientDir() / TEXT("OmniCaptureFFmpegPipe"));
+    IFileManager::Get().DeleteDirectory(*Directory, false, true);
+    IFileManager::Get().MakeDirectory(*Directory, true);
+    const FString VideoCopy = Directory / TEXT("video.raw");
+    const FString AudioCopy = Directory / TEXT("audio.raw");
+
+    // Stands in for ffmpeg: reads stdin to the end, then connects to the audio pipe by name and reads that to the end.
+    const FString Script = FString::Printf(
+        TEXT("$i=[Console]::OpenStandardInput(); $v=[IO.File]::Create('%s'); $i.CopyTo($v); $v.Close(); ")
+        TEXT("$p=New-Object IO.Pipes.NamedPipeClientStream('.', '%s'.Substring(9), 'In'); $p.Connect(30000); ")
+        TEXT("$a=[IO.File]::Create('%s'); $p.CopyTo($a); $a.Close(); $p.Close()"),
+        *VideoCopy, FOmniCaptureFFmpegPipe::GetAudioPipeToken(), *AudioCopy);
+
+    FOmniCaptureFFmpegPipe Pipe;
+    TestTrue(TEXT("Fake encoder starts"), Pipe.Start(TEXT("powershell.exe"), FString::Printf(TEXT("-NoProfile -NonInteractive -Command \"%s\""), *Script), Directory, true, 0));
+    TestTrue(TEXT("Audio pipe is created"), Pipe.HasAudio());
+
+    // Frames larger than the queue limit make every push after the first wait for the reader.
+    constexpr int32 FrameCount = 8;
+    constexpr int64 FrameBytes = 1024 * 1024 + 512;
+    constexpr int32 AudioChunks = 3;
+    constexpr int64 AudioChunkBytes = 48000 * 2 * sizeof(int16) / 10;
+    for (int32 FrameIndex = 0; FrameIndex < FrameCount; ++FrameIndex)
+    {
+        if (FrameIndex < AudioChunks)
+        {
+            TArray64<uint8> Audio;
+            Audio.Init(static_cast<uint8>(0x40 + FrameIndex), AudioChunkBytes);
+            TestTrue(TEXT("Audio is accepted"), Pipe.PushAudio(MoveTemp(Audio)));
+        }
+
+        TArray64<uint8> Video;
+        Video.Init(static_cast<uint8>(FrameIndex), FrameBytes);
+        TestTrue(TEXT("Frames are accepted"), Pipe.PushVideo(MoveTemp(Video)));
+    }
+
+    TestEqual(TEXT("Fake encoder exits cleanly"), Pipe.Finish(), 0);
+    const FOmniCaptureFFmpegPipeStats Stats = Pipe.GetStats();
+    TestEqual(TEXT("Every frame was pushed"), Stats.VideoPushes, FrameCount);
+    TestEqual(TEXT("Nothing was dropped"), Stats.DroppedPushes, 0);
+    TestTrue(TEXT("A slow reader pushes back"), Stats.BlockedPushes > 0);
+    TestEqual(TEXT("Every video byte reached the reader"), IFileManager::Get().FileSize(*VideoCopy), FrameCount * FrameBytes);
+    TestEqual(TEXT("Every audio byte reached the reader"), IFileManager::Get().FileSize(*AudioCopy), AudioChunks * AudioChunkBytes);
+
+    IFileManager::Get().DeleteDirectory(*Directory, false, true);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureFFmpegPipeExitCodeTest, "OmniCapture.FFmpegPipe.ExitCode", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCaptureFFmpegPipeExitCodeTest::RunTest(const FString& Parameters)
+{
+    FOmniCaptureFFmpegPipe Pipe;
+    TestEqual(TEXT("Finishing an unstarted pipe reports no exit code"), Pipe.Finish(), static_cast<int32>(INDEX_NONE));
+
+    TestTrue(TEXT("Process starts"), Pipe.Start(TEXT("cmd.exe"), TEXT("/c exit 3"), FString(), false, 0));
+    TArray64<uint8> Video;
+    Video.Init(0, 4096);
+    Pipe.PushVideo(MoveTemp(Video));
+    TestEqual(TEXT("The encoder's exit code is returned"), Pipe.Finish(), 3);
+    return true;
+}
+
+#endif
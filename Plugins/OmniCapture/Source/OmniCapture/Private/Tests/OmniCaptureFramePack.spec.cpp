@@ -0,0 +1,127 @@
+#include "Misc/AutomationTest.h"
+
+#include "OmniCaptureFramePack.h"
+#include "OmniCaptureImageWriter.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+    TArray64<uint8> MakePayload(int32 Size, uint8 Seed)
+    {
+        TArray64<uint8> Payload;
+        Payload.SetNumUninitialized(Size);
+        for (int32 Index = 0; Index < Size; ++Index)
+        {
+            Payload[Index] = static_cast<uint8>(Seed + Index * 7);
+        }
+        return Payload;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureFramePackRoundTripTest, "OmniCapture.FramePack.RoundTrip", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCaptureFramePackRoundTripTest::RunTest(const FString& Parameters)
+{
+    const FString Directory = FPaths::AutomationTransientDir() / TEXT("OmniCaptureFramePack");
+    IFileManager::Get().DeleteDirectory(*Directory, false, true);
+    const FString PackPath = Directory / (FString(TEXT("Pack")) + FOmniCaptureFramePackWriter::GetExtension());
+
+    const TArray64<uint8> Frame1 = MakePayload(5000, 1);
+    const TArray64<uint8> Frame0 = MakePayload(3000, 2);
+    const TArray64<uint8> Depth0 = MakePayload(700, 3);
+
+    FOmniCaptureFramePackWriter Writer;
+    TestTrue(TEXT("Pack opens"), Writer.Open(PackPath, 64 * 1024));
+    TestTrue(TEXT("Frames append out of order"), Writer.Append(1, TEXT("Pack_000001.png"), true, Frame1.GetData(), Frame1.Num())
+        && Writer.Append(0, TEXT("Pack_000000.png"), true, Frame0.GetData(), Frame0.Num())
+        && Writer.Append(0, TEXT("Pack_000000_Depth.png"), false, Depth0.GetData(), Depth0.Num()));
+    const int64 BytesBeforeReference = Writer.GetBytesWritten();
+    TestTrue(TEXT("A repeated frame references its source"), Writer.AppendReference(2, TEXT("Pack_000002.png"), true, TEXT("Pack_000001.png")));
+    TestFalse(TEXT("References need a source that is in the pack"), Writer.AppendReference(3, TEXT("Pack_000003.png"), true, TEXT("Missing.png")));
+    TestTrue(TEXT("A reference stores no payload"), Writer.GetBytesWritten() - BytesBeforeReference < 64);
+    TestTrue(TEXT("Bytes written excludes the preallocated tail"), Writer.GetBytesWritten() > Frame1.Num() + Frame0.Num() + Depth0.Num() && Writer.GetBytesWritten() < 64 * 1024);
+
+    {
+        // Still open, so there is no index yet: the reader has to walk the chunks and stop at the preallocated zeros.
+        FOmniCaptureFramePackReader Recovering;
+        TestTrue(TEXT("An unfinished pack opens"), Recovering.Open(PackPath));
+        TestTrue(TEXT("Its entries are recovered"), Recovering.WasRecovered() && Recovering.GetEntries().Num() == 4);
+        const FOmniCaptureFramePackEntry* Recovered = Recovering.FindEntry(TEXT("Pack_000002.png"));
+        TArray64<uint8> RecoveredBytes;
+        TestTrue(TEXT("Recovered references resolve to the source bytes"), Recovered && Recovering.ReadEntry(*Recovered, RecoveredBytes) && RecoveredBytes == Frame1);
+    }
+
+    TestTrue(TEXT("Pack closes"), Writer.Close());
+    TestEqual(TEXT("The tail is trimmed on close"), IFileManager::Get().FileSize(*PackPath), Writer.GetBytesWritten());
+
+    FOmniCaptureFramePackReader Reader;
+    TestTrue(TEXT("Closed pack opens"), Reader.Open(PackPath));
+    TestFalse(TEXT("The index is used"), Reader.WasRecovered());
+    TestEqual(TEXT("Every entry is indexed"), Reader.GetEntries().Num(), 4);
+
+    const TArray<int32> Primary = Reader.GetPrimaryEntriesInFrameOrder();
+    TestTrue(TEXT("Beauty frames come back in frame order"), Primary.Num() == 3 && Reader.GetEntries()[Primary[0]].FrameIndex == 0 && Reader.GetEntries()[Primary[1]].FrameIndex == 1 && Reader.GetEntries()[Primary[2]].FrameIndex == 2);
+
+    const FOmniCaptureFramePackEntry* Depth = Reader.FindEntry(TEXT("Pack_000000_Depth.png"));
+    TArray64<uint8> Read;
+    TestTrue(TEXT("Layers are found by name"), Depth && !Depth->bPrimary && Reader.ReadEntry(*Depth, Read));
+    TestTrue(TEXT("Payloads survive the pack"), Read == Depth0);
+
+    const FString ExtractDirectory = Directory / TEXT("Extracted");
+    int32 FilesWritten = 0;
+    TestTrue(TEXT("Pack extracts"), Reader.ExtractToDirectory(ExtractDirectory, &FilesWritten));
+    TestEqual(TEXT("Every entry becomes a file"), FilesWritten, 4);
+    TArray64<uint8> Extracted;
+    TestTrue(TEXT("Extracted files keep their bytes"), FFileHelper::LoadFileToArray(Extracted, *(ExtractDirectory / TEXT("Pack_000001.png"))) && Extracted == Frame1);
+    TestTrue(TEXT("References extract as full files"), FFileHelper::LoadFileToArray(Extracted, *(ExtractDirectory / TEXT("Pack_000002.png"))) && Extracted == Frame1);
+
+    Reader.Close();
+    IFileManager::Get().DeleteDirectory(*Directory, false, true);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureFramePackWriterTest, "OmniCapture.FramePack.ImageWriter", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCaptureFramePackWriterTest::RunTest(const FString& Parameters)
+{
+    const FString Directory = FPaths::AutomationTransientDir() / TEXT("OmniCaptureFramePackWriter");
+    IFileManager::Get().DeleteDirectory(*Directory, false, true);
+
+    FOmniCaptureSettings Settings;
+    Settings.OutputFileName = TEXT("Packed");
+    Settings.ImageFormat = EOmniCaptureImageFormat::Intermediate;
+    Settings.bWriteFramePack = true;
+    Settings.FramePackPreallocateMB = 1;
+
+    constexpr int32 FrameCount = 6;
+    {
+        FOmniCaptureImageWriter Writer;
+        Writer.Initialize(Settings, Directory);
+        for (int32 FrameIndex = 0; FrameIndex < FrameCount; ++FrameIndex)
+        {
+            TUniquePtr<TImagePixelData<FColor>> PixelData = MakeUnique<TImagePixelData<FColor>>(FIntPoint(32, 16));
+            PixelData->Pixels.Init(FColor(FrameIndex * 20, 10, 200, 255), 32 * 16);
+
+            TUniquePtr<FOmniCaptureFrame> Frame = MakeUnique<FOmniCaptureFrame>();
+            Frame->Metadata.FrameIndex = FrameIndex;
+            Frame->PixelData = MoveTemp(PixelData);
+            Frame->PixelDataType = EOmniCapturePixelDataType::Color8;
+            Writer.EnqueueFrame(MoveTemp(Frame), FString::Printf(TEXT("Packed_%06d%s"), FrameIndex, *Settings.GetImageFileExtension()));
+        }
+        Writer.Flush();
+        TestTrue(TEXT("The writer reports the pack size"), Writer.GetFramePackBytesWritten() > 0 && Writer.GetFramePackBytesWritten() == IFileManager::Get().FileSize(*Writer.GetFramePackPath()));
+    }
+
+    TArray<FString> LooseFiles;
+    IFileManager::Get().FindFiles(LooseFiles, *(Directory / (TEXT("Packed_*") + Settings.GetImageFileExtension())), true, false);
+    TestEqual(TEXT("No loose frame files"), LooseFiles.Num(), 0);
+
+    FOmniCaptureFramePackReader Reader;
+    TestTrue(TEXT("The capture pack opens"), Reader.Open(Directory / (Settings.OutputFileName + FOmniCaptureFramePackWriter::GetExtension())));
+    TestEqual(TEXT("Every frame is packed"), Reader.GetPrimaryEntriesInFrameOrder().Num(), FrameCount);
+    TestTrue(TEXT("Frames keep their file names"), Reader.FindEntry(FString::Printf(TEXT("Packed_%06d%s"), FrameCount - 1, *Settings.GetImageFileExtension())) != nullptr);
+
+    Reader.Close();
+    IFileManager::Get().DeleteDirectory(*Directory, false, true);
+    return true;
+}
@@ -0,0 +1,49 @@
+#include "Misc/AutomationTest.h"
+
+#include "OmniCaptureFramePool.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureFramePoolReuseTest, "OmniCapture.FramePool.ReusesBuffersWithinBudget", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCaptureFramePoolReuseTest::RunTest(const FString& Parameters)
+{
+    FOmniCaptureFramePool& Pool = FOmniCaptureFramePool::Get();
+    const int64 PreviousBudget = Pool.GetStats().BudgetBytes;
+
+    Pool.Configure(0);
+    Pool.Configure(64ll * 1024 * 1024);
+
+    const FIntPoint Size(1024, 512);
+    const FOmniCaptureFramePoolStats Before = Pool.GetStats();
+
+    TUniquePtr<TImagePixelData<FFloat16Color>> First = Pool.AcquirePixels<FFloat16Color>(Size);
+    TestEqual(TEXT("Acquired buffer holds every pixel"), First->Pixels.Num(), static_cast<int64>(Size.X) * Size.Y);
+    const FFloat16Color* FirstStorage = First->Pixels.GetData();
+    Pool.ReleasePixels(MoveTemp(First));
+
+    // A slightly smaller frame falls in the same size class and must reuse the allocation.
+    TUniquePtr<TImagePixelData<FFloat16Color>> Second = Pool.AcquirePixels<FFloat16Color>(FIntPoint(1020, 512));
+    TestEqual(TEXT("Same size class reuses the storage"), Second->Pixels.GetData(), FirstStorage);
+    Pool.ReleasePixels(MoveTemp(Second));
+
+    const FOmniCaptureFramePoolStats After = Pool.GetStats();
+    TestEqual(TEXT("One miss for the first acquire"), After.BufferMisses - Before.BufferMisses, 1ll);
+    TestEqual(TEXT("One hit for the second acquire"), After.BufferHits - Before.BufferHits, 1ll);
+    TestTrue(TEXT("Idle bytes stay within the budget"), After.PooledBytes <= After.BudgetBytes);
+
+    // A budget smaller than one buffer forces the pool to free rather than keep it.
+    Pool.Configure(1024);
+    Pool.ReleasePixels(Pool.AcquirePixels<FColor>(Size));
+    const FOmniCaptureFramePoolStats Tight = Pool.GetStats();
+    TestEqual(TEXT("Nothing is pooled beyond the budget"), Tight.PooledBytes, 0ll);
+    TestTrue(TEXT("Over-budget buffers are counted as discarded"), Tight.BuffersDiscarded > After.BuffersDiscarded);
+
+    TUniquePtr<FOmniCaptureFrame> Frame = Pool.AcquireFrame();
+    Frame->Metadata.FrameIndex = 42;
+    Pool.ReleaseFrame(MoveTemp(Frame));
+    TUniquePtr<FOmniCaptureFrame> Recycled = Pool.AcquireFrame();
+    TestEqual(TEXT("Recycled frames come back reset"), Recycled->Metadata.FrameIndex, 0);
+    Recycled.Reset();
+
+    Pool.Configure(0);
+    Pool.Configure(PreviousBudget);
+    return true;
+}
@@ -0,0 +1,138 @@
+#include "Misc/AutomationTest.h"
+
+#include "OmniCaptureImageWriter.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/Paths.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureImageWriterSlotTest, "OmniCapture.ImageWriter.TaskSlots", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCaptureImageWriterSlotTest::RunTest(const FString& Parameters)
+{
+    const FString Directory = FPaths::AutomationTransientDir() / TEXT("OmniCaptureWriterSlots");
+    IFileManager::Get().DeleteDirectory(*Directory, false, true);
+
+    FOmniCaptureSettings Settings;
+    Settings.OutputFileName = TEXT("Slots");
+    Settings.ImageFormat = EOmniCaptureImageFormat::Intermediate;
+    Settings.MaxPendingImageTasks = 2;
+
+    FOmniCaptureImageWriter Writer;
+    Writer.Initialize(Settings, Directory);
+
+    constexpr int32 FrameCount = 12;
+    for (int32 FrameIndex = 0; FrameIndex < FrameCount; ++FrameIndex)
+    {
+        // Every other frame is much larger, so small writes finish behind big ones and free their slots first.
+        const FIntPoint Size = (FrameIndex % 2) ? FIntPoint(16, 16) : FIntPoint(1024, 512);
+        TUniquePtr<TImagePixelData<FColor>> PixelData = MakeUnique<TImagePixelData<FColor>>(Size);
+        PixelData->Pixels.Init(FColor(FrameIndex, 0, 0, 255), static_cast<int64>(Size.X) * Size.Y);
+
+        TUniquePtr<FOmniCaptureFrame> Frame = MakeUnique<FOmniCaptureFrame>();
+        Frame->Metadata.FrameIndex = FrameIndex;
+        Frame->PixelData = MoveTemp(PixelData);
+        Frame->PixelDataType = EOmniCapturePixelDataType::Color8;
+        Writer.EnqueueFrame(MoveTemp(Frame), FString::Printf(TEXT("Slots_%06d%s"), FrameIndex, *Settings.GetImageFileExtension()));
+        TestTrue(TEXT("Never more tasks in flight than slots"), Writer.GetTaskStats().InFlightTasks <= Settings.MaxPendingImageTasks);
+    }
+
+    const double Deadline = FPlatformTime::Seconds() + 30.0;
+    while (Writer.GetTaskStats().InFlightTasks > 0 && FPlatformTime::Seconds() < Deadline)
+    {
+        FPlatformProcess::Sleep(0.001f);
+    }
+
+    const FOmniCaptureImageWriterStats Stats = Writer.GetTaskStats();
+    TestEqual(TEXT("Every task completed"), Stats.CompletedTasks, FrameCount);
+    TestEqual(TEXT("No task failed"), Stats.FailedTasks, 0);
+    TestTrue(TEXT("Peak stays within the slot count"), Stats.PeakInFlightTasks >= 1 && Stats.PeakInFlightTasks <= Settings.MaxPendingImageTasks);
+    TestTrue(TEXT("Encode latency is recorded"), Stats.AverageEncodeMilliseconds > 0.0 && Stats.MaxEncodeMilliseconds >= Stats.AverageEncodeMilliseconds);
+    TestTrue(TEXT("Files go through the I/O pool"), Stats.IOThreads == Settings.IOThreadCount && Stats.AverageIOMilliseconds > 0.0);
+    TestTrue(TEXT("Encode threads are capped by the slot count"), Stats.EncodeThreads >= 1 && Stats.EncodeThreads <= Settings.MaxPendingImageTasks);
+    TestEqual(TEXT("Every frame's metadata is recorded"), Writer.GetCapturedFrames().Num(), FrameCount);
+
+    TArray<FString> Written;
+    IFileManager::Get().FindFiles(Written, *(Directory / (TEXT("Slots_*") + Settings.GetImageFileExtension())), true, false);
+    TestEqual(TEXT("Every frame is on disk"), Written.Num(), FrameCount);
+
+    int64 BytesOnDisk = 0;
+    for (const FString& FileName : Written)
+    {
+        BytesOnDisk += IFileManager::Get().FileSize(*(Directory / FileName));
+    }
+    TestEqual(TEXT("The byte counter matches the files on disk"), Writer.GetBytesWritten(), BytesOnDisk);
+
+    Writer.Flush();
+    IFileManager::Get().DeleteDirectory(*Directory, false, true);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureImageWriterDedupTest, "OmniCapture.ImageWriter.DeduplicateFrames", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCaptureImageWriterDedupTest::RunTest(const FString& Parameters)
+{
+    const FString Directory = FPaths::AutomationTransientDir() / TEXT("OmniCaptureWriterDedup");
+
+    FOmniCaptureSettings Settings;
+    Settings.OutputFileName = TEXT("Dedup");
+    Settings.ImageFormat = EOmniCaptureImageFormat::Intermediate;
+    Settings.bDeduplicateFrames = true;
+    Settings.MaxPendingImageTasks = 4;
+    const FString Extension = Settings.GetImageFileExtension();
+
+    // Three runs of a held shot: frames 0-3 match, 4-5 match, 6 stands alone.
+    const uint8 Shades[] = { 10, 10, 10, 10, 80, 80, 150 };
+    constexpr int32 FrameCount = UE_ARRAY_COUNT(Shades);
+    auto MakeFrame = [&Shades](int32 FrameIndex)
+    {
+        TUniquePtr<TImagePixelData<FColor>> PixelData = MakeUnique<TImagePixelData<FColor>>(FIntPoint(64, 32));
+        PixelData->Pixels.Init(FColor(Shades[FrameIndex], 20, 30, 255), 64 * 32);
+
+        TUniquePtr<FOmniCaptureFrame> Frame = MakeUnique<FOmniCaptureFrame>();
+        Frame->Metadata.FrameIndex = FrameIndex;
+        Frame->PixelData = MoveTemp(PixelData);
+        Frame->PixelDataType = EOmniCapturePixelDataType::Color8;
+        return Frame;
+    };
+
+    // Enqueued in order by one caller, then the way several ring buffer workers deliver them: linked in order by the
+    // ordered stage, enqueued in whatever order the workers finish, here with repeats ahead of the frames they repeat.
+    const int32 InOrder[] = { 0, 1, 2, 3, 4, 5, 6 };
+    const int32 Scrambled[] = { 6, 3, 5, 1, 4, 2, 0 };
+    for (const int32* EnqueueOrder : { InOrder, Scrambled })
+    {
+        const bool bLinked = EnqueueOrder == Scrambled;
+        const TCHAR* Order = bLinked ? TEXT("out of order") : TEXT("in order");
+        IFileManager::Get().DeleteDirectory(*Directory, false, true);
+
+        FOmniCaptureImageWriter Writer;
+        Writer.Initialize(Settings, Directory);
+        TArray<TUniquePtr<FOmniCaptureFrame>> Frames;
+        for (int32 FrameIndex = 0; FrameIndex < FrameCount; ++FrameIndex)
+        {
+            Frames.Add(MakeFrame(FrameIndex));
+            if (bLinked)
+            {
+                Writer.LinkFrame(*Frames.Last());
+            }
+        }
+        for (int32 Position = 0; Position < FrameCount; ++Position)
+        {
+            const int32 FrameIndex = EnqueueOrder[Position];
+            Writer.EnqueueFrame(MoveTemp(Frames[FrameIndex]), FString::Printf(TEXT("Dedup_%06d%s"), FrameIndex, *Extension));
+        }
+        Writer.Flush();
+
+        const FOmniCaptureImageWriterStats Stats = Writer.GetTaskStats();
+        TestEqual(FString::Printf(TEXT("Repeated frames are counted (%s)"), Order), Stats.DuplicateFrames, 4);
+        TestEqual(FString::Printf(TEXT("Every frame completes (%s)"), Order), Stats.CompletedTasks, FrameCount);
+        TestEqual(FString::Printf(TEXT("No frame fails (%s)"), Order), Stats.FailedTasks, 0);
+
+        const int64 HeldSize = IFileManager::Get().FileSize(*(Directory / (TEXT("Dedup_000000") + Extension)));
+        TestTrue(FString::Printf(TEXT("The first frame of a run is encoded (%s)"), Order), HeldSize > 0);
+        TestEqual(FString::Printf(TEXT("Repeats get a file of their own (%s)"), Order), IFileManager::Get().FileSize(*(Directory / (TEXT("Dedup_000003") + Extension))), HeldSize);
+        TestEqual(FString::Printf(TEXT("A repeat enqueued before its run's first frame still gets its file (%s)"), Order), IFileManager::Get().FileSize(*(Directory / (TEXT("Dedup_000005") + Extension))), IFileManager::Get().FileSize(*(Directory / (TEXT("Dedup_000004") + Extension))));
+        TestTrue(FString::Printf(TEXT("A changed frame is encoded again (%s)"), Order), IFileManager::Get().FileSize(*(Directory / (TEXT("Dedup_000006") + Extension))) > 0);
+    }
+
+    IFileManager::Get().DeleteDirectory(*Directory, false, true);
+    return true;
+}
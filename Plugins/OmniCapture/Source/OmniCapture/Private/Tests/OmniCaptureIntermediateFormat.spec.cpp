@@ -0,0 +1,150 @@
+#include "Misc/AutomationTest.h"
+
+#include "OmniCaptureIntermediateFormat.h"
+#include "OmniCaptureTranscoder.h"
+#include "HAL/FileManager.h"
+#include "Math/RandomStream.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+    /** Runs, gradients, repeats and noise, so every QOI op shows up. */
+    TUniquePtr<TImagePixelData<FColor>> BuildColorFrame(const FIntPoint& Size, int32 Seed)
+    {
+        TUniquePtr<TImagePixelData<FColor>> PixelData = MakeUnique<TImagePixelData<FColor>>(Size);
+        PixelData->Pixels.SetNumUninitialized(static_cast<int64>(Size.X) * Size.Y);
+        FRandomStream Random(Seed);
+        for (int32 Y = 0; Y < Size.Y; ++Y)
+        {
+            for (int32 X = 0; X < Size.X; ++X)
+            {
+                const int64 Index = static_cast<int64>(Y) * Size.X + X;
+                FColor& Pixel = PixelData->Pixels[Index];
+                switch ((X / 7 + Y) % 4)
+                {
+                case 0:
+                    Pixel = FColor(40, 80, 120, 255);
+                    break;
+                case 1:
+                    Pixel = FColor(static_cast<uint8>(X), static_cast<uint8>(Y * 3), static_cast<uint8>(X + Y), 255);
+                    break;
+                case 2:
+                    Pixel = Index >= 9 ? PixelData->Pixels[Index - 9] : FColor::Black;
+                    break;
+                default:
+                    Pixel = FColor(Random.RandRange(0, 255), Random.RandRange(0, 255), Random.RandRange(0, 255), Random.RandRange(0, 255));
+                    break;
+                }
+            }
+        }
+        return PixelData;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureIntermediateRoundTripTest, "OmniCapture.Intermediate.RoundTrip", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCaptureIntermediateRoundTripTest::RunTest(const FString& Parameters)
+{
+    const FIntPoint Size(131, 67);
+    TUniquePtr<TImagePixelData<FColor>> Color = BuildColorFrame(Size, 7);
+
+    TArray64<uint8> QOI;
+    FOmniCaptureIntermediateFormat::EncodeQOI(Color->Pixels.GetData(), Size, QOI);
+    TestTrue(TEXT("QOI stream starts with the magic"), QOI.Num() > 22 && QOI[0] == 'q' && QOI[1] == 'o' && QOI[2] == 'i' && QOI[3] == 'f');
+    TestTrue(TEXT("QOI is smaller than the raw frame"), QOI.Num() < Color->Pixels.Num() * static_cast<int64>(sizeof(FColor)));
+
+    TArray<FColor> Decoded;
+    Decoded.SetNumUninitialized(Color->Pixels.Num());
+    TestTrue(TEXT("QOI decodes"), FOmniCaptureIntermediateFormat::DecodeQOI(QOI.GetData(), QOI.Num(), Size, Decoded.GetData()));
+    TestTrue(TEXT("QOI is lossless"), FMemory::Memcmp(Decoded.GetData(), Color->Pixels.GetData(), Decoded.Num() * sizeof(FColor)) == 0);
+    TestFalse(TEXT("A truncated stream is rejected"), FOmniCaptureIntermediateFormat::DecodeQOI(QOI.GetData(), QOI.Num() / 2, Size, Decoded.GetData()));
+    TestFalse(TEXT("A size mismatch is rejected"), FOmniCaptureIntermediateFormat::DecodeQOI(QOI.GetData(), QOI.Num(), FIntPoint(Size.X + 1, Size.Y), Decoded.GetData()));
+
+    const FString Directory = FPaths::AutomationTransientDir() / TEXT("OmniCaptureIntermediate");
+    IFileManager::Get().MakeDirectory(*Directory, true);
+
+    const FString ColorPath = Directory / (FString(TEXT("Color")) + FOmniCaptureIntermediateFormat::GetExtension());
+    TestTrue(TEXT("8-bit frame writes"), FOmniCaptureIntermediateFormat::Write(ColorPath, *Color, false, EOmniCapturePixelPrecision::Unknown, EOmniCapturePixelDataType::Color8));
+
+    TUniquePtr<FImagePixelData> Read;
+    bool bLinear = true;
+    EOmniCapturePixelPrecision Precision = EOmniCapturePixelPrecision::Unknown;
+    EOmniCapturePixelDataType PixelDataType = EOmniCapturePixelDataType::Unknown;
+    TestTrue(TEXT("8-bit frame reads"), FOmniCaptureIntermediateFormat::Read(ColorPath, Read, bLinear, Precision, PixelDataType));
+    TestTrue(TEXT("8-bit frame keeps its type"), !bLinear && PixelDataType == EOmniCapturePixelDataType::Color8 && Read.IsValid() && Read->GetSize() == Size);
+    if (Read.IsValid() && PixelDataType == EOmniCapturePixelDataType::Color8)
+    {
+        const TImagePixelData<FColor>* ReadColor = static_cast<const TImagePixelData<FColor>*>(Read.Get());
+        TestTrue(TEXT("8-bit pixels survive the file"), FMemory::Memcmp(ReadColor->Pixels.GetData(), Color->Pixels.GetData(), Color->Pixels.Num() * sizeof(FColor)) == 0);
+    }
+
+    TImagePixelData<FFloat16Color> Half(Size);
+    Half.Pixels.SetNumUninitialized(static_cast<int64>(Size.X) * Size.Y);
+    for (int64 Index = 0; Index < Half.Pixels.Num(); ++Index)
+    {
+        Half.Pixels[Index] = FFloat16Color(FLinearColor(Index * 0.01f, -1.5f, 65000.0f, 1.0f));
+    }
+
+    const FString HalfPath = Directory / (FString(TEXT("Half")) + FOmniCaptureIntermediateFormat::GetExtension());
+    TestTrue(TEXT("Half frame writes"), FOmniCaptureIntermediateFormat::Write(HalfPath, Half, true, EOmniCapturePixelPrecision::HalfFloat, EOmniCapturePixelDataType::LinearColorFloat16));
+    TestTrue(TEXT("Half frame reads"), FOmniCaptureIntermediateFormat::Read(HalfPath, Read, bLinear, Precision, PixelDataType));
+    TestTrue(TEXT("Half frame keeps its type"), bLinear && Precision == EOmniCapturePixelPrecision::HalfFloat && PixelDataType == EOmniCapturePixelDataType::LinearColorFloat16);
+    if (Read.IsValid() && PixelDataType == EOmniCapturePixelDataType::LinearColorFloat16)
+    {
+        const TImagePixelData<FFloat16Color>* ReadHalf = static_cast<const TImagePixelData<FFloat16Color>*>(Read.Get());
+        TestTrue(TEXT("Half pixels are stored bit for bit"), FMemory::Memcmp(ReadHalf->Pixels.GetData(), Half.Pixels.GetData(), Half.Pixels.Num() * sizeof(FFloat16Color)) == 0);
+    }
+
+    IFileManager::Get().DeleteDirectory(*Directory, false, true);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureIntermediateTranscodeTest, "OmniCapture.Intermediate.TranscodeResumes", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCaptureIntermediateTranscodeTest::RunTest(const FString& Parameters)
+{
+    const FString Directory = FPaths::AutomationTransientDir() / TEXT("OmniCaptureTranscode");
+    IFileManager::Get().DeleteDirectory(*Directory, false, true);
+    IFileManager::Get().MakeDirectory(*Directory, true);
+
+    FOmniCaptureSettings Settings;
+    Settings.OutputFileName = TEXT("Take");
+    Settings.ImageFormat = EOmniCaptureImageFormat::Intermediate;
+    Settings.IntermediateTranscodeFormat = EOmniCaptureImageFormat::PNG;
+
+    const FIntPoint Size(64, 32);
+    const FString Extension = FOmniCaptureIntermediateFormat::GetExtension();
+    for (int32 FrameIndex = 0; FrameIndex < 6; ++FrameIndex)
+    {
+        const FString Stem = FString::Printf(TEXT("Take_%06d"), FrameIndex);
+        TUniquePtr<TImagePixelData<FColor>> Frame = BuildColorFrame(Size, FrameIndex);
+        FOmniCaptureIntermediateFormat::Write(Directory / (Stem + Extension), *Frame, false, EOmniCapturePixelPrecision::Unknown, EOmniCapturePixelDataType::Color8);
+        FOmniCaptureIntermediateFormat::Write(Directory / (Stem + TEXT("_Depth") + Extension), *Frame, false, EOmniCapturePixelPrecision::Unknown, EOmniCapturePixelDataType::Color8);
+    }
+    TestEqual(TEXT("Beauty files and layers group into frames"), FOmniCaptureTranscoder::CountPendingFrames(Settings, Directory), 6);
+
+    // An interrupted pass: frame 2 already landed and lost its intermediates, frame 4 has an unreadable beauty file.
+    IFileManager::Get().Delete(*(Directory / (TEXT("Take_000002") + Extension)));
+    IFileManager::Get().Delete(*(Directory / (TEXT("Take_000002_Depth") + Extension)));
+    TArray<uint8> Garbage;
+    Garbage.Init(0xCD, 64);
+    TUniquePtr<FArchive> Corrupt(IFileManager::Get().CreateFileWriter(*(Directory / (TEXT("Take_000004") + Extension))));
+    Corrupt->Serialize(Garbage.GetData(), Garbage.Num());
+    Corrupt.Reset();
+
+    FOmniCaptureTranscodeResult Result = FOmniCaptureTranscoder::TranscodeSequence(Settings, Directory);
+    TestEqual(TEXT("Readable frames transcode"), Result.FramesTranscoded, 4);
+    TestEqual(TEXT("The unreadable frame fails"), Result.FramesFailed, 1);
+    TestEqual(TEXT("The failed frame stays pending"), Result.FramesPending, 1);
+    TestTrue(TEXT("Beauty PNG written"), FPaths::FileExists(Directory / TEXT("Take_000000.png")));
+    TestTrue(TEXT("Layer PNG written beside it"), FPaths::FileExists(Directory / TEXT("Take_000000_Depth.png")));
+    TestFalse(TEXT("Transcoded intermediates are removed"), FPaths::FileExists(Directory / (TEXT("Take_000000") + Extension)));
+
+    // Replace the bad frame and resume: only it is left to do.
+    TUniquePtr<TImagePixelData<FColor>> Frame = BuildColorFrame(Size, 4);
+    FOmniCaptureIntermediateFormat::Write(Directory / (TEXT("Take_000004") + Extension), *Frame, false, EOmniCapturePixelPrecision::Unknown, EOmniCapturePixelDataType::Color8);
+    Result = FOmniCaptureTranscoder::TranscodeSequence(Settings, Directory);
+    TestEqual(TEXT("The resumed pass only converts the remaining frame"), Result.FramesTranscoded, 1);
+    TestTrue(TEXT("The sequence is complete"), Result.IsComplete() && FPaths::FileExists(Directory / TEXT("Take_000004_Depth.png")));
+
+    IFileManager::Get().DeleteDirectory(*Directory, false, true);
+    return true;
+}
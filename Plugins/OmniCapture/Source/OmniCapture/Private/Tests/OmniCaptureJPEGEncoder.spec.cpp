@@ -0,0 +1,83 @@
+#include "Misc/AutomationTest.h"
+
+#include "OmniCaptureJPEGEncoder.h"
+#include "IImageWrapper.h"
+#include "IImageWrapperModule.h"
+#include "Modules/ModuleManager.h"
+
+namespace
+{
+    bool DecodeJPEG(const TArray64<uint8>& JPEG, TArray64<uint8>& OutRaw)
+    {
+        IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(TEXT("ImageWrapper"));
+        TSharedPtr<IImageWrapper> Wrapper = ImageWrapperModule.CreateImageWrapper(EImageFormat::JPEG);
+        return Wrapper.IsValid() && Wrapper->SetCompressed(JPEG.GetData(), JPEG.Num()) && Wrapper->GetRaw(ERGBFormat::BGRA, 8, OutRaw);
+    }
+
+    int32 CountRestartMarkers(const TArray64<uint8>& JPEG)
+    {
+        int32 Count = 0;
+        for (int64 Index = 0; Index + 1 < JPEG.Num(); ++Index)
+        {
+            Count += JPEG[Index] == 0xFF && JPEG[Index + 1] >= 0xD0 && JPEG[Index + 1] <= 0xD7 ? 1 : 0;
+        }
+        return Count;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureJPEGEncoderStripsTest, "OmniCapture.JPEGEncoder.StripsDecodeLikeOneStream", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCaptureJPEGEncoderStripsTest::RunTest(const FString& Parameters)
+{
+    if (!FOmniCaptureJPEGEncoder::IsAvailable())
+    {
+        AddInfo(TEXT("Built without libjpeg-turbo; the writer uses IImageWrapper instead."));
+        return true;
+    }
+
+    // Neither dimension is a multiple of the MCU size, so the right edge is padded and the last strip is short.
+    const FIntPoint Size(301, 203);
+    TArray64<FColor> Pixels;
+    Pixels.SetNumUninitialized(static_cast<int64>(Size.X) * Size.Y);
+    for (int32 Y = 0; Y < Size.Y; ++Y)
+    {
+        for (int32 X = 0; X < Size.X; ++X)
+        {
+            Pixels[static_cast<int64>(Y) * Size.X + X] = FColor(X * 255 / Size.X, Y * 255 / Size.Y, (X ^ Y) & 0xFF, 255);
+        }
+    }
+
+    const EOmniCaptureJPEGSubsampling Modes[] = { EOmniCaptureJPEGSubsampling::Subsampling420, EOmniCaptureJPEGSubsampling::Subsampling422, EOmniCaptureJPEGSubsampling::Subsampling444 };
+    for (EOmniCaptureJPEGSubsampling Mode : Modes)
+    {
+        FOmniCaptureJPEGEncodeOptions Serial;
+        Serial.Subsampling = Mode;
+        Serial.MaxThreads = 1;
+
+        FOmniCaptureJPEGEncodeOptions Striped = Serial;
+        Striped.MaxThreads = 4;
+        Striped.MinStripPixels = Size.X * 16;
+
+        TArray64<uint8> SerialJPEG;
+        TArray64<uint8> StripedJPEG;
+        TestTrue(TEXT("Serial encode succeeds"), FOmniCaptureJPEGEncoder::Encode(Size, Pixels.GetData(), Serial, SerialJPEG));
+        TestTrue(TEXT("Striped encode succeeds"), FOmniCaptureJPEGEncoder::Encode(Size, Pixels.GetData(), Striped, StripedJPEG));
+        TestEqual(TEXT("A single stream has no restart markers"), CountRestartMarkers(SerialJPEG), 0);
+        TestTrue(TEXT("Strips are joined with restart markers"), CountRestartMarkers(StripedJPEG) > 1);
+
+        TArray64<uint8> SerialRaw;
+        TArray64<uint8> StripedRaw;
+        TestTrue(TEXT("Serial JPEG decodes"), DecodeJPEG(SerialJPEG, SerialRaw));
+        TestTrue(TEXT("Striped JPEG decodes"), DecodeJPEG(StripedJPEG, StripedRaw));
+        TestTrue(TEXT("Strips decode to the same pixels as one stream"), SerialRaw.Num() == Pixels.Num() * 4 && SerialRaw == StripedRaw);
+    }
+
+    FOmniCaptureJPEGEncodeOptions Low;
+    Low.Quality = 20;
+    FOmniCaptureJPEGEncodeOptions High;
+    High.Quality = 95;
+    TArray64<uint8> LowJPEG;
+    TArray64<uint8> HighJPEG;
+    TestTrue(TEXT("Quality changes the file size"), FOmniCaptureJPEGEncoder::Encode(Size, Pixels.GetData(), Low, LowJPEG)
+        && FOmniCaptureJPEGEncoder::Encode(Size, Pixels.GetData(), High, HighJPEG) && LowJPEG.Num() < HighJPEG.Num());
+    return true;
+}
@@ -0,0 +1,304 @@
+#include "Misc/AutomationTest.h"
+
+#include "OmniCaptureMP4Writer.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+    uint32 ReadBigEndian32(const TArray<uint8>& Bytes, int64 Offset)
+    {
+        return (static_cast<uint32>(Bytes[Offset]) << 24) | (static_cast<uint32>(Bytes[Offset + 1]) << 16) | (static_cast<uint32>(Bytes[Offset + 2]) << 8) | Bytes[Offset + 3];
+    }
+
+    FString ReadFourCC(const TArray<uint8>& Bytes, int64 Offset)
+    {
+        return FString::Printf(TEXT("%c%c%c%c"), Bytes[Offset], Bytes[Offset + 1], Bytes[Offset + 2], Bytes[Offset + 3]);
+    }
+
+    /** Top-level box types in file order, with the offset of each; stops at the first malformed size. */
+    TArray<TPair<FString, int64>> ReadTopLevelBoxes(const TArray<uint8>& Bytes)
+    {
+        TArray<TPair<FString, int64>> Boxes;
+        int64 Offset = 0;
+        while (Offset + 8 <= Bytes.Num())
+        {
+            uint64 Size = ReadBigEndian32(Bytes, Offset);
+            if (Size == 1 && Offset + 16 <= Bytes.Num())
+            {
+                Size = (static_cast<uint64>(ReadBigEndian32(Bytes, Offset + 8)) << 32) | ReadBigEndian32(Bytes, Offset + 12);
+            }
+            if (Size < 8 || Offset + static_cast<int64>(Size) > Bytes.Num())
+            {
+                break;
+            }
+            Boxes.Add({ ReadFourCC(Bytes, Offset + 4), Offset });
+            Offset += Size;
+        }
+        return Boxes;
+    }
+
+    /** Offset just past the type of the first box named Type; the canned payloads never contain these names. */
+    int64 FindBoxPayload(const TArray<uint8>& Bytes, const char* Type)
+    {
+        for (int64 Offset = 4; Offset + 4 <= Bytes.Num(); ++Offset)
+        {
+            if (FMemory::Memcmp(Bytes.GetData() + Offset, Type, 4) == 0)
+            {
+                return Offset + 4;
+            }
+        }
+        return INDEX_NONE;
+    }
+
+    bool MatchesAt(const TArray<uint8>& Bytes, int64 Offset, const TArray<uint8>& Expected)
+    {
+        return Offset != INDEX_NONE && Offset + Expected.Num() <= Bytes.Num() && FMemory::Memcmp(Bytes.GetData() + Offset, Expected.GetData(), Expected.Num()) == 0;
+    }
+
+    TArray<uint8> LoadFile(const FString& Path)
+    {
+        TArray<uint8> Bytes;
+        FFileHelper::LoadFileToArray(Bytes, *Path);
+        return Bytes;
+    }
+
+    const TArray<uint8> GH264Header = { 0, 0, 0, 1, 0x67, 0x64, 0x00, 0x1F, 0xAE, 0, 0, 0, 1, 0x68, 0xEE, 0x3C, 0x80 };
+    const TArray<uint8> GH264Idr = { 0, 0, 0, 1, 0x09, 0x10, 0, 0, 0, 1, 0x65, 0x88, 0x84, 0x21, 0xA0 };
+    const TArray<uint8> GH264NonIdr = { 0, 0, 1, 0x41, 0x9A, 0x02, 0x04 };
+
+    constexpr int32 GFrameCount = 9;
+    constexpr int32 GAudioChannels = 4;
+    constexpr int32 GAudioFramesPerVideoFrame = 1600;
+
+    /** Nine 30 fps H.264 frames with a key frame every third and first-order ambisonic audio alongside. */
+    void WriteH264Capture(FOmniCaptureMP4Writer& Writer)
+    {
+        Writer.AddVideo(GH264Header.GetData(), GH264Header.Num(), false, 0.0);
+
+        TArray<int16> Audio;
+        Audio.Init(0x1234, GAudioFramesPerVideoFrame * GAudioChannels);
+        for (int32 FrameIndex = 0; FrameIndex < GFrameCount; ++FrameIndex)
+        {
+            const double Timestamp = 10.0 + FrameIndex / 30.0;
+            const TArray<uint8>& Frame = FrameIndex % 3 == 0 ? GH264Idr : GH264NonIdr;
+            Writer.AddVideo(Frame.GetData(), Frame.Num(), FrameIndex % 3 == 0, Timestamp);
+            Writer.AddAudio(Audio.GetData(), GAudioFramesPerVideoFrame, 48000, GAudioChannels, Timestamp);
+        }
+    }
+
+    FOmniCaptureMP4Config MakeH264Config()
+    {
+        FOmniCaptureMP4Config Config;
+        Config.Codec = EOmniCaptureMP4Codec::H264;
+        Config.Width = 64;
+        Config.Height = 32;
+        Config.FrameRate = 30.0;
+        Config.bWithAudio = true;
+        Config.AudioSampleRate = 48000;
+        Config.AudioChannels = GAudioChannels;
+        Config.FragmentSeconds = 0.1;
+        Config.Spherical.bEnabled = true;
+        Config.Spherical.StereoMode = 1;
+        Config.Spherical.bAmbisonicAudio = true;
+        return Config;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureMP4WriterFragmentedTest, "OmniCapture.MP4Writer.FragmentedH264", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCaptureMP4WriterFragmentedTest::RunTest(const FString& Parameters)
+{
+    const FString Directory = FPaths::ConvertRelativePathToFull(FPaths::AutomationTransientDir() / TEXT("OmniCaptureMP4Writer"));
+    const FString Path = Directory / TEXT("fragmented.mp4");
+
+    FOmniCaptureMP4Writer Writer;
+    TestTrue(TEXT("Writer opens"), Writer.Open(Path, MakeH264Config()));
+    WriteH264Capture(Writer);
+    TestEqual(TEXT("Every frame became a sample"), Writer.GetVideoSampleCount(), GFrameCount);
+    TestTrue(TEXT("Writer closes"), Writer.Close(false));
+    TestEqual(TEXT("A fragment per key frame interval"), Writer.GetFragmentCount(), 3);
+
+    const TArray<uint8> Bytes = LoadFile(Path);
+    const TArray<TPair<FString, int64>> Boxes = ReadTopLevelBoxes(Bytes);
+    TArray<FString> Types;
+    for (const TPair<FString, int64>& Box : Boxes)
+    {
+        Types.Add(Box.Key);
+    }
+    TestEqual(TEXT("Top-level layout"), FString::Join(Types, TEXT(",")), FString(TEXT("ftyp,moov,moof,mdat,moof,mdat,moof,mdat")));
+    TestEqual(TEXT("Boxes cover the whole file"), Writer.GetBytesWritten(), static_cast<int64>(Bytes.Num()));
+
+    // avcC: version, profile/compat/level from the SPS, 4-byte lengths, one SPS and one PPS, then the High profile extension.
+    const int64 AvcC = FindBoxPayload(Bytes, "avcC");
+    TestTrue(TEXT("avcC header"), MatchesAt(Bytes, AvcC, { 0x01, 0x64, 0x00, 0x1F, 0xFF, 0xE1, 0x00, 0x05, 0x67, 0x64, 0x00, 0x1F, 0xAE, 0x01, 0x00, 0x04, 0x68, 0xEE, 0x3C, 0x80 }));
+    TestTrue(TEXT("avcC High profile extension"), MatchesAt(Bytes, AvcC + 20, { 0xFD, 0xF8, 0xF8, 0x00 }));
+
+    const int64 St3d = FindBoxPayload(Bytes, "st3d");
+    TestTrue(TEXT("st3d marks top-bottom stereo"), MatchesAt(Bytes, St3d, { 0, 0, 0, 0, 1 }));
+    TestTrue(TEXT("sv3d is written"), FindBoxPayload(Bytes, "sv3d") != INDEX_NONE);
+    TestTrue(TEXT("Equirectangular projection"), FindBoxPayload(Bytes, "equi") != INDEX_NONE);
+    const int64 SA3D = FindBoxPayload(Bytes, "SA3D");
+    TestTrue(TEXT("SA3D describes first-order ambisonics"), MatchesAt(Bytes, SA3D, { 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 4 }));
+
+    // Samples are length-prefixed, without the access unit delimiter or the parameter sets.
+    const int64 FirstPayload = Boxes.Num() > 3 ? Boxes[3].Value + 8 : INDEX_NONE;
+    TestTrue(TEXT("First sample is a length-prefixed IDR"), MatchesAt(Bytes, FirstPayload, { 0x00, 0x00, 0x00, 0x05, 0x65, 0x88, 0x84, 0x21, 0xA0, 0x00, 0x00, 0x00, 0x04, 0x41 }));
+
+    IFileManager::Get().DeleteDirectory(*Directory, false, true);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureMP4WriterFastStartTest, "OmniCapture.MP4Writer.FastStart", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCaptureMP4WriterFastStartTest::RunTest(const FString& Parameters)
+{
+    const FString Directory = FPaths::ConvertRelativePathToFull(FPaths::AutomationTransientDir() / TEXT("OmniCaptureMP4Writer"));
+    const FString Path = Directory / TEXT("faststart.mp4");
+
+    FOmniCaptureMP4Writer Writer;
+    TestTrue(TEXT("Writer opens"), Writer.Open(Path, MakeH264Config()));
+    WriteH264Capture(Writer);
+    TestTrue(TEXT("Writer closes"), Writer.Close(true));
+    TestFalse(TEXT("Temporary file is gone"), FPaths::FileExists(Path + TEXT(".faststart")));
+
+    const TArray<uint8> Bytes = LoadFile(Path);
+    const TArray<TPair<FString, int64>> Boxes = ReadTopLevelBoxes(Bytes);
+    TArray<FString> Types;
+    for (const TPair<FString, int64>& Box : Boxes)
+    {
+        Types.Add(Box.Key);
+    }
+    TestEqual(TEXT("Progressive layout"), FString::Join(Types, TEXT(",")), FString(TEXT("ftyp,moov,mdat")));
+    TestEqual(TEXT("No fragments remain"), FindBoxPayload(Bytes, "moof"), static_cast<int64>(INDEX_NONE));
+
+    // The first stsz/stss/co64 belong to the video track.
+    const int64 Stsz = FindBoxPayload(Bytes, "stsz");
+    TestEqual(TEXT("Every frame is in the sample table"), Stsz != INDEX_NONE ? ReadBigEndian32(Bytes, Stsz + 8) : 0u, static_cast<uint32>(GFrameCount));
+    const int64 Stss = FindBoxPayload(Bytes, "stss");
+    TestEqual(TEXT("Every third frame is a sync sample"), Stss != INDEX_NONE ? ReadBigEndian32(Bytes, Stss + 4) : 0u, 3u);
+    const int64 Co64 = FindBoxPayload(Bytes, "co64");
+    const int64 MdatPayload = Boxes.Num() == 3 ? Boxes[2].Value + 8 : INDEX_NONE;
+    TestEqual(TEXT("First chunk starts the mdat"), Co64 != INDEX_NONE ? static_cast<int64>(ReadBigEndian32(Bytes, Co64 + 12)) : 0, MdatPayload);
+    TestTrue(TEXT("First sample is the IDR"), MatchesAt(Bytes, MdatPayload, { 0x00, 0x00, 0x00, 0x05, 0x65 }));
+
+    IFileManager::Get().DeleteDirectory(*Directory, false, true);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureMP4WriterHEVCTest, "OmniCapture.MP4Writer.HEVCConfiguration", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCaptureMP4WriterHEVCTest::RunTest(const FString& Parameters)
+{
+    const FString Directory = FPaths::ConvertRelativePathToFull(FPaths::AutomationTransientDir() / TEXT("OmniCaptureMP4Writer"));
+    const FString Path = Directory / TEXT("hevc.mp4");
+
+    // Main 10, level 3.1, 64x64 4:2:0; the SPS carries emulation-prevention bytes.
+    const TArray<uint8> KeyFrame = {
+        0, 0, 0, 1, 0x40, 0x01, 0x0C, 0x01, 0xFF, 0xFF,
+        0, 0, 0, 1, 0x42, 0x01, 0x01, 0x01, 0x60, 0x00, 0x00, 0x03, 0x00, 0x90, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00, 0x5D, 0xA0, 0x20, 0x81, 0x04, 0xDC,
+        0, 0, 0, 1, 0x44, 0x01, 0xC1, 0x72,
+        0, 0, 1, 0x26, 0x01, 0xAF, 0x10 };
+    const TArray<uint8> Trailing = { 0, 0, 1, 0x02, 0x01, 0xD0, 0x08 };
+
+    FOmniCaptureMP4Config Config;
+    Config.Codec = EOmniCaptureMP4Codec::HEVC;
+    Config.Width = 64;
+    Config.Height = 64;
+    Config.bConstantFrameRate = false;
+
+    FOmniCaptureMP4Writer Writer;
+    TestTrue(TEXT("Writer opens"), Writer.Open(Path, Config));
+    TestFalse(TEXT("Frames before the first key frame are dropped"), Writer.AddVideo(Trailing.GetData(), Trailing.Num(), false, 0.0));
+    TestTrue(TEXT("Key frame is accepted"), Writer.AddVideo(KeyFrame.GetData(), KeyFrame.Num(), true, 1.0));
+    TestTrue(TEXT("Trailing frame is accepted"), Writer.AddVideo(Trailing.GetData(), Trailing.Num(), false, 1.05));
+    TestTrue(TEXT("Writer closes"), Writer.Close(false));
+
+    const TArray<uint8> Bytes = LoadFile(Path);
+    TestTrue(TEXT("Sample entry is hvc1"), FindBoxPayload(Bytes, "hvc1") != INDEX_NONE);
+    const int64 HvcC = FindBoxPayload(Bytes, "hvcC");
+    TestTrue(TEXT("hvcC profile, tier and level"), MatchesAt(Bytes, HvcC, { 0x01, 0x01, 0x60, 0x00, 0x00, 0x00, 0x90, 0x00, 0x00, 0x00, 0x00, 0x00, 0x5D }));
+    TestTrue(TEXT("hvcC chroma format and bit depths"), MatchesAt(Bytes, HvcC + 13, { 0xF0, 0x00, 0xFC, 0xFD, 0xFA, 0xFA, 0x00, 0x00, 0x0F, 0x03 }));
+    TestTrue(TEXT("hvcC VPS array"), MatchesAt(Bytes, HvcC + 23, { 0xA0, 0x00, 0x01, 0x00, 0x06, 0x40, 0x01 }));
+
+    // With variable frame rate the first sample lasts until the next timestamp: 0.05 s at 90 kHz.
+    const int64 Trun = FindBoxPayload(Bytes, "trun");
+    TestEqual(TEXT("Two samples in the fragment"), Trun != INDEX_NONE ? ReadBigEndian32(Bytes, Trun + 4) : 0u, 2u);
+    TestEqual(TEXT("Duration follows the timestamps"), Trun != INDEX_NONE ? ReadBigEndian32(Bytes, Trun + 12) : 0u, 4500u);
+
+    IFileManager::Get().DeleteDirectory(*Directory, false, true);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureMP4WriterAudioOriginTest, "OmniCapture.MP4Writer.AudioBeforeVideoOrigin", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCaptureMP4WriterAudioOriginTest::RunTest(const FString& Parameters)
+{
+    const FString Directory = FPaths::ConvertRelativePathToFull(FPaths::AutomationTransientDir() / TEXT("OmniCaptureMP4Writer"));
+    const FString Path = Directory / TEXT("audioorigin.mp4");
+
+    FOmniCaptureMP4Config Config = MakeH264Config();
+    Config.Spherical.bEnabled = false;
+    FOmniCaptureMP4Writer Writer;
+    TestTrue(TEXT("Writer opens"), Writer.Open(Path, Config));
+
+    // A later segment: the first frame is 100 s into the capture and the recorder started half a second before it.
+    constexpr double VideoOrigin = 100.0;
+    constexpr double AudioOrigin = VideoOrigin - 0.5;
+    TArray<int16> Audio;
+    Audio.Init(0x1234, GAudioFramesPerVideoFrame * GAudioChannels);
+    Writer.AddVideo(GH264Header.GetData(), GH264Header.Num(), false, 0.0);
+    Writer.AddVideo(GH264Idr.GetData(), GH264Idr.Num(), true, VideoOrigin);
+    for (int32 PacketIndex = 0; PacketIndex < 45; ++PacketIndex)
+    {
+        Writer.AddAudio(Audio.GetData(), GAudioFramesPerVideoFrame, 48000, GAudioChannels, AudioOrigin + PacketIndex / 30.0);
+    }
+    for (int32 FrameIndex = 1; FrameIndex < 30; ++FrameIndex)
+    {
+        Writer.AddVideo(GH264NonIdr.GetData(), GH264NonIdr.Num(), false, VideoOrigin + FrameIndex / 30.0);
+    }
+
+    // The half second recorded before the first frame is trimmed; the second that follows it is kept whole.
+    TestEqual(TEXT("Audio starts at the first frame"), Writer.GetAudioFrameCount(), static_cast<int64>(48000));
+    TestTrue(TEXT("Writer closes"), Writer.Close(true));
+
+    TestTrue(TEXT("The file has an audio track"), FindBoxPayload(LoadFile(Path), "soun") != INDEX_NONE);
+
+    IFileManager::Get().DeleteDirectory(*Directory, false, true);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureMP4WriterAudioFormatTest, "OmniCapture.MP4Writer.AudioFormatFromConfig", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCaptureMP4WriterAudioFormatTest::RunTest(const FString& Parameters)
+{
+    const FString Directory = FPaths::ConvertRelativePathToFull(FPaths::AutomationTransientDir() / TEXT("OmniCaptureMP4Writer"));
+    const FString Path = Directory / TEXT("audioformat.mp4");
+
+    FOmniCaptureMP4Config Config = MakeH264Config();
+    Config.Spherical.bEnabled = false;
+    Config.AudioSampleRate = 44100;
+    Config.AudioChannels = 6;
+    FOmniCaptureMP4Writer Writer;
+    TestTrue(TEXT("Writer opens"), Writer.Open(Path, Config));
+
+    // The first fragment, and with it the sample entry, is written before any audio arrives.
+    Writer.AddVideo(GH264Header.GetData(), GH264Header.Num(), false, 0.0);
+    for (int32 FrameIndex = 0; FrameIndex < 4; ++FrameIndex)
+    {
+        const TArray<uint8>& Frame = FrameIndex % 3 == 0 ? GH264Idr : GH264NonIdr;
+        Writer.AddVideo(Frame.GetData(), Frame.Num(), FrameIndex % 3 == 0, FrameIndex / 30.0);
+    }
+    TestEqual(TEXT("The first fragment is out"), Writer.GetFragmentCount(), 1);
+
+    TArray<int16> Audio;
+    Audio.Init(0x1234, 1470 * 6);
+    TestTrue(TEXT("Audio in the configured format is kept"), Writer.AddAudio(Audio.GetData(), 1470, 44100, 6, 4 / 30.0));
+    TestFalse(TEXT("Audio in another format is left out"), Writer.AddAudio(Audio.GetData(), 1470 * 3, 48000, 2, 5 / 30.0));
+    TestEqual(TEXT("Only the matching audio is counted"), Writer.GetAudioFrameCount(), static_cast<int64>(1470 * 5));
+    TestTrue(TEXT("Writer closes"), Writer.Close(false));
+
+    // sowt: six reserved bytes, data reference, eight reserved bytes, then channels, sample size and 16.16 rate.
+    const TArray<uint8> Bytes = LoadFile(Path);
+    const int64 Sowt = FindBoxPayload(Bytes, "sowt");
+    TestTrue(TEXT("The sample entry carries the configured format"), MatchesAt(Bytes, Sowt + 16, { 0x00, 0x06, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0xAC, 0x44, 0x00, 0x00 }));
+
+    IFileManager::Get().DeleteDirectory(*Directory, false, true);
+    return true;
+}
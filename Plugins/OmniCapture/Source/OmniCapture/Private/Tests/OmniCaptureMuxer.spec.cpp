@@ -0,0 +1,73 @@
+#include "Misc/AutomationTest.h"
+
+#include "OmniCaptureMuxer.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+
+#if PLATFORM_WINDOWS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureMuxerLiveAudioFormatTest, "OmniCapture.Muxer.LiveAudioFormatWithoutAudioOnFirstFrame", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCaptureMuxerLiveAudioFormatTest::RunTest(const FString& Parameters)
+{
+    const FString Directory = FPaths::ConvertRelativePathToFull(FPaths::AutomationTransientDir() / TEXT("OmniCaptureMuxerLiveAudio"));
+    IFileManager::Get().DeleteDirectory(*Directory, false, true);
+
+    FOmniCaptureSettings Settings;
+    Settings.OutputFileName = TEXT("LiveAudio");
+    Settings.OutputFormat = EOmniOutputFormat::ImageSequence;
+    Settings.bStreamToFFmpeg = true;
+    Settings.bRecordAudio = true;
+    Settings.TargetFrameRate = 30.0f;
+
+    // A 44.1 kHz, six-channel device: neither matches the defaults the muxer would otherwise assume.
+    constexpr int32 SampleRate = 44100;
+    constexpr int32 Channels = 6;
+    constexpr int32 FrameCount = 30;
+    constexpr int32 AudioFramesPerVideoFrame = SampleRate / 30;
+
+    FOmniCaptureMuxer Muxer;
+    Muxer.Initialize(Settings, Directory);
+    Muxer.BeginRealtimeSession(Settings);
+    Muxer.SetLiveAudioFormat(SampleRate, Channels);
+
+    for (int32 FrameIndex = 0; FrameIndex < FrameCount; ++FrameIndex)
+    {
+        FOmniCaptureFrame Frame;
+        Frame.Metadata.FrameIndex = FrameIndex;
+        Frame.Metadata.Timecode = FrameIndex / 30.0;
+        TUniquePtr<TImagePixelData<FColor>> PixelData = MakeUnique<TImagePixelData<FColor>>(FIntPoint(64, 32));
+        PixelData->Pixels.Init(FColor(FrameIndex * 8, 0, 0, 255), 64 * 32);
+        Frame.PixelData = MoveTemp(PixelData);
+        Frame.PixelDataType = EOmniCapturePixelDataType::Color8;
+
+        // The first frame, which opens ffmpeg, arrives before any audio, as it does at the start of every segment.
+        if (FrameIndex > 0)
+        {
+            FOmniAudioPacket& Packet = Frame.AudioPackets.AddDefaulted_GetRef();
+            Packet.Timestamp = Frame.Metadata.Timecode;
+            Packet.SampleRate = SampleRate;
+            Packet.NumChannels = Channels;
+            Packet.PCM16.Init(static_cast<int16>(FrameIndex * 100), AudioFramesPerVideoFrame * Channels);
+        }
+
+        Muxer.PushFrame(Frame);
+        if (FrameIndex == 0 && !Muxer.IsLiveEncodeActive())
+        {
+            AddWarning(TEXT("FFmpeg could not be started; live audio format test skipped."));
+            Muxer.EndRealtimeSession();
+            return true;
+        }
+    }
+
+    Muxer.EndRealtimeSession();
+    FOmniCaptureFFmpegPipeStats Stats;
+    TestTrue(TEXT("Live encode finishes cleanly"), Muxer.FinishLiveEncode(&Stats));
+    TestEqual(TEXT("Every video frame reached ffmpeg"), Stats.VideoPushes, FrameCount);
+    TestEqual(TEXT("No audio was skipped for its format"), Muxer.GetLiveDroppedAudioPackets(), 0);
+    TestEqual(TEXT("Audio covers the video at the device format"), Stats.AudioBytes, static_cast<int64>(FrameCount) * AudioFramesPerVideoFrame * Channels * sizeof(int16));
+
+    IFileManager::Get().DeleteDirectory(*Directory, false, true);
+    return true;
+}
+
+#endif
@@ -0,0 +1,167 @@
+#include "Misc/AutomationTest.h"
+
+#include "OmniCapturePNGEncoder.h"
+#include "HAL/PlatformTime.h"
+#include "IImageWrapper.h"
+#include "IImageWrapperModule.h"
+#include "Math/RandomStream.h"
+#include "Modules/ModuleManager.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace
+{
+    /** Smooth gradients with a noisy band, roughly the mix of sky and detail in a panorama. */
+    void BuildSyntheticImage(const FIntPoint& Size, int32 BitDepth, TArray64<uint8>& OutPixels)
+    {
+        const int32 BytesPerChannel = BitDepth / 8;
+        OutPixels.SetNumUninitialized(static_cast<int64>(Size.X) * Size.Y * 4 * BytesPerChannel);
+        FRandomStream Random(Size.X ^ (Size.Y << 8) ^ BitDepth);
+        for (int32 Y = 0; Y < Size.Y; ++Y)
+        {
+            const bool bNoisyRow = Y > Size.Y / 2 && Y < Size.Y * 3 / 4;
+            for (int32 X = 0; X < Size.X; ++X)
+            {
+                const uint16 Channels[4] =
+                {
+                    static_cast<uint16>(X * 65535 / FMath::Max(1, Size.X - 1)),
+                    static_cast<uint16>(Y * 65535 / FMath::Max(1, Size.Y - 1)),
+                    static_cast<uint16>(bNoisyRow ? Random.RandRange(0, 65535) : 32768),
+                    static_cast<uint16>(X % 97 == 0 ? 0 : 65535)
+                };
+
+                uint8* Pixel = OutPixels.GetData() + (static_cast<int64>(Y) * Size.X + X) * 4 * BytesPerChannel;
+                for (int32 Channel = 0; Channel < 4; ++Channel)
+                {
+                    if (BytesPerChannel == 2)
+                    {
+                        FMemory::Memcpy(Pixel + Channel * 2, &Channels[Channel], sizeof(uint16));
+                    }
+                    else
+                    {
+                        Pixel[Channel] = static_cast<uint8>(Channels[Channel] >> 8);
+                    }
+                }
+            }
+        }
+    }
+
+    bool DecodeWithImageWrapper(const TArray64<uint8>& PNG, int32 BitDepth, TArray64<uint8>& OutRaw)
+    {
+        IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(TEXT("ImageWrapper"));
+        TSharedPtr<IImageWrapper> Wrapper = ImageWrapperModule.CreateImageWrapper(EImageFormat::PNG);
+        return Wrapper.IsValid() && Wrapper->SetCompressed(PNG.GetData(), PNG.Num()) && Wrapper->GetRaw(ERGBFormat::BGRA, BitDepth, OutRaw);
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCapturePNGEncoderRoundTripTest, "OmniCapture.PNGEncoder.DecodesWithLibpng", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCapturePNGEncoderRoundTripTest::RunTest(const FString& Parameters)
+{
+    // Odd sizes and tiny strips force many strips, a partial last strip and rows fed across several calls; on one thread
+    // the same rows go out as a single strip per call.
+    const FIntPoint Size(253, 131);
+    for (int32 BitDepth : { 8, 16 })
+    {
+        TArray64<uint8> Pixels;
+        BuildSyntheticImage(Size, BitDepth, Pixels);
+        const int64 BytesPerRow = static_cast<int64>(Size.X) * 4 * (BitDepth / 8);
+
+        for (int32 MaxThreads : { 0, 1 })
+        {
+            for (int64 MinStripBytes : { 1ll, 4096ll, 1ll << 20 })
+            {
+                FOmniCapturePNGEncodeOptions Options;
+                Options.MinStripBytes = MinStripBytes;
+                Options.MaxThreads = MaxThreads;
+
+                TArray64<uint8> PNG;
+                TestTrue(FString::Printf(TEXT("%d-bit image encodes in one call"), BitDepth), FOmniCapturePNGEncoder::EncodeToMemory(Size, ERGBFormat::BGRA, BitDepth, Pixels.GetData(), BytesPerRow, Options, PNG));
+
+                TArray64<uint8> Decoded;
+                TestTrue(FString::Printf(TEXT("%d-bit output decodes (strips of %lld bytes, %d threads)"), BitDepth, MinStripBytes, MaxThreads), DecodeWithImageWrapper(PNG, BitDepth, Decoded));
+                TestTrue(FString::Printf(TEXT("%d-bit pixels survive the round trip (strips of %lld bytes, %d threads)"), BitDepth, MinStripBytes, MaxThreads), Decoded.Num() == Pixels.Num() && FMemory::Memcmp(Decoded.GetData(), Pixels.GetData(), Pixels.Num()) == 0);
+
+                TArray64<uint8> Chunked;
+                FMemoryWriter64 Writer(Chunked);
+                FOmniCapturePNGEncoder Encoder(Writer, Size, ERGBFormat::BGRA, BitDepth, Options);
+                bool bEncoded = Encoder.Begin();
+                TArray<const uint8*> Rows;
+                for (int32 Y = 0; Y < Size.Y; ++Y)
+                {
+                    Rows.Add(Pixels.GetData() + BytesPerRow * Y);
+                }
+                for (int32 RowStart = 0; bEncoded && RowStart < Size.Y; RowStart += 17)
+                {
+                    bEncoded = Encoder.WriteRows(Rows.GetData() + RowStart, FMath::Min(17, Size.Y - RowStart));
+                }
+                TestTrue(TEXT("Rows written in chunks encode"), bEncoded && Encoder.End());
+                TestTrue(TEXT("Chunked output decodes to the same pixels"), DecodeWithImageWrapper(Chunked, BitDepth, Decoded) && Decoded.Num() == Pixels.Num() && FMemory::Memcmp(Decoded.GetData(), Pixels.GetData(), Pixels.Num()) == 0);
+            }
+        }
+    }
+
+    TArray64<uint8> Unused;
+    FMemoryWriter64 Writer(Unused);
+    FOmniCapturePNGEncoder Encoder(Writer, Size, ERGBFormat::BGRA, 8, FOmniCapturePNGEncodeOptions());
+    TestTrue(TEXT("A truncated image is rejected"), Encoder.Begin() && !Encoder.End());
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCapturePNGEncoderProfileTest, "OmniCapture.PNGEncoder.ProfilesDecodeWithLibpng", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCapturePNGEncoderProfileTest::RunTest(const FString& Parameters)
+{
+    const FIntPoint Size(512, 256);
+    for (int32 BitDepth : { 8, 16 })
+    {
+        TArray64<uint8> Pixels;
+        BuildSyntheticImage(Size, BitDepth, Pixels);
+
+        for (EOmniCapturePNGCompression Profile : { EOmniCapturePNGCompression::Realtime, EOmniCapturePNGCompression::Balanced, EOmniCapturePNGCompression::Archive })
+        {
+            TArray64<uint8> PNG;
+            TArray64<uint8> Decoded;
+            const FOmniCapturePNGEncodeOptions Options = FOmniCapturePNGEncodeOptions::ForProfile(Profile);
+            const bool bEncoded = FOmniCapturePNGEncoder::EncodeToMemory(Size, ERGBFormat::BGRA, BitDepth, Pixels.GetData(), static_cast<int64>(Size.X) * 4 * (BitDepth / 8), Options, PNG);
+            TestTrue(FString::Printf(TEXT("%d-bit profile %d round-trips"), BitDepth, static_cast<int32>(Profile)), bEncoded && DecodeWithImageWrapper(PNG, BitDepth, Decoded) && Decoded.Num() == Pixels.Num() && FMemory::Memcmp(Decoded.GetData(), Pixels.GetData(), Pixels.Num()) == 0);
+        }
+    }
+
+    const FOmniCapturePNGEncodeOptions Realtime = FOmniCapturePNGEncodeOptions::ForProfile(EOmniCapturePNGCompression::Realtime);
+    TestTrue(TEXT("Realtime uses level 1, a fixed Sub filter and RLE"), Realtime.CompressionLevel == 1 && !Realtime.bAdaptiveFilter && Realtime.bRunLengthMatching);
+    TestEqual(TEXT("Archive uses the maximum level"), FOmniCapturePNGEncodeOptions::ForProfile(EOmniCapturePNGCompression::Archive).CompressionLevel, 9);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCapturePNGEncoderBenchmark, "OmniCapture.PNGEncoder.Throughput", EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+bool FOmniCapturePNGEncoderBenchmark::RunTest(const FString& Parameters)
+{
+    IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(TEXT("ImageWrapper"));
+
+    // Stereo over-under frames at the three output sizes the writer sees most.
+    const FIntPoint Sizes[] = { FIntPoint(4096, 4096), FIntPoint(8192, 8192), FIntPoint(16384, 8192) };
+    for (const FIntPoint& Size : Sizes)
+    {
+        TArray64<uint8> Pixels;
+        BuildSyntheticImage(Size, 8, Pixels);
+
+        // Single-stream libpng, the encoder the writer used before strips.
+        TSharedPtr<IImageWrapper> Wrapper = ImageWrapperModule.CreateImageWrapper(EImageFormat::PNG);
+        double Start = FPlatformTime::Seconds();
+        Wrapper->SetRaw(Pixels.GetData(), Pixels.Num(), Size.X, Size.Y, ERGBFormat::BGRA, 8);
+        const int64 SingleStreamBytes = Wrapper->GetCompressed().Num();
+        const double SingleStreamSeconds = FPlatformTime::Seconds() - Start;
+
+        AddInfo(FString::Printf(TEXT("PNG %dx%d single-stream: %.2f frames/s, %.1f MB"), Size.X, Size.Y, 1.0 / FMath::Max(SingleStreamSeconds, 1.0e-9), SingleStreamBytes / (1024.0 * 1024.0)));
+
+        const TCHAR* ProfileNames[] = { TEXT("Balanced"), TEXT("Realtime"), TEXT("Archive") };
+        for (EOmniCapturePNGCompression Profile : { EOmniCapturePNGCompression::Balanced, EOmniCapturePNGCompression::Realtime, EOmniCapturePNGCompression::Archive })
+        {
+            TArray64<uint8> PNG;
+            Start = FPlatformTime::Seconds();
+            FOmniCapturePNGEncoder::EncodeToMemory(Size, ERGBFormat::BGRA, 8, Pixels.GetData(), static_cast<int64>(Size.X) * 4, FOmniCapturePNGEncodeOptions::ForProfile(Profile), PNG);
+            const double StripSeconds = FPlatformTime::Seconds() - Start;
+            AddInfo(FString::Printf(TEXT("PNG %dx%d strips (%s): %.2f frames/s, %.1f MB"), Size.X, Size.Y, ProfileNames[static_cast<int32>(Profile)], 1.0 / FMath::Max(StripSeconds, 1.0e-9), PNG.Num() / (1024.0 * 1024.0)));
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,95 @@
+#include "Misc/AutomationTest.h"
+
+#include "Async/Async.h"
+#include "ImagePixelData.h"
+#include "OmniCapturePreviewActor.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCapturePreviewDownsampleTest, "OmniCapture.Preview.DecimatesWithBoxFilter", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCapturePreviewDownsampleTest::RunTest(const FString& Parameters)
+{
+    TestEqual(TEXT("8K stereo frames are capped on the longest side"), AOmniCapturePreviewActor::GetDecimatedSize(FIntPoint(8192, 8192), 1024), FIntPoint(1024, 1024));
+    TestEqual(TEXT("Aspect ratio is kept"), AOmniCapturePreviewActor::GetDecimatedSize(FIntPoint(7680, 3840), 1024), FIntPoint(1024, 512));
+    TestEqual(TEXT("Small frames are not upscaled"), AOmniCapturePreviewActor::GetDecimatedSize(FIntPoint(640, 320), 1024), FIntPoint(640, 320));
+
+    // A 1-pixel checkerboard must average to mid grey rather than alias to either colour.
+    const FIntPoint SourceSize(64, 32);
+    TImagePixelData<FColor> Checker(SourceSize);
+    Checker.Pixels.SetNumUninitialized(static_cast<int64>(SourceSize.X) * SourceSize.Y);
+    for (int32 Y = 0; Y < SourceSize.Y; ++Y)
+    {
+        for (int32 X = 0; X < SourceSize.X; ++X)
+        {
+            Checker.Pixels[static_cast<int64>(Y) * SourceSize.X + X] = ((X + Y) & 1) ? FColor::White : FColor::Black;
+        }
+    }
+
+    TArray<FColor> Preview;
+    AOmniCapturePreviewActor::DownsamplePreview(Checker, FIntRect(FIntPoint::ZeroValue, SourceSize), FIntPoint(16, 8), Preview);
+    TestEqual(TEXT("Preview holds the target pixel count"), Preview.Num(), 16 * 8);
+
+    bool bAllGrey = Preview.Num() > 0;
+    for (const FColor& Pixel : Preview)
+    {
+        bAllGrey &= FMath::Abs(Pixel.R - 128) <= 1 && Pixel.R == Pixel.G && Pixel.G == Pixel.B && Pixel.A == 255;
+    }
+    TestTrue(TEXT("Box filter averages the checkerboard"), bAllGrey);
+
+    // Cropping to the right half of a side-by-side frame only reads that eye.
+    TImagePixelData<FLinearColor> Stereo(SourceSize);
+    Stereo.Pixels.SetNumUninitialized(static_cast<int64>(SourceSize.X) * SourceSize.Y);
+    for (int32 Y = 0; Y < SourceSize.Y; ++Y)
+    {
+        for (int32 X = 0; X < SourceSize.X; ++X)
+        {
+            Stereo.Pixels[static_cast<int64>(Y) * SourceSize.X + X] = X < SourceSize.X / 2 ? FLinearColor::Red : FLinearColor::Blue;
+        }
+    }
+
+    AOmniCapturePreviewActor::DownsamplePreview(Stereo, FIntRect(SourceSize.X / 2, 0, SourceSize.X, SourceSize.Y), FIntPoint(8, 8), Preview);
+    bool bAllBlue = Preview.Num() == 64;
+    for (const FColor& Pixel : Preview)
+    {
+        bAllBlue &= Pixel == FColor::Blue;
+    }
+    TestTrue(TEXT("Eye crop never samples the other eye"), bAllBlue);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCapturePreviewBuildOffGameThreadTest, "OmniCapture.Preview.BuildsOffGameThread", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCapturePreviewBuildOffGameThreadTest::RunTest(const FString& Parameters)
+{
+    // Top-bottom stereo: left eye green on top, right eye blue below.
+    const FIntPoint SourceSize(256, 256);
+    TImagePixelData<FColor> Stereo(SourceSize);
+    Stereo.Pixels.SetNumUninitialized(static_cast<int64>(SourceSize.X) * SourceSize.Y);
+    for (int32 Y = 0; Y < SourceSize.Y; ++Y)
+    {
+        for (int32 X = 0; X < SourceSize.X; ++X)
+        {
+            Stereo.Pixels[static_cast<int64>(Y) * SourceSize.X + X] = Y < SourceSize.Y / 2 ? FColor::Green : FColor::Blue;
+        }
+    }
+
+    FOmniCaptureSettings Settings;
+    Settings.Mode = EOmniCaptureMode::Stereo;
+    Settings.StereoLayout = EOmniCaptureStereoLayout::TopBottom;
+    Settings.PreviewMaxResolution = 64;
+
+    // Capture workers build the preview, so it must not need the game thread.
+    FOmniCapturePreviewImage Image;
+    const bool bBuilt = Async(EAsyncExecution::ThreadPool, [&Stereo, &Settings, &Image]()
+    {
+        return !IsInGameThread() && AOmniCapturePreviewActor::BuildPreview(Stereo, Settings, EOmniCapturePreviewView::RightEye, Image);
+    }).Get();
+
+    TestTrue(TEXT("Preview is built on a worker thread"), bBuilt);
+    TestEqual(TEXT("The right eye is decimated to the preview cap"), Image.Size, FIntPoint(64, 32));
+
+    bool bAllBlue = Image.Pixels.Num() == 64 * 32;
+    for (const FColor& Pixel : Image.Pixels)
+    {
+        bAllBlue &= Pixel == FColor::Blue;
+    }
+    TestTrue(TEXT("Only the right eye is sampled"), bAllBlue);
+    return true;
+}
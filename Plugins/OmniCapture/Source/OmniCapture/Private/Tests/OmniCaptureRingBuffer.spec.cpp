@@ -0,0 +1,363 @@
+#include "Misc/AutomationTest.h"
+
+#include "OmniCaptureRingBuffer.h"
+#include "OmniCaptureMemoryBudget.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/ScopeLock.h"
+
+namespace
+{
+    /** Mutex + TQueue + sleep-polling queue the lock-free ring replaced, kept as a latency baseline. */
+    class FLegacyCaptureQueue final : public FRunnable
+    {
+    public:
+        ~FLegacyCaptureQueue()
+        {
+            bRunning = false;
+            if (DataEvent)
+            {
+                DataEvent->Trigger();
+            }
+            if (Thread.IsValid())
+            {
+                Thread->WaitForCompletion();
+                Thread.Reset();
+            }
+            if (DataEvent)
+            {
+                FPlatformProcess::ReturnSynchEventToPool(DataEvent);
+                DataEvent = nullptr;
+            }
+        }
+
+        void Initialize(const FOmniCaptureSettings& Settings, const TFunction<void(TUniquePtr<FOmniCaptureFrame>&&)>& InConsumer)
+        {
+            Consumer = InConsumer;
+            Capacity = Settings.RingBufferCapacity;
+            Policy = Settings.RingBufferPolicy;
+            DataEvent = FPlatformProcess::GetSynchEventFromPool();
+            bRunning = true;
+            Thread.Reset(FRunnableThread::Create(this, TEXT("OmniCaptureLegacyQueue")));
+        }
+
+        void Enqueue(TUniquePtr<FOmniCaptureFrame>&& Frame)
+        {
+            while (Capacity > 0 && Pending.Load() >= Capacity)
+            {
+                if (Policy == EOmniCaptureRingBufferPolicy::DropOldest)
+                {
+                    TUniquePtr<FOmniCaptureFrame> Discarded;
+                    FScopeLock Lock(&QueueCS);
+                    if (Queue.Dequeue(Discarded))
+                    {
+                        Pending.DecrementExchange();
+                    }
+                    break;
+                }
+                FPlatformProcess::Sleep(0.001f);
+            }
+
+            {
+                FScopeLock Lock(&QueueCS);
+                Queue.Enqueue(MoveTemp(Frame));
+                Pending.IncrementExchange();
+            }
+            DataEvent->Trigger();
+        }
+
+        void Flush()
+        {
+            for (;;)
+            {
+                TUniquePtr<FOmniCaptureFrame> Frame;
+                {
+                    FScopeLock Lock(&QueueCS);
+                    if (!Queue.Dequeue(Frame))
+                    {
+                        break;
+                    }
+                }
+                Consumer(MoveTemp(Frame));
+                Pending.DecrementExchange();
+            }
+        }
+
+        virtual uint32 Run() override
+        {
+            while (bRunning.Load())
+            {
+                DataEvent->Wait();
+                Flush();
+            }
+            Flush();
+            return 0;
+        }
+
+    private:
+        TQueue<TUniquePtr<FOmniCaptureFrame>, EQueueMode::Mpsc> Queue;
+        FCriticalSection QueueCS;
+        TFunction<void(TUniquePtr<FOmniCaptureFrame>&&)> Consumer;
+        TUniquePtr<FRunnableThread> Thread;
+        FEvent* DataEvent = nullptr;
+        TAtomic<bool> bRunning { false };
+        TAtomic<int32> Pending { 0 };
+        int32 Capacity = 0;
+        EOmniCaptureRingBufferPolicy Policy = EOmniCaptureRingBufferPolicy::DropOldest;
+    };
+
+    void SpinFor(double Seconds)
+    {
+        const double End = FPlatformTime::Seconds() + Seconds;
+        while (FPlatformTime::Seconds() < End)
+        {
+        }
+    }
+
+    struct FProducerLatency
+    {
+        double P50Microseconds = 0.0;
+        double P99Microseconds = 0.0;
+        int32 Consumed = 0;
+    };
+
+    template <typename QueueType>
+    FProducerLatency MeasureProducerLatency(EOmniCaptureRingBufferPolicy Policy, int32 FrameCount)
+    {
+        FOmniCaptureSettings Settings;
+        Settings.RingBufferCapacity = 6;
+        Settings.RingBufferPolicy = Policy;
+
+        TAtomic<int32> Consumed { 0 };
+        TArray<double> Samples;
+        Samples.Reserve(FrameCount);
+
+        {
+            QueueType Queue;
+            Queue.Initialize(Settings, [&Consumed](TUniquePtr<FOmniCaptureFrame>&& Frame)
+            {
+                // Roughly the cost of dispatching a frame to the writer, slightly slower than the producer.
+                SpinFor(0.00025);
+                Consumed.IncrementExchange();
+            });
+
+            TArray<TUniquePtr<FOmniCaptureFrame>> Frames;
+            Frames.Reserve(FrameCount);
+            for (int32 Index = 0; Index < FrameCount; ++Index)
+            {
+                TUniquePtr<FOmniCaptureFrame> Frame = MakeUnique<FOmniCaptureFrame>();
+                Frame->Metadata.FrameIndex = Index;
+                Frames.Add(MoveTemp(Frame));
+            }
+
+            for (int32 Index = 0; Index < FrameCount; ++Index)
+            {
+                SpinFor(0.0002);
+                const uint64 Start = FPlatformTime::Cycles64();
+                Queue.Enqueue(MoveTemp(Frames[Index]));
+                Samples.Add(FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - Start) * 1.0e6);
+            }
+
+            Queue.Flush();
+        }
+
+        Samples.Sort();
+        FProducerLatency Result;
+        Result.P50Microseconds = Samples[Samples.Num() / 2];
+        Result.P99Microseconds = Samples[FMath::Min(Samples.Num() - 1, (Samples.Num() * 99) / 100)];
+        Result.Consumed = Consumed.Load();
+        return Result;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureRingBufferOrderingTest, "OmniCapture.RingBuffer.BlockProducerDeliversAllFrames", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCaptureRingBufferOrderingTest::RunTest(const FString& Parameters)
+{
+    FOmniCaptureSettings Settings;
+    Settings.RingBufferCapacity = 3;
+    Settings.RingBufferPolicy = EOmniCaptureRingBufferPolicy::BlockProducer;
+
+    constexpr int32 FrameCount = 256;
+    TArray<int32> Received;
+    Received.Reserve(FrameCount);
+
+    {
+        FOmniCaptureRingBuffer RingBuffer;
+        RingBuffer.Initialize(Settings, [&Received](TUniquePtr<FOmniCaptureFrame>&& Frame)
+        {
+            Received.Add(Frame->Metadata.FrameIndex);
+        });
+
+        for (int32 Index = 0; Index < FrameCount; ++Index)
+        {
+            TUniquePtr<FOmniCaptureFrame> Frame = MakeUnique<FOmniCaptureFrame>();
+            Frame->Metadata.FrameIndex = Index;
+            RingBuffer.Enqueue(MoveTemp(Frame));
+        }
+
+        // Destruction joins the worker before the final drain, so the consumer is never re-entered concurrently.
+        TestEqual(TEXT("BlockProducer never drops frames"), RingBuffer.GetStats().DroppedFrames, 0);
+    }
+
+    TestEqual(TEXT("Every frame reaches the consumer"), Received.Num(), FrameCount);
+    for (int32 Index = 1; Index < Received.Num(); ++Index)
+    {
+        if (Received[Index] <= Received[Index - 1])
+        {
+            AddError(FString::Printf(TEXT("Frame %d delivered after frame %d"), Received[Index], Received[Index - 1]));
+            break;
+        }
+    }
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureRingBufferLatencyBenchmark, "OmniCapture.RingBuffer.ProducerLatency", EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+bool FOmniCaptureRingBufferLatencyBenchmark::RunTest(const FString& Parameters)
+{
+    constexpr int32 FrameCount = 2000;
+
+    const EOmniCaptureRingBufferPolicy Policies[] = { EOmniCaptureRingBufferPolicy::DropOldest, EOmniCaptureRingBufferPolicy::BlockProducer };
+    for (EOmniCaptureRingBufferPolicy Policy : Policies)
+    {
+        const TCHAR* PolicyName = Policy == EOmniCaptureRingBufferPolicy::DropOldest ? TEXT("DropOldest") : TEXT("BlockProducer");
+
+        const FProducerLatency Legacy = MeasureProducerLatency<FLegacyCaptureQueue>(Policy, FrameCount);
+        const FProducerLatency LockFree = MeasureProducerLatency<FOmniCaptureRingBuffer>(Policy, FrameCount);
+
+        AddInfo(FString::Printf(TEXT("%s producer latency: mutex queue p50 %.1fus p99 %.1fus | lock-free ring p50 %.1fus p99 %.1fus"),
+            PolicyName, Legacy.P50Microseconds, Legacy.P99Microseconds, LockFree.P50Microseconds, LockFree.P99Microseconds));
+
+        if (Policy == EOmniCaptureRingBufferPolicy::BlockProducer)
+        {
+            TestEqual(TEXT("Lock-free ring delivers every frame when blocking"), LockFree.Consumed, FrameCount);
+        }
+        else
+        {
+            TestTrue(TEXT("Lock-free ring delivers frames when dropping"), LockFree.Consumed > 0 && LockFree.Consumed <= FrameCount);
+        }
+    }
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureRingBufferOrderedWorkersTest, "OmniCapture.RingBuffer.OrderedStageWithWorkers", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCaptureRingBufferOrderedWorkersTest::RunTest(const FString& Parameters)
+{
+    FOmniCaptureSettings Settings;
+    Settings.RingBufferCapacity = 8;
+    Settings.RingBufferPolicy = EOmniCaptureRingBufferPolicy::BlockProducer;
+    Settings.RingBufferWorkerCount = 4;
+
+    constexpr int32 FrameCount = 512;
+    TArray<int32> OrderedIndices;
+    OrderedIndices.Reserve(FrameCount);
+    TAtomic<int32> ParallelCount { 0 };
+    FOmniCaptureRingBufferStats FinalStats;
+
+    {
+        FOmniCaptureRingBuffer RingBuffer;
+        RingBuffer.Initialize(Settings,
+            [&ParallelCount](TUniquePtr<FOmniCaptureFrame>&& Frame)
+            {
+                // Uneven per-frame cost so workers finish out of order.
+                SpinFor((Frame->Metadata.FrameIndex % 3) * 0.0001);
+                ParallelCount.IncrementExchange();
+            },
+            [&OrderedIndices](const FOmniCaptureFrame& Frame)
+            {
+                OrderedIndices.Add(Frame.Metadata.FrameIndex);
+            });
+
+        for (int32 Index = 0; Index < FrameCount; ++Index)
+        {
+            TUniquePtr<FOmniCaptureFrame> Frame = MakeUnique<FOmniCaptureFrame>();
+            Frame->Metadata.FrameIndex = Index;
+            RingBuffer.Enqueue(MoveTemp(Frame));
+        }
+
+        RingBuffer.Flush();
+        FinalStats = RingBuffer.GetStats();
+    }
+
+    TestEqual(TEXT("Parallel stage sees every frame"), ParallelCount.Load(), FrameCount);
+    TestEqual(TEXT("Ordered stage sees every frame"), OrderedIndices.Num(), FrameCount);
+    for (int32 Index = 0; Index < OrderedIndices.Num(); ++Index)
+    {
+        if (OrderedIndices[Index] != Index)
+        {
+            AddError(FString::Printf(TEXT("Ordered stage received frame %d at position %d"), OrderedIndices[Index], Index));
+            break;
+        }
+    }
+
+    TestEqual(TEXT("Stats report every worker"), FinalStats.WorkerUtilization.Num(), 4);
+    TestTrue(TEXT("Reorder window never exceeds the number of consumers plus the flushing thread"), FinalStats.MaxReorderWindowDepth <= 5);
+    AddInfo(FString::Printf(TEXT("Max reorder window depth: %d"), FinalStats.MaxReorderWindowDepth));
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureRingBufferByteBudgetTest, "OmniCapture.RingBuffer.ByteBudgetBoundsFramesInFlight", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCaptureRingBufferByteBudgetTest::RunTest(const FString& Parameters)
+{
+    const FIntPoint Size(256, 256);
+    const int64 FrameBytes = static_cast<int64>(Size.X) * Size.Y * sizeof(FColor);
+    constexpr int32 FrameCount = 64;
+
+    const EOmniCaptureRingBufferPolicy Policies[] = { EOmniCaptureRingBufferPolicy::BlockProducer, EOmniCaptureRingBufferPolicy::DropOldest };
+    for (EOmniCaptureRingBufferPolicy Policy : Policies)
+    {
+        FOmniCaptureSettings Settings;
+        // Frame-count capacity alone would admit 16 frames; the byte budget should hold it to two.
+        Settings.RingBufferCapacity = 16;
+        Settings.RingBufferPolicy = Policy;
+
+        FOmniCaptureMemoryBudget Budget;
+        Budget.Configure(FrameBytes * 2);
+
+        TAtomic<int32> Consumed { 0 };
+        FOmniCaptureRingBufferStats FinalStats;
+        {
+            FOmniCaptureRingBuffer RingBuffer;
+            RingBuffer.SetMemoryBudget(&Budget);
+            RingBuffer.Initialize(Settings, [&Consumed, &Budget](TUniquePtr<FOmniCaptureFrame>&& Frame)
+            {
+                SpinFor(0.0005);
+                Budget.ReleaseFrame(*Frame);
+                Consumed.IncrementExchange();
+            });
+
+            for (int32 Index = 0; Index < FrameCount; ++Index)
+            {
+                TUniquePtr<FOmniCaptureFrame> Frame = MakeUnique<FOmniCaptureFrame>();
+                Frame->Metadata.FrameIndex = Index;
+                TUniquePtr<TImagePixelData<FColor>> PixelData = MakeUnique<TImagePixelData<FColor>>(Size);
+                PixelData->Pixels.SetNumZeroed(static_cast<int64>(Size.X) * Size.Y);
+                Frame->PixelData = MoveTemp(PixelData);
+                RingBuffer.Enqueue(MoveTemp(Frame));
+            }
+
+            RingBuffer.Flush();
+            FinalStats = RingBuffer.GetStats();
+        }
+
+        TestTrue(TEXT("Peak bytes in flight stay within the budget"), FinalStats.PeakBytesInFlight <= FrameBytes * 2);
+        TestEqual(TEXT("Every reservation is returned"), Budget.GetInFlightBytes(), 0ll);
+        TestEqual(TEXT("Stats report the configured budget"), FinalStats.MemoryBudgetBytes, FrameBytes * 2);
+
+        if (Policy == EOmniCaptureRingBufferPolicy::BlockProducer)
+        {
+            TestEqual(TEXT("Blocking on bytes still delivers every frame"), Consumed.Load(), FrameCount);
+            TestTrue(TEXT("Producer blocked on the byte budget"), FinalStats.BudgetBlockedPushes > 0);
+        }
+        else
+        {
+            TestEqual(TEXT("Every frame is either consumed or dropped"), Consumed.Load() + FinalStats.DroppedFrames, FrameCount);
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,120 @@
+#include "Misc/AutomationTest.h"
+
+#include "OmniCaptureSegmentFinalizer.h"
+#include "OmniCaptureIntermediateFormat.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureSegmentFinalizerOrderTest, "OmniCapture.SegmentFinalizer.ResultsInRotationOrder", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCaptureSegmentFinalizerOrderTest::RunTest(const FString& Parameters)
+{
+    FOmniCaptureSegmentFinalizer Finalizer;
+    TestTrue(TEXT("Finalizer starts"), Finalizer.Start(1));
+
+    // Segments without writers or frames: the finalizer still runs each one and reports it, but there is nothing to mux.
+    constexpr int32 SegmentCount = 8;
+    for (int32 SegmentIndex = 0; SegmentIndex < SegmentCount; ++SegmentIndex)
+    {
+        FOmniCaptureSegmentFinalizeJob Job;
+        Job.Segment.SegmentIndex = SegmentIndex;
+        Job.bFinalize = SegmentIndex % 2 == 0;
+        Finalizer.Enqueue(MoveTemp(Job));
+    }
+    Finalizer.WaitForAll();
+
+    const FOmniCaptureSegmentFinalizeStats Stats = Finalizer.GetStats();
+    TestEqual(TEXT("Nothing left queued"), Stats.QueuedSegments, 0);
+    TestEqual(TEXT("Nothing left running"), Stats.ActiveSegments, 0);
+    TestEqual(TEXT("No progress without active segments"), Stats.ActiveProgress, 0.0f);
+    TestEqual(TEXT("Empty segments are not counted as completed"), Stats.CompletedSegments, 0);
+    TestEqual(TEXT("Empty segments are not counted as failed"), Stats.FailedSegments, 0);
+    TestTrue(TEXT("Finalize time is recorded"), Stats.MaxFinalizeSeconds >= Stats.LastFinalizeSeconds && Stats.LastFinalizeSeconds >= 0.0);
+
+    const TArray<FOmniCaptureSegmentFinalizeResult> Results = Finalizer.ConsumeResults();
+    TestEqual(TEXT("Every segment reports back"), Results.Num(), SegmentCount);
+    for (int32 Index = 0; Index < Results.Num(); ++Index)
+    {
+        TestEqual(TEXT("One thread finishes segments in rotation order"), Results[Index].SegmentIndex, Index);
+        TestFalse(TEXT("Nothing is finalized without frames"), Results[Index].bFinalized);
+        TestTrue(TEXT("No output without frames"), Results[Index].OutputPath.IsEmpty());
+    }
+    TestEqual(TEXT("Results are handed out once"), Finalizer.ConsumeResults().Num(), 0);
+
+    // The pool restarts after WaitForAll, so later segments are still taken.
+    FOmniCaptureSegmentFinalizeJob Late;
+    Late.Segment.SegmentIndex = SegmentCount;
+    Finalizer.Enqueue(MoveTemp(Late));
+    Finalizer.WaitForAll();
+    const TArray<FOmniCaptureSegmentFinalizeResult> LateResults = Finalizer.ConsumeResults();
+    TestTrue(TEXT("A segment enqueued after WaitForAll is finalized"), LateResults.Num() == 1 && LateResults[0].SegmentIndex == SegmentCount);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureSegmentFinalizerProgressTest, "OmniCapture.SegmentFinalizer.ProgressRunsToCompletion", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCaptureSegmentFinalizerProgressTest::RunTest(const FString& Parameters)
+{
+    FOmniCaptureSegmentFinalizeJob Job;
+    Job.Segment.SegmentIndex = 3;
+    FOmniCaptureSegmentFinalizeResult Result;
+    TArray<float> Reported;
+    FOmniCaptureSegmentFinalizer::Finalize(Job, Result, [&Reported](float Progress)
+    {
+        Reported.Add(Progress);
+    });
+
+    TestEqual(TEXT("Result belongs to the segment"), Result.SegmentIndex, 3);
+    TestTrue(TEXT("Progress starts at zero and ends at one"), Reported.Num() >= 2 && Reported[0] == 0.0f && Reported.Last() == 1.0f);
+    bool bMonotonic = true;
+    for (int32 Index = 1; Index < Reported.Num(); ++Index)
+    {
+        bMonotonic &= Reported[Index] >= Reported[Index - 1];
+    }
+    TestTrue(TEXT("Progress never goes backwards"), bMonotonic);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FOmniCaptureSegmentFinalizerIntermediateTest, "OmniCapture.SegmentFinalizer.SkipsMuxForIntermediates", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+bool FOmniCaptureSegmentFinalizerIntermediateTest::RunTest(const FString& Parameters)
+{
+    const FString Directory = FPaths::ConvertRelativePathToFull(FPaths::AutomationTransientDir() / TEXT("OmniCaptureFinalizerIntermediates"));
+    IFileManager::Get().DeleteDirectory(*Directory, false, true);
+    IFileManager::Get().MakeDirectory(*Directory, true);
+
+    // The transcoder only looks at names until it converts, so a placeholder stands in for an untranscoded frame.
+    const FString BaseName = TEXT("Intermediates");
+    TestTrue(TEXT("Placeholder frame written"), FFileHelper::SaveStringToFile(TEXT("omniraw"), *(Directory / (BaseName + TEXT("_000000") + FOmniCaptureIntermediateFormat::GetExtension()))));
+
+    FOmniCaptureSegmentFinalizeJob Job;
+    Job.Segment.SegmentIndex = 2;
+    Job.Segment.Directory = Directory;
+    Job.Segment.BaseFileName = BaseName;
+    Job.Segment.bHasImageSequence = true;
+    Job.Segment.Frames.AddDefaulted();
+    Job.Settings.OutputFormat = EOmniOutputFormat::ImageSequence;
+    Job.Settings.ImageFormat = EOmniCaptureImageFormat::Intermediate;
+    Job.Settings.bTranscodeIntermediatesOnFinalize = false;
+    Job.Settings.bStreamToFFmpeg = false;
+
+    FOmniCaptureSegmentFinalizeResult Result;
+    FOmniCaptureSegmentFinalizer::Finalize(Job, Result, [](float) {});
+
+    TestTrue(TEXT("The segment is finalized"), Result.bFinalized);
+    TestTrue(TEXT("Leaving frames for a later transcode is not a failure"), Result.bSuccess);
+    TestTrue(TEXT("No video is claimed"), Result.OutputPath.IsEmpty());
+    TestEqual(TEXT("The frames are reported where they are"), Result.ImageSequenceDirectory, Directory);
+
+    int32 IntermediateWarnings = 0;
+    int32 MuxFailures = 0;
+    for (const FOmniCaptureSegmentFinalizeMessage& Message : Result.Messages)
+    {
+        IntermediateWarnings += Message.Verbosity == ELogVerbosity::Warning && Message.Message.Contains(TEXT("still intermediates")) ? 1 : 0;
+        MuxFailures += Message.Message.Contains(TEXT("muxing failed")) ? 1 : 0;
+    }
+    TestEqual(TEXT("One message says the frames need transcoding"), IntermediateWarnings, 1);
+    TestEqual(TEXT("ffmpeg is not pointed at intermediates"), MuxFailures, 0);
+    TestFalse(TEXT("No video was written"), FPaths::FileExists(Directory / (BaseName + TEXT(".mp4"))));
+
+    IFileManager::Get().DeleteDirectory(*Directory, false, true);
+    return true;
+}
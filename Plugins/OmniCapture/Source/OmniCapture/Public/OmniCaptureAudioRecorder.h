@@ -1,6 +1,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "OmniCaptureAudioRing.h"
 #include "OmniCaptureTypes.h"
 #include "Templates/Atomic.h"
 
@@ -18,12 +19,22 @@ public:
     FOmniCaptureAudioRecorder();
 
     bool Initialize(UWorld* InWorld, const FOmniCaptureSettings& Settings);
-    void Start();
+    /** Packet timestamps are seconds since TimelineOriginSeconds (an FPlatformTime::Seconds value), the clock frames are stamped with. */
+    void Start(double TimelineOriginSeconds);
     void Stop(const FString& OutputDirectory, const FString& BaseFileName);
 
-    void GatherAudio(double FrameTimestamp, TArray<FOmniAudioPacket>& OutPackets);
+    /** Moves the audio up to the frame's timestamp into Frame.AudioPackets, reusing the frame's spare PCM buffers. Game thread only. */
+    void GatherAudio(double FrameTimestamp, FOmniCaptureFrame& Frame);
+    /** Rate and channel count of the submix buffers the mixer device will deliver; false without an audio mixer. */
+    bool GetAudioFormat(int32& OutSampleRate, int32& OutNumChannels) const;
     FString GetDebugStatus() const;
     int32 GetPendingPacketCount() const;
+    /** Submix buffers dropped because the ring was full. */
+    int32 GetOverflowCount() const { return Ring.GetOverflowCount(); }
+    /** Frames that found no audio although the last gathered audio ended well before them. */
+    int32 GetUnderflowCount() const { return Ring.GetUnderflowCount(); }
+    /** Size of the WAV the engine will write on Stop, counted as the submix delivers it. */
+    int64 GetRecordedBytes() const { return RecordedBytes.Load(); }
 
     void SetPaused(bool bInPaused);
     bool IsPaused() const { return bPaused.Load(); }
@@ -35,22 +46,26 @@ private:
     void RegisterListener();
     void UnregisterListener();
     void HandleSubmixBuffer(const float* AudioData, int32 NumSamples, int32 NumChannels, int32 SampleRate, double AudioClock);
+    void ResetRing();
 
     TWeakObjectPtr<UWorld> WorldPtr;
     bool bIsRecording = false;
     float Gain = 1.0f;
     FString OutputFilePath;
 
-    mutable FCriticalSection PacketCS;
-    TQueue<FOmniAudioPacket, EQueueMode::Mpsc> PendingPackets;
     TWeakObjectPtr<USoundSubmix> TargetSubmix;
     class FOmniCaptureSubmixListener* SubmixListener = nullptr;
     class Audio::FMixerDevice* MixerDevice = nullptr;
     double AudioClockOrigin = -1.0;
     double AudioStartTime = 0.0;
+    double TimelineOrigin = 0.0;
+    /** Where the first submix buffer falls on the capture timeline; the audio clock counts from there. */
+    double TimelineOffset = 0.0;
     int32 CachedSampleRate = 48000;
-    TAtomic<int32> PendingPacketCount = 0;
-    TAtomic<int32> DroppedPacketCount = 0;
+
+    /** Filled by the audio render thread, drained by GatherAudio; ResetRing runs while no listener is registered. */
+    FOmniCaptureAudioRing Ring;
+    TAtomic<int64> RecordedBytes = 0;
     TAtomic<bool> bPaused = false;
     TAtomic<bool> bLoggedOverflowWarning = false;
 };
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OmniCaptureTypes.h"
+#include "Templates/Atomic.h"
+
+/**
+ * Single-producer, single-consumer ring that carries submix buffers from the audio render thread to the capture
+ * thread as 16-bit PCM. Samples and the chunk records describing each buffer live in two power-of-two rings indexed by
+ * ever-increasing counters; each side only stores its own counters, so neither side ever takes a lock or allocates.
+ */
+class OMNICAPTURE_API FOmniCaptureAudioRing
+{
+public:
+    /** 2 MiB of PCM: about 10 s of stereo or 2.7 s of 8-channel audio at 48 kHz. */
+    static constexpr int32 DefaultSampleCapacity = 1 << 20;
+    static constexpr int32 DefaultChunkCapacity = 256;
+
+    /** Capacities are rounded up to powers of two. Allocates, so it runs while nothing produces or consumes. */
+    void Initialize(int32 SampleCapacity = DefaultSampleCapacity, int32 ChunkCapacity = DefaultChunkCapacity);
+    /** Empties the ring and clears its counters; same restriction as Initialize. */
+    void Reset();
+
+    /** Producer side. Scales by Gain into PCM; a buffer that does not fit is dropped whole and counted as an overflow. */
+    bool Push(const float* InSamples, int32 NumSamples, int32 NumChannels, int32 SampleRate, float Gain, double Timestamp);
+
+    /**
+     * Consumer side. Moves the buffers stamped up to just past FrameTimestamp into Frame.AudioPackets, merging
+     * back-to-back buffers of one format into one packet and reusing the frame's spare PCM arrays. With bExpectAudio,
+     * finding nothing although the last gathered audio ended well before FrameTimestamp counts as an underflow.
+     */
+    void Gather(double FrameTimestamp, FOmniCaptureFrame& Frame, bool bExpectAudio);
+
+    int32 GetPendingChunkCount() const { return static_cast<int32>(ChunkWriteIndex.Load() - ChunkReadIndex.Load()); }
+    int32 GetOverflowCount() const { return OverflowCount.Load(); }
+    int32 GetUnderflowCount() const { return UnderflowCount.Load(); }
+
+private:
+    /** One submix buffer's place in the sample ring. */
+    struct FAudioChunk
+    {
+        double Timestamp = 0.0;
+        int32 SampleRate = 0;
+        int32 NumChannels = 0;
+        int32 NumSamples = 0;
+        uint64 Start = 0;
+    };
+
+    TArray<int16> Samples;
+    TArray<FAudioChunk> Chunks;
+    uint64 SampleWriteIndex = 0;
+    TAtomic<uint64> SampleReadIndex = 0;
+    TAtomic<uint64> ChunkWriteIndex = 0;
+    TAtomic<uint64> ChunkReadIndex = 0;
+    double LastGatheredEndTime = -1.0;
+
+    TAtomic<int32> OverflowCount = 0;
+    TAtomic<int32> UnderflowCount = 0;
+};
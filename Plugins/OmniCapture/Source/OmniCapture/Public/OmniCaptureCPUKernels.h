@@ -0,0 +1,68 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Source of one output pixel in a cubemap: packed face/texel plus bilinear fractions towards the next texel in 1/65535 steps. */
+struct FOmniCaptureCubemapSample
+{
+    static constexpr uint32 FaceShift = 29;
+    static constexpr uint32 TexelMask = (1u << FaceShift) - 1u;
+    static constexpr uint32 Transparent = MAX_uint32;
+
+    uint32 Texel = Transparent;
+    uint16 WeightX = 0;
+    uint16 WeightY = 0;
+};
+static_assert(sizeof(FOmniCaptureCubemapSample) == 8, "Cubemap samples are serialised as raw memory.");
+
+/** Six square faces of one resolution, stored either as FLinearColor or as FFloat16Color (bHalf). */
+struct FOmniCaptureCubemapView
+{
+    const FLinearColor* Faces[6] = {};
+    const FFloat16Color* HalfFaces[6] = {};
+    int32 Resolution = 0;
+    bool bHalf = false;
+};
+
+/**
+ * Per-span kernels for CPU reprojection and for the image writer's colour conversions. The default versions go through
+ * UE's VectorRegister abstraction (SSE/AVX on x86, NEON on ARM): each pixel's four channels share one
+ * VectorRegister4Float, and the loops are unrolled by four pixels so independent pixels overlap in the pipeline. The
+ * Reference versions are the scalar definitions they are tested against. Transparent samples gather to zero; half
+ * faces are widened per texel as they are read.
+ */
+class OMNICAPTURE_API FOmniCaptureCPUKernels
+{
+public:
+    static void GatherNearest(const FOmniCaptureCubemapView& Cubemap, const FOmniCaptureCubemapSample* Samples, int32 Count, FLinearColor* Out);
+    static void GatherBilinear(const FOmniCaptureCubemapView& Cubemap, const FOmniCaptureCubemapSample* Samples, int32 Count, FLinearColor* Out);
+    static void GatherBilinearReference(const FOmniCaptureCubemapView& Cubemap, const FOmniCaptureCubemapSample* Samples, int32 Count, FLinearColor* Out);
+
+    static void PackFloat16(const FLinearColor* Source, FFloat16Color* Out, int32 Count);
+    static void PackFloat16Reference(const FLinearColor* Source, FFloat16Color* Out, int32 Count);
+
+    /** Matches FLinearColor::ToFColor(true) to within one code value. */
+    static void PackSRGB(const FLinearColor* Source, FColor* Out, int32 Count);
+    static void PackSRGBReference(const FLinearColor* Source, FColor* Out, int32 Count);
+    static void PackSRGB(const FFloat16Color* Source, FColor* Out, int32 Count);
+
+    static void WidenFloat16(const FFloat16Color* Source, FLinearColor* Out, int32 Count);
+    static void WidenFloat16Reference(const FFloat16Color* Source, FLinearColor* Out, int32 Count);
+
+    /** Clamps to [0,1] and rounds to 16 bits per channel, written B, G, R, A as PNG rows expect. Out holds Count * 4 values. */
+    static void PackUNorm16BGRA(const FLinearColor* Source, uint16* Out, int32 Count);
+    static void PackUNorm16BGRAReference(const FLinearColor* Source, uint16* Out, int32 Count);
+    static void PackUNorm16BGRA(const FFloat16Color* Source, uint16* Out, int32 Count);
+
+    /** Widens 8-bit BGRA to 16-bit BGRA by byte replication, so 255 becomes 65535. */
+    static void ExpandUNorm16BGRA(const FColor* Source, uint16* Out, int32 Count);
+
+    /** Same as FColor::ReinterpretAsLinear: code / 255 with no transfer curve. */
+    static void UnpackColor(const FColor* Source, FLinearColor* Out, int32 Count);
+    static void UnpackColorReference(const FColor* Source, FLinearColor* Out, int32 Count);
+    static void UnpackColor(const FColor* Source, FFloat16Color* Out, int32 Count);
+
+    /** Audio samples scaled by Gain and rounded to signed 16-bit PCM, saturating instead of wrapping. */
+    static void PackPCM16(const float* Source, float Gain, int16* Out, int32 Count);
+    static void PackPCM16Reference(const float* Source, float Gain, int16* Out, int32 Count);
+};
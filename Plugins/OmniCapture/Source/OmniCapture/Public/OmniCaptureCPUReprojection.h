@@ -0,0 +1,109 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OmniCaptureEquirectConverter.h"
+
+/** A read-back cube face. Half-float captures stay in HalfPixels as read; only FullFloat captures fill Pixels. */
+struct FOmniCaptureCPUFace
+{
+    int32 Resolution = 0;
+    EOmniCapturePixelPrecision Precision = EOmniCapturePixelPrecision::Unknown;
+    TArray<FLinearColor> Pixels;
+    TArray<FFloat16Color> HalfPixels;
+
+    bool HasHalfStorage() const
+    {
+        return HalfPixels.Num() > 0;
+    }
+
+    FLinearColor GetTexel(int32 Index) const
+    {
+        return HasHalfStorage() ? FLinearColor(HalfPixels[Index]) : Pixels[Index];
+    }
+
+    bool IsValid() const
+    {
+        const int32 TexelCount = Resolution * Resolution;
+        return Resolution > 0 && (HasHalfStorage() ? HalfPixels.Num() == TexelCount && Pixels.Num() == 0 : Pixels.Num() == TexelCount);
+    }
+};
+
+struct FOmniCaptureCPUCubemap
+{
+    FOmniCaptureCPUFace Faces[6];
+    EOmniCapturePixelPrecision Precision = EOmniCapturePixelPrecision::Unknown;
+
+    bool IsValid() const
+    {
+        for (int32 Index = 0; Index < 6; ++Index)
+        {
+            if (!Faces[Index].IsValid())
+            {
+                return false;
+            }
+        }
+
+        return Precision != EOmniCapturePixelPrecision::Unknown;
+    }
+};
+
+/**
+ * A CPU reprojection that has not run yet. It owns the read-back faces and produces the output a band of rows at a time,
+ * so a writer can stream the frame to disk without the full projected image ever being resident.
+ */
+struct OMNICAPTURE_API FOmniCaptureCPURowSource
+{
+    FOmniCaptureCPURowSource() = default;
+    UE_NONCOPYABLE(FOmniCaptureCPURowSource);
+
+    FOmniCaptureCPUCubemap LeftCubemap;
+    FOmniCaptureCPUCubemap RightCubemap;
+    FIntPoint Size = FIntPoint::ZeroValue;
+    bool bIsLinear = false;
+    EOmniCapturePixelPrecision PixelPrecision = EOmniCapturePixelPrecision::Unknown;
+    EOmniCapturePixelDataType PixelDataType = EOmniCapturePixelDataType::Unknown;
+    int32 MaxWorkers = 0;
+    TFunction<void(int32 Y, FLinearColor* OutRow)> GatherRow;
+
+    bool IsValid() const
+    {
+        return Size.X > 0 && Size.Y > 0 && GatherRow;
+    }
+
+    int64 GetBytesPerRow() const;
+
+    /** Face memory held until the frame is written; what a queued streamed frame costs instead of its output image. */
+    int64 GetResidentBytes() const;
+
+    /** Fills RowCount rows starting at RowStart with tightly packed PixelDataType pixels. */
+    void ProduceRows(int32 RowStart, int32 RowCount, void* OutRows) const;
+};
+
+/**
+ * CPU fallback reprojection from read-back cube faces.
+ * Output rows are split into tiles that task-graph workers claim in ascending order; every pixel is computed
+ * independently, so the result is identical for any worker count.
+ * With bCacheCPUReprojectionLUT the per-pixel direction and face lookup is done once per settings combination and
+ * cached as a sampling map shared by both eyes and every pass; bPersistCPUReprojectionLUT also keeps it on disk.
+ * Rows are gathered and packed through FOmniCaptureCPUKernels, nearest or bilinear per bBilinearCPUSampling.
+ * The Stream variants defer that work to whoever pulls rows from the returned row source.
+ */
+class OMNICAPTURE_API FOmniCaptureCPUReprojection
+{
+public:
+    /** MaxWorkers <= 0 uses every task-graph worker plus the calling thread; 1 runs serially on the calling thread. */
+    static void ConvertToEquirectangular(const FOmniCaptureSettings& Settings, const FOmniCaptureCPUCubemap& LeftCubemap, const FOmniCaptureCPUCubemap& RightCubemap, FOmniCaptureEquirectResult& OutResult, int32 MaxWorkers = 0);
+    static void ConvertToFisheye(const FOmniCaptureSettings& Settings, const FOmniCaptureCPUCubemap& LeftCubemap, const FOmniCaptureCPUCubemap& RightCubemap, FOmniCaptureEquirectResult& OutResult, int32 MaxWorkers = 0);
+
+    /** Like the Convert functions, but leave PixelData empty and hand back an FOmniCaptureCPURowSource in OutResult.RowSource. */
+    static void StreamToEquirectangular(const FOmniCaptureSettings& Settings, FOmniCaptureCPUCubemap&& LeftCubemap, FOmniCaptureCPUCubemap&& RightCubemap, FOmniCaptureEquirectResult& OutResult, int32 MaxWorkers = 0);
+    static void StreamToFisheye(const FOmniCaptureSettings& Settings, FOmniCaptureCPUCubemap&& LeftCubemap, FOmniCaptureCPUCubemap&& RightCubemap, FOmniCaptureEquirectResult& OutResult, int32 MaxWorkers = 0);
+
+    /** Number of threads a MaxWorkers of zero resolves to. */
+    static int32 GetMaxWorkerCount();
+
+    /** Drops every cached sampling map; files on disk are left alone. */
+    static void ResetLUTCache();
+    static int32 GetCachedLUTCount();
+    static FString GetLUTCacheDirectory();
+};
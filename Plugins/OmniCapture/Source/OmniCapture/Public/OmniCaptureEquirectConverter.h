@@ -8,11 +8,11 @@
 // 公共头只做前置声明，避免路径/版本差异在项目内扩散
 class UTextureRenderTarget2D;
 class FTextureRenderTargetResource;
+struct FOmniCaptureCPURowSource;
 
 struct FOmniCaptureEquirectResult
 {
     TUniquePtr<FImagePixelData> PixelData;
-    TArray<FColor> PreviewPixels;
     FIntPoint Size = FIntPoint::ZeroValue;
     bool bIsLinear = false;
     bool bUsedCPUFallback = false;
@@ -23,6 +23,8 @@ struct FOmniCaptureEquirectResult
     FTextureRHIRef Texture;
     FGPUFenceRHIRef ReadyFence;
     TArray<TRefCountPtr<IPooledRenderTarget>> EncoderPlanes;
+    /** Set instead of PixelData when the CPU fallback streams rows to the writer. */
+    TSharedPtr<FOmniCaptureCPURowSource, ESPMode::ThreadSafe> RowSource;
 };
 
 class OMNICAPTURE_API FOmniCaptureEquirectConverter
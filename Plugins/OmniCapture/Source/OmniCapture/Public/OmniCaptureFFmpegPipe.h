@@ -0,0 +1,61 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformProcess.h"
+#include "Templates/Atomic.h"
+
+struct FOmniCaptureFFmpegPipeInput;
+
+struct FOmniCaptureFFmpegPipeStats
+{
+    int32 VideoPushes = 0;
+    int64 VideoBytes = 0;
+    int64 AudioBytes = 0;
+    /** Pushes that found their input full and waited for ffmpeg to catch up, and how long they waited in total. */
+    int32 BlockedPushes = 0;
+    double BlockedSeconds = 0.0;
+    /** Pushes refused because ffmpeg had exited or an input broke. */
+    int32 DroppedPushes = 0;
+};
+
+/**
+ * A running ffmpeg fed raw frames on stdin and, optionally, raw PCM on a second (named) pipe. Each input is drained by
+ * its own writer thread, so a reader busy on one never starves the other. A push blocks once MaxQueuedBytes are already
+ * waiting on its input, which is how a slow encode pushes back into the capture ring buffer instead of growing memory.
+ */
+class OMNICAPTURE_API FOmniCaptureFFmpegPipe
+{
+public:
+    /** Replaced in the arguments with the path ffmpeg should open for audio. */
+    static const TCHAR* GetAudioPipeToken() { return TEXT("{AudioPipe}"); }
+
+    FOmniCaptureFFmpegPipe();
+    ~FOmniCaptureFFmpegPipe();
+
+    /** Launches Binary with Arguments; bWithAudio creates the audio pipe and fills in GetAudioPipeToken(). */
+    bool Start(const FString& Binary, const FString& Arguments, const FString& WorkingDirectory, bool bWithAudio, int64 MaxQueuedBytes);
+    /** False once ffmpeg has gone away; the bytes are dropped. */
+    bool PushVideo(TArray64<uint8>&& Bytes);
+    bool PushAudio(TArray64<uint8>&& Bytes);
+    /** Ends both inputs, waits for ffmpeg to finish the file and returns its exit code; INDEX_NONE if it never started. */
+    int32 Finish();
+
+    bool IsStarted() const { return bStarted; }
+    bool HasAudio() const { return AudioInput.IsValid(); }
+    FOmniCaptureFFmpegPipeStats GetStats() const;
+
+private:
+    bool Push(FOmniCaptureFFmpegPipeInput& Input, TArray64<uint8>&& Bytes);
+    bool IsProcessRunning() const;
+
+    FProcHandle ProcHandle;
+    void* StdInRead = nullptr;
+    void* StdInWrite = nullptr;
+    TUniquePtr<FOmniCaptureFFmpegPipeInput> VideoInput;
+    TUniquePtr<FOmniCaptureFFmpegPipeInput> AudioInput;
+    int64 MaxQueuedBytes = 0;
+    bool bStarted = false;
+
+    FOmniCaptureFFmpegPipeStats Stats;
+    mutable FCriticalSection StatsCS;
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IFileHandle;
+
+/**
+ * One .omnipack per segment holds every encoded frame file (PNG, JPG, BMP, EXR or intermediate, plus auxiliary layers)
+ * back to back, so a long take is a single growing file instead of hundreds of thousands. Each payload is preceded by a
+ * small chunk header and the file ends in an index; a pack that was never closed is recovered by walking the chunks.
+ * A repeated frame is a reference chunk pointing at the earlier payload, so held shots cost a header per frame.
+ */
+struct FOmniCaptureFramePackEntry
+{
+    int32 FrameIndex = INDEX_NONE;
+    /** File name the frame would have had on disk, e.g. Take_000042_Depth.png. */
+    FString Name;
+    /** The frame's beauty image, as opposed to one of its layers. */
+    bool bPrimary = true;
+    int64 Offset = 0;
+    int64 Size = 0;
+};
+
+class OMNICAPTURE_API FOmniCaptureFramePackWriter
+{
+public:
+    static const TCHAR* GetExtension() { return TEXT(".omnipack"); }
+
+    ~FOmniCaptureFramePackWriter();
+
+    /** The file is grown PreallocateBytes at a time and trimmed on Close; 0 lets it grow with every append. */
+    bool Open(const FString& InFilePath, int64 PreallocateBytes);
+    /** Safe to call from several threads; entries land in call order. */
+    bool Append(int32 FrameIndex, const FString& Name, bool bPrimary, const uint8* Data, int64 Size);
+    /** Adds Name as another name for the bytes already appended under SourceName, without storing them twice. */
+    bool AppendReference(int32 FrameIndex, const FString& Name, bool bPrimary, const FString& SourceName);
+    /** Writes the index and trims the preallocated tail. */
+    bool Close();
+
+    bool IsOpen() const { return Handle.IsValid(); }
+    const FString& GetFilePath() const { return FilePath; }
+    /** Header, chunks and payloads written so far, without the unused preallocated tail. */
+    int64 GetBytesWritten() const { return BytesWritten.Load(); }
+    int32 GetEntryCount() const;
+
+private:
+    bool EnsureCapacity(int64 RequiredEnd);
+    /** Both expect WriteCS to be held. */
+    bool WriteChunk(int32 FrameIndex, const FString& Name, uint8 Flags, const uint8* Data, int64 Size, int64& OutPayloadOffset);
+    void AddEntry(int32 FrameIndex, const FString& Name, bool bPrimary, int64 Offset, int64 Size);
+
+    FString FilePath;
+    TUniquePtr<IFileHandle> Handle;
+    TArray<FOmniCaptureFramePackEntry> Entries;
+    TMap<FString, int32> EntryByName;
+    int64 WriteOffset = 0;
+    int64 AllocatedBytes = 0;
+    int64 GrowBytes = 0;
+    bool bFailed = false;
+    TAtomic<int64> BytesWritten { 0 };
+    mutable FCriticalSection WriteCS;
+};
+
+class OMNICAPTURE_API FOmniCaptureFramePackReader
+{
+public:
+    ~FOmniCaptureFramePackReader();
+
+    bool Open(const FString& InFilePath);
+    void Close();
+
+    const TArray<FOmniCaptureFramePackEntry>& GetEntries() const { return Entries; }
+    /** True when the pack had no index and its entries were found by scanning the chunks. */
+    bool WasRecovered() const { return bRecovered; }
+    const FOmniCaptureFramePackEntry* FindEntry(const FString& Name) const;
+    /** Indices into GetEntries() of every beauty image, ordered by frame. */
+    TArray<int32> GetPrimaryEntriesInFrameOrder() const;
+    /** Safe to call from several threads. */
+    bool ReadEntry(const FOmniCaptureFramePackEntry& Entry, TArray64<uint8>& OutData) const;
+    /** Writes every entry into Directory under its original file name. */
+    bool ExtractToDirectory(const FString& Directory, int32* OutFilesWritten = nullptr) const;
+
+private:
+    bool ReadIndex(int64 IndexOffset, int64 IndexBytes);
+    void RecoverEntries(int64 FileSize);
+
+    FString FilePath;
+    TUniquePtr<IFileHandle> Handle;
+    TArray<FOmniCaptureFramePackEntry> Entries;
+    TMap<FString, int32> EntryByName;
+    bool bRecovered = false;
+    mutable FCriticalSection ReadCS;
+};
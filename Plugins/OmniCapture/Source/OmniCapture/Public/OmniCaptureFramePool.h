@@ -0,0 +1,78 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ImagePixelData.h"
+#include "OmniCaptureTypes.h"
+#include "Templates/Atomic.h"
+
+/**
+ * Process-wide recycler for capture frames and their pixel storage.
+ * Pixel arrays are bucketed by pixel type and size class so a returned 8K buffer can back the next 8K frame
+ * without touching the allocator. The budget caps idle buffers only, and anything returned beyond it is freed; frames in
+ * flight are bounded by the ring buffer's FOmniCaptureMemoryBudget instead.
+ */
+class OMNICAPTURE_API FOmniCaptureFramePool
+{
+public:
+    static FOmniCaptureFramePool& Get();
+
+    /** Sets the idle-memory budget. Zero disables pooling and releases everything currently held. */
+    void Configure(int64 InBudgetBytes);
+    void Trim();
+
+    template <typename PixelType>
+    TUniquePtr<TImagePixelData<PixelType>> AcquirePixels(const FIntPoint& Size)
+    {
+        const int64 PixelCount = static_cast<int64>(FMath::Max(0, Size.X)) * FMath::Max(0, Size.Y);
+        TArray64<PixelType> Storage;
+        AcquireStorage(Storage, PixelCount);
+        return MakeUnique<TImagePixelData<PixelType>>(Size, MoveTemp(Storage));
+    }
+
+    /** Returns the pixel storage of any FColor / FFloat16Color / FLinearColor image; other types are simply freed. */
+    void ReleasePixels(TUniquePtr<FImagePixelData>&& PixelData);
+
+    TUniquePtr<FOmniCaptureFrame> AcquireFrame();
+    void ReleaseFrame(TUniquePtr<FOmniCaptureFrame>&& Frame);
+
+    FOmniCaptureFramePoolStats GetStats() const;
+
+private:
+    FOmniCaptureFramePool();
+
+    template <typename PixelType>
+    struct TBucketSet
+    {
+        TMap<int64, TArray<TArray64<PixelType>>> Buckets;
+    };
+
+    void AcquireStorage(TArray64<FColor>& OutStorage, int64 PixelCount);
+    void AcquireStorage(TArray64<FFloat16Color>& OutStorage, int64 PixelCount);
+    void AcquireStorage(TArray64<FLinearColor>& OutStorage, int64 PixelCount);
+
+    template <typename PixelType>
+    void AcquireFromBuckets(TBucketSet<PixelType>& Set, TArray64<PixelType>& OutStorage, int64 PixelCount);
+
+    template <typename PixelType>
+    void ReturnToBuckets(TBucketSet<PixelType>& Set, TArray64<PixelType>&& Storage);
+
+    template <typename PixelType>
+    void ClearBuckets(TBucketSet<PixelType>& Set);
+
+    static int64 GetSizeClassBytes(int64 Bytes, bool bRoundUp);
+
+    mutable FCriticalSection PoolCS;
+    TBucketSet<FColor> ColorBuckets;
+    TBucketSet<FFloat16Color> HalfBuckets;
+    TBucketSet<FLinearColor> FloatBuckets;
+    TArray<TUniquePtr<FOmniCaptureFrame>> IdleFrames;
+
+    /** Read on every release without PoolCS, so it is atomic; PooledBytes is only touched under the lock. */
+    TAtomic<int64> BudgetBytes { 0 };
+    int64 PooledBytes = 0;
+    TAtomic<int64> BufferHits;
+    TAtomic<int64> BufferMisses;
+    TAtomic<int64> BuffersDiscarded;
+    TAtomic<int64> FrameHits;
+    TAtomic<int64> FrameMisses;
+};
@@ -2,10 +2,16 @@
 
 #include "CoreMinimal.h"
 #include "OmniCaptureTypes.h"
+#include "OmniCaptureWorkerPool.h"
 #include "Async/Future.h"
 #include "Templates/Function.h"
 #include "ImageWriteTypes.h"
 
+class FEvent;
+class FOmniCaptureFramePackWriter;
+class FOmniCaptureMemoryBudget;
+struct FOmniCaptureCPURowSource;
+
 class OMNICAPTURE_API FOmniCaptureImageWriter
 {
 public:
@@ -13,10 +19,28 @@ public:
     ~FOmniCaptureImageWriter();
 
     void Initialize(const FOmniCaptureSettings& Settings, const FString& InOutputDirectory);
+    /** Frame reservations handed to the writer are released when the write task finishes. */
+    void SetMemoryBudget(FOmniCaptureMemoryBudget* InMemoryBudget) { MemoryBudget = InMemoryBudget; }
     void EnqueueFrame(TUniquePtr<FOmniCaptureFrame>&& Frame, const FString& FrameFileName);
+    /**
+     * With bDeduplicateFrames, compares the frame with the one linked before it. Call in FrameIndex order ahead of
+     * EnqueueFrame when frames are enqueued from several threads; frames that were not linked are linked on enqueue.
+     */
+    void LinkFrame(const FOmniCaptureFrame& Frame);
+    /** Writes the frame and its auxiliary layers on the calling thread; safe to call from several threads at once. */
+    bool WriteFrame(TUniquePtr<FOmniCaptureFrame>&& Frame, const FString& FrameFileName) const;
     void Flush();
     const TArray<FOmniCaptureFrameMetadata>& GetCapturedFrames() const { return CapturedMetadata; }
     TArray<FOmniCaptureFrameMetadata> ConsumeCapturedFrames();
+    /** Totals over every PNG written so far; seconds are summed per file, so concurrent writes overlap. */
+    FOmniCapturePNGEncodeStats GetPNGEncodeStats() const;
+    FOmniCaptureImageWriterStats GetTaskStats() const;
+    /** Where frames go when Settings.bWriteFramePack is on: <OutputDirectory>/<OutputFileName>.omnipack. */
+    FString GetFramePackPath() const;
+    /** 0 when frames are written as loose files. */
+    int64 GetFramePackBytesWritten() const;
+    /** Everything this writer has put on disk so far, loose files and pack together; kept as files complete, no stat calls. */
+    int64 GetBytesWritten() const;
 
 private:
     struct FExrLayerRequest
@@ -28,9 +52,18 @@ private:
         EOmniCapturePixelDataType PixelDataType = EOmniCapturePixelDataType::Unknown;
     };
 
+    struct FDedupFrame;
+
+    bool WriteFrameFiles(const FString& FilePath, EOmniCaptureImageFormat Format, bool bIsLinear, EOmniCapturePixelPrecision PixelPrecision, EOmniCapturePixelDataType PixelDataType, TUniquePtr<FImagePixelData> PixelData, TSharedPtr<FOmniCaptureCPURowSource, ESPMode::ThreadSafe> RowSource, TMap<FName, FOmniCaptureLayerPayload>&& AuxiliaryLayers) const;
     bool WritePixelDataToDisk(TUniquePtr<FImagePixelData> PixelData, const FString& FilePath, EOmniCaptureImageFormat Format, bool bIsLinear, EOmniCapturePixelPrecision PixelPrecision, EOmniCapturePixelDataType PixelDataType) const;
     bool WritePNGRaw(const FString& FilePath, const FIntPoint& Size, const void* RawData, int64 RawSizeInBytes, ERGBFormat Format, int32 BitDepth) const;
-    bool WritePNGWithRowSource(const FString& FilePath, const FIntPoint& Size, ERGBFormat Format, int32 BitDepth, TFunctionRef<void(int32 RowStart, int32 RowCount, int64 BytesPerRow, TArray64<uint8>& TempBuffer, TArray<uint8*>& RowPointers)> PrepareRows) const;
+    /** RowsPerChunk <= 0 sizes chunks to roughly 64 MB of encoded rows. */
+    bool WritePNGWithRowSource(const FString& FilePath, const FIntPoint& Size, ERGBFormat Format, int32 BitDepth, TFunctionRef<void(int32 RowStart, int32 RowCount, int64 BytesPerRow, TArray64<uint8>& TempBuffer, TArray<uint8*>& RowPointers)> PrepareRows, int32 RowsPerChunk = 0) const;
+    /** Writes a frame that is still a CPU row source, pulling StreamingBandRows rows at a time where the format allows it. */
+    bool WriteRowSourceToDisk(const FOmniCaptureCPURowSource& RowSource, const FString& FilePath, EOmniCaptureImageFormat Format) const;
+    void RecordPNGEncode(double Seconds, int64 RawBytes, int64 EncodedBytes) const;
+    bool WriteStreamedPNG(const FOmniCaptureCPURowSource& RowSource, const FString& FilePath) const;
+    bool WriteStreamedEXR(const FOmniCaptureCPURowSource& RowSource, const FString& FilePath) const;
     bool WritePNG(const TImagePixelData<FColor>& PixelData, const FString& FilePath) const;
     bool WritePNGFromLinear(const TImagePixelData<FFloat16Color>& PixelData, const FString& FilePath) const;
     bool WritePNGFromLinearFloat32(const TImagePixelData<FLinearColor>& PixelData, const FString& FilePath) const;
@@ -45,13 +78,25 @@ private:
     bool WriteEXRInternal(TUniquePtr<FImagePixelData> PixelData, const FString& FilePath, EImagePixelType PixelType) const;
     bool WriteEXRFrame(const FString& FilePath, bool bIsLinear, TUniquePtr<FImagePixelData> PixelData, EOmniCapturePixelPrecision PixelPrecision, EOmniCapturePixelDataType PixelDataType, TMap<FName, FOmniCaptureLayerPayload>&& AuxiliaryLayers, const FString& LayerDirectory, const FString& LayerBaseName, const FString& LayerExtension) const;
     bool WriteCombinedEXR(const FString& FilePath, TArray<FExrLayerRequest>& Layers) const;
+    /** Gives Frame's files the bytes Source already stored: hard links on disk, references in a frame pack. */
+    static bool StoreDuplicateFiles(const FDedupFrame& Source, const FDedupFrame& Frame, FOmniCaptureFramePackWriter* Pack, TAtomic<int64>* BytesWritten);
+    /** Hashes the frame and makes it the next link in the chain, pointing at the run it repeats if any. */
+    TSharedPtr<FDedupFrame, ESPMode::ThreadSafe> LinkDedupFrame(const FOmniCaptureFrame& Frame);
+    /** Linked frames that never get written are marked as failed, so repeats waiting on them finish. */
+    void AbandonLinkedFrames();
     void RequestStop();
     bool IsStopRequested() const;
-    void WaitForAvailableTaskSlot();
-    void TrackPendingTask(TFuture<bool>&& TaskFuture);
-    void PruneCompletedTasks();
-    void EnforcePendingTaskLimit();
+    bool TryAcquireTaskSlot();
+    /** Blocks until any write task finishes and hands back its slot; false once a stop is requested. */
+    bool AcquireTaskSlot();
+    void CompleteTask(const FString& FilePath, double EnqueueTime, double StartTime, double EncodeEndTime, double IOSeconds, bool bSucceeded);
     void WaitForAllTasks();
+    /** Started on the first frame rather than in Initialize, so writers that only call WriteFrame never spawn threads or open a pack. */
+    void EnsureWorkerPools();
+
+    static constexpr uint32 SlotWaitTimeoutMilliseconds = 50;
+    /** Enqueue-to-finish time past which a write counts as a stall. */
+    static constexpr double StalledTaskSeconds = 1.0;
 
     bool bInitialized = false;
     FString OutputDirectory;
@@ -62,12 +107,61 @@ private:
     bool bPackEXRAuxiliaryLayers = true;
     bool bUseEXRMultiPart = false;
     EOmniCaptureEXRCompression TargetEXRCompression = EOmniCaptureEXRCompression::Zip;
+    /** Threads OpenEXR compresses each file's line blocks on; 0 = one per worker core, 1 = on the encode thread. */
+    int32 EXRThreadCount = 0;
+    int32 StreamingBandRows = 128;
+    /** 1 keeps the single-stream libpng encoder; otherwise PNGs are deflated in strips on up to this many threads (0 = one on the encode pool, all workers elsewhere). */
+    int32 PNGEncodeThreads = 0;
+    EOmniCapturePNGCompression TargetPNGCompression = EOmniCapturePNGCompression::Balanced;
+    int32 JPEGQuality = 85;
+    EOmniCaptureJPEGSubsampling JPEGSubsampling = EOmniCaptureJPEGSubsampling::Subsampling420;
+    bool bJPEGFastDCT = false;
+    /** 1 encodes each JPEG in one piece; otherwise large frames are split into restart-interval strips (0 = none on the encode pool, all workers elsewhere). */
+    int32 JPEGEncodeThreads = 0;
+    /** 0 = one thread per core the engine would give its own workers. */
+    int32 EncodeThreadCount = 0;
+    uint64 EncodeThreadAffinityMask = 0;
+    /** 0 writes each file on the thread that encoded it. */
+    int32 IOThreadCount = 1;
+    bool bWriteFramePack = false;
+    int64 FramePackPreallocateBytes = 0;
+    /** A frame identical to the one before it (by FrameIndex) is linked to that frame's files instead of being encoded again. */
+    bool bDeduplicateFrames = false;
+    FOmniCaptureMemoryBudget* MemoryBudget = nullptr;
+
+    FOmniCaptureWorkerPool EncodePool;
+    FOmniCaptureWorkerPool IOPool;
+    TUniquePtr<FOmniCaptureFramePackWriter> FramePack;
+    TAtomic<bool> bWorkerPoolsStarted;
+    mutable FCriticalSection WorkerPoolCS;
+
+    /** The frame linked last, for the next one to compare against. Guarded by DedupCS. */
+    TSharedPtr<FDedupFrame, ESPMode::ThreadSafe> LastDedupFrame;
+    /** Frames LinkFrame linked that EnqueueFrame has not taken yet, by FrameIndex. Guarded by DedupCS. */
+    TMap<int32, TSharedPtr<FDedupFrame, ESPMode::ThreadSafe>> LinkedDedupFrames;
+    FCriticalSection DedupCS;
+    TAtomic<int32> DuplicateFrames;
+    TAtomic<int64> LooseBytesWritten;
 
     TArray<FOmniCaptureFrameMetadata> CapturedMetadata;
     FCriticalSection MetadataCS;
 
-    TArray<TFuture<bool>> PendingTasks;
-    FCriticalSection PendingTasksCS;
+    mutable FOmniCapturePNGEncodeStats PNGStats;
+    mutable FCriticalSection PNGStatsCS;
+
+    TAtomic<int32> InFlightTasks;
+    TAtomic<int32> PeakInFlightTasks;
+    /** In-flight repeats still waiting for their run's first frame. They hold no pixels, so they take no slot. */
+    TAtomic<int32> WaitingRepeats;
+    TAtomic<int32> WaitingForSlot;
+    FEvent* TaskCompletedEvent = nullptr;
+
+    FOmniCaptureImageWriterStats TaskStats;
+    double TotalQueueSeconds = 0.0;
+    double TotalEncodeSeconds = 0.0;
+    double TotalIOSeconds = 0.0;
+    mutable FCriticalSection TaskStatsCS;
+
     TAtomic<bool> bStopRequested;
 };
 
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ImagePixelData.h"
+#include "OmniCaptureTypes.h"
+
+/**
+ * Lossless capture intermediate: a 32-byte header followed by either a QOI stream (8-bit frames) or the pixel array as
+ * it sits in memory (half, float, scalar and vector layers). Cheap enough that the writer keeps up with the GPU;
+ * FOmniCaptureTranscoder turns the files into the final format once the take is over.
+ */
+class OMNICAPTURE_API FOmniCaptureIntermediateFormat
+{
+public:
+    static const TCHAR* GetExtension() { return TEXT(".omniraw"); }
+
+    static bool Write(const FString& FilePath, const FImagePixelData& PixelData, bool bIsLinear, EOmniCapturePixelPrecision Precision, EOmniCapturePixelDataType PixelDataType);
+    /** The same file, built in memory for writers that hand the bytes to another thread. */
+    static bool Encode(const FImagePixelData& PixelData, bool bIsLinear, EOmniCapturePixelPrecision Precision, EOmniCapturePixelDataType PixelDataType, TArray64<uint8>& OutFile);
+    /** Pixel storage comes from the frame pool where the type is pooled. */
+    static bool Read(const FString& FilePath, TUniquePtr<FImagePixelData>& OutPixelData, bool& bOutIsLinear, EOmniCapturePixelPrecision& OutPrecision, EOmniCapturePixelDataType& OutPixelDataType);
+
+    /** Appends a complete QOI image (header, ops, end marker) to Out. */
+    static void EncodeQOI(const FColor* Pixels, const FIntPoint& Size, TArray64<uint8>& Out);
+    /** Fails if the stream is malformed or its dimensions differ from Size. */
+    static bool DecodeQOI(const uint8* Data, int64 Length, const FIntPoint& Size, FColor* OutPixels);
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OmniCaptureTypes.h"
+
+struct FOmniCaptureJPEGEncodeOptions
+{
+    /** libjpeg quality, 1-100. */
+    int32 Quality = 85;
+    EOmniCaptureJPEGSubsampling Subsampling = EOmniCaptureJPEGSubsampling::Subsampling420;
+    /** libjpeg's fast integer DCT: noticeably quicker, slightly less accurate at high quality settings. */
+    bool bFastDCT = false;
+    /** <= 0 uses every task-graph worker plus the calling thread; 1 encodes serially on the calling thread. */
+    int32 MaxThreads = 0;
+    /** Frames are cut into strips of at least this many pixels; smaller frames are encoded in one piece. */
+    int64 MinStripPixels = 1024 * 1024;
+};
+
+/**
+ * JPEG encoder that hands BGRA rows straight to libjpeg-turbo, without the IImageWrapper copy. Large frames are cut into
+ * strips whose height is a whole number of MCU rows; each strip is compressed on its own thread and the scans are joined
+ * with RSTn markers under a DRI segment whose interval is one strip. Every strip starts with fresh DC predictors and
+ * uses the same standard tables, so the result is the file a single encoder would write with that restart interval.
+ */
+class OMNICAPTURE_API FOmniCaptureJPEGEncoder
+{
+public:
+    /** False when the module was built without libjpeg-turbo; callers then fall back to IImageWrapper. */
+    static bool IsAvailable();
+
+    /** Encodes Size.X * Size.Y tightly packed FColor pixels; alpha is dropped. */
+    static bool Encode(const FIntPoint& Size, const FColor* Pixels, const FOmniCaptureJPEGEncodeOptions& Options, TArray64<uint8>& OutJPEG);
+};
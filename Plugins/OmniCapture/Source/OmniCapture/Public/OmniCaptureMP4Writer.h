@@ -0,0 +1,131 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IFileHandle;
+struct FOmniCaptureSettings;
+
+enum class EOmniCaptureMP4Codec : uint8 { H264, HEVC };
+
+/** Google spherical video (st3d/sv3d) and spatial audio (SA3D) boxes; with bEnabled off the file carries none. */
+struct FOmniCaptureMP4Spherical
+{
+    bool bEnabled = false;
+    /** As st3d stores it: 0 mono, 1 top-bottom, 2 left-right. */
+    uint8 StereoMode = 0;
+    /** Fraction of the sphere cropped away at each edge of the equirectangular frame; VR180 drops a quarter left and right. */
+    double BoundTop = 0.0;
+    double BoundBottom = 0.0;
+    double BoundLeft = 0.0;
+    double BoundRight = 0.0;
+    /** The audio track is ACN/SN3D ambisonics; needs (order + 1)^2 channels. */
+    bool bAmbisonicAudio = false;
+};
+
+struct FOmniCaptureMP4Config
+{
+    EOmniCaptureMP4Codec Codec = EOmniCaptureMP4Codec::H264;
+    int32 Width = 0;
+    int32 Height = 0;
+    double FrameRate = 30.0;
+    /** Sample durations come from FrameRate rather than from the gaps between timestamps. */
+    bool bConstantFrameRate = true;
+    /** A track of 16-bit PCM in the format below; audio in any other format is left out. */
+    bool bWithAudio = false;
+    int32 AudioSampleRate = 48000;
+    int32 AudioChannels = 2;
+    /** A fragment is closed at the first key frame after this much video. */
+    double FragmentSeconds = 1.0;
+    FOmniCaptureMP4Spherical Spherical;
+
+    static FOmniCaptureMP4Config FromSettings(const FOmniCaptureSettings& Settings);
+};
+
+/**
+ * Writes H.264/HEVC Annex-B access units and interleaved PCM into a fragmented MP4 as they arrive, so a capture that
+ * stops abruptly still leaves a playable file up to its last fragment. avcC/hvcC are built from the SPS/PPS/VPS found
+ * in the stream, which are then kept out of the samples. Close can relay the fragments out into a single moov-first
+ * file for players that prefer a progressive layout. Audio is stored as little-endian PCM under QuickTime's 'sowt'
+ * sample entry, which ffmpeg and common players read although it is not part of the ISO base media format.
+ */
+class OMNICAPTURE_API FOmniCaptureMP4Writer
+{
+public:
+    ~FOmniCaptureMP4Writer();
+
+    bool Open(const FString& InFilePath, const FOmniCaptureMP4Config& InConfig);
+    /**
+     * One access unit with its start codes. Parameter sets may come with the first key frame or in a buffer of their
+     * own; frames before the first key frame are dropped. TimestampSeconds is the clock the audio shares; its
+     * origin is the first key frame, so both streams may count from any point.
+     */
+    bool AddVideo(const uint8* AnnexB, int64 Size, bool bKeyFrame, double TimestampSeconds);
+    /** Interleaved samples placed by timestamp against the first video frame: gaps become silence and overlaps are trimmed. */
+    bool AddAudio(const int16* Samples, int32 FrameCount, int32 SampleRate, int32 NumChannels, double TimestampSeconds);
+    /** Writes the last fragment; bFastStart then rewrites the file as one moov-first progressive MP4. */
+    bool Close(bool bFastStart);
+
+    bool IsOpen() const { return Handle.IsValid(); }
+    const FString& GetFilePath() const { return FilePath; }
+    int32 GetVideoSampleCount() const { return VideoSamples.Num() + PendingVideo.Num(); }
+    int64 GetAudioFrameCount() const { return AudioFramesWritten + AudioFramesQueued; }
+    int32 GetFragmentCount() const { return Fragments.Num(); }
+    int64 GetBytesWritten() const { return WriteOffset; }
+
+private:
+    struct FVideoSample
+    {
+        uint32 Size = 0;
+        uint32 Duration = 0;
+        bool bSync = false;
+    };
+
+    struct FFragment
+    {
+        /** Where this fragment's mdat payload starts in the fragmented file: video bytes, then audio bytes. */
+        int64 PayloadOffset = 0;
+        int64 VideoBytes = 0;
+        int32 FirstVideoSample = 0;
+        int32 VideoSampleCount = 0;
+        int64 AudioFrames = 0;
+    };
+
+    bool WriteHeader();
+    bool FlushFragment();
+    bool WriteBytes(const uint8* Data, int64 Size);
+    /** The whole moov; bProgressive adds full sample tables with chunks from PayloadBase in the relaid file. */
+    TArray<uint8> BuildMovie(bool bProgressive, int64 PayloadBase) const;
+    bool RewriteFastStart();
+    int64 GetAudioBytesPerFrame() const { return static_cast<int64>(AudioChannels) * sizeof(int16); }
+
+    FString FilePath;
+    FOmniCaptureMP4Config Config;
+    TUniquePtr<IFileHandle> Handle;
+    int64 WriteOffset = 0;
+    bool bHeaderWritten = false;
+    bool bFailed = false;
+
+    TArray<TArray<uint8>> VPS;
+    TArray<TArray<uint8>> SPS;
+    TArray<TArray<uint8>> PPS;
+
+    double TimeOrigin = 0.0;
+    bool bHasTimeOrigin = false;
+    int64 LastVideoTicks = 0;
+
+    /** Samples already in a fragment, then the ones waiting for the next; the last pending one may still lack its duration. */
+    TArray<FVideoSample> VideoSamples;
+    TArray<FVideoSample> PendingVideo;
+    TArray<uint8> PendingVideoBytes;
+    int64 VideoDecodeTicks = 0;
+    int64 PendingVideoTicks = 0;
+
+    int32 AudioSampleRate = 0;
+    int32 AudioChannels = 0;
+    int64 AudioFramesWritten = 0;
+    int64 AudioFramesQueued = 0;
+    TArray<uint8> PendingAudioBytes;
+    int32 DroppedAudioPackets = 0;
+
+    TArray<FFragment> Fragments;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OmniCaptureTypes.h"
+#include "Templates/Atomic.h"
+
+/**
+ * Byte accounting for frames in flight between the capture thread and disk.
+ * The ring buffer reserves a frame's pixel bytes on enqueue; whoever ends up owning the pixels
+ * (ring consumer or image-writer task) releases them once they are gone.
+ */
+class OMNICAPTURE_API FOmniCaptureMemoryBudget
+{
+public:
+    FOmniCaptureMemoryBudget();
+    ~FOmniCaptureMemoryBudget();
+
+    /** Zero disables the limit; bytes are still tracked for stats. */
+    void Configure(int64 InLimitBytes);
+
+    /** Beauty plus auxiliary layer pixel bytes. */
+    static int64 GetFrameBytes(const FOmniCaptureFrame& Frame);
+
+    /** A single frame larger than the whole budget is admitted when nothing else is in flight, so capture never wedges. */
+    bool TryReserve(int64 Bytes);
+    void Release(int64 Bytes);
+
+    /** Releases whatever the frame still holds and clears its reservation. */
+    void ReleaseFrame(FOmniCaptureFrame& Frame);
+
+    /** Waits up to TimeoutMilliseconds for some reservation to be released. */
+    void WaitForRelease(uint32 TimeoutMilliseconds);
+
+    bool IsLimited() const { return LimitBytes.Load() > 0; }
+    int64 GetLimitBytes() const { return LimitBytes.Load(); }
+    int64 GetInFlightBytes() const { return InFlightBytes.Load(); }
+    int64 GetPeakBytes() const { return PeakBytes.Load(); }
+
+private:
+    TAtomic<int64> LimitBytes;
+    TAtomic<int64> InFlightBytes;
+    TAtomic<int64> PeakBytes;
+    TAtomic<int32> WaitingProducers;
+    FEvent* ReleasedEvent = nullptr;
+};
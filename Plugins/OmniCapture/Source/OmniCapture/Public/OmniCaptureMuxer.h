@@ -1,23 +1,38 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "OmniCaptureFFmpegPipe.h"
 #include "OmniCaptureTypes.h"
 
 class OMNICAPTURE_API FOmniCaptureMuxer
 {
 public:
+    FOmniCaptureMuxer();
+    ~FOmniCaptureMuxer();
+
     void Initialize(const FOmniCaptureSettings& Settings, const FString& InOutputDirectory);
-    bool FinalizeCapture(const FOmniCaptureSettings& Settings, const TArray<FOmniCaptureFrameMetadata>& Frames, const FString& AudioPath, const FString& VideoPath, int32 DroppedFrames);
+    bool FinalizeCapture(const FOmniCaptureSettings& Settings, const TArray<FOmniCaptureFrameMetadata>& Frames, const FString& AudioPath, const FString& VideoPath, int32 DroppedFrames, const FOmniCapturePNGEncodeStats& PNGEncodeStats = FOmniCapturePNGEncodeStats(), int32 DuplicateFrames = 0);
     void BeginRealtimeSession(const FOmniCaptureSettings& Settings);
     void EndRealtimeSession();
     void PushFrame(const FOmniCaptureFrame& Frame);
+    /** Closes the live encode started by PushFrame when Settings.ShouldStreamToFFmpeg(); true if ffmpeg wrote the file cleanly. */
+    bool FinishLiveEncode(FOmniCaptureFFmpegPipeStats* OutStats = nullptr);
+    bool IsLiveEncodeActive() const { return LivePipe.IsValid(); }
+    /** Format of the audio the live encode will be fed; set once recording starts so it holds even when the first frames carry no audio. */
+    void SetLiveAudioFormat(int32 SampleRate, int32 NumChannels);
+    /** Audio packets the live encode skipped because they did not match its PCM input format. */
+    int32 GetLiveDroppedAudioPackets() const { return LiveDroppedAudioPackets; }
     FOmniAudioSyncStats GetAudioStats() const { return AudioStats; }
     static FString ResolveFFmpegBinary(const FOmniCaptureSettings& Settings);
     static bool IsFFmpegAvailable(const FOmniCaptureSettings& Settings, FString* OutResolvedPath = nullptr);
 
 private:
-    bool WriteManifest(const FOmniCaptureSettings& Settings, const TArray<FOmniCaptureFrameMetadata>& Frames, const FString& AudioPath, const FString& VideoPath, int32 DroppedFrames, FString& OutManifestPath) const;
+    bool WriteManifest(const FOmniCaptureSettings& Settings, const TArray<FOmniCaptureFrameMetadata>& Frames, const FString& AudioPath, const FString& VideoPath, int32 DroppedFrames, const FOmniCapturePNGEncodeStats& PNGEncodeStats, int32 DuplicateFrames, FString& OutManifestPath) const;
     bool TryInvokeFFmpeg(const FOmniCaptureSettings& Settings, const TArray<FOmniCaptureFrameMetadata>& Frames, const FString& AudioPath, const FString& VideoPath) const;
+    /** Codec, metadata, colour and container arguments shared by the offline mux and the live encode, ending with the output file. */
+    FString BuildOutputArguments(const FOmniCaptureSettings& Settings) const;
+    bool StartLiveEncode(const FOmniCaptureFrame& Frame);
+    void PushLiveAudio(const FOmniCaptureFrame& Frame);
     bool WriteSpatialMetadata(const FOmniCaptureSettings& Settings) const;
     FString BuildFFmpegBinaryPath() const;
     double CalculateFrameRate(const TArray<FOmniCaptureFrameMetadata>& Frames) const;
@@ -31,4 +46,18 @@ private:
     double LastAudioTimestamp = 0.0;
     double DriftWarningThresholdMs = 25.0;
     bool bRealtimeSessionActive = false;
+
+    TUniquePtr<FOmniCaptureFFmpegPipe> LivePipe;
+    FOmniCaptureSettings LiveSettings;
+    bool bLiveEncodeRequested = false;
+    bool bLiveEncodeFailed = false;
+    bool bLivePlanarFloat = false;
+    FIntPoint LiveFrameSize = FIntPoint::ZeroValue;
+    double LiveFrameRate = 30.0;
+    int32 LiveAudioSampleRate = 48000;
+    int32 LiveAudioChannels = 2;
+    bool bLiveAudioFormatKnown = false;
+    int64 LiveAudioFramesWritten = 0;
+    int32 LiveDroppedVideoFrames = 0;
+    int32 LiveDroppedAudioPackets = 0;
 };
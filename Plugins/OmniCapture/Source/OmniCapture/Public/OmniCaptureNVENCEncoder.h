@@ -1,7 +1,9 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "OmniCaptureMP4Writer.h"
 #include "OmniCaptureTypes.h"
+#include "Templates/Atomic.h"
 
 #if PLATFORM_WINDOWS && WITH_OMNI_NVENC
     #define OMNI_WITH_NVENC 1
@@ -19,6 +21,7 @@
     #define OMNI_WITH_NVENC 0
 #endif
 
+
 struct FOmniNVENCPresetStatus
 {
     FString Name;
@@ -59,6 +62,8 @@ public:
 
     void Initialize(const FOmniCaptureSettings& Settings, const FString& OutputDirectory);
     void EnqueueFrame(const FOmniCaptureFrame& Frame);
+    /** Format of the audio the frames carry; the MP4 opens with the first frame, and without a format it has no audio track. */
+    void SetAudioFormat(int32 SampleRate, int32 NumChannels);
     void Finalize();
 
     static bool IsNVENCAvailable();
@@ -73,6 +78,8 @@ public:
     bool IsInitialized() const { return bInitialized; }
     FString GetOutputFilePath() const { return OutputFilePath; }
     const FString& GetLastError() const { return LastErrorMessage; }
+    /** Bitstream and MP4 bytes handed to disk so far; safe to read from any thread. */
+    int64 GetBytesWritten() const { return BytesWritten.Load(); }
 
 private:
     FString OutputFilePath;
@@ -81,6 +88,7 @@ private:
     bool bZeroCopyRequested = true;
     EOmniCaptureCodec RequestedCodec = EOmniCaptureCodec::HEVC;
     FString LastErrorMessage;
+    TAtomic<int64> BytesWritten { 0 };
 
 #if OMNI_WITH_NVENC
     OmniNVENC::FNVENCSession EncoderSession;
@@ -92,6 +100,19 @@ private:
     FCriticalSection EncoderCS;
     TUniquePtr<IFileHandle> BitstreamFile;
     bool bAnnexBHeaderWritten = false;
+    /** Set with bMuxNVENCToMP4: every packet is also muxed into <OutputFileName>.mp4 as it is written. */
+    TUniquePtr<FOmniCaptureMP4Writer> MP4Writer;
+    bool bMP4FastStart = false;
+    bool bMP4Requested = false;
+    bool bMP4AudioFormatKnown = false;
+    FString MP4Path;
+    FOmniCaptureMP4Config MP4Config;
+
+    void WriteToMP4(const uint8* Data, int64 Size, bool bKeyFrame, double TimestampSeconds);
+    void CountMP4Bytes();
+    int64 MP4BytesCounted = 0;
+    /** Capture timecode of this segment's first frame; video and audio both reach the MP4 as seconds since it. */
+    double MP4TimeOrigin = -1.0;
 
     bool WriteAnnexBHeader();
 #endif
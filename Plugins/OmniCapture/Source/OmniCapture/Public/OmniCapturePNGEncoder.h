@@ -0,0 +1,72 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ImageWriteTypes.h"
+#include "OmniCaptureTypes.h"
+
+class FArchive;
+
+struct FOmniCapturePNGEncodeOptions
+{
+    /** zlib level, 0-9. */
+    int32 CompressionLevel = 6;
+    /** Chooses the cheapest of the five filters per row; otherwise every row uses Sub. */
+    bool bAdaptiveFilter = true;
+    /** zlib's Z_RLE strategy: distance-one matches only, several times faster on filtered rows for a few percent of size. */
+    bool bRunLengthMatching = false;
+    /** <= 0 uses every task-graph worker plus the calling thread; 1 encodes serially, in one strip, on the calling thread. */
+    int32 MaxThreads = 0;
+    /** Rows are grouped into strips of at least this many raw bytes; smaller strips cost ratio for no extra parallelism. */
+    int64 MinStripBytes = 256 * 1024;
+
+    static FOmniCapturePNGEncodeOptions ForProfile(EOmniCapturePNGCompression Profile);
+};
+
+/**
+ * PNG encoder that filters and deflates independent row strips on several threads and stitches them into one zlib
+ * stream: every strip but the last ends on a full-flush boundary, the stream header is written once and the adler32
+ * of the strips is combined at the end, so stock decoders see an ordinary single-stream PNG.
+ * Adaptive filtering picks each row's filter with libpng's minimum-sum-of-absolute-differences heuristic.
+ * Rows are given in the writer's native layout: BGRA or RGBA order and little-endian 16-bit channels.
+ */
+class OMNICAPTURE_API FOmniCapturePNGEncoder
+{
+public:
+    FOmniCapturePNGEncoder(FArchive& InArchive, const FIntPoint& InSize, ERGBFormat InFormat, int32 InBitDepth, const FOmniCapturePNGEncodeOptions& InOptions);
+
+    /** Writes the signature and header; false for formats or bit depths PNG cannot hold. */
+    bool Begin();
+
+    /** Encodes the next RowCount rows. Rows may arrive in any number of calls; the stream closes with the last image row. */
+    bool WriteRows(const uint8* const* Rows, int32 RowCount);
+
+    /** Writes the trailer; false if fewer rows than the image height were written or the archive failed. */
+    bool End();
+
+    /** 8/16-bit RGBA, BGRA and Gray; float formats go through the libpng path. */
+    static bool SupportsFormat(ERGBFormat Format, int32 BitDepth);
+
+    /** Encodes a whole image held in memory. */
+    static bool EncodeToMemory(const FIntPoint& Size, ERGBFormat Format, int32 BitDepth, const uint8* Pixels, int64 BytesPerRow, const FOmniCapturePNGEncodeOptions& Options, TArray64<uint8>& OutPNG);
+
+private:
+    void WriteChunk(const char* Type, const uint8* Data, int64 Length);
+
+    FArchive& Archive;
+    FIntPoint Size;
+    ERGBFormat Format;
+    int32 BitDepth;
+    FOmniCapturePNGEncodeOptions Options;
+
+    int32 Channels = 0;
+    int32 BytesPerPixel = 0;
+    int64 RowBytes = 0;
+    int32 RowsWritten = 0;
+    uint32 Adler = 1;
+    bool bBegun = false;
+
+    /** Last row of the previous WriteRows call in PNG byte order; the Up/Average/Paeth predictor for the next call. */
+    TArray64<uint8> PriorRow;
+    /** Last 32 KB of filtered bytes of the previous call; the deflate dictionary of its first strip. */
+    TArray64<uint8> Window;
+};
@@ -3,12 +3,20 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
 #include "OmniCaptureTypes.h"
+#include "Templates/Atomic.h"
 #include "OmniCapturePreviewActor.generated.h"
 
 class UStaticMeshComponent;
 class UMaterialInstanceDynamic;
 class UTexture2D;
-struct FOmniCaptureEquirectResult;
+struct FImagePixelData;
+
+/** A decimated frame built off the game thread, waiting for UploadPreview. */
+struct FOmniCapturePreviewImage
+{
+    FIntPoint Size = FIntPoint::ZeroValue;
+    TArray<FColor> Pixels;
+};
 
 UCLASS()
 class OMNICAPTURE_API AOmniCapturePreviewActor : public AActor
@@ -19,12 +27,29 @@ public:
     AOmniCapturePreviewActor();
 
     void Initialize(float InScale, const FIntPoint& InitialResolution);
-    void UpdatePreviewTexture(const FOmniCaptureEquirectResult& Result, const FOmniCaptureSettings& Settings);
+
+    /**
+     * Box-filters the frame (or the eye View shows) down to at most Settings.PreviewMaxResolution. Touches no actor state,
+     * so capture workers call it on frames that still hold their CPU pixels.
+     */
+    static bool BuildPreview(const FImagePixelData& PixelData, const FOmniCaptureSettings& Settings, EOmniCapturePreviewView View, FOmniCapturePreviewImage& OutImage);
+    /**
+     * Uploads a built preview on the render thread. Returns false while the previous upload is still queued, so a slow
+     * render thread sheds preview frames instead of capture time. Game thread only.
+     */
+    bool UploadPreview(FOmniCapturePreviewImage&& Image);
+    bool IsUploadPending() const { return PendingUploads->Load() > 0; }
     void SetPreviewEnabled(bool bEnabled);
     void SetPreviewView(EOmniCapturePreviewView InView);
+    EOmniCapturePreviewView GetPreviewView() const { return PreviewViewMode; }
     UTexture2D* GetPreviewTexture() const { return PreviewTexture; }
     FIntPoint GetPreviewResolution() const { return PreviewResolution; }
 
+    static FIntPoint GetDecimatedSize(const FIntPoint& SourceSize, int32 MaxResolution);
+
+    /** Averages SourceRect into TargetSize sRGB pixels; large footprints are box-sampled on an evenly spaced 4x4 grid. */
+    static void DownsamplePreview(const FImagePixelData& Source, const FIntRect& SourceRect, const FIntPoint& TargetSize, TArray<FColor>& OutPixels);
+
 protected:
     virtual void BeginPlay() override;
 
@@ -48,5 +73,5 @@ private:
     float PreviewScale = 1.0f;
     FIntPoint PreviewResolution = FIntPoint::ZeroValue;
     EOmniCapturePreviewView PreviewViewMode = EOmniCapturePreviewView::StereoComposite;
-    TArray<FColor> PreviewScratchBuffer;
+    TSharedRef<TAtomic<int32>, ESPMode::ThreadSafe> PendingUploads = MakeShared<TAtomic<int32>, ESPMode::ThreadSafe>(0);
 };
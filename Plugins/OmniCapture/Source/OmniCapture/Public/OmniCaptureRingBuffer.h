@@ -2,8 +2,10 @@
 
 #include "CoreMinimal.h"
 #include "OmniCaptureTypes.h"
+#include "Templates/Atomic.h"
 
 class FRunnableThread;
+class FOmniCaptureMemoryBudget;
 class FOmniCaptureRingBufferWorker;
 
 class OMNICAPTURE_API FOmniCaptureRingBuffer
@@ -12,27 +14,72 @@ public:
     FOmniCaptureRingBuffer();
     ~FOmniCaptureRingBuffer();
 
-    void Initialize(const FOmniCaptureSettings& Settings, const TFunction<void(TUniquePtr<FOmniCaptureFrame>&&)>& InConsumer);
+    /**
+     * Starts Settings.RingBufferWorkerCount consumer threads. InConsumer may run concurrently on several workers;
+     * InOrderedConsumer (optional) runs first and always sees frames serially in FrameIndex order.
+     */
+    void Initialize(const FOmniCaptureSettings& Settings, const TFunction<void(TUniquePtr<FOmniCaptureFrame>&&)>& InConsumer, const TFunction<void(const FOmniCaptureFrame&)>& InOrderedConsumer = TFunction<void(const FOmniCaptureFrame&)>());
+    /** Frames reserve their pixel bytes here on enqueue; consumers inherit the reservation through FOmniCaptureFrame::ReservedBytes. */
+    void SetMemoryBudget(FOmniCaptureMemoryBudget* InMemoryBudget) { MemoryBudget = InMemoryBudget; }
     void Enqueue(TUniquePtr<FOmniCaptureFrame>&& Frame);
     void Flush();
     FOmniCaptureRingBufferStats GetStats() const;
 
 private:
-    void StartWorker();
-    void StopWorker();
+    friend class FOmniCaptureRingBufferWorker;
+
+    /** Slot of the bounded MPMC ring. Sequence tells producers/consumers whose turn the slot is. */
+    struct FSlot
+    {
+        TAtomic<uint64> Sequence;
+        FOmniCaptureFrame* Frame = nullptr;
+    };
+
+    void AllocateSlots(int32 InSlotCount);
+    void ReleaseSlots();
+    bool TryPush(FOmniCaptureFrame* Frame);
+    bool TryPop(FOmniCaptureFrame*& OutFrame);
+    bool ReserveFrameBytes(FOmniCaptureFrame& Frame);
+    void DiscardFrame(FOmniCaptureFrame* Frame);
+    /** OutWorkCycles, when given, accumulates the cycles spent inside the consumers. */
+    bool ProcessNextFrame(uint64* OutWorkCycles = nullptr);
+    void Drain();
+    void StartWorkers(int32 InWorkerCount);
+    void StopWorkers();
+
+    /** Frame popped from the ring that is waiting for (or holding) its turn in the ordered stage. */
+    struct FReorderEntry
+    {
+        int32 FrameIndex = 0;
+        FEvent* TurnEvent = nullptr;
+    };
+
+    TUniquePtr<FSlot[]> Slots;
+    uint64 SlotCount = 0;
+    alignas(PLATFORM_CACHE_LINE_SIZE) TAtomic<uint64> EnqueuePosition;
+    alignas(PLATFORM_CACHE_LINE_SIZE) TAtomic<uint64> DequeuePosition;
 
-    TQueue<TUniquePtr<FOmniCaptureFrame>, EQueueMode::Mpsc> Queue;
     TFunction<void(TUniquePtr<FOmniCaptureFrame>&&)> Consumer;
+    TFunction<void(const FOmniCaptureFrame&)> OrderedConsumer;
+    FOmniCaptureMemoryBudget* MemoryBudget = nullptr;
 
-    TUniquePtr<FRunnableThread> WorkerThread;
-    FOmniCaptureRingBufferWorker* Worker = nullptr;
+    TArray<TUniquePtr<FRunnableThread>> WorkerThreads;
+    TArray<FOmniCaptureRingBufferWorker*> Workers;
     FEvent* DataEvent = nullptr;
-    FCriticalSection QueueCriticalSection;
+    FEvent* SpaceEvent = nullptr;
+    FEvent* DrainedEvent = nullptr;
     TAtomic<bool> bRunning;
+    TAtomic<int32> ActiveWorkers;
+
+    mutable FCriticalSection ReorderCS;
+    TArray<FReorderEntry> ReorderWindow;
+    TAtomic<int32> ReorderDepth;
+    TAtomic<int32> MaxReorderDepth;
+    TAtomic<int32> WaitingProducers;
     TAtomic<int32> PendingCount;
     TAtomic<int32> DroppedCount;
     TAtomic<int32> BlockedCount;
+    TAtomic<int32> BudgetBlockedCount;
     int32 Capacity = 0;
     EOmniCaptureRingBufferPolicy Policy = EOmniCaptureRingBufferPolicy::DropOldest;
 };
-
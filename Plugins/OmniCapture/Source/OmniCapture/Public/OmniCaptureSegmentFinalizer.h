@@ -0,0 +1,113 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Logging/LogVerbosity.h"
+#include "OmniCaptureTypes.h"
+#include "OmniCaptureWorkerPool.h"
+
+class FOmniCaptureImageWriter;
+class FOmniCaptureMuxer;
+class FOmniCaptureNVENCEncoder;
+
+struct FOmniCaptureSegmentRecord
+{
+    int32 SegmentIndex = 0;
+    FString Directory;
+    FString BaseFileName;
+    FString AudioPath;
+    FString VideoPath;
+    TArray<FOmniCaptureFrameMetadata> Frames;
+    int32 DroppedFrames = 0;
+    /** Frames that repeated the one before them and were linked instead of encoded. */
+    int32 DuplicateFrames = 0;
+    bool bHasImageSequence = false;
+    FOmniCapturePNGEncodeStats PNGEncodeStats;
+};
+
+/** A segment that has stopped receiving frames: the writers still holding its tail and what its files need to be finished. */
+struct FOmniCaptureSegmentFinalizeJob
+{
+    FOmniCaptureSegmentRecord Segment;
+    /** The capture settings with this segment's directory and file name. */
+    FOmniCaptureSettings Settings;
+    EOmniOutputFormat RequestedOutputFormat = EOmniOutputFormat::ImageSequence;
+    /** Off when the capture is discarded: the writers are closed but nothing is muxed. */
+    bool bFinalize = true;
+
+    TUniquePtr<FOmniCaptureImageWriter> ImageWriter;
+    TUniquePtr<FOmniCaptureNVENCEncoder> NVENCEncoder;
+    /** Only handed over while it owns a live ffmpeg encode. */
+    TUniquePtr<FOmniCaptureMuxer> LiveMuxer;
+
+    FOmniCaptureSegmentFinalizeJob();
+    FOmniCaptureSegmentFinalizeJob(FOmniCaptureSegmentFinalizeJob&&);
+    FOmniCaptureSegmentFinalizeJob& operator=(FOmniCaptureSegmentFinalizeJob&&);
+    ~FOmniCaptureSegmentFinalizeJob();
+};
+
+struct FOmniCaptureSegmentFinalizeMessage
+{
+    ELogVerbosity::Type Verbosity = ELogVerbosity::Log;
+    FString Step;
+    FString Message;
+    /** Also written to the output log, not just the capture diagnostics. */
+    bool bLog = false;
+};
+
+struct FOmniCaptureSegmentFinalizeResult
+{
+    int32 SegmentIndex = 0;
+    bool bFinalized = false;
+    bool bSuccess = true;
+    /** The muxed video, when one was expected and written. */
+    FString OutputPath;
+    /** Set when the segment's frames were left as an image sequence, and whether that was a fallback from NVENC. */
+    FString ImageSequenceDirectory;
+    bool bImageSequenceFallback = false;
+    bool bOpenPreview = false;
+    double Seconds = 0.0;
+    /** Diagnostics gathered off the game thread, to be replayed in order. */
+    TArray<FOmniCaptureSegmentFinalizeMessage> Messages;
+};
+
+/**
+ * Finishes rotated-out capture segments in the background so the next segment can start writing straight away: drains
+ * the old image writer, closes the old encoders, then writes the manifest and muxes. At most MaxConcurrent segments are
+ * finalized at once; later ones wait their turn in rotation order. Results are collected by the game thread.
+ */
+class OMNICAPTURE_API FOmniCaptureSegmentFinalizer
+{
+public:
+    FOmniCaptureSegmentFinalizer();
+    ~FOmniCaptureSegmentFinalizer();
+
+    bool Start(int32 MaxConcurrent);
+    void Enqueue(FOmniCaptureSegmentFinalizeJob&& Job);
+    /** Blocks until every queued segment is finished; Enqueue may be used again afterwards. */
+    void WaitForAll();
+    /** Results finished since the last call, in the order they finished. */
+    TArray<FOmniCaptureSegmentFinalizeResult> ConsumeResults();
+    FOmniCaptureSegmentFinalizeStats GetStats() const;
+
+    /** Does the whole job on the calling thread; progress runs from 0 to 1 through draining, transcoding and muxing. */
+    static void Finalize(FOmniCaptureSegmentFinalizeJob& Job, FOmniCaptureSegmentFinalizeResult& OutResult, TFunctionRef<void(float)> ReportProgress);
+
+private:
+    struct FActiveJob
+    {
+        int32 SegmentIndex = 0;
+        float Progress = 0.0f;
+    };
+
+    static void DrainWriters(FOmniCaptureSegmentFinalizeJob& Job, FOmniCaptureSegmentFinalizeResult& OutResult);
+    static void FinalizeOutputs(FOmniCaptureSegmentFinalizeJob& Job, FOmniCaptureSegmentFinalizeResult& OutResult, TFunctionRef<void(float)> ReportProgress);
+
+    FOmniCaptureWorkerPool Pool;
+    int32 MaxConcurrent = 1;
+
+    mutable FCriticalSection StateCS;
+    int32 QueuedJobs = 0;
+    TArray<TSharedPtr<FActiveJob>> ActiveJobs;
+    TArray<FOmniCaptureSegmentFinalizeResult> Results;
+    FOmniCaptureSegmentFinalizeStats Stats;
+};
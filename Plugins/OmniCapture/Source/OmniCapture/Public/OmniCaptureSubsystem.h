@@ -7,29 +7,19 @@
 #include "OmniCaptureAudioRecorder.h"
 #include "OmniCaptureNVENCEncoder.h"
 #include "OmniCaptureMuxer.h"
+#include "OmniCaptureMemoryBudget.h"
+#include "OmniCaptureSegmentFinalizer.h"
 #include "Templates/Atomic.h"
 #include "Logging/LogVerbosity.h"
 #include "OmniCaptureOptional.h"
+#include "OmniCapturePreviewActor.h"
 #include "OmniCaptureSubsystem.generated.h"
 
 class AOmniCaptureRigActor;
 class AOmniCaptureDirectorActor;
-class AOmniCapturePreviewActor;
 class UTexture2D;
 class IConsoleVariable;
 
-struct FOmniCaptureSegmentRecord
-{
-    int32 SegmentIndex = 0;
-    FString Directory;
-    FString BaseFileName;
-    FString AudioPath;
-    FString VideoPath;
-    TArray<FOmniCaptureFrameMetadata> Frames;
-    int32 DroppedFrames = 0;
-    bool bHasImageSequence = false;
-};
-
 UCLASS()
 class OMNICAPTURE_API UOmniCaptureSubsystem final : public UWorldSubsystem
 {
@@ -75,9 +65,19 @@ public:
     UFUNCTION(BlueprintCallable, Category = "OmniCapture")
     FOmniCaptureRingBufferStats GetRingBufferStats() const { return LatestRingBufferStats; }
 
+    UFUNCTION(BlueprintCallable, Category = "OmniCapture")
+    FOmniCaptureFramePoolStats GetFramePoolStats() const;
+
+    UFUNCTION(BlueprintCallable, Category = "OmniCapture")
+    FOmniCaptureImageWriterStats GetImageWriterStats() const;
+
     UFUNCTION(BlueprintCallable, Category = "OmniCapture")
     FOmniAudioSyncStats GetAudioSyncStats() const;
 
+    /** Rotated-out segments still being written and muxed in the background. */
+    UFUNCTION(BlueprintCallable, Category = "OmniCapture")
+    FOmniCaptureSegmentFinalizeStats GetSegmentFinalizeStats() const;
+
     UFUNCTION(BlueprintCallable, Category = "OmniCapture")
     const FOmniCaptureSettings& GetActiveSettings() const { return ActiveSettings; }
 
@@ -96,6 +96,14 @@ public:
     UFUNCTION(BlueprintCallable, Category = "OmniCapture")
     FString GetLastStillImagePath() const { return LastStillImagePath; }
 
+    /** Converts the intermediate frames left in Directory (InSettings.OutputDirectory when empty); safe to call again after an interrupted pass. */
+    UFUNCTION(BlueprintCallable, Category = "OmniCapture")
+    bool TranscodeIntermediateSequence(const FOmniCaptureSettings& InSettings, const FString& Directory, int32& OutFramesPending);
+
+    /** Unpacks an .omnipack into loose frame files (beside the pack when Directory is empty). */
+    UFUNCTION(BlueprintCallable, Category = "OmniCapture")
+    bool ExtractFramePack(const FString& PackPath, const FString& Directory, int32& OutFilesWritten);
+
     UFUNCTION(BlueprintCallable, Category = "OmniCapture")
     void SetPreviewVisualizationMode(EOmniCapturePreviewView InView);
 
@@ -119,8 +127,10 @@ private:
 
     void SpawnPreviewActor();
     void DestroyPreviewActor();
+    /** Capture worker: builds the preview the game thread asked for, if Frame is that frame and still holds its pixels. */
+    void BuildRequestedPreview(const FOmniCaptureFrame& Frame);
+    void UploadPublishedPreview();
     void InitializeOutputWriters();
-    void ShutdownOutputWriters(bool bFinalizeOutputs);
     void FinalizeOutputs(bool bFinalizeOutputs);
 
     bool ValidateEnvironment();
@@ -140,8 +150,12 @@ private:
 
     void ConfigureActiveSegment();
     void RotateSegmentIfNeeded();
-    void CompleteActiveSegment(bool bStoreResults);
+    /** Hands the active segment's writers and frame record over for finalizing; the subsystem is left without writers. */
+    FOmniCaptureSegmentFinalizeJob DetachActiveSegment(bool bFinalizeOutputs);
+    void ReportFinalizedSegments();
+    /** Summed from the active writers' byte counters; never scans the output directory. */
     int64 CalculateActiveSegmentSizeBytes() const;
+    void RefreshFreeDiskBaseline();
     void UpdateRuntimeWarnings();
     void AddWarningUnique(const FString& Warning);
     void RemoveWarning(const FString& Warning);
@@ -186,11 +200,21 @@ private:
     double ActiveAttemptStartTime = 0.0;
     double LastPreviewUpdateTime = 0.0;
     double PreviewFrameInterval = 0.0;
+    /** The frame the next preview is built from and the view it shows; INDEX_NONE while none is due. Guarded by PreviewCS. */
+    int32 PreviewRequestFrameIndex = INDEX_NONE;
+    EOmniCapturePreviewView PreviewRequestView = EOmniCapturePreviewView::StereoComposite;
+    /** Built by a capture worker, uploaded on the next tick. Guarded by PreviewCS. */
+    TOptional<FOmniCapturePreviewImage> PublishedPreview;
+    FCriticalSection PreviewCS;
     double CurrentCaptureFPS = 0.0;
     double LastFpsSampleTime = 0.0;
     int32 FramesSinceLastFpsSample = 0;
     double LastRuntimeWarningCheckTime = 0.0;
     double LastSegmentSizeCheckTime = 0.0;
+    /** Free space when last queried and the active segment's size at that moment; the estimate grows from there. */
+    uint64 FreeDiskBaselineBytes = 0;
+    int64 SegmentBytesAtFreeDiskBaseline = 0;
+    bool bHasFreeDiskBaseline = false;
     double CurrentSegmentStartTime = 0.0;
     int32 CurrentSegmentIndex = 0;
     double DynamicParameterStartTime = 0.0;
@@ -201,11 +225,13 @@ private:
     TWeakObjectPtr<AOmniCaptureDirectorActor> TickActor;
     TWeakObjectPtr<AOmniCapturePreviewActor> PreviewActor;
 
+    TUniquePtr<FOmniCaptureMemoryBudget> MemoryBudget;
     TUniquePtr<FOmniCaptureRingBuffer> RingBuffer;
     TUniquePtr<FOmniCaptureImageWriter> ImageWriter;
     TUniquePtr<FOmniCaptureAudioRecorder> AudioRecorder;
     TUniquePtr<FOmniCaptureNVENCEncoder> NVENCEncoder;
     TUniquePtr<FOmniCaptureMuxer> OutputMuxer;
+    TUniquePtr<FOmniCaptureSegmentFinalizer> SegmentFinalizer;
 
     TAtomic<bool> bUsingNVENCImageFallback{ false };
     bool bCapturedImageSequenceThisSegment = false;
@@ -213,7 +239,6 @@ private:
     FString LastImageSequenceFallbackDirectory;
 
     TArray<FOmniCaptureFrameMetadata> CapturedFrameMetadata;
-    TArray<FOmniCaptureSegmentRecord> CompletedSegments;
     FString RecordedAudioPath;
     FString RecordedVideoPath;
     FString LastFinalizedOutput;
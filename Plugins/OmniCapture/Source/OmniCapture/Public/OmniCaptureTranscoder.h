@@ -0,0 +1,36 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OmniCaptureTypes.h"
+
+struct FOmniCaptureTranscodeResult
+{
+    EOmniCaptureImageFormat TargetFormat = EOmniCaptureImageFormat::PNG;
+    int32 FramesTranscoded = 0;
+    int32 FramesFailed = 0;
+    /** Intermediate frames still on disk once the pass returns. */
+    int32 FramesPending = 0;
+    double Seconds = 0.0;
+
+    bool IsComplete() const { return FramesPending == 0; }
+};
+
+/**
+ * Converts an intermediate sequence (<Base>_NNNNNN.omniraw plus its <Base>_NNNNNN_<Layer>.omniraw layers) into
+ * Settings.IntermediateTranscodeFormat, one frame per worker across all cores. A frame's intermediates are deleted only
+ * after every output for it is written, beauty file last, so whatever is left on disk is exactly the work a later
+ * pass has to resume.
+ */
+class OMNICAPTURE_API FOmniCaptureTranscoder
+{
+public:
+    /**
+     * Settings.OutputFileName is the sequence base name; MaxThreads <= 0 uses every task graph worker. ReportProgress,
+     * if set, gets the finished fraction after each frame from whichever worker finished it.
+     */
+    static FOmniCaptureTranscodeResult TranscodeSequence(const FOmniCaptureSettings& Settings, const FString& Directory, int32 MaxThreads = 0, const TFunction<void(float)>& ReportProgress = TFunction<void(float)>());
+    static int32 CountPendingFrames(const FOmniCaptureSettings& Settings, const FString& Directory);
+    /** Records the pass in <Base>_Manifest.json; frame counts accumulate across resumed passes. */
+    static bool UpdateManifest(const FOmniCaptureSettings& Settings, const FString& Directory, const FOmniCaptureTranscodeResult& Result);
+    static EOmniCaptureImageFormat ResolveTargetFormat(const FOmniCaptureSettings& Settings);
+};
@@ -22,6 +22,7 @@ namespace OmniCapture
 }
 
 class UCurveFloat;
+struct FOmniCaptureCPURowSource;
 
 UENUM(BlueprintType)
 enum class EOmniCaptureMode : uint8 { Mono, Stereo };
@@ -59,7 +60,7 @@ enum class EOmniOutputFormat : uint8
 };
 
 UENUM(BlueprintType)
-enum class EOmniCaptureImageFormat : uint8 { PNG, JPG, EXR, BMP };
+enum class EOmniCaptureImageFormat : uint8 { PNG, JPG, EXR, BMP, Intermediate UMETA(DisplayName = "Intermediate (transcoded after capture)") };
 
 UENUM(BlueprintType)
 enum class EOmniCaptureEXRCompression : uint8
@@ -108,6 +109,22 @@ enum class EOmniCapturePNGBitDepth : uint8
         BitDepth8 = 2 UMETA(DisplayName = "8-bit Color")
 };
 
+UENUM(BlueprintType)
+enum class EOmniCapturePNGCompression : uint8
+{
+        Balanced UMETA(DisplayName = "Balanced"),
+        Realtime UMETA(DisplayName = "Realtime (zlib 1, Sub filter, RLE)"),
+        Archive UMETA(DisplayName = "Archive (zlib 9, adaptive filters)")
+};
+
+UENUM(BlueprintType)
+enum class EOmniCaptureJPEGSubsampling : uint8
+{
+        Subsampling420 UMETA(DisplayName = "4:2:0"),
+        Subsampling422 UMETA(DisplayName = "4:2:2"),
+        Subsampling444 UMETA(DisplayName = "4:4:4")
+};
+
 UENUM(BlueprintType)
 enum class EOmniCaptureColorSpace : uint8 { BT709, BT2020, HDR10 };
 
@@ -215,12 +232,15 @@ struct OMNICAPTURE_API FOmniCaptureSettings
         UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capture|Fisheye", meta = (EditCondition = "Projection == EOmniCaptureProjection::Fisheye")) bool bFisheyeConvertToEquirect = false;
         UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capture", meta = (ClampMin = 0.0, UIMin = 0.0)) float TargetFrameRate = 60.0f;
         UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capture") EOmniCaptureGamma Gamma = EOmniCaptureGamma::SRGB;
+	/** Frames are downsampled for the preview on the capture workers. Streamed CPU frames and GPU-only (NVENC) frames carry no CPU pixels, so the preview keeps its last image while they are captured. */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capture") bool bEnablePreviewWindow = true;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capture", meta = (ClampMin = 0.1, UIMin = 0.1)) float PreviewScreenScale = 1.0f;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capture", meta = (ClampMin = 1.0, UIMin = 5.0, ClampMax = 240.0)) float PreviewFrameRate = 30.0f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capture", meta = (ClampMin = 64, UIMin = 256, UIMax = 4096)) int32 PreviewMaxResolution = 1024;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capture") bool bRecordAudio = true;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capture") float AudioGain = 1.0f;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capture") TSoftObjectPtr<class USoundSubmix> SubmixToRecord;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capture") bool bAmbisonicAudio = false;
         UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capture") float InterPupillaryDistanceCm = 6.4f;
         UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capture|Stereo", meta = (ClampMin = 0.0, UIMin = 0.0)) float EyeConvergenceDistanceCm = 0.0f;
         UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capture|Stereo") UCurveFloat* InterpupillaryDistanceCurve = nullptr;
@@ -229,10 +249,26 @@ struct OMNICAPTURE_API FOmniCaptureSettings
         UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capture", meta = (ClampMin = 0)) int32 SegmentSizeLimitMB = 0;
         UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capture", meta = (ClampMin = 0, UIMin = 0)) int32 SegmentFrameCount = 0;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capture") bool bCreateSegmentSubfolders = true;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capture", meta = (ClampMin = 1, UIMin = 1, UIMax = 4)) int32 MaxConcurrentSegmentFinalizations = 1;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output") EOmniOutputFormat OutputFormat = EOmniOutputFormat::ImageSequence;
         UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output") EOmniCaptureImageFormat ImageFormat = EOmniCaptureImageFormat::PNG;
         UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output") EOmniCaptureHDRPrecision HDRPrecision = EOmniCaptureHDRPrecision::HalfFloat;
         UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output") EOmniCapturePNGBitDepth PNGBitDepth = EOmniCapturePNGBitDepth::BitDepth32;
+        /** Threads each PNG is deflated on. 0 = one per file on the encode threads, which already run files in parallel, or every engine worker elsewhere; 1 = libpng. */
+        UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output", meta = (ClampMin = 0, UIMin = 0)) int32 PNGEncodeThreads = 0;
+        UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output") EOmniCapturePNGCompression PNGCompression = EOmniCapturePNGCompression::Balanced;
+        UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output|JPEG", meta = (ClampMin = 1, ClampMax = 100, UIMin = 1, UIMax = 100)) int32 JPEGQuality = 85;
+        UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output|JPEG") EOmniCaptureJPEGSubsampling JPEGSubsampling = EOmniCaptureJPEGSubsampling::Subsampling420;
+        UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output|JPEG") bool bJPEGFastDCT = false;
+        /** Threads each JPEG is split over. 0 = one per file on the encode threads, which already run files in parallel, or every engine worker elsewhere. */
+        UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output|JPEG", meta = (ClampMin = 0, UIMin = 0)) int32 JPEGEncodeThreads = 0;
+        UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output|Intermediate") EOmniCaptureImageFormat IntermediateTranscodeFormat = EOmniCaptureImageFormat::PNG;
+        UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output|Intermediate") bool bTranscodeIntermediatesOnFinalize = true;
+        UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output|Pack") bool bWriteFramePack = false;
+        UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output|Pack", meta = (ClampMin = 0, UIMin = 0)) int32 FramePackPreallocateMB = 256;
+        UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output") bool bDeduplicateFrames = false;
+        UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output|FFmpeg") bool bStreamToFFmpeg = false;
+        UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output|FFmpeg", meta = (EditCondition = "bStreamToFFmpeg", ClampMin = 16, UIMin = 16)) int32 FFmpegPipeBufferMB = 256;
         UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output") FString OutputDirectory;
         UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output") FString OutputFileName = TEXT("OmniCapture");
         UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output") EOmniCaptureColorSpace ColorSpace = EOmniCaptureColorSpace::BT709;
@@ -240,20 +276,34 @@ struct OMNICAPTURE_API FOmniCaptureSettings
         UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output|EXR") bool bPackEXRAuxiliaryLayers = true;
         UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output|EXR") bool bUseEXRMultiPart = false;
         UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output|EXR") EOmniCaptureEXRCompression EXRCompression = EOmniCaptureEXRCompression::Zip;
+        UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output|EXR", meta = (ClampMin = 0, UIMin = 0)) int32 EXRThreadCount = 0;
         UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output") bool bForceConstantFrameRate = true;
         UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output") bool bAllowNVENCFallback = true;
         UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output", meta = (ClampMin = 1, UIMin = 1)) int32 MaxPendingImageTasks = 8;
+        UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output|Threads", meta = (ClampMin = 0, UIMin = 0)) int32 EncodeThreadCount = 0;
+        UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output|Threads") int64 EncodeThreadAffinityMask = 0;
+        UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output|Threads", meta = (ClampMin = 0, UIMin = 0)) int32 IOThreadCount = 1;
+        /** Idle pixel buffers kept for reuse; frames in flight are bounded by InFlightMemoryBudgetMB. 0 disables pooling. */
+        UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output", meta = (ClampMin = 0, UIMin = 0)) int32 FramePoolBudgetMB = 2048;
         UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Diagnostics", meta = (ClampMin = 0)) int32 MinimumFreeDiskSpaceGB = 2;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Diagnostics", meta = (ClampMin = 0.1, ClampMax = 1.0)) float LowFrameRateWarningRatio = 0.85f;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output") FString PreferredFFmpegPath;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capture", meta = (ClampMin = 0.0, ClampMax = 1.0)) float SeamBlend = 0.25f;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capture", meta = (ClampMin = 0.0, ClampMax = 1.0)) float PolarDampening = 0.5f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capture") bool bCacheCPUReprojectionLUT = true;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capture", meta = (EditCondition = "bCacheCPUReprojectionLUT")) bool bPersistCPUReprojectionLUT = false;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capture") bool bBilinearCPUSampling = false;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capture") bool bStreamCPUConversionToWriter = false;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Capture", meta = (EditCondition = "bStreamCPUConversionToWriter", ClampMin = 8, UIMin = 16, UIMax = 1024)) int32 CPUStreamingBandRows = 128;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Output") FOmniCaptureQuality Quality;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NVENC") EOmniCaptureCodec Codec = EOmniCaptureCodec::HEVC;
         UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NVENC") EOmniCaptureColorFormat NVENCColorFormat = EOmniCaptureColorFormat::NV12;
         UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NVENC") bool bZeroCopy = true;
+        UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NVENC") bool bMuxNVENCToMP4 = false;
         UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NVENC", meta = (ClampMin = 0, UIMin = 0)) int32 RingBufferCapacity = 6;
         UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NVENC") EOmniCaptureRingBufferPolicy RingBufferPolicy = EOmniCaptureRingBufferPolicy::DropOldest;
+        UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NVENC", meta = (ClampMin = 1, UIMin = 1, ClampMax = 16, UIMax = 8)) int32 RingBufferWorkerCount = 1;
+        UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NVENC", meta = (ClampMin = 0, UIMin = 0)) int32 InFlightMemoryBudgetMB = 4096;
         UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NVENC") FString NVENCRuntimeDirectory;
         UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "NVENC") FString NVENCDllPathOverride;
         UPROPERTY(meta = (DeprecatedProperty, DeprecationMessage = "Use NVENCRuntimeDirectory instead.")) FString AVEncoderModulePathOverride_DEPRECATED;
@@ -283,6 +333,8 @@ struct OMNICAPTURE_API FOmniCaptureSettings
         bool IsFullDome() const;
         bool IsSphericalMirror() const;
         bool SupportsSphericalMetadata() const;
+        /** Image-sequence output encoded by a live ffmpeg instead of being written frame by frame. */
+        bool ShouldStreamToFFmpeg() const;
         bool UseDualFisheyeLayout() const;
         bool ShouldConvertFisheyeToEquirect() const;
         FString GetStereoModeMetadataTag() const;
@@ -354,8 +406,12 @@ struct FOmniCaptureFrame
         EOmniCapturePixelPrecision PixelPrecision = EOmniCapturePixelPrecision::Unknown;
         EOmniCapturePixelDataType PixelDataType = EOmniCapturePixelDataType::Unknown;
         TArray<FOmniAudioPacket> AudioPackets;
+        /** PCM storage kept from the frame's previous use, so gathering audio into a pooled frame does not allocate. */
+        TArray<TArray<int16>> SpareAudioPCM;
         TArray<FTextureRHIRef> EncoderTextures;
         TMap<FName, FOmniCaptureLayerPayload> AuxiliaryLayers;
+        TSharedPtr<FOmniCaptureCPURowSource, ESPMode::ThreadSafe> RowSource;
+        int64 ReservedBytes = 0;
 };
 
 USTRUCT(BlueprintType)
@@ -365,6 +421,63 @@ struct FOmniCaptureRingBufferStats
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int32 PendingFrames = 0;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int32 DroppedFrames = 0;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int32 BlockedPushes = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int32 WorkerCount = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") TArray<float> WorkerUtilization;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int32 ReorderWindowDepth = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int32 MaxReorderWindowDepth = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int64 BytesInFlight = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int64 PeakBytesInFlight = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int64 MemoryBudgetBytes = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int32 BudgetBlockedPushes = 0;
+};
+
+USTRUCT(BlueprintType)
+struct FOmniCapturePNGEncodeStats
+{
+	GENERATED_BODY()
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int32 FrameCount = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") double EncodeSeconds = 0.0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int64 RawBytes = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int64 EncodedBytes = 0;
+};
+
+USTRUCT(BlueprintType)
+struct FOmniCaptureImageWriterStats
+{
+	GENERATED_BODY()
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int32 InFlightTasks = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int32 PeakInFlightTasks = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int32 MaxPendingTasks = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int32 CompletedTasks = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int32 FailedTasks = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int32 StalledTasks = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int32 SlotWaits = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") double SlotWaitMilliseconds = 0.0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") double AverageQueueMilliseconds = 0.0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") double MaxQueueMilliseconds = 0.0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") double AverageEncodeMilliseconds = 0.0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") double MaxEncodeMilliseconds = 0.0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") double AverageIOMilliseconds = 0.0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") double MaxIOMilliseconds = 0.0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int32 EncodeThreads = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int32 IOThreads = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") float EncodeUtilization = 0.0f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") float IOUtilization = 0.0f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int32 QueuedIOJobs = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int32 DuplicateFrames = 0;
+};
+
+USTRUCT(BlueprintType)
+struct FOmniCaptureFramePoolStats
+{
+	GENERATED_BODY()
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int64 BufferHits = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int64 BufferMisses = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int64 BuffersDiscarded = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int64 FrameHits = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int64 FrameMisses = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int64 PooledBytes = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int64 BudgetBytes = 0;
 };
 
 USTRUCT(BlueprintType)
@@ -376,7 +489,23 @@ struct FOmniAudioSyncStats
         UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Audio") double DriftMilliseconds = 0.0;
         UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Audio") double MaxObservedDriftMilliseconds = 0.0;
         UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Audio") int32 PendingPackets = 0;
+        UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Audio") int32 OverflowCount = 0;
+        UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Audio") int32 UnderflowCount = 0;
         UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Audio") bool bInError = false;
 };
 
+USTRUCT(BlueprintType)
+struct FOmniCaptureSegmentFinalizeStats
+{
+        GENERATED_BODY()
+        UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int32 QueuedSegments = 0;
+        UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int32 ActiveSegments = 0;
+        UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int32 CompletedSegments = 0;
+        UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") int32 FailedSegments = 0;
+        /** Averaged over the segments being finalized right now; 0 when none are. */
+        UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") float ActiveProgress = 0.0f;
+        UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") double LastFinalizeSeconds = 0.0;
+        UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stats") double MaxFinalizeSeconds = 0.0;
+};
+
 OMNICAPTURE_API FName GetAuxiliaryLayerName(EOmniCaptureAuxiliaryPassType PassType);
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "Templates/Atomic.h"
+#include "Templates/Function.h"
+
+class FRunnableThread;
+class FOmniCaptureWorkerPoolThread;
+
+/**
+ * A few named threads draining one FIFO job queue. OmniCapture runs its image encodes and its file writes on these
+ * instead of GThreadPool, so compression never competes with engine tasks and disk waits never hold an encode thread.
+ * With one thread the jobs run strictly in submission order.
+ */
+class OMNICAPTURE_API FOmniCaptureWorkerPool
+{
+public:
+    FOmniCaptureWorkerPool();
+    ~FOmniCaptureWorkerPool();
+
+    /** AffinityMask 0 lets the threads run on any core. */
+    bool Start(const FString& Name, int32 ThreadCount, uint64 AffinityMask = 0, EThreadPriority Priority = TPri_Normal);
+    /** Runs whatever is still queued, then joins the threads. */
+    void Stop();
+
+    void Enqueue(TUniqueFunction<void()>&& Job);
+
+    bool IsRunning() const { return Threads.Num() > 0; }
+    int32 GetThreadCount() const { return Threads.Num(); }
+    int32 GetQueuedJobs() const { return QueuedJobs.Load(); }
+    /** Busy share of the pool's lifetime, averaged over its threads. */
+    float GetUtilization() const;
+
+private:
+    friend class FOmniCaptureWorkerPoolThread;
+
+    bool RunNextJob();
+
+    TQueue<TUniqueFunction<void()>, EQueueMode::Mpsc> Jobs;
+    FCriticalSection DequeueCS;
+    TAtomic<int32> QueuedJobs;
+    TAtomic<int32> ActiveThreads;
+    TAtomic<bool> bRunning;
+    /** Held while Enqueue queues a job and while Start or Stop flips bRunning, so no job lands after Stop's last drain. */
+    FCriticalSection RunStateCS;
+    FEvent* JobEvent = nullptr;
+
+    TArray<TUniquePtr<FRunnableThread>> Threads;
+    TArray<FOmniCaptureWorkerPoolThread*> Workers;
+};
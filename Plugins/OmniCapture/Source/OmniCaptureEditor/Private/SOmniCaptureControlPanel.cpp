@@ -126,6 +126,8 @@ namespace
             return LOCTEXT("ImageFormatEXR", "EXR Sequence");
         case EOmniCaptureImageFormat::BMP:
             return LOCTEXT("ImageFormatBMP", "BMP Sequence");
+        case EOmniCaptureImageFormat::Intermediate:
+            return LOCTEXT("ImageFormatIntermediate", "Intermediate (transcoded on finalize)");
         case EOmniCaptureImageFormat::PNG:
         default:
             return LOCTEXT("ImageFormatPNG", "PNG Sequence");
@@ -276,6 +278,7 @@ void SOmniCaptureControlPanel::Construct(const FArguments& InArgs)
     ImageFormatOptions.Add(MakeShared<TEnumOptionValue<EOmniCaptureImageFormat>>(EOmniCaptureImageFormat::JPG));
     ImageFormatOptions.Add(MakeShared<TEnumOptionValue<EOmniCaptureImageFormat>>(EOmniCaptureImageFormat::EXR));
     ImageFormatOptions.Add(MakeShared<TEnumOptionValue<EOmniCaptureImageFormat>>(EOmniCaptureImageFormat::BMP));
+    ImageFormatOptions.Add(MakeShared<TEnumOptionValue<EOmniCaptureImageFormat>>(EOmniCaptureImageFormat::Intermediate));
 
     PNGBitDepthOptions.Reset();
     PNGBitDepthOptions.Add(MakeShared<TEnumOptionValue<EOmniCapturePNGBitDepth>>(EOmniCapturePNGBitDepth::BitDepth8));
@@ -1902,10 +1905,23 @@ void SOmniCaptureControlPanel::RefreshStatus()
     }
 
     const FOmniCaptureRingBufferStats RingStats = Subsystem->GetRingBufferStats();
-    const FText RingText = FText::Format(LOCTEXT("RingStatsFormat", "Ring Buffer: Pending {0} | Dropped {1} | Blocked {2}"),
+    float AverageUtilization = 0.0f;
+    for (float Utilization : RingStats.WorkerUtilization)
+    {
+        AverageUtilization += Utilization;
+    }
+    AverageUtilization = RingStats.WorkerUtilization.Num() > 0 ? AverageUtilization / RingStats.WorkerUtilization.Num() : 0.0f;
+
+    const FText RingText = FText::Format(LOCTEXT("RingStatsFormat", "Ring Buffer: Pending {0} | Dropped {1} | Blocked {2} | Workers {3} ({4}% busy) | Reorder {5} (Max {6}) | In Flight {7} / {8} MB"),
         FText::AsNumber(RingStats.PendingFrames),
         FText::AsNumber(RingStats.DroppedFrames),
-        FText::AsNumber(RingStats.BlockedPushes));
+        FText::AsNumber(RingStats.BlockedPushes + RingStats.BudgetBlockedPushes),
+        FText::AsNumber(RingStats.WorkerCount),
+        FText::AsNumber(FMath::RoundToInt(AverageUtilization * 100.0f)),
+        FText::AsNumber(RingStats.ReorderWindowDepth),
+        FText::AsNumber(RingStats.MaxReorderWindowDepth),
+        FText::AsNumber(RingStats.BytesInFlight / (1024 * 1024)),
+        RingStats.MemoryBudgetBytes > 0 ? FText::AsNumber(RingStats.MemoryBudgetBytes / (1024 * 1024)) : LOCTEXT("UnlimitedBudget", "Unlimited"));
     RingBufferTextBlock->SetText(RingText);
 
     const FOmniAudioSyncStats AudioStats = Subsystem->GetAudioSyncStats();